@@ -3,21 +3,121 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "engine/core/time.h"
 #include "engine/core/log.h"
+#include "engine/core/profiler.h"
+#include "engine/core/startup.h"
+#include "engine/core/frame_timings.h"
+#include "engine/core/jobs.h"
+#include "engine/core/memory.h"
 #include "engine/platform/window.h"
 #include "engine/platform/input.h"
+#include "engine/platform/async_io.h"
 #include "engine/scene/camera.h"
+#include "engine/scene/camera_path.h"
 #include "engine/renderer/vulkan_renderer.h"
 #include "engine/scene/gltf_loader.h"
+#include "engine/scene/bvh.h"
+#include "engine/scene/light.h"
+#include "engine/terrain/terrain.h"
+#include "engine/terrain/height_query.h"
 #include <GLFW/glfw3.h>
 #include <cmath>
 #include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+#include <string>
 
 using namespace eng;
 
-int main() {
+// Reproducible perf runs:
+//   sandbox --record fly.campath     record input, camera and dt per frame; saved on exit
+//   sandbox --replay fly.campath     once all content is loaded, drive the camera from the path at a
+//                                    fixed step (--step-hz, default 60), write per-frame CPU/GPU times
+//                                    to --csv (default fly.campath.csv), log percentiles and quit
+//   --job-workers N, --pin-threads 1 size the job system (default: one worker per extra core, unpinned)
+//   --io-backend uring|threads|inline file reads for assets (default uring, falling back to threads)
+//   --pipeline-cache PATH            Vulkan pipeline cache file, "" to disable (default: per-user cache
+//                                    directory, see VulkanRenderer::defaultPipelineCachePath)
+struct Options {
+    std::string recordPath, replayPath, csvPath;
+    std::optional<std::string> pipelineCachePath;
+    float stepHz = 60.0f;
+    jobs::Config jobs;
+    io::Config io;
+};
+
+static bool parseArgs(int argc, char** argv, Options& o) {
+    for (int i = 1; i < argc; ++i) {
+        const char* a = argv[i];
+        const char* v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!v) { eng::log::error("Missing value for %s", a); return false; }
+        if (std::strcmp(a, "--record") == 0) o.recordPath = v;
+        else if (std::strcmp(a, "--replay") == 0) o.replayPath = v;
+        else if (std::strcmp(a, "--csv") == 0) o.csvPath = v;
+        else if (std::strcmp(a, "--step-hz") == 0) o.stepHz = (float)std::atof(v);
+        else if (std::strcmp(a, "--job-workers") == 0) o.jobs.workers = (unsigned)std::atoi(v);
+        else if (std::strcmp(a, "--pipeline-cache") == 0) o.pipelineCachePath = v;
+        else if (std::strcmp(a, "--pin-threads") == 0) o.jobs.pinThreads = std::atoi(v) != 0;
+        else if (std::strcmp(a, "--io-backend") == 0) {
+            if (std::strcmp(v, "uring") == 0) o.io.backend = io::Backend::IoUring;
+            else if (std::strcmp(v, "threads") == 0) o.io.backend = io::Backend::ThreadPool;
+            else if (std::strcmp(v, "inline") == 0) o.io.backend = io::Backend::Inline;
+            else { eng::log::error("--io-backend must be uring, threads or inline"); return false; }
+        }
+        else { eng::log::error("Unknown option %s (use --record, --replay, --csv, --step-hz, --job-workers, --pin-threads, --io-backend, --pipeline-cache)", a); return false; }
+        ++i;
+    }
+    if (!o.recordPath.empty() && !o.replayPath.empty()) { eng::log::error("--record and --replay are exclusive"); return false; }
+    if (o.stepHz <= 0.0f) { eng::log::error("--step-hz must be positive"); return false; }
+    if (o.csvPath.empty() && !o.replayPath.empty()) o.csvPath = o.replayPath + ".csv";
+    return true;
+}
+
+int main(int argc, char** argv) {
+    ENG_PROFILE_THREAD("main");
+    startup::mark("launch"); // first touch: sets the timeline origin and makes this the main lane
+    Options opts;
+    if (!parseArgs(argc, argv, opts)) return 2;
+    jobs::init(opts.jobs); // startup loads, terrain chunks, BVH builds and texture decodes run on its workers
+    io::init(opts.io);     // glTF buffers and the pipeline cache are read through it
+    scene::CameraPath path;
+    if (!opts.replayPath.empty() && (!path.load(opts.replayPath) || path.empty())) return 1;
+    const bool recording = !opts.recordPath.empty(), replaying = !opts.replayPath.empty();
+    // Startup task graph: terrain generation and glTF parsing only need the CPU, so they start
+    // right away as jobs while this thread brings up the window and Vulkan. Each result is
+    // uploaded from the frame loop as soon as its group is done; frames render whatever has arrived.
+    terrain::Settings terrainSettings;
+    terrainSettings.chunkPoints = 64; terrainSettings.radiusChunks = 3; terrainSettings.heightScale = 60.0f; terrainSettings.frequency = 0.0045f; terrainSettings.octaves = 5;
+    jobs::Group terrainLoad, sceneLoad;
+    std::vector<terrain::Vertex> terrainVertices;
+    jobs::run(terrainLoad, [&] {
+        startup::Phase phase("terrain generate");
+        terrainVertices = terrain::generate(terrainSettings);
+    });
+    terrain::HeightQuery ground; // filled once the terrain arrives; the camera stays above it
+    scene::Scene gltfScene;
+    scene::Bvh loadedBvh, sceneBvh; // built by the job, moved into sceneBvh (picking, F5) once it is done
+    std::string sceneError;
+    jobs::run(sceneLoad, [&] {
+        try {
+            {
+                startup::Phase phase("gltf load");
+                gltfScene = scene::GltfLoader::load("scenes/old_town/scene.gltf");
+            }
+            startup::Phase phase("gltf bvh");
+            loadedBvh.build(gltfScene.meshes);
+        } catch (const std::exception& e) {
+            sceneError = e.what();
+        }
+    });
+    bool terrainPending = true, scenePending = true;
+
+    auto windowStart = startup::clock::now();
     platform::WindowCreateInfo wci; wci.title = "Sandbox"; wci.width = 1280; wci.height = 720;
     platform::Window window(wci);
     platform::Input::attach(window.handle());
+    startup::record("window", windowStart, startup::clock::now());
 
     scene::Camera cam;
     time::DeltaTimer timer;
@@ -25,63 +125,209 @@ int main() {
     eng::log::info("Sandbox started. WASD + Mouse to move. ESC to quit.");
 
     renderer::VulkanRenderer vk;
+    if (opts.pipelineCachePath) vk.setPipelineCachePath(*opts.pipelineCachePath);
     if (!vk.initialize(window.handle())) {
         eng::log::error("Failed to init Vulkan renderer");
+        jobs::wait(terrainLoad); jobs::wait(sceneLoad); // they write into main's locals
         return 1;
     }
 
-    // Load GLTF scene
-    try {
-        auto gltfMeshes = eng::scene::GltfLoader::loadScene("scenes/old_town/scene.gltf");
-        if (!gltfMeshes.empty()) {
-            vk.loadGltfMeshes(gltfMeshes);
-            eng::log::info("Loaded GLTF scene with {} meshes", gltfMeshes.size());
-        } else {
-            eng::log::warn("No meshes loaded from GLTF scene");
+    // A field of colored local lights around the origin to exercise the clustered lighting path
+    {
+        std::vector<scene::PointLight> points;
+        for (int z = -16; z < 16; ++z)
+            for (int x = -16; x < 16; ++x) {
+                scene::PointLight l;
+                l.position = { x * 6.0f + 3.0f, 2.0f, z * 6.0f + 3.0f };
+                l.color = { 0.5f + 0.5f * sinf(x * 0.7f), 0.5f + 0.5f * sinf(z * 0.9f + 2.0f), 0.5f + 0.5f * sinf((x + z) * 0.5f + 4.0f) };
+                l.range = 8.0f;
+                points.push_back(l);
+            }
+        std::vector<scene::SpotLight> spots;
+        for (int i = 0; i < 8; ++i) {
+            scene::SpotLight l;
+            float a = i * 0.785398f;
+            l.position = { cosf(a) * 20.0f, 12.0f, sinf(a) * 20.0f };
+            l.direction = glm::normalize(glm::vec3(-cosf(a), -2.0f, -sinf(a)));
+            l.range = 30.0f;
+            spots.push_back(l);
         }
-    } catch (const std::exception& e) {
-        eng::log::error("GLTF loading failed: {}", e.what());
+        vk.setLights(points, spots);
+        eng::log::info("Added %zu point and %zu spot lights", points.size(), spots.size());
     }
 
+    bool traceKeyDown = false, cullKeyDown = false, queueKeyDown = false, dynResKeyDown = false, pickKeyDown = false;
+    bool occlusionCulling = true, dynamicResolution = true;
+    bool firstFrame = true, startupReported = false;
+    // Replay starts once startup is over, so loading never shows up in the timings
+    const float replayStep = 1.0f / opts.stepHz;
+    float replayTime = 0.0f;
+    uint32_t replayFrame = 0;
+    uint64_t gpuSeq = 0;
+    uint64_t replayAllocs = 0; uint32_t replayAllocFrames = 0; // main-thread heap traffic (ENGINE_COUNT_ALLOCATIONS)
+    time::FrameTimings timings;
+    if (replaying) { timings.reserve((size_t)(path.duration() / replayStep) + 2); path.pose(0.0f, cam); }
     while (!window.shouldClose()) {
+        ENG_PROFILE_SCOPE("frame");
+        auto frameStart = time::clock::now();
+        memory::AllocationScope frameAllocs;
+        // Startup uploads, whichever finishes first
+        if (terrainPending && terrainLoad.done()) {
+            startup::Phase phase("terrain upload");
+            terrainPending = false;
+            ground.build(terrainSettings, terrainVertices);
+            if (!vk.loadTerrain(terrainVertices)) eng::log::error("Terrain upload failed");
+            terrainVertices = {};
+        }
+        if (scenePending && sceneLoad.done()) {
+            startup::Phase phase("gltf upload");
+            scenePending = false;
+            sceneBvh = std::move(loadedBvh);
+            if (!sceneError.empty()) {
+                eng::log::error("GLTF loading failed: %s", sceneError);
+            } else if (!gltfScene.meshes.empty()) {
+                size_t meshCount = gltfScene.meshes.size();
+                vk.loadGltfScene(std::move(gltfScene));
+                eng::log::info("Loaded GLTF scene with %zu meshes", meshCount);
+            } else {
+                eng::log::warn("No meshes loaded from GLTF scene");
+            }
+        }
+        if (!startupReported && !firstFrame && !terrainPending && !scenePending) {
+            startup::mark("all content uploaded");
+            startup::report();
+            startupReported = true;
+        }
         float dt = timer.tick();
         platform::InputState& in = platform::Input::state();
 
         const float speed = 10.0f;
         const float sensitivity = 0.0025f;
 
-        // Mouse look
-        cam.yaw   -= static_cast<float>(in.mouseDx) * sensitivity;
-        cam.pitch -= static_cast<float>(in.mouseDy) * sensitivity;
-        cam.pitch = std::clamp(cam.pitch, -1.55f, 1.55f);
-        in.mouseDx = in.mouseDy = 0.0;
-
-        // WASD
-        glm::vec3 fwd{ cosf(cam.pitch) * sinf(cam.yaw), 0.0f, cosf(cam.pitch) * cosf(cam.yaw) };
-        glm::vec3 right = glm::normalize(glm::cross(fwd, {0,1,0}));
-        glm::vec3 move{0};
-        if (in.keys[GLFW_KEY_W]) move += fwd;
-        if (in.keys[GLFW_KEY_S]) move -= fwd;
-        if (in.keys[GLFW_KEY_A]) move -= right;
-        if (in.keys[GLFW_KEY_D]) move += right;
-        if (in.keys[GLFW_KEY_SPACE]) move.y += 1.0f;
-        if (in.keys[GLFW_KEY_LEFT_SHIFT]) move.y -= 1.0f;
-        if (glm::length(move) > 0.0f) cam.position += glm::normalize(move) * speed * dt;
+        if (replaying) {
+            // The path owns the camera; live look/move input is dropped
+            in.mouseDx = in.mouseDy = 0.0;
+            if (startupReported) path.pose(replayTime, cam);
+        } else {
+            scene::CameraSample sample;
+            sample.dt = dt; sample.mouseDx = (float)in.mouseDx; sample.mouseDy = (float)in.mouseDy;
+
+            // Mouse look
+            cam.yaw   -= static_cast<float>(in.mouseDx) * sensitivity;
+            cam.pitch -= static_cast<float>(in.mouseDy) * sensitivity;
+            cam.pitch = std::clamp(cam.pitch, -1.55f, 1.55f);
+            in.mouseDx = in.mouseDy = 0.0;
+
+            // WASD
+            glm::vec3 fwd{ cosf(cam.pitch) * sinf(cam.yaw), 0.0f, cosf(cam.pitch) * cosf(cam.yaw) };
+            glm::vec3 right = glm::normalize(glm::cross(fwd, {0,1,0}));
+            glm::vec3 move{0};
+            if (in.keys[GLFW_KEY_W]) { move += fwd; sample.keys |= scene::KeyForward; }
+            if (in.keys[GLFW_KEY_S]) { move -= fwd; sample.keys |= scene::KeyBack; }
+            if (in.keys[GLFW_KEY_A]) { move -= right; sample.keys |= scene::KeyLeft; }
+            if (in.keys[GLFW_KEY_D]) { move += right; sample.keys |= scene::KeyRight; }
+            if (in.keys[GLFW_KEY_SPACE]) { move.y += 1.0f; sample.keys |= scene::KeyUp; }
+            if (in.keys[GLFW_KEY_LEFT_SHIFT]) { move.y -= 1.0f; sample.keys |= scene::KeyDown; }
+            if (glm::length(move) > 0.0f) cam.position += glm::normalize(move) * speed * dt;
+            // Never below eye height over the terrain (outside the generated chunks: the analytic height)
+            const float eyeHeight = 1.7f;
+            if (ground.loaded()) cam.position.y = std::max(cam.position.y, ground.height(cam.position.x, cam.position.z) + eyeHeight);
+
+            if (recording) {
+                sample.position = cam.position; sample.yaw = cam.yaw; sample.pitch = cam.pitch;
+                path.add(sample);
+            }
+        }
 
         if (in.keys[GLFW_KEY_ESCAPE]) glfwSetWindowShouldClose(window.handle(), 1);
+#if defined(ENG_PROFILER) && ENG_PROFILER
+        // F9: dump the CPU profiler buffers as a Chrome trace
+        if (in.keys[GLFW_KEY_F9] && !traceKeyDown) {
+            if (eng::profiler::writeChromeTrace("trace.json")) eng::log::info("Wrote trace.json");
+            else eng::log::warn("Failed to write trace.json");
+        }
+#endif
+        traceKeyDown = in.keys[GLFW_KEY_F9];
+        // F8: toggle Hi-Z occlusion culling and report what the last frame culled
+        if (in.keys[GLFW_KEY_F8] && !cullKeyDown) {
+            occlusionCulling = !occlusionCulling;
+            vk.setOcclusionCulling(occlusionCulling);
+            auto st = vk.occlusionStats();
+            eng::log::info("Occlusion culling %s (last frame: %u tested, %u frustum culled, %u occluded)",
+                           occlusionCulling ? "on" : "off", st.tested, st.frustumCulled, st.occlusionCulled);
+        }
+        cullKeyDown = in.keys[GLFW_KEY_F8];
+        // F7: report the scene pass state changes after render queue sorting
+        if (in.keys[GLFW_KEY_F7] && !queueKeyDown) {
+            auto st = vk.renderQueueStats();
+            eng::log::info("Render queue: %u draws, %u pipeline binds (%u elided), %u material binds (%u elided)",
+                           st.draws, st.pipelineBinds, st.pipelineBindsSkipped, st.materialBinds, st.materialBindsSkipped);
+        }
+        queueKeyDown = in.keys[GLFW_KEY_F7];
+        // F6: toggle GPU-time driven dynamic resolution and report the current render scale
+        if (in.keys[GLFW_KEY_F6] && !dynResKeyDown) {
+            const auto& dr = vk.dynamicResolution();
+            VkExtent2D ext = vk.renderExtent();
+            eng::log::info("Dynamic resolution %s (last frame: %ux%u, scale %.2f, GPU %.2f ms of %.2f ms budget)",
+                           dynamicResolution ? "off" : "on", ext.width, ext.height, dr.scale(), dr.averageMs(), dr.settings().targetMs);
+            dynamicResolution = !dynamicResolution;
+            vk.setDynamicResolution(dynamicResolution);
+        }
+        dynResKeyDown = in.keys[GLFW_KEY_F6];
+        // F5: pick along the view direction against the scene meshes and the terrain
+        if (in.keys[GLFW_KEY_F5] && !pickKeyDown) {
+            glm::vec3 dir{ cosf(cam.pitch) * sinf(cam.yaw), sinf(cam.pitch), cosf(cam.pitch) * cosf(cam.yaw) };
+            auto t0 = time::clock::now();
+            scene::BvhHit meshHit; terrain::RayHit groundHit;
+            bool onMesh = sceneBvh.raycast(cam.position, dir, cam.farPlane, meshHit);
+            bool onGround = ground.raycast(cam.position, dir, onMesh ? meshHit.t : cam.farPlane, groundHit);
+            float us = std::chrono::duration<float, std::micro>(time::clock::now() - t0).count();
+            if (onGround) eng::log::info("Pick: terrain at %.1f m (%.1f, %.1f, %.1f), %.1f us", groundHit.t, groundHit.position.x, groundHit.position.y, groundHit.position.z, us);
+            else if (onMesh) eng::log::info("Pick: mesh %u instance %u triangle %u at %.1f m, %.1f us", meshHit.mesh, meshHit.instance, meshHit.triangle, meshHit.t, us);
+            else eng::log::info("Pick: nothing within %.0f m, %.1f us", cam.farPlane, us);
+        }
+        pickKeyDown = in.keys[GLFW_KEY_F5];
 
         window.pollEvents();
+        jobs::pumpMain(); // jobs that must run on the GLFW thread
         int fbw=0, fbh=0; window.getFramebufferSize(fbw, fbh);
         float aspect = fbh>0 ? (float)fbw/(float)fbh : 1.0f;
-        glm::mat4 vp = cam.proj(aspect) * cam.view();
-        vk.setVP(&vp[0][0]);
+        glm::mat4 view = cam.view(), proj = cam.proj(aspect);
+        vk.setCamera(&view[0][0], &proj[0][0], cam.nearPlane, cam.farPlane);
         vk.setPointSize(3.0f);
         const float lightDir[3] = {-0.5f, -1.0f, -0.25f};
         const float lightColor[3] = {1.0f, 0.98f, 0.9f};
         vk.setLight(lightDir, lightColor, 2.0f);
         vk.drawFrame(0.05f, 0.07f, 0.12f);
+        if (firstFrame) { startup::mark("first frame"); firstFrame = false; }
+
+        if (replaying && startupReported) {
+            // GPU results arrive frames in flight later; take each new "frame" sample once
+            time::FrameTiming ft;
+            ft.frame = replayFrame++; ft.t = replayTime;
+            ft.cpuMs = std::chrono::duration<float, std::milli>(time::clock::now() - frameStart).count();
+            uint64_t seq = 0;
+            float gpuMs = vk.gpuProfiler().latestMs("frame", &seq);
+            if (seq != gpuSeq) { ft.gpuMs = gpuMs; gpuSeq = seq; }
+            timings.add(ft);
+            if (uint64_t n = frameAllocs.allocations()) { replayAllocs += n; ++replayAllocFrames; }
+            replayTime += replayStep;
+            if (replayTime > path.duration()) {
+                if (timings.writeCsv(opts.csvPath)) eng::log::info("Wrote %s", opts.csvPath);
+                else eng::log::error("Failed to write %s", opts.csvPath);
+                timings.logSummary("Replay");
+                // The steady-state frame loop is meant to stay off the heap entirely
+                if (memory::countingEnabled() && replayAllocs) eng::log::warn("Replay: %llu heap allocations on the main thread in %u of %u frames", (unsigned long long)replayAllocs, replayAllocFrames, replayFrame);
+                else if (memory::countingEnabled()) eng::log::info("Replay: no heap allocations on the main thread");
+                glfwSetWindowShouldClose(window.handle(), 1);
+            }
+        }
     }
+    if (recording) path.save(opts.recordPath);
+    jobs::wait(terrainLoad); jobs::wait(sceneLoad); // closed before the content arrived; the loads still read through io
     vk.shutdown();
+    io::shutdown();
+    jobs::shutdown();
     eng::log::info("Goodbye.");
     return 0;
 }
@@ -0,0 +1,110 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// engine_bench harness: CPU-only micro/macro benchmarks of engine hot paths.
+//   ENG_BENCH(terrainGenerate, "terrain/generate") { setup...; st.setOps(n); st.measure([&] { work(); }); }
+//   eng::bench::add("ecs/emplace", 100000, &fn)   same, parameterized; the arg is appended to the name
+// measure() batches fast bodies until one repetition lasts Config::minRepMs, runs the warmup
+// repetitions, then times Config::reps repetitions. Results report the median and p95 per call,
+// ns per op (setOps) and bytes per op (setBytes). Setup outside measure() is not timed; a body
+// that must do untimed work on every call returns its own duration in ns (a double) instead.
+
+namespace eng::bench {
+    using clock = std::chrono::steady_clock;
+
+    struct Config {
+        uint32_t warmup = 2, reps = 15;
+        double minRepMs = 2.0;
+    };
+
+    template <class T> inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static const void* volatile sink; sink = &value;
+#endif
+    }
+
+    class State {
+    public:
+        State(const Config& cfg, uint64_t arg) : cfg_(cfg), arg_(arg) {}
+        uint64_t arg() const { return arg_; }
+        // Work done by one call of the measured body
+        void setOps(double ops) { ops_ = ops > 0.0 ? ops : 1.0; }
+        void setBytes(double bytes) { bytes_ = bytes; }
+
+        template <class F> void measure(F&& body) {
+            batch_ = 1;
+            for (;;) {
+                double ns = timeBatch(body, batch_);
+                if (ns >= cfg_.minRepMs * 1e6 || batch_ >= (1u << 24)) break;
+                double grow = ns > 0.0 ? cfg_.minRepMs * 1e6 / ns * 1.2 : 100.0;
+                batch_ = (uint32_t)std::min<double>(batch_ * std::clamp(grow, 2.0, 100.0), 1u << 24);
+            }
+            for (uint32_t i = 0; i < cfg_.warmup; ++i) timeBatch(body, batch_);
+            samples_.clear();
+            for (uint32_t i = 0; i < std::max(cfg_.reps, 1u); ++i) samples_.push_back(timeBatch(body, batch_) / batch_);
+        }
+
+        const std::vector<double>& samples() const { return samples_; } // ns per body call
+        uint32_t batch() const { return batch_; }
+        double ops() const { return ops_; }
+        double bytes() const { return bytes_; }
+    private:
+        Config cfg_;
+        uint64_t arg_;
+        double ops_ = 1.0, bytes_ = 0.0;
+        uint32_t batch_ = 1;
+        std::vector<double> samples_;
+
+        template <class F> static double timeBatch(F& body, uint32_t n) {
+            if constexpr (std::is_same_v<std::invoke_result_t<F&>, double>) {
+                double ns = 0.0;
+                for (uint32_t i = 0; i < n; ++i) ns += body();
+                return ns;
+            } else {
+                auto t0 = clock::now();
+                for (uint32_t i = 0; i < n; ++i) body();
+                return std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+            }
+        }
+    };
+
+    using Fn = void (*)(State&);
+    struct Entry { std::string name; Fn fn; uint64_t arg; };
+
+    inline std::vector<Entry>& registry() { static std::vector<Entry> r; return r; }
+    inline bool add(const char* name, Fn fn) { registry().push_back({ name, fn, 0 }); return true; }
+    inline bool add(const char* name, uint64_t arg, Fn fn) { registry().push_back({ std::string(name) + "/" + std::to_string(arg), fn, arg }); return true; }
+
+    struct Result {
+        std::string name;
+        double medianNs = 0.0, p95Ns = 0.0, minNs = 0.0; // per body call
+        double nsPerOp = 0.0, bytesPerOp = 0.0;
+        uint32_t reps = 0, batch = 0;
+    };
+
+    inline Result summarize(const std::string& name, const State& st) {
+        Result r; r.name = name; r.batch = st.batch();
+        std::vector<double> s = st.samples();
+        if (s.empty()) return r;
+        std::sort(s.begin(), s.end());
+        r.reps = (uint32_t)s.size();
+        r.minNs = s.front();
+        r.medianNs = s.size() % 2 ? s[s.size() / 2] : 0.5 * (s[s.size() / 2 - 1] + s[s.size() / 2]);
+        r.p95Ns = s[std::min(s.size() - 1, (size_t)(s.size() * 0.95))];
+        r.nsPerOp = r.medianNs / st.ops();
+        r.bytesPerOp = st.bytes() / st.ops();
+        return r;
+    }
+}
+
+#define ENG_BENCH(fn, name)                                              \
+    static void fn(::eng::bench::State& st);                             \
+    static const bool fn##Registered = ::eng::bench::add(name, &fn);     \
+    static void fn(::eng::bench::State& st)
@@ -0,0 +1,124 @@
+#include "bench.h"
+#include "datasets.h"
+#include "engine/scene/bvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace eng::bench;
+
+// Roughly old_town sized: 64 distinct 64x64 grid meshes (~254k triangles), 8 instances each
+namespace {
+    struct SceneFixture {
+        std::vector<eng::scene::Mesh> meshes = data::syntheticMeshes(64, 64, 8);
+        eng::scene::Bvh bvh;
+        std::vector<glm::vec3> origins, dirs;
+        SceneFixture() {
+            bvh.build(meshes);
+            // Rays from above the field aimed down into it, like picking from a raised camera
+            data::Rng rng(11);
+            glm::vec3 lo = bvh.bounds().lo, hi = bvh.bounds().hi;
+            for (int i = 0; i < 1024; ++i) {
+                origins.push_back({ rng.uniform(lo.x, hi.x), hi.y + 20.0f, rng.uniform(lo.z, hi.z) });
+                dirs.push_back({ rng.uniform(-0.5f, 0.5f), -1.0f, rng.uniform(-0.5f, 0.5f) });
+            }
+        }
+        static SceneFixture& get() { static SceneFixture f; return f; }
+    };
+
+    // Every triangle of every instance, the way a query had to be answered before
+    bool bruteForce(const std::vector<eng::scene::Mesh>& meshes, const glm::vec3& origin, const glm::vec3& dir, float maxT, float& best) {
+        bool found = false; best = maxT;
+        for (const auto& m : meshes)
+            for (const glm::mat4& xf : m.instances) {
+                glm::mat4 inv = glm::inverse(xf);
+                glm::vec3 o(inv * glm::vec4(origin, 1.0f)), d(inv * glm::vec4(dir, 0.0f));
+                for (size_t t = 0; t + 2 < m.indices.size(); t += 3) {
+                    glm::vec3 v0 = m.vertices[m.indices[t]].position;
+                    glm::vec3 e1 = m.vertices[m.indices[t + 1]].position - v0, e2 = m.vertices[m.indices[t + 2]].position - v0;
+                    glm::vec3 p = glm::cross(d, e2);
+                    float det = glm::dot(e1, p);
+                    if (std::abs(det) < 1e-12f) continue;
+                    glm::vec3 s = o - v0, q = glm::cross(s, e1);
+                    float u = glm::dot(s, p) / det, v = glm::dot(d, q) / det, th = glm::dot(e2, q) / det;
+                    if (u >= 0.0f && v >= 0.0f && u + v <= 1.0f && th > 0.0f && th < best) { best = th; found = true; }
+                }
+            }
+        return found;
+    }
+
+    // raycast() must agree with the brute force on hit or miss and on t; checked once per run on
+    // the first rays, outside the timed body
+    void expectBruteForce(const SceneFixture& f, size_t rays) {
+        for (size_t i = 0; i < rays; ++i) {
+            eng::scene::BvhHit h; float t = 0.0f;
+            bool a = f.bvh.raycast(f.origins[i], f.dirs[i], 1000.0f, h), b = bruteForce(f.meshes, f.origins[i], f.dirs[i], 1000.0f, t);
+            if (a != b || (a && std::abs(h.t - t) > 1e-3f * std::max(1.0f, t))) {
+                std::fprintf(stderr, "bvh: ray %zu: raycast %s t=%g, brute force %s t=%g\n", i, a ? "hit" : "missed", a ? h.t : 0.0f, b ? "hit" : "missed", b ? t : 0.0f);
+                std::abort();
+            }
+        }
+    }
+}
+
+// Ops are triangles
+ENG_BENCH(bvhBuild, "scene/bvh/build") {
+    auto& f = SceneFixture::get();
+    st.setOps((double)f.bvh.triangleCount());
+    st.measure([&] { eng::scene::Bvh b; b.build(f.meshes); doNotOptimize(b); });
+}
+
+// Ops are rays
+ENG_BENCH(bvhRaycast, "scene/bvh/raycast") {
+    auto& f = SceneFixture::get();
+    expectBruteForce(f, 8);
+    st.setOps((double)f.origins.size());
+    st.measure([&] {
+        uint32_t hits = 0;
+        for (size_t i = 0; i < f.origins.size(); ++i) { eng::scene::BvhHit h; hits += f.bvh.raycast(f.origins[i], f.dirs[i], 1000.0f, h); }
+        doNotOptimize(hits);
+    });
+}
+
+ENG_BENCH(bvhOccluded, "scene/bvh/occluded") {
+    auto& f = SceneFixture::get();
+    st.setOps((double)f.origins.size());
+    st.measure([&] {
+        uint32_t blocked = 0;
+        for (size_t i = 0; i < f.origins.size(); ++i) blocked += f.bvh.occluded(f.origins[i], f.origins[i] + f.dirs[i] * 200.0f);
+        doNotOptimize(blocked);
+    });
+}
+
+// Same rays without acceleration; only a few, it is that slow
+ENG_BENCH(bvhRaycastBrute, "scene/bvh/raycast_brute_force") {
+    auto& f = SceneFixture::get();
+    const size_t n = 4;
+    st.setOps((double)n);
+    st.measure([&] {
+        uint32_t hits = 0; float t;
+        for (size_t i = 0; i < n; ++i) hits += bruteForce(f.meshes, f.origins[i], f.dirs[i], 1000.0f, t);
+        doNotOptimize(hits);
+    });
+}
+
+// Move every other instance and refit the top level; ops are instances
+ENG_BENCH(bvhRefit, "scene/bvh/refit") {
+    auto& f = SceneFixture::get();
+    { eng::scene::Bvh empty; empty.build({}); empty.refit(); } // a tree with no instances is a single empty root
+    eng::scene::Bvh bvh; bvh.build(f.meshes);
+    float phase = 0.0f;
+    st.setOps((double)bvh.instances().size());
+    st.measure([&] {
+        phase += 0.1f;
+        for (uint32_t i = 0; i < (uint32_t)bvh.instances().size(); i += 2) {
+            glm::mat4 xf = bvh.instances()[i].transform;
+            xf[3].y = std::sin(phase + i);
+            bvh.setTransform(i, xf);
+        }
+        bvh.refit();
+        doNotOptimize(bvh);
+    });
+}
@@ -0,0 +1,264 @@
+#include "bench.h"
+#include "engine/ecs/ecs.h"
+#include "engine/ecs/dirty_ranges.h"
+#include "engine/ecs/snapshot.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace eng::bench;
+
+namespace {
+    struct Position { float x, y, z; };
+    struct Velocity { float x, y, z; };
+    struct Transform { float m[16]; };
+
+    // n entities with a Transform, mirrored into a flat "GPU" array indexed by entity - 1
+    struct SyncFixture {
+        eng::ecs::Registry reg;
+        std::vector<Transform> mirror;
+        eng::ecs::DirtyRanges dirty;
+        eng::ecs::Tick lastSync = 0;
+        uint64_t rng = 0x9E3779B97F4A7C15ull;
+        explicit SyncFixture(uint32_t n) : mirror(n) {
+            for (uint32_t i = 0; i < n; ++i) {
+                Transform t{}; t.m[0] = t.m[5] = t.m[10] = t.m[15] = 1.0f; t.m[12] = (float)i;
+                reg.emplace<Transform>(reg.create(), t);
+            }
+        }
+        // A frame of gameplay: `count` random transforms move
+        void simulate(uint32_t count) {
+            uint32_t n = (uint32_t)mirror.size();
+            for (uint32_t i = 0; i < count; ++i) {
+                rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+                reg.patch<Transform>((eng::ecs::Entity)(rng % n) + 1, [](Transform& t) { t.m[13] += 0.01f; });
+            }
+        }
+        // Copy only changed slots, coalesced into ranges; returns the slots copied
+        uint64_t syncChanged() {
+            reg.changed<Transform>(lastSync, [&](eng::ecs::Entity e, const Transform&) { dirty.mark(e - 1); });
+            auto& data = reg.getOrCreate<Transform>().data;
+            for (const auto& r : dirty.build(4))
+                for (uint32_t s = r.first; s < r.first + r.count; ++s) mirror[s] = data.find(s + 1)->second;
+            uint64_t copied = dirty.coveredSlots();
+            dirty.clear();
+            lastSync = reg.tick();
+            reg.advance();
+            return copied;
+        }
+        void syncAll() {
+            reg.each<Transform>([&](eng::ecs::Entity e, const Transform& t) { mirror[e - 1] = t; });
+            reg.advance();
+        }
+        bool matches() {
+            bool ok = true;
+            reg.each<Transform>([&](eng::ecs::Entity e, const Transform& t) { ok = ok && std::memcmp(&mirror[e - 1], &t, sizeof(t)) == 0; });
+            return ok;
+        }
+    };
+
+    // n entities with Position, Velocity and Transform: the raw-copy path of the snapshot format
+    void buildWorld(eng::ecs::Registry& reg, uint32_t n) {
+        for (uint32_t i = 0; i < n; ++i) {
+            eng::ecs::Entity e = reg.create();
+            Transform t{}; t.m[0] = t.m[5] = t.m[10] = t.m[15] = 1.0f; t.m[12] = (float)i;
+            reg.emplace<Position>(e, { (float)i, 0.0f, 0.0f });
+            reg.emplace<Velocity>(e, { 0.0f, 1.0f, 0.0f });
+            reg.emplace<Transform>(e, t);
+        }
+    }
+    eng::ecs::SnapshotTypes worldTypes() {
+        eng::ecs::SnapshotTypes types;
+        types.add<Position>("Position"); types.add<Velocity>("Velocity"); types.add<Transform>("Transform");
+        return types;
+    }
+    template <class T> bool sameComponents(const eng::ecs::Registry& a, const eng::ecs::Registry& b) {
+        const auto* sa = a.find<T>(); const auto* sb = b.find<T>();
+        if (!sa || !sb || sa->data.size() != sb->data.size()) return false;
+        for (const auto& [e, v] : sa->data) {
+            auto it = sb->data.find(e);
+            if (it == sb->data.end() || std::memcmp(&it->second, &v, sizeof(T)) != 0) return false;
+        }
+        return true;
+    }
+    void expectSameWorld(const eng::ecs::Registry& a, const eng::ecs::Registry& b, const char* what) {
+        if (sameComponents<Position>(a, b) && sameComponents<Velocity>(a, b) && sameComponents<Transform>(a, b) && a.nextEntity() == b.nextEntity()) return;
+        std::fprintf(stderr, "ecs: %s did not restore the saved world\n", what);
+        std::abort();
+    }
+}
+
+// create() + two emplace() per entity into a fresh registry; ops are entities
+static void ecsCreateEmplace(State& st) {
+    const uint32_t n = (uint32_t)st.arg();
+    st.setOps(n);
+    st.measure([&] {
+        eng::ecs::Registry reg;
+        for (uint32_t i = 0; i < n; ++i) {
+            eng::ecs::Entity e = reg.create();
+            reg.emplace<Position>(e, { (float)i, 0.0f, 0.0f });
+            reg.emplace<Velocity>(e, { 0.0f, 1.0f, 0.0f });
+        }
+        doNotOptimize(reg);
+    });
+}
+
+// Random-order component lookups by entity; ops are lookups
+static void ecsLookup(State& st) {
+    const uint32_t n = (uint32_t)st.arg();
+    eng::ecs::Registry reg;
+    std::vector<eng::ecs::Entity> order;
+    for (uint32_t i = 0; i < n; ++i) { eng::ecs::Entity e = reg.create(); reg.emplace<Position>(e, { (float)i, 0.0f, 0.0f }); order.push_back(e); }
+    uint64_t s = 0x9E3779B97F4A7C15ull;
+    for (uint32_t i = n; i > 1; --i) { s ^= s << 13; s ^= s >> 7; s ^= s << 17; std::swap(order[i - 1], order[s % i]); }
+    auto& positions = reg.getOrCreate<Position>().data;
+    st.setOps(n);
+    st.measure([&] {
+        float sum = 0.0f;
+        for (eng::ecs::Entity e : order) sum += positions.find(e)->second.x;
+        doNotOptimize(sum);
+    });
+}
+
+// Position += Velocity over every entity that has both, the typical system loop
+static void ecsIterate(State& st) {
+    const uint32_t n = (uint32_t)st.arg();
+    eng::ecs::Registry reg;
+    for (uint32_t i = 0; i < n; ++i) {
+        eng::ecs::Entity e = reg.create();
+        reg.emplace<Position>(e, { (float)i, 0.0f, 0.0f });
+        reg.emplace<Velocity>(e, { 0.0f, 1.0f, 0.0f });
+    }
+    auto& positions = reg.getOrCreate<Position>().data;
+    auto& velocities = reg.getOrCreate<Velocity>().data;
+    st.setOps(n);
+    st.setBytes((double)n * (sizeof(Position) + sizeof(Velocity)));
+    st.measure([&] {
+        for (auto& [e, p] : positions) {
+            auto v = velocities.find(e);
+            if (v == velocities.end()) continue;
+            p.x += v->second.x * 0.016f; p.y += v->second.y * 0.016f; p.z += v->second.z * 0.016f;
+        }
+        doNotOptimize(positions);
+    });
+}
+
+// Renderer-style sync of 100k transforms with 1% of them moving per frame: only the changed slots
+// are copied, versus re-copying everything. Ops are entities in the registry.
+static void ecsSyncChanged(State& st) {
+    SyncFixture f((uint32_t)st.arg());
+    f.syncChanged(); // initial upload: everything is new
+    st.setOps((double)f.mirror.size());
+    st.measure([&] { f.simulate((uint32_t)f.mirror.size() / 100); doNotOptimize(f.syncChanged()); });
+    if (!f.matches()) { std::fprintf(stderr, "ecs: change-driven mirror diverged\n"); std::abort(); }
+}
+
+static void ecsSyncFull(State& st) {
+    SyncFixture f((uint32_t)st.arg());
+    st.setOps((double)f.mirror.size());
+    st.measure([&] { f.simulate((uint32_t)f.mirror.size() / 100); f.syncAll(); doNotOptimize(f.mirror.data()); });
+}
+
+// World snapshots of n entities (three raw component types). Ops are entities; bytes are the
+// snapshot size, so bytes/op over ns/op is the throughput in GB/s.
+static void ecsSnapshotSave(State& st) {
+    eng::ecs::Registry reg;
+    buildWorld(reg, (uint32_t)st.arg());
+    auto types = worldTypes();
+    std::vector<uint8_t> bytes;
+    eng::ecs::saveSnapshot(reg, types, bytes); // sizes the buffer; later saves reuse it
+    st.setOps((double)st.arg());
+    st.setBytes((double)bytes.size());
+    st.measure([&] { eng::ecs::saveSnapshot(reg, types, bytes); doNotOptimize(bytes.data()); });
+}
+
+static void ecsSnapshotLoad(State& st) {
+    eng::ecs::Registry src, dst;
+    buildWorld(src, (uint32_t)st.arg());
+    auto types = worldTypes();
+    std::vector<uint8_t> bytes;
+    eng::ecs::saveSnapshot(src, types, bytes);
+    st.setOps((double)st.arg());
+    st.setBytes((double)bytes.size());
+    st.measure([&] { if (!eng::ecs::loadSnapshot(dst, types, bytes.data(), bytes.size())) std::abort(); });
+    expectSameWorld(src, dst, "snapshot_load");
+}
+
+// Through the file system: write, then map and load. The file stays in the page cache, so this is
+// the mmap path's cost over the in-memory load, not disk speed.
+static void ecsSnapshotFile(State& st) {
+    eng::ecs::Registry src, dst;
+    buildWorld(src, (uint32_t)st.arg());
+    auto types = worldTypes();
+    const std::string path = "bench_snapshot.ecss";
+    if (!eng::ecs::saveSnapshot(src, types, path)) std::abort();
+    eng::ecs::SnapshotInfo info;
+    st.setOps((double)st.arg());
+    st.measure([&] { if (!eng::ecs::loadSnapshot(dst, types, path, &info)) std::abort(); });
+    st.setBytes((double)info.bytes);
+    std::remove(path.c_str());
+    expectSameWorld(src, dst, "snapshot_load_file");
+}
+
+// A frame's delta with 1% of the transforms changed and a few entities gone, applied to a copy of
+// the base state; ops are entities in the world
+static void ecsSnapshotDelta(State& st) {
+    const uint32_t n = (uint32_t)st.arg();
+    eng::ecs::Registry src, dst;
+    buildWorld(src, n);
+    auto types = worldTypes();
+    std::vector<uint8_t> bytes;
+    eng::ecs::saveSnapshot(src, types, bytes);
+    eng::ecs::loadSnapshot(dst, types, bytes.data(), bytes.size());
+    uint64_t rng = 0x9E3779B97F4A7C15ull;
+    uint64_t size = 0;
+    st.setOps((double)n);
+    st.measure([&] {
+        eng::ecs::Tick base = src.tick();
+        src.advance();
+        for (uint32_t i = 0; i < n / 100; ++i) {
+            rng ^= rng << 13; rng ^= rng >> 7; rng ^= rng << 17;
+            src.patch<Transform>((eng::ecs::Entity)(rng % n) + 1, [](Transform& t) { t.m[13] += 0.01f; });
+        }
+        src.destroy((eng::ecs::Entity)(rng % n) + 1);
+        eng::ecs::saveSnapshot(src, types, bytes, base);
+        if (!eng::ecs::loadSnapshot(dst, types, bytes.data(), bytes.size())) std::abort();
+        size = bytes.size();
+    });
+    st.setBytes((double)size);
+    expectSameWorld(src, dst, "snapshot_delta");
+}
+
+// A delta against a base 100 ticks old, past the 64-tick retention window, with an entity destroyed
+// every tick: those removals are no longer logged, so the save falls back to a full snapshot and
+// the copy still loses them
+static void ecsSnapshotStaleDelta(State& st) {
+    const uint32_t n = (uint32_t)st.arg();
+    eng::ecs::Registry src, dst;
+    buildWorld(src, n);
+    auto types = worldTypes();
+    std::vector<uint8_t> bytes;
+    eng::ecs::saveSnapshot(src, types, bytes);
+    eng::ecs::loadSnapshot(dst, types, bytes.data(), bytes.size());
+    eng::ecs::Entity victim = 1;
+    eng::ecs::SnapshotInfo info;
+    st.setOps((double)n);
+    st.measure([&] {
+        eng::ecs::Tick base = src.tick();
+        for (int t = 0; t < 100; ++t) { src.advance(); src.destroy(victim++); }
+        eng::ecs::saveSnapshot(src, types, bytes, base);
+        if (!eng::ecs::loadSnapshot(dst, types, bytes.data(), bytes.size(), &info) || info.delta) std::abort();
+    });
+    st.setBytes((double)bytes.size());
+    expectSameWorld(src, dst, "snapshot_delta against a stale base");
+}
+
+static const bool ecsRegistered =
+    add("ecs/create_emplace", 10000, &ecsCreateEmplace) && add("ecs/create_emplace", 100000, &ecsCreateEmplace) &&
+    add("ecs/lookup", 10000, &ecsLookup) && add("ecs/lookup", 100000, &ecsLookup) &&
+    add("ecs/iterate", 10000, &ecsIterate) && add("ecs/iterate", 100000, &ecsIterate) &&
+    add("ecs/sync_changed", 100000, &ecsSyncChanged) && add("ecs/sync_full", 100000, &ecsSyncFull) &&
+    add("ecs/snapshot_save", 1000000, &ecsSnapshotSave) && add("ecs/snapshot_load", 1000000, &ecsSnapshotLoad) &&
+    add("ecs/snapshot_load_file", 1000000, &ecsSnapshotFile) && add("ecs/snapshot_delta", 1000000, &ecsSnapshotDelta) &&
+    add("ecs/snapshot_delta_stale", 100000, &ecsSnapshotStaleDelta);
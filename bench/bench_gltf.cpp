@@ -0,0 +1,22 @@
+// The loader is header-only tinygltf underneath; its implementation (and stb's) lives in this TU,
+// as it does in the sandbox's main.cpp
+#define TINYGLTF_IMPLEMENTATION
+#define STB_IMAGE_IMPLEMENTATION
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include "bench.h"
+#include "datasets.h"
+#include <cstdio>
+
+using namespace eng::bench;
+
+// Parse + decode + flatten of a procedural scene; ops are input vertices, bytes are file bytes
+static void gltfLoad(const char* name, uint32_t meshes, uint32_t gridN, uint32_t instances, State& st) {
+    data::GltfDataset ds = data::writeProceduralGltf(data::scratchDir(), name, meshes, gridN, instances);
+    if (ds.path.empty()) { std::fprintf(stderr, "gltf: cannot write %s dataset\n", name); return; }
+    st.setOps((double)ds.vertices);
+    st.setBytes((double)ds.fileBytes);
+    st.measure([&] { doNotOptimize(eng::scene::GltfLoader::load(ds.path).meshes.data()); });
+}
+
+ENG_BENCH(gltfLoadSmall, "gltf/load/small_16x32") { gltfLoad("small", 16, 32, 4, st); }
+ENG_BENCH(gltfLoadLarge, "gltf/load/large_64x128") { gltfLoad("large", 64, 128, 16, st); }
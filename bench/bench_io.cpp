@@ -0,0 +1,115 @@
+#include "bench.h"
+#include "engine/platform/async_io.h"
+#include <cstdio>
+#include <cstdlib>
+#include <optional>
+#include <string>
+#include <vector>
+#if defined(__linux__)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace eng::bench;
+using eng::io::Backend;
+using eng::io::FileData;
+
+// Asset-style reads: 64 files of 1 MiB (a scene's buffers and textures) and one 64 MiB file, read
+// one after another with readNow() or as a batch through the thread pool or io_uring. Ops are
+// files, bytes are file bytes. Warm runs read from the page cache and so measure the overhead of
+// each path; cold runs evict the files first (Linux only) and measure the device.
+namespace {
+    constexpr uint32_t kSmallFiles = 64;
+    constexpr size_t kSmallBytes = 1u << 20, kLargeBytes = 64u << 20;
+
+    uint8_t expected(size_t file, size_t i) { return (uint8_t)(i * 131 + (i >> 12) + file * 7); }
+
+    // In the working directory rather than the temp directory: /tmp is often tmpfs, which has no
+    // device behind it, so the cold runs would measure memory. Removed when the bench exits.
+    struct Files {
+        std::vector<std::string> small, large;
+        Files() {
+            for (uint32_t i = 0; i < kSmallFiles; ++i) small.push_back(write("bench_io_" + std::to_string(i) + ".bin", i, kSmallBytes));
+            large.push_back(write("bench_io_large.bin", kSmallFiles, kLargeBytes));
+        }
+        ~Files() {
+            for (const std::string& p : small) std::remove(p.c_str());
+            for (const std::string& p : large) std::remove(p.c_str());
+        }
+        static std::string write(std::string path, size_t file, size_t bytes) {
+            std::vector<uint8_t> data(bytes);
+            for (size_t i = 0; i < bytes; ++i) data[i] = expected(file, i);
+            std::FILE* f = std::fopen(path.c_str(), "wb");
+            bool ok = f && std::fwrite(data.data(), 1, bytes, f) == bytes;
+            if (f) ok = (std::fclose(f) == 0) && ok;
+            if (!ok) { std::fprintf(stderr, "io: cannot write %s\n", path.c_str()); std::abort(); }
+            return path;
+        }
+    };
+    Files& files() { static Files f; return f; }
+
+    // Drops the files from the page cache (written back first: dirty pages are not dropped). The
+    // open/fadvise calls are timed with the read, a few microseconds per file.
+    void evict(const std::vector<std::string>& paths) {
+#if defined(__linux__)
+        for (const std::string& p : paths) {
+            int fd = ::open(p.c_str(), O_RDONLY);
+            if (fd < 0) continue;
+            ::fdatasync(fd);
+            ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            ::close(fd);
+        }
+#else
+        (void)paths;
+#endif
+    }
+
+    // Restarts the service on one backend for the entry, then goes back to the default
+    struct UseBackend {
+        explicit UseBackend(Backend b) {
+            eng::io::shutdown();
+            eng::io::Config cfg; cfg.backend = b;
+            eng::io::init(cfg);
+            if (eng::io::backend() != b) std::fprintf(stderr, "io: %s unavailable, measuring %s\n", eng::io::backendName(b), eng::io::backendName(eng::io::backend()));
+        }
+        ~UseBackend() { eng::io::shutdown(); eng::io::init(); }
+    };
+
+    // Backend::Inline here means the loop of blocking readNow() calls loaders used before
+    void readFiles(State& st, Backend backend, bool large, bool cold) {
+        const std::vector<std::string>& paths = large ? files().large : files().small;
+        const size_t first = large ? kSmallFiles : 0, bytes = large ? kLargeBytes : kSmallBytes;
+        std::optional<UseBackend> use;
+        if (backend != Backend::Inline) use.emplace(backend);
+        std::vector<FileData> got;
+        st.setOps((double)paths.size());
+        st.setBytes((double)(paths.size() * bytes));
+        st.measure([&] {
+            if (cold) evict(paths);
+            got.clear();
+            if (backend == Backend::Inline) for (const std::string& p : paths) got.push_back(eng::io::readNow(p));
+            else for (auto& f : eng::io::readBatch(paths)) got.push_back(f.get());
+            doNotOptimize(got.data());
+        });
+        for (size_t f = 0; f < got.size(); ++f) {
+            bool ok = got[f].ok() && got[f].bytes.size() == bytes;
+            for (size_t i = 0; ok && i < bytes; ++i) ok = got[f].bytes[i] == expected(first + f, i);
+            if (!ok) { std::fprintf(stderr, "io: %s read back wrong (error %d, %zu bytes)\n", got[f].path.c_str(), got[f].error, got[f].bytes.size()); std::abort(); }
+        }
+    }
+}
+
+ENG_BENCH(ioSmallWarmSync, "io/files_64x1MiB/warm/sync") { readFiles(st, Backend::Inline, false, false); }
+ENG_BENCH(ioSmallWarmThreads, "io/files_64x1MiB/warm/thread_pool") { readFiles(st, Backend::ThreadPool, false, false); }
+ENG_BENCH(ioSmallWarmUring, "io/files_64x1MiB/warm/io_uring") { readFiles(st, Backend::IoUring, false, false); }
+ENG_BENCH(ioLargeWarmSync, "io/file_64MiB/warm/sync") { readFiles(st, Backend::Inline, true, false); }
+ENG_BENCH(ioLargeWarmThreads, "io/file_64MiB/warm/thread_pool") { readFiles(st, Backend::ThreadPool, true, false); }
+ENG_BENCH(ioLargeWarmUring, "io/file_64MiB/warm/io_uring") { readFiles(st, Backend::IoUring, true, false); }
+#if defined(__linux__)
+ENG_BENCH(ioSmallColdSync, "io/files_64x1MiB/cold/sync") { readFiles(st, Backend::Inline, false, true); }
+ENG_BENCH(ioSmallColdThreads, "io/files_64x1MiB/cold/thread_pool") { readFiles(st, Backend::ThreadPool, false, true); }
+ENG_BENCH(ioSmallColdUring, "io/files_64x1MiB/cold/io_uring") { readFiles(st, Backend::IoUring, false, true); }
+ENG_BENCH(ioLargeColdSync, "io/file_64MiB/cold/sync") { readFiles(st, Backend::Inline, true, true); }
+ENG_BENCH(ioLargeColdThreads, "io/file_64MiB/cold/thread_pool") { readFiles(st, Backend::ThreadPool, true, true); }
+ENG_BENCH(ioLargeColdUring, "io/file_64MiB/cold/io_uring") { readFiles(st, Backend::IoUring, true, true); }
+#endif
@@ -0,0 +1,116 @@
+#include "bench.h"
+#include "engine/core/jobs.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace eng::bench;
+
+// The job system has no test target; these entries check their own results and abort on a wrong
+// one, so every bench run doubles as a stress run of the scheduler.
+namespace {
+    void check(bool ok, const char* what) {
+        if (ok) return;
+        std::fprintf(stderr, "jobs: %s\n", what);
+        std::abort();
+    }
+}
+
+// Scheduling overhead: ops are empty jobs submitted from the main thread and waited for
+ENG_BENCH(jobsEmpty, "jobs/empty_submit_wait") {
+    const int n = 1024;
+    std::atomic<int> ran{0};
+    st.setOps(n);
+    st.measure([&] {
+        ran.store(0, std::memory_order_relaxed);
+        eng::jobs::Group g;
+        for (int i = 0; i < n; ++i) eng::jobs::run(g, [&] { ran.fetch_add(1, std::memory_order_relaxed); });
+        eng::jobs::wait(g);
+        check(ran.load() == n, "empty jobs lost");
+    });
+}
+
+// Jobs spawning jobs: a binary tree of depth 12, so most submissions come from workers' own deques
+ENG_BENCH(jobsTree, "jobs/spawn_tree") {
+    struct Tree {
+        static void spawn(eng::jobs::Group& g, std::atomic<int>& leaves, int depth) {
+            if (depth == 0) { leaves.fetch_add(1, std::memory_order_relaxed); return; }
+            eng::jobs::run(g, [&g, &leaves, depth] { spawn(g, leaves, depth - 1); });
+            eng::jobs::run(g, [&g, &leaves, depth] { spawn(g, leaves, depth - 1); });
+        }
+    };
+    const int depth = 12;
+    std::atomic<int> leaves{0};
+    st.setOps((double)(2 << depth) - 2);
+    st.measure([&] {
+        leaves.store(0, std::memory_order_relaxed);
+        eng::jobs::Group g;
+        Tree::spawn(g, leaves, depth);
+        eng::jobs::wait(g);
+        check(leaves.load() == 1 << depth, "spawn tree lost leaves");
+    });
+}
+
+// Ops are elements; a light body, so chunking overhead shows
+ENG_BENCH(jobsParallelFor, "jobs/parallel_for_sum") {
+    const size_t n = 1 << 20;
+    std::vector<uint32_t> values(n);
+    uint64_t expected = 0;
+    for (size_t i = 0; i < n; ++i) { values[i] = (uint32_t)(i * 2654435761u >> 16); expected += values[i]; }
+    st.setOps((double)n);
+    st.setBytes((double)n * sizeof(uint32_t));
+    st.measure([&] {
+        std::atomic<uint64_t> sum{0};
+        eng::jobs::parallelFor(0, n, [&](size_t b, size_t e) {
+            uint64_t s = 0;
+            for (size_t i = b; i < e; ++i) s += values[i];
+            sum.fetch_add(s, std::memory_order_relaxed);
+        });
+        check(sum.load() == expected, "parallelFor sum mismatch");
+    });
+}
+
+// Dependency counters: 32 stages of 16 jobs, each stage scheduled by after() on the previous one.
+// Every job checks that the whole previous stage finished before it started. Ops are jobs.
+ENG_BENCH(jobsChain, "jobs/dependency_chain") {
+    const int stages = 32, width = 16;
+    st.setOps((double)stages * width);
+    st.measure([&] {
+        std::vector<std::atomic<int>> done(stages);
+        for (auto& d : done) d.store(0, std::memory_order_relaxed);
+        std::vector<eng::jobs::Group> groups(stages);
+        for (int s = 0; s < stages; ++s)
+            for (int j = 0; j < width; ++j) {
+                auto body = [&done, s, width] {
+                    check(s == 0 || done[s - 1].load(std::memory_order_acquire) == width, "stage started before its dependency");
+                    done[s].fetch_add(1, std::memory_order_acq_rel);
+                };
+                if (s == 0) eng::jobs::run(groups[0], body);
+                else eng::jobs::after(groups[s - 1], groups[s], body);
+            }
+        eng::jobs::wait(groups[stages - 1]);
+        for (int s = 0; s < stages - 1; ++s) eng::jobs::wait(groups[s]); // groups must be done before destruction
+        check(done[stages - 1].load() == width, "dependency chain incomplete");
+    });
+}
+
+// Main-thread affinity: workers post jobs that only the main thread may run, as GLFW calls would be
+ENG_BENCH(jobsMain, "jobs/main_thread_roundtrip") {
+    const int n = 64;
+    st.setOps(n);
+    st.measure([&] {
+        std::atomic<int> onMain{0};
+        eng::jobs::Group workers, mainJobs;
+        for (int i = 0; i < n; ++i)
+            eng::jobs::run(workers, [&] {
+                eng::jobs::runOnMain(mainJobs, [&] {
+                    check(!eng::jobs::running() || eng::jobs::threadIndex() == 0, "main-thread job ran on a worker");
+                    onMain.fetch_add(1, std::memory_order_relaxed);
+                });
+            });
+        eng::jobs::wait(workers);
+        eng::jobs::wait(mainJobs);
+        check(onMain.load() == n, "main-thread jobs lost");
+    });
+}
@@ -0,0 +1,111 @@
+#include "bench.h"
+#include "engine/core/log.h"
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace eng::bench;
+
+// What a thread pays per eng::log call while others log at the same time. Each repetition every
+// thread logs a burst and times only its own calls; the backend is flushed between repetitions
+// (untimed), so the bursts land in drained rings and never take the drop path. Ops are messages
+// per thread, so ns/op is the mean caller latency of one call. The fprintf entries are the
+// synchronous path logging used before: every call formats under the shared stream lock.
+namespace {
+    constexpr uint32_t kBurst = 1000; // ~64 KB of records, well inside the 256 KB per-thread ring
+
+    // Threads kept across repetitions (a thread's log ring is created by its first message). run()
+    // wakes them all, each runs the work once, and returns their mean duration in ns.
+    class Crew {
+    public:
+        Crew(uint32_t threads, std::function<double()> work) : work_(std::move(work)) {
+            for (uint32_t i = 0; i < threads; ++i) threads_.emplace_back([this] { loop(); });
+        }
+        ~Crew() {
+            { std::lock_guard<std::mutex> lock(mutex_); stop_ = true; }
+            start_.notify_all();
+            for (std::thread& t : threads_) t.join();
+        }
+        double run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ++generation_; pending_ = (uint32_t)threads_.size(); totalNs_ = 0.0;
+            start_.notify_all();
+            done_.wait(lock, [&] { return pending_ == 0; });
+            return totalNs_ / threads_.size();
+        }
+    private:
+        void loop() {
+            uint64_t seen = 0;
+            for (;;) {
+                {
+                    std::unique_lock<std::mutex> lock(mutex_);
+                    start_.wait(lock, [&] { return stop_ || generation_ != seen; });
+                    if (stop_) return;
+                    seen = generation_;
+                }
+                double ns = work_();
+                std::lock_guard<std::mutex> lock(mutex_);
+                totalNs_ += ns;
+                if (--pending_ == 0) done_.notify_one();
+            }
+        }
+        std::function<double()> work_;
+        std::vector<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable start_, done_;
+        uint64_t generation_ = 0;
+        uint32_t pending_ = 0;
+        double totalNs_ = 0.0;
+        bool stop_ = false;
+    };
+
+    template <class F> double timed(F&& f) {
+        auto t0 = clock::now();
+        f();
+        return std::chrono::duration<double, std::nano>(clock::now() - t0).count();
+    }
+
+    // Messages are formatted but not printed: the console sink is off for the entry
+    struct QuietLog {
+        eng::log::Level level = eng::log::level();
+        QuietLog() { eng::log::flush(); eng::log::setConsole(false); eng::log::setLevel(eng::log::Level::Info); }
+        ~QuietLog() { eng::log::flush(); eng::log::setLevel(level); eng::log::setConsole(true); }
+    };
+}
+
+static void logAsync(State& st) {
+    QuietLog quiet;
+    Crew crew((uint32_t)st.arg(), [] {
+        return timed([] { for (uint32_t i = 0; i < kBurst; ++i) eng::log::info("frame %u: %-12s %8.3f ms", i, "visibility", 1.25 + i); });
+    });
+    st.setOps(kBurst);
+    st.measure([&] { eng::log::flush(); return crew.run(); });
+}
+
+static void logSyncFprintf(State& st) {
+#if defined(_WIN32)
+    std::FILE* sink = std::fopen("NUL", "w");
+#else
+    std::FILE* sink = std::fopen("/dev/null", "w");
+#endif
+    if (!sink) { std::fprintf(stderr, "log: cannot open the null device\n"); return; }
+    Crew crew((uint32_t)st.arg(), [sink] {
+        return timed([sink] { for (uint32_t i = 0; i < kBurst; ++i) std::fprintf(sink, "frame %u: %-12s %8.3f ms\n", i, "visibility", 1.25 + i); });
+    });
+    st.setOps(kBurst);
+    st.measure([&] { return crew.run(); });
+    std::fclose(sink);
+}
+
+// A call below the runtime level: the cost every disabled debug line still pays
+ENG_BENCH(logFiltered, "log/filtered") {
+    st.setOps(kBurst);
+    st.measure([] { for (uint32_t i = 0; i < kBurst; ++i) eng::log::debug("frame %u: %-12s %8.3f ms", i, "visibility", 1.25 + i); });
+}
+
+static const bool logRegistered =
+    add("log/async_info", 1, &logAsync) && add("log/async_info", 4, &logAsync) &&
+    add("log/sync_fprintf", 1, &logSyncFprintf) && add("log/sync_fprintf", 4, &logSyncFprintf);
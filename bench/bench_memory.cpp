@@ -0,0 +1,102 @@
+#include "bench.h"
+#include "engine/core/memory.h"
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+using namespace eng::bench;
+using namespace eng::memory;
+
+// Ops are allocations; each call allocates a batch and frees it, like a frame's worth of small objects
+namespace {
+    constexpr int kBatch = 1024;
+    constexpr size_t kObject = 64;
+
+    // With ENGINE_COUNT_ALLOCATIONS, the arena and pool paths must not touch the heap once warm.
+    // Checked on one extra call outside measure(), whose sample bookkeeping allocates.
+    template <class F> void expectNoHeap(F& body, const char* what) {
+        AllocationScope scope;
+        body();
+        if (!countingEnabled() || scope.allocations() == 0) return;
+        std::fprintf(stderr, "memory: %s allocated %llu times from the heap\n", what, (unsigned long long)scope.allocations());
+        std::abort();
+    }
+}
+
+ENG_BENCH(memoryHeap, "memory/heap_new_delete") {
+    std::vector<void*> ptrs(kBatch);
+    st.setOps(kBatch);
+    st.measure([&] {
+        for (auto& p : ptrs) { p = ::operator new(kObject); doNotOptimize(p); }
+        for (void* p : ptrs) ::operator delete(p);
+    });
+}
+
+ENG_BENCH(memoryPool, "memory/pool_alloc_free") {
+    std::vector<void*> ptrs(kBatch);
+    for (auto& p : ptrs) p = poolAllocate(kObject); // warm: the pages exist before timing
+    for (void* p : ptrs) poolDeallocate(p, kObject);
+    st.setOps(kBatch);
+    auto body = [&] {
+        for (auto& p : ptrs) { p = poolAllocate(kObject); doNotOptimize(p); }
+        for (void* p : ptrs) poolDeallocate(p, kObject);
+    };
+    st.measure(body);
+    expectNoHeap(body, "pool_alloc_free");
+}
+
+ENG_BENCH(memoryArena, "memory/arena_alloc_reset") {
+    LinearArena arena(kBatch * kObject);
+    st.setOps(kBatch);
+    auto body = [&] {
+        for (int i = 0; i < kBatch; ++i) doNotOptimize(arena.allocate(kObject, 16));
+        arena.reset();
+    };
+    st.measure(body);
+    expectNoHeap(body, "arena_alloc_reset");
+}
+
+// A per-frame list built by push_back: the heap vector regrows from empty every frame
+ENG_BENCH(memoryVectorHeap, "memory/frame_vector_heap") {
+    st.setOps(4096);
+    st.measure([&] {
+        std::vector<uint32_t> v;
+        for (uint32_t i = 0; i < 4096; ++i) v.push_back(i);
+        doNotOptimize(v.data());
+    });
+}
+
+ENG_BENCH(memoryVectorArena, "memory/frame_vector_arena") {
+    FrameArena frames(2, 64 * 1024);
+    uint64_t frame = 0;
+    st.setOps(4096);
+    auto body = [&] {
+        frames.beginFrame(frame++);
+        ArenaVector<uint32_t> v{ ArenaAllocator<uint32_t>(frames.current()) };
+        for (uint32_t i = 0; i < 4096; ++i) v.push_back(i);
+        doNotOptimize(v.data());
+    };
+    st.measure(body); // grows both slots to the high-water mark
+    expectNoHeap(body, "frame_vector_arena");
+}
+
+// Node containers: 1024 map inserts and the teardown
+ENG_BENCH(memoryMapHeap, "memory/map_heap") {
+    st.setOps(kBatch);
+    st.measure([&] {
+        std::map<uint32_t, uint32_t> m;
+        for (uint32_t i = 0; i < kBatch; ++i) m.emplace(i * 2654435761u, i);
+        doNotOptimize(m.size());
+    });
+}
+
+ENG_BENCH(memoryMapPool, "memory/map_pool") {
+    using PoolMap = std::map<uint32_t, uint32_t, std::less<uint32_t>, PoolAllocator<std::pair<const uint32_t, uint32_t>>>;
+    st.setOps(kBatch);
+    st.measure([&] {
+        PoolMap m;
+        for (uint32_t i = 0; i < kBatch; ++i) m.emplace(i * 2654435761u, i);
+        doNotOptimize(m.size());
+    });
+}
@@ -0,0 +1,239 @@
+#include "bench.h"
+#include "datasets.h"
+#include "engine/renderer/hiz_reference.h"
+#include "engine/renderer/light_clusters.h"
+#include "engine/renderer/mesh_packing.h"
+#include "engine/renderer/range_allocator.h"
+#include "engine/renderer/render_queue.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace eng::bench;
+using namespace eng::renderer;
+
+// Keys shaped like a real frame: a few pipelines, a few hundred materials, random depths
+static std::vector<uint64_t> drawKeys(uint32_t n) {
+    data::Rng rng(42);
+    std::vector<uint64_t> keys(n);
+    for (auto& k : keys) k = sortkey::opaque(DrawPass::Opaque, rng.below(6), rng.below(300), rng.below(1u << sortkey::kDepthBits));
+    return keys;
+}
+
+static void renderQueueSort(State& st) {
+    std::vector<uint64_t> keys = drawKeys((uint32_t)st.arg());
+    RenderQueue q; q.reserve(keys.size());
+    st.setOps((double)keys.size());
+    st.setBytes((double)keys.size() * sizeof(RenderItem));
+    st.measure([&] {
+        q.clear();
+        for (uint32_t i = 0; i < (uint32_t)keys.size(); ++i) q.push(keys[i], i);
+        q.sort();
+        doNotOptimize(q.items().data());
+    });
+}
+
+// Comparison baseline for the radix sort: std::stable_sort on the same items
+static void renderQueueStdSort(State& st) {
+    std::vector<uint64_t> keys = drawKeys((uint32_t)st.arg());
+    std::vector<RenderItem> items; items.reserve(keys.size());
+    st.setOps((double)keys.size());
+    st.setBytes((double)keys.size() * sizeof(RenderItem));
+    st.measure([&] {
+        items.clear();
+        for (uint32_t i = 0; i < (uint32_t)keys.size(); ++i) items.push_back({ keys[i], i });
+        std::stable_sort(items.begin(), items.end(), [](const RenderItem& a, const RenderItem& b) { return a.key < b.key; });
+        doNotOptimize(items.data());
+    });
+}
+
+// Steady-state churn in a half-full arena: free a random live range, allocate one of random size.
+// Ops are allocate+free pairs.
+ENG_BENCH(rangeAllocatorChurn, "renderer/range_allocator/churn") {
+    const uint32_t live = 4096, steps = 4096;
+    const uint64_t stride = sizeof(eng::scene::MeshVertex);
+    RangeAllocator a;
+    std::vector<std::pair<uint64_t, uint64_t>> ranges;
+    data::Rng rng(7);
+    st.setOps(steps);
+    st.measure([&] {
+        a.reset(64ull << 20);
+        ranges.clear();
+        for (uint32_t i = 0; i < live; ++i) { uint64_t size = (1 + rng.below(1024)) * stride; ranges.push_back({ a.allocate(size, stride), size }); }
+        for (uint32_t i = 0; i < steps; ++i) {
+            auto& r = ranges[rng.below(live)];
+            a.free(r.first, r.second);
+            r.second = (1 + rng.below(1024)) * stride;
+            r.first = a.allocate(r.second, stride);
+        }
+        doNotOptimize(a.used());
+    });
+}
+
+// packMeshes, the CPU side of VulkanRenderer::createMeshGeometry, into a host-memory arena.
+// Ops are source vertices, bytes are geometry bytes written.
+static void meshPacking(State& st) {
+    std::vector<eng::scene::Mesh> meshes = data::syntheticMeshes((uint32_t)st.arg(), 64, 8);
+    size_t vertices = 0, bytes = 0;
+    for (const auto& m : meshes) {
+        vertices += m.vertices.size();
+        bytes += m.vertices.size() * sizeof(eng::scene::MeshVertex) + m.indices.size() * sizeof(uint32_t) + m.instances.size() * sizeof(GpuInstance);
+    }
+    RangeAllocator a;
+    std::vector<uint8_t> memory(bytes * 2);
+    MeshArena arena;
+    arena.allocate = [&](uint64_t size, uint64_t alignment) { return a.allocate(size, alignment); };
+    arena.base = memory.data();
+    auto material = [](int m) { return (uint32_t)(m + 1); };
+    PackedGeometry packed;
+    st.setOps((double)vertices);
+    st.setBytes((double)bytes);
+    st.measure([&] {
+        a.reset(memory.size());
+        if (!packMeshes(meshes, arena, material, packed)) std::abort();
+        doNotOptimize(memory.data());
+    });
+}
+
+// The CPU references have no test target: the entries timing them first check them once, outside
+// the timed body, and abort on a wrong result
+namespace {
+    // assignLightsReference() against the lookup the shaders do: a point inside a light's range,
+    // projected to the screen and binned with clusterIndex(), must find the light in its cluster's
+    // list unless that list is full. Lists never exceed kMaxLightsPerCluster and are ascending.
+    void checkClusters(const ClusterParams& p, const glm::mat4& view, const glm::mat4& proj, const std::vector<GpuLight>& lights, uint64_t seed) {
+        std::vector<uint32_t> counts, indices;
+        assignLightsReference(p, lights, counts, indices);
+        for (uint32_t c = 0; c < kClusterCount; ++c) {
+            bool ok = counts[c] <= kMaxLightsPerCluster;
+            for (uint32_t k = 0; ok && k < counts[c]; ++k) {
+                uint32_t i = indices[(size_t)c * kMaxLightsPerCluster + k];
+                ok = i < lights.size() && (k == 0 || i > indices[(size_t)c * kMaxLightsPerCluster + k - 1]);
+            }
+            if (!ok) { std::fprintf(stderr, "renderer: cluster %u has a bad light list (%u lights)\n", c, counts[c]); std::abort(); }
+        }
+        data::Rng rng(seed);
+        uint32_t tested = 0;
+        for (uint32_t i = 0; i < (uint32_t)lights.size(); ++i) {
+            const GpuLight& l = lights[i];
+            for (int s = 0; s < 16; ++s) {
+                // Strictly inside the range, so rounding at a cluster face cannot decide the outcome
+                glm::vec3 d(rng.uniform(-1.0f, 1.0f), rng.uniform(-1.0f, 1.0f), rng.uniform(-1.0f, 1.0f));
+                if (glm::dot(d, d) > 1.0f) continue;
+                glm::vec3 world = glm::vec3(l.position[0], l.position[1], l.position[2]) + d * (l.range * 0.98f);
+                glm::vec4 v = view * glm::vec4(world, 1.0f), clip = proj * v;
+                float depth = -v.z;
+                if (clip.w <= 0.0f || depth < p.screen[2] || depth > p.screen[3]) continue;
+                float px = (clip.x / clip.w * 0.5f + 0.5f) * p.screen[0], py = (clip.y / clip.w * 0.5f + 0.5f) * p.screen[1];
+                if (px < 0.0f || py < 0.0f || px >= p.screen[0] || py >= p.screen[1]) continue;
+                uint32_t c = clusterIndex(p, px, py, depth);
+                if (counts[c] == kMaxLightsPerCluster) continue; // full: later lights may be dropped
+                const uint32_t* list = &indices[(size_t)c * kMaxLightsPerCluster];
+                if (!std::binary_search(list, list + counts[c], i)) {
+                    std::fprintf(stderr, "renderer: light %u reaches (%.1f, %.1f) at depth %.2f but is not listed in cluster %u\n", i, px, py, depth, c);
+                    std::abort();
+                }
+                ++tested;
+            }
+        }
+        if (tested == 0) { std::fprintf(stderr, "renderer: no light sample landed on screen\n"); std::abort(); }
+    }
+
+    // buildHiZReference() on a w x h buffer against rules that do not reuse its region math: every
+    // texel holds at least the max of the depth texels its footprint touches (the footprint of
+    // level 0 is exact), later levels halve exactly (2x2 blocks, 2x1 once an axis is down to 1),
+    // and the 1x1 top is the global max. Returns the widest level 0 region seen.
+    uint32_t checkHiZ(uint32_t w, uint32_t h, uint64_t seed) {
+        std::vector<float> depth((size_t)w * h);
+        data::Rng rng(seed);
+        for (auto& d : depth) d = rng.uniform(0.0f, 0.5f);
+        depth[rng.below(w * h)] = 1.0f; // one far texel, which must reach the top
+        auto levels = buildHiZReference(depth.data(), w, h);
+        auto fail = [&](const char* what, size_t level) {
+            std::fprintf(stderr, "renderer: Hi-Z of %ux%u: %s at level %zu\n", w, h, what, level);
+            std::abort();
+        };
+        uint32_t lw = hizLevel0Size(w), lh = hizLevel0Size(h), pw = 0, widest = 0;
+        if (levels.size() != hizLevelCount(lw, lh)) fail("wrong level count", levels.size());
+        for (size_t L = 0; L < levels.size(); ++L) {
+            if (levels[L].size() != (size_t)lw * lh) fail("wrong level size", L);
+            for (uint32_t y = 0; y < lh; ++y)
+                for (uint32_t x = 0; x < lw; ++x) {
+                    uint64_t x0 = (uint64_t)x * w / lw, x1 = ((uint64_t)(x + 1) * w + lw - 1) / lw;
+                    uint64_t y0 = (uint64_t)y * h / lh, y1 = ((uint64_t)(y + 1) * h + lh - 1) / lh;
+                    float direct = 0.0f;
+                    for (uint64_t sy = y0; sy < y1; ++sy)
+                        for (uint64_t sx = x0; sx < x1; ++sx) direct = std::max(direct, depth[sy * w + sx]);
+                    float v = levels[L][(size_t)y * lw + x];
+                    if (v < direct) fail("a depth texel was dropped", L);
+                    if (L == 0) {
+                        if (v != direct) fail("level 0 differs from its footprint", L);
+                        widest = std::max(widest, (uint32_t)std::max(x1 - x0, y1 - y0));
+                        continue;
+                    }
+                    const std::vector<float>& prev = levels[L - 1];
+                    uint32_t sx = pw == lw ? 1 : 2, sy = prev.size() / pw == lh ? 1 : 2;
+                    float children = 0.0f;
+                    for (uint32_t cy = 0; cy < sy; ++cy)
+                        for (uint32_t cx = 0; cx < sx; ++cx) children = std::max(children, prev[(size_t)(y * sy + cy) * pw + x * sx + cx]);
+                    if (v != children) fail("not the max of the level below", L);
+                }
+            pw = lw;
+            lw = std::max(lw / 2, 1u); lh = std::max(lh / 2, 1u);
+        }
+        if (levels.back().size() != 1 || levels.back()[0] != 1.0f) fail("the top is not the global max", levels.size() - 1);
+        return widest;
+    }
+}
+
+// CPU reference of the light binning compute pass at 1080p; ops are lights
+static void clusterAssign(State& st) {
+    std::vector<GpuLight> lights = data::randomLights((uint32_t)st.arg(), 80.0f, 99);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 8.0f, 60.0f), glm::vec3(0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::mat4 proj = glm::perspective(glm::radians(60.0f), 1920.0f / 1080.0f, 0.1f, 500.0f);
+    ClusterParams p = makeClusterParams(view, proj, 0.1f, 500.0f, 1920.0f, 1080.0f, (uint32_t)lights.size());
+    checkClusters(p, view, proj, lights, 5);
+    {
+        // Random cameras, and a crowd of lights in a small volume so full clusters are covered too
+        data::Rng rng(st.arg());
+        for (int i = 0; i < 4; ++i) {
+            glm::vec3 eye(rng.uniform(-60.0f, 60.0f), rng.uniform(1.0f, 30.0f), rng.uniform(-60.0f, 60.0f));
+            glm::vec3 target(rng.uniform(-20.0f, 20.0f), 0.0f, rng.uniform(-20.0f, 20.0f));
+            glm::mat4 v = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+            std::vector<GpuLight> set = i == 3 ? data::randomLights(2048, 6.0f, 17) : lights;
+            checkClusters(makeClusterParams(v, proj, 0.1f, 500.0f, 1920.0f, 1080.0f, (uint32_t)set.size()), v, proj, set, 6 + i);
+        }
+    }
+    std::vector<uint32_t> counts, indices;
+    st.setOps((double)lights.size());
+    st.measure([&] {
+        assignLightsReference(p, lights, counts, indices);
+        doNotOptimize(counts.data());
+    });
+}
+
+// Max-reduction pyramid of a 1080p depth buffer; ops are source texels
+ENG_BENCH(hizReference1080p, "renderer/hiz_reference/1920x1080") {
+    // Powers of two, non-powers of two (ratios near 2 give the 3x3 regions of level 0), one-texel
+    // axes and chains of odd length
+    const uint32_t sizes[][2] = { {1, 1}, {3, 3}, {5, 3}, {37, 5}, {64, 64}, {600, 7}, {1023, 1}, {1, 777}, {1920, 1080} };
+    uint32_t widest = 0;
+    for (const auto& s : sizes) widest = std::max(widest, checkHiZ(s[0], s[1], s[0] * 31 + s[1]));
+    if (widest != 3) { std::fprintf(stderr, "renderer: Hi-Z checks never reached a 3x3 region\n"); std::abort(); }
+
+    const uint32_t w = 1920, h = 1080;
+    std::vector<float> depth((size_t)w * h);
+    data::Rng rng(3);
+    for (auto& d : depth) d = rng.uniform(0.0f, 1.0f);
+    st.setOps((double)depth.size());
+    st.setBytes((double)depth.size() * sizeof(float));
+    st.measure([&] { doNotOptimize(buildHiZReference(depth.data(), w, h).back().data()); });
+}
+
+static const bool rendererRegistered =
+    add("renderer/render_queue/radix_sort", 10000, &renderQueueSort) && add("renderer/render_queue/radix_sort", 100000, &renderQueueSort) &&
+    add("renderer/render_queue/std_stable_sort", 10000, &renderQueueStdSort) && add("renderer/render_queue/std_stable_sort", 100000, &renderQueueStdSort) &&
+    add("renderer/mesh_packing/meshes", 16, &meshPacking) && add("renderer/mesh_packing/meshes", 128, &meshPacking) &&
+    add("renderer/cluster_assign/lights", 256, &clusterAssign) && add("renderer/cluster_assign/lights", 1024, &clusterAssign);
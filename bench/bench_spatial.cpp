@@ -0,0 +1,159 @@
+#include "bench.h"
+#include "datasets.h"
+#include "engine/core/jobs.h"
+#include "engine/ecs/spatial_hash.h"
+#include "engine/scene/transform.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace eng::bench;
+using eng::ecs::Entity;
+using eng::scene::Transform;
+
+// 100k entities wandering over a 2 km square (about 30 within 20 m of a point), queried the way
+// gameplay does: who is near this point, who are my 8 closest neighbours
+namespace {
+    constexpr uint32_t kQueries = 256;
+    constexpr float kExtent = 1000.0f, kRadius = 20.0f;
+
+    struct WorldFixture {
+        eng::ecs::Registry reg;
+        eng::ecs::SpatialHash grid{ 16.0f };
+        std::vector<glm::vec3> queries;
+        data::Rng rng{ 5 };
+        explicit WorldFixture(uint32_t n) {
+            for (uint32_t i = 0; i < n; ++i) {
+                Transform t;
+                t.position = { rng.uniform(-kExtent, kExtent), rng.uniform(0.0f, 10.0f), rng.uniform(-kExtent, kExtent) };
+                reg.emplace<Transform>(reg.create(), t);
+            }
+            for (uint32_t i = 0; i < kQueries; ++i) queries.push_back({ rng.uniform(-kExtent, kExtent), 5.0f, rng.uniform(-kExtent, kExtent) });
+            grid.update(reg);
+            reg.advance();
+        }
+        // One frame: every `stride`-th entity takes a small step
+        void simulate(uint32_t stride) {
+            Entity n = reg.nextEntity();
+            for (Entity e = 1 + rng.below(stride); e < n; e += stride)
+                reg.patch<Transform>(e, [&](Transform& t) { t.position.x += rng.uniform(-1.0f, 1.0f); t.position.z += rng.uniform(-1.0f, 1.0f); });
+        }
+        // What gameplay did before the index: test every entity
+        void bruteRadius(const glm::vec3& c, float r, std::vector<Entity>& out) {
+            reg.each<Transform>([&](Entity e, const Transform& t) { glm::vec3 d = t.position - c; if (glm::dot(d, d) <= r * r) out.push_back(e); });
+        }
+        void bruteNearest(const glm::vec3& c, uint32_t k, std::vector<Entity>& out, std::vector<std::pair<float, Entity>>& scratch) {
+            scratch.clear();
+            reg.each<Transform>([&](Entity e, const Transform& t) { glm::vec3 d = t.position - c; scratch.push_back({ glm::dot(d, d), e }); });
+            std::partial_sort(scratch.begin(), scratch.begin() + k, scratch.end());
+            out.clear();
+            for (uint32_t i = 0; i < k; ++i) out.push_back(scratch[i].second);
+        }
+    };
+
+    void expectSame(std::vector<Entity> a, std::vector<Entity> b, bool sorted, const char* what) {
+        if (!sorted) { std::sort(a.begin(), a.end()); std::sort(b.begin(), b.end()); }
+        if (a == b) return;
+        std::fprintf(stderr, "spatial: %s disagrees with the brute-force scan (%zu vs %zu entities)\n", what, a.size(), b.size());
+        std::abort();
+    }
+}
+
+// Ops are entities. All of them move each frame, so update() takes the bulk rebuild path; the
+// patch() calls that move them are included.
+static void spatialUpdateAll(State& st) {
+    WorldFixture f((uint32_t)st.arg());
+    st.setOps((double)st.arg());
+    st.measure([&] { f.simulate(1); f.grid.update(f.reg); f.reg.advance(); });
+}
+
+// One entity in 20 moves: applied incrementally from the change log
+static void spatialUpdateSome(State& st) {
+    WorldFixture f((uint32_t)st.arg());
+    st.setOps((double)st.arg());
+    st.measure([&] { f.simulate(20); f.grid.update(f.reg); f.reg.advance(); });
+    std::vector<Entity> a, b;
+    f.grid.queryRadius(f.queries[0], 200.0f, a); f.bruteRadius(f.queries[0], 200.0f, b);
+    expectSame(a, b, false, "incrementally updated grid");
+}
+
+// Ops are queries
+static void spatialRadius(State& st) {
+    WorldFixture f((uint32_t)st.arg());
+    std::vector<Entity> hits;
+    st.setOps(kQueries);
+    st.measure([&] {
+        hits.clear();
+        for (const glm::vec3& q : f.queries) f.grid.queryRadius(q, kRadius, hits);
+        doNotOptimize(hits.data());
+    });
+    for (const glm::vec3& q : f.queries) {
+        std::vector<Entity> a, b;
+        f.grid.queryRadius(q, kRadius, a); f.bruteRadius(q, kRadius, b);
+        expectSame(a, b, false, "radius query");
+    }
+}
+
+static void spatialRadiusBrute(State& st) {
+    WorldFixture f((uint32_t)st.arg());
+    std::vector<Entity> hits;
+    st.setOps(kQueries / 16); // a few suffice, it is that slow
+    st.measure([&] {
+        hits.clear();
+        for (uint32_t i = 0; i < kQueries / 16; ++i) f.bruteRadius(f.queries[i], kRadius, hits);
+        doNotOptimize(hits.data());
+    });
+}
+
+// The same queries from every worker at once: readers share the grid without locking
+static void spatialRadiusParallel(State& st) {
+    WorldFixture f((uint32_t)st.arg());
+    const uint32_t rounds = 16;
+    std::vector<uint32_t> counts((size_t)kQueries * rounds);
+    st.setOps((double)counts.size());
+    st.measure([&] {
+        eng::jobs::parallelFor(0, counts.size(), [&](size_t b, size_t e) {
+            std::vector<Entity> hits;
+            for (size_t i = b; i < e; ++i) { hits.clear(); f.grid.queryRadius(f.queries[i % kQueries], kRadius, hits); counts[i] = (uint32_t)hits.size(); }
+        });
+        doNotOptimize(counts.data());
+    });
+    for (uint32_t i = 0; i < kQueries; ++i) {
+        std::vector<Entity> b;
+        f.bruteRadius(f.queries[i], kRadius, b);
+        for (uint32_t r = 0; r < rounds; ++r)
+            if (counts[(size_t)r * kQueries + i] != b.size()) { std::fprintf(stderr, "spatial: parallel radius query %u found %u, expected %zu\n", i, counts[(size_t)r * kQueries + i], b.size()); std::abort(); }
+    }
+}
+
+static void spatialNearest(State& st) {
+    WorldFixture f((uint32_t)st.arg());
+    std::vector<Entity> hits;
+    st.setOps(kQueries);
+    st.measure([&] {
+        for (const glm::vec3& q : f.queries) { f.grid.nearest(q, 8, hits); doNotOptimize(hits.data()); }
+    });
+    std::vector<Entity> b;
+    std::vector<std::pair<float, Entity>> scratch;
+    for (const glm::vec3& q : f.queries) {
+        f.grid.nearest(q, 8, hits); f.bruteNearest(q, 8, b, scratch);
+        expectSame(hits, b, true, "nearest(8)");
+    }
+}
+
+static void spatialNearestBrute(State& st) {
+    WorldFixture f((uint32_t)st.arg());
+    std::vector<Entity> hits;
+    std::vector<std::pair<float, Entity>> scratch;
+    st.setOps(kQueries / 16);
+    st.measure([&] {
+        for (uint32_t i = 0; i < kQueries / 16; ++i) { f.bruteNearest(f.queries[i], 8, hits, scratch); doNotOptimize(hits.data()); }
+    });
+}
+
+static const bool spatialRegistered =
+    add("spatial/update_all", 100000, &spatialUpdateAll) && add("spatial/update_5pct", 100000, &spatialUpdateSome) &&
+    add("spatial/radius", 100000, &spatialRadius) && add("spatial/radius_brute_force", 100000, &spatialRadiusBrute) &&
+    add("spatial/radius_parallel", 100000, &spatialRadiusParallel) &&
+    add("spatial/nearest8", 100000, &spatialNearest) && add("spatial/nearest8_brute_force", 100000, &spatialNearestBrute);
@@ -0,0 +1,155 @@
+#include "bench.h"
+#include "datasets.h"
+#include "engine/terrain/terrain.h"
+#include "engine/terrain/height_query.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace eng::bench;
+
+ENG_BENCH(terrainNoise2D, "terrain/noise2D") {
+    const int n = 4096;
+    st.setOps(n);
+    st.measure([&] {
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i) sum += eng::terrain::noise2D(i * 0.731f, i * 0.317f);
+        doNotOptimize(sum);
+    });
+}
+
+ENG_BENCH(terrainFbm5, "terrain/fbm/octaves5") {
+    const int n = 1024;
+    st.setOps(n);
+    st.measure([&] {
+        float sum = 0.0f;
+        for (int i = 0; i < n; ++i) sum += eng::terrain::fbm(i * 0.731f, i * 0.317f, 5);
+        doNotOptimize(sum);
+    });
+}
+
+// Whole (2r+1)^2-chunk field as the sandbox builds it; ops are output vertices
+static void terrainGenerate(State& st) {
+    eng::terrain::Settings s;
+    s.chunkPoints = 64; s.radiusChunks = (int)st.arg(); s.heightScale = 60.0f; s.frequency = 0.0045f; s.octaves = 5;
+    size_t count = eng::terrain::generate(s).size();
+    st.setOps((double)count);
+    st.setBytes((double)(count * sizeof(eng::terrain::Vertex)));
+    st.measure([&] { doNotOptimize(eng::terrain::generate(s).data()); });
+}
+static const bool terrainGenerateRegistered = add("terrain/generate/radius", 1, &terrainGenerate) && add("terrain/generate/radius", 3, &terrainGenerate);
+
+// HeightQuery against the sandbox terrain: points spread over the loaded grid, so none take the
+// analytic fallback; ops are points. The fixture checks the batched path and the raycast once,
+// when it is built, and aborts on a wrong result.
+namespace {
+    struct GroundFixture {
+        eng::terrain::Settings s;
+        eng::terrain::HeightQuery hq;
+        std::vector<float> xs, zs, out;
+        GroundFixture() {
+            s.chunkPoints = 64; s.radiusChunks = 3; s.heightScale = 60.0f; s.frequency = 0.0045f; s.octaves = 5;
+            hq.build(s, eng::terrain::generate(s));
+            data::Rng rng(0x2545F4914F6CDD1Dull);
+            float extent = 3.0f * 63.0f;
+            for (int i = 0; i < 4096; ++i) { xs.push_back(rng.uniform(-extent, extent)); zs.push_back(rng.uniform(-extent, extent)); }
+            out.resize(xs.size());
+            checkBatch(rng);
+            for (size_t i = 0; i < 64; ++i) checkRay(ray(i), i);
+        }
+        static GroundFixture& get() { static GroundFixture f; return f; }
+
+        // The raycast entry's rays: downward-slanted from above the terrain, as for mouse picking
+        std::pair<glm::vec3, glm::vec3> ray(size_t i) const {
+            const size_t n = 1024;
+            return { glm::vec3(xs[i] * 0.5f, 90.0f, zs[i] * 0.5f), glm::vec3(xs[n + i] * 0.01f, -1.0f, zs[n + i] * 0.01f) };
+        }
+
+        // heights() (SSE2 groups of four where available) against height() one point at a time,
+        // with points outside the grid mixed in and a count that leaves a scalar tail
+        void checkBatch(data::Rng& rng) const {
+            std::vector<float> bx(xs), bz(zs);
+            for (int i = 0; i < 203; ++i) { bx.push_back(rng.uniform(-400.0f, 400.0f)); bz.push_back(rng.uniform(-400.0f, 400.0f)); }
+            for (size_t i = 0; i + 1 < bx.size(); i += 7) { std::swap(bx[i], bx[bx.size() - 1 - i / 7]); std::swap(bz[i], bz[bz.size() - 1 - i / 7]); }
+            std::vector<float> batch(bx.size());
+            hq.heights(bx.data(), bz.data(), batch.data(), bx.size());
+            for (size_t i = 0; i < bx.size(); ++i) {
+                float h = hq.height(bx[i], bz[i]);
+                if (std::abs(batch[i] - h) > 1e-4f * std::max(1.0f, std::abs(h))) {
+                    std::fprintf(stderr, "terrain: heights() gives %g at (%g, %g), height() %g\n", batch[i], bx[i], bz[i], h);
+                    std::abort();
+                }
+            }
+        }
+
+        // raycast() against a ray march over height(): fine steps inside the grid until the ray is at
+        // or below the surface, then bisection. Hit or miss and t must agree.
+        void checkRay(const std::pair<glm::vec3, glm::vec3>& r, size_t i) const {
+            const glm::vec3& o = r.first; const glm::vec3& d = r.second;
+            const float maxT = 400.0f, step = 0.01f;
+            auto below = [&](float t) { glm::vec3 p = o + d * t; return p.y <= hq.height(p.x, p.z); };
+            bool marched = false, entered = false; float tm = 0.0f;
+            for (float t = 0.0f, prev = 0.0f; t <= maxT; prev = t, t += step) {
+                glm::vec3 p = o + d * t;
+                if (!hq.contains(p.x, p.z)) { if (entered) break; continue; }
+                entered = true;
+                if (!below(t)) continue;
+                float lo = prev, hi = t;
+                for (int k = 0; k < 40 && t > 0.0f; ++k) { float mid = 0.5f * (lo + hi); (below(mid) ? hi : lo) = mid; }
+                marched = true; tm = hi;
+                break;
+            }
+            eng::terrain::RayHit hit;
+            bool cast = hq.raycast(o, d, maxT, hit);
+            if (cast != marched || (cast && std::abs(hit.t - tm) > 1e-3f)) {
+                std::fprintf(stderr, "terrain: ray %zu: raycast %s t=%g, ray march %s t=%g\n", i, cast ? "hit" : "missed", cast ? hit.t : 0.0f, marched ? "hit" : "missed", tm);
+                std::abort();
+            }
+        }
+    };
+}
+
+ENG_BENCH(heightQueryAnalytic, "terrain/height/analytic") {
+    auto& f = GroundFixture::get();
+    st.setOps((double)f.xs.size());
+    st.measure([&] {
+        for (size_t i = 0; i < f.xs.size(); ++i) f.out[i] = eng::terrain::height(f.xs[i], f.zs[i], f.s);
+        doNotOptimize(f.out.data());
+    });
+}
+
+ENG_BENCH(heightQueryScalar, "terrain/height/grid_scalar") {
+    auto& f = GroundFixture::get();
+    st.setOps((double)f.xs.size());
+    st.measure([&] {
+        for (size_t i = 0; i < f.xs.size(); ++i) f.out[i] = f.hq.height(f.xs[i], f.zs[i]);
+        doNotOptimize(f.out.data());
+    });
+}
+
+ENG_BENCH(heightQueryBatch, "terrain/height/grid_batch") {
+    auto& f = GroundFixture::get();
+    st.setOps((double)f.xs.size());
+    st.measure([&] {
+        f.hq.heights(f.xs.data(), f.zs.data(), f.out.data(), f.xs.size());
+        doNotOptimize(f.out.data());
+    });
+}
+
+// Downward-slanted rays from above the terrain, as for mouse picking; ops are rays
+ENG_BENCH(heightQueryRaycast, "terrain/height/raycast") {
+    auto& f = GroundFixture::get();
+    const size_t n = 1024;
+    st.setOps((double)n);
+    st.measure([&] {
+        uint32_t hits = 0;
+        for (size_t i = 0; i < n; ++i) {
+            eng::terrain::RayHit hit;
+            auto [o, d] = f.ray(i);
+            hits += f.hq.raycast(o, d, 400.0f, hit);
+        }
+        doNotOptimize(hits);
+    });
+}
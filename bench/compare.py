@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Compare two engine_bench JSON outputs.
+
+    engine_bench --json current.json
+    python3 bench/compare.py baseline.json current.json [--threshold 0.10] [--metric ns_per_op]
+    python3 bench/compare.py baseline.json current.json --update   # accept current as the new baseline
+
+Exits 1 when any benchmark got slower than the threshold allows, so CI can gate on it.
+Benchmarks present on only one side are listed but never fail the comparison.
+"""
+import argparse
+import json
+import shutil
+import sys
+
+
+def load(path: str) -> dict[str, dict]:
+    with open(path, "r", encoding="utf-8") as f:
+        doc = json.load(f)
+    if doc.get("suite") != "engine_bench":
+        raise ValueError(f"{path}: not an engine_bench result file")
+    return {r["name"]: r for r in doc.get("results", [])}
+
+
+def main() -> int:
+    ap = argparse.ArgumentParser(description="Compare engine_bench results against a baseline")
+    ap.add_argument("baseline")
+    ap.add_argument("current")
+    ap.add_argument("--threshold", type=float, default=0.10, help="relative slowdown that counts as a regression (default 0.10)")
+    ap.add_argument("--metric", default="ns_per_op", choices=["ns_per_op", "median_ns", "p95_ns", "min_ns"])
+    ap.add_argument("--update", action="store_true", help="copy current over baseline after reporting")
+    args = ap.parse_args()
+
+    try:
+        base = load(args.baseline)
+    except FileNotFoundError:
+        if args.update:
+            shutil.copyfile(args.current, args.baseline)
+            print(f"no baseline yet; wrote {args.baseline}")
+            return 0
+        print(f"baseline {args.baseline} not found (run with --update to create it)", file=sys.stderr)
+        return 2
+    cur = load(args.current)
+
+    regressions = 0
+    print(f"{'benchmark':44} {'baseline':>12} {'current':>12} {'change':>9}")
+    for name in sorted(set(base) | set(cur)):
+        if name not in cur:
+            print(f"{name:44} {'':>12} {'missing':>12}")
+            continue
+        if name not in base:
+            print(f"{name:44} {'new':>12} {cur[name][args.metric]:12.2f}")
+            continue
+        b, c = base[name][args.metric], cur[name][args.metric]
+        change = (c - b) / b if b > 0 else 0.0
+        flag = ""
+        if change > args.threshold:
+            flag = "  REGRESSION"
+            regressions += 1
+        elif change < -args.threshold:
+            flag = "  faster"
+        print(f"{name:44} {b:12.2f} {c:12.2f} {change:+8.1%}{flag}")
+
+    print(f"\n{regressions} regression(s) beyond {args.threshold:.0%} on {args.metric}")
+    if args.update:
+        shutil.copyfile(args.current, args.baseline)
+        print(f"updated {args.baseline}")
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
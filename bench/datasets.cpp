@@ -0,0 +1,145 @@
+#include "datasets.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace eng::bench::data {
+
+// Grid over [0, gridN-1]^2 in x/z with a gentle per-mesh bump, so meshes are not byte-identical
+static void gridMesh(uint32_t meshIndex, uint32_t gridN, std::vector<eng::scene::MeshVertex>& verts, std::vector<uint32_t>& indices) {
+    verts.clear(); indices.clear();
+    verts.reserve((size_t)gridN * gridN);
+    float phase = meshIndex * 0.37f;
+    for (uint32_t z = 0; z < gridN; ++z)
+        for (uint32_t x = 0; x < gridN; ++x) {
+            eng::scene::MeshVertex v;
+            v.position = { (float)x, 0.25f * std::sin(x * 0.3f + phase) * std::cos(z * 0.3f), (float)z };
+            v.normal = { 0.0f, 1.0f, 0.0f };
+            v.texCoord = { x / (float)(gridN - 1), z / (float)(gridN - 1) };
+            verts.push_back(v);
+        }
+    indices.reserve((size_t)(gridN - 1) * (gridN - 1) * 6);
+    for (uint32_t z = 0; z + 1 < gridN; ++z)
+        for (uint32_t x = 0; x + 1 < gridN; ++x) {
+            uint32_t i = z * gridN + x;
+            uint32_t quad[6] = { i, i + gridN, i + 1, i + 1, i + gridN, i + gridN + 1 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+}
+
+static glm::vec3 instanceOffset(uint32_t meshIndex, uint32_t instance, uint32_t gridN) {
+    return { (float)(instance * gridN), 0.0f, (float)(meshIndex * gridN) };
+}
+
+std::string scratchDir() {
+    std::error_code ec;
+    std::filesystem::path dir = std::filesystem::temp_directory_path(ec) / "engine_bench";
+    std::filesystem::create_directories(dir, ec);
+    return dir.string();
+}
+
+GltfDataset writeProceduralGltf(const std::string& dir, const std::string& name, uint32_t meshes, uint32_t gridN, uint32_t instancesPerMesh) {
+    GltfDataset out;
+    std::string binName = name + ".bin";
+    std::string binPath = (std::filesystem::path(dir) / binName).string();
+    out.path = (std::filesystem::path(dir) / (name + ".gltf")).string();
+    out.meshes = meshes; out.nodes = meshes * instancesPerMesh;
+
+    // Binary: per mesh positions, normals, uvs, indices, each 4-byte aligned by construction
+    std::vector<uint8_t> bin;
+    std::string views, accessors, meshList, nodes, materials, sceneNodes;
+    std::vector<eng::scene::MeshVertex> verts; std::vector<uint32_t> indices;
+    char buf[512];
+    uint32_t view = 0;
+    auto addView = [&](const void* data, size_t bytes, bool indexBuffer) {
+        std::snprintf(buf, sizeof(buf), "%s{\"buffer\":0,\"byteOffset\":%zu,\"byteLength\":%zu,\"target\":%d}",
+                      view ? "," : "", bin.size(), bytes, indexBuffer ? 34963 : 34962);
+        views += buf;
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        bin.insert(bin.end(), p, p + bytes);
+        return view++;
+    };
+    for (uint32_t m = 0; m < meshes; ++m) {
+        gridMesh(m, gridN, verts, indices);
+        out.vertices += verts.size(); out.indices += indices.size();
+        std::vector<float> pos, nrm, uv;
+        glm::vec3 lo(1e30f), hi(-1e30f);
+        for (const auto& v : verts) {
+            pos.insert(pos.end(), { v.position.x, v.position.y, v.position.z });
+            nrm.insert(nrm.end(), { v.normal.x, v.normal.y, v.normal.z });
+            uv.insert(uv.end(), { v.texCoord.x, v.texCoord.y });
+            lo = glm::min(lo, v.position); hi = glm::max(hi, v.position);
+        }
+        uint32_t vPos = addView(pos.data(), pos.size() * 4, false), vNrm = addView(nrm.data(), nrm.size() * 4, false);
+        uint32_t vUv = addView(uv.data(), uv.size() * 4, false), vIdx = addView(indices.data(), indices.size() * 4, true);
+        uint32_t a = m * 4;
+        std::snprintf(buf, sizeof(buf),
+                      "%s{\"bufferView\":%u,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\",\"min\":[%g,%g,%g],\"max\":[%g,%g,%g]}"
+                      ",{\"bufferView\":%u,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC3\"}"
+                      ",{\"bufferView\":%u,\"componentType\":5126,\"count\":%zu,\"type\":\"VEC2\"}",
+                      m ? "," : "", vPos, verts.size(), lo.x, lo.y, lo.z, hi.x, hi.y, hi.z, vNrm, verts.size(), vUv, verts.size());
+        accessors += buf;
+        std::snprintf(buf, sizeof(buf), ",{\"bufferView\":%u,\"componentType\":5125,\"count\":%zu,\"type\":\"SCALAR\"}", vIdx, indices.size());
+        accessors += buf;
+        std::snprintf(buf, sizeof(buf), "%s{\"primitives\":[{\"attributes\":{\"POSITION\":%u,\"NORMAL\":%u,\"TEXCOORD_0\":%u},\"indices\":%u,\"material\":%u}]}",
+                      m ? "," : "", a, a + 1, a + 2, a + 3, m);
+        meshList += buf;
+        std::snprintf(buf, sizeof(buf), "%s{\"pbrMetallicRoughness\":{\"baseColorFactor\":[%g,%g,%g,1]}}",
+                      m ? "," : "", 0.3 + 0.7 * (m % 7) / 6.0, 0.3 + 0.7 * (m % 5) / 4.0, 0.3 + 0.7 * (m % 3) / 2.0);
+        materials += buf;
+        for (uint32_t i = 0; i < instancesPerMesh; ++i) {
+            uint32_t n = m * instancesPerMesh + i;
+            glm::vec3 t = instanceOffset(m, i, gridN);
+            std::snprintf(buf, sizeof(buf), "%s{\"mesh\":%u,\"translation\":[%g,%g,%g]}", n ? "," : "", m, t.x, t.y, t.z);
+            nodes += buf;
+            std::snprintf(buf, sizeof(buf), "%s%u", n ? "," : "", n);
+            sceneNodes += buf;
+        }
+    }
+
+    std::FILE* f = std::fopen(binPath.c_str(), "wb");
+    if (!f) return {};
+    bool ok = std::fwrite(bin.data(), 1, bin.size(), f) == bin.size();
+    ok = std::fclose(f) == 0 && ok;
+    std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"engine_bench\"},\"scene\":0,\"scenes\":[{\"nodes\":[" + sceneNodes + "]}]"
+                       ",\"nodes\":[" + nodes + "],\"meshes\":[" + meshList + "],\"materials\":[" + materials + "]"
+                       ",\"accessors\":[" + accessors + "],\"bufferViews\":[" + views + "]"
+                       ",\"buffers\":[{\"uri\":\"" + binName + "\",\"byteLength\":" + std::to_string(bin.size()) + "}]}";
+    f = std::fopen(out.path.c_str(), "wb");
+    if (!f) return {};
+    ok = std::fwrite(json.data(), 1, json.size(), f) == json.size() && ok;
+    ok = std::fclose(f) == 0 && ok;
+    if (!ok) return {};
+    out.fileBytes = bin.size() + json.size();
+    return out;
+}
+
+std::vector<eng::scene::Mesh> syntheticMeshes(uint32_t meshes, uint32_t gridN, uint32_t instancesPerMesh) {
+    std::vector<eng::scene::Mesh> out(meshes);
+    for (uint32_t m = 0; m < meshes; ++m) {
+        gridMesh(m, gridN, out[m].vertices, out[m].indices);
+        out[m].material = (int)m;
+        for (uint32_t i = 0; i < instancesPerMesh; ++i) {
+            glm::mat4 t(1.0f);
+            t[3] = glm::vec4(instanceOffset(m, i, gridN), 1.0f);
+            out[m].instances.push_back(t);
+        }
+    }
+    return out;
+}
+
+std::vector<eng::renderer::GpuLight> randomLights(uint32_t count, float extent, uint64_t seed) {
+    Rng rng(seed);
+    std::vector<eng::renderer::GpuLight> lights(count);
+    for (auto& l : lights) {
+        l.position[0] = rng.uniform(-extent, extent); l.position[1] = rng.uniform(0.5f, 6.0f); l.position[2] = rng.uniform(-extent, extent);
+        l.range = rng.uniform(2.0f, 12.0f);
+        l.color[0] = rng.uniform(0.2f, 1.0f); l.color[1] = rng.uniform(0.2f, 1.0f); l.color[2] = rng.uniform(0.2f, 1.0f);
+        l.type = (uint32_t)eng::renderer::LightType::Point;
+    }
+    return lights;
+}
+
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "engine/scene/gltf_loader.h"
+#include "engine/renderer/light_clusters.h"
+
+// Synthetic inputs for engine_bench; everything is generated from a seed, so runs are comparable.
+namespace eng::bench::data {
+    // xorshift64*: fast, deterministic across platforms (unlike std::uniform_*_distribution)
+    struct Rng {
+        uint64_t s;
+        explicit Rng(uint64_t seed) : s(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+        uint64_t next() { s ^= s >> 12; s ^= s << 25; s ^= s >> 27; return s * 0x2545F4914F6CDD1Dull; }
+        float uniform(float lo, float hi) { return lo + (hi - lo) * (float)((next() >> 40) * (1.0 / 16777216.0)); }
+        uint32_t below(uint32_t n) { return (uint32_t)((next() >> 32) % n); }
+    };
+
+    struct GltfDataset {
+        std::string path;            // the .gltf; its .bin sits next to it
+        size_t fileBytes = 0;        // .gltf + .bin
+        uint32_t meshes = 0, nodes = 0;
+        size_t vertices = 0, indices = 0; // per unique mesh, summed
+    };
+
+    // Writes <dir>/<name>.gltf and .bin: `meshes` distinct gridN x gridN grid meshes, each drawn by
+    // `instancesPerMesh` translated nodes and given its own untextured material
+    GltfDataset writeProceduralGltf(const std::string& dir, const std::string& name, uint32_t meshes, uint32_t gridN, uint32_t instancesPerMesh);
+
+    // The same meshes as the loader would return them, without touching the file system
+    std::vector<eng::scene::Mesh> syntheticMeshes(uint32_t meshes, uint32_t gridN, uint32_t instancesPerMesh);
+
+    // Point lights scattered over a square of +-extent around the origin
+    std::vector<eng::renderer::GpuLight> randomLights(uint32_t count, float extent, uint64_t seed);
+
+    // Directory for generated files (created on demand under the system temp directory)
+    std::string scratchDir();
+}
@@ -0,0 +1,103 @@
+#include "bench.h"
+#include "engine/core/jobs.h"
+#include "engine/core/log.h"
+#include "engine/platform/async_io.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// engine_bench [--filter substr] [--reps N] [--warmup N] [--min-rep-ms X] [--json out.json] [--list] [--verbose]
+// Compare two JSON outputs with bench/compare.py.
+
+using namespace eng::bench;
+
+static void writeJsonString(std::FILE* f, const std::string& s) {
+    std::fputc('"', f);
+    for (char c : s) {
+        if (c == '"' || c == '\\') { std::fputc('\\', f); std::fputc(c, f); }
+        else if ((unsigned char)c < 0x20) std::fprintf(f, "\\u%04x", (unsigned)c);
+        else std::fputc(c, f);
+    }
+    std::fputc('"', f);
+}
+
+static bool writeJson(const char* path, const Config& cfg, const std::vector<Result>& results) {
+    std::FILE* f = std::fopen(path, "wb");
+    if (!f) return false;
+    std::fprintf(f, "{\n  \"suite\": \"engine_bench\",\n  \"config\": {\"warmup\": %u, \"reps\": %u, \"min_rep_ms\": %.3f},\n  \"results\": [\n",
+                 cfg.warmup, cfg.reps, cfg.minRepMs);
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        std::fputs("    {\"name\": ", f);
+        writeJsonString(f, r.name);
+        std::fprintf(f, ", \"median_ns\": %.3f, \"p95_ns\": %.3f, \"min_ns\": %.3f, \"ns_per_op\": %.4f, \"bytes_per_op\": %.3f, \"reps\": %u, \"batch\": %u}%s\n",
+                     r.medianNs, r.p95Ns, r.minNs, r.nsPerOp, r.bytesPerOp, r.reps, r.batch, i + 1 < results.size() ? "," : "");
+    }
+    std::fputs("  ]\n}\n", f);
+    return std::fclose(f) == 0;
+}
+
+static std::string human(double ns) {
+    char buf[32];
+    if (ns >= 1e9) std::snprintf(buf, sizeof(buf), "%.2f s", ns * 1e-9);
+    else if (ns >= 1e6) std::snprintf(buf, sizeof(buf), "%.2f ms", ns * 1e-6);
+    else if (ns >= 1e3) std::snprintf(buf, sizeof(buf), "%.2f us", ns * 1e-3);
+    else std::snprintf(buf, sizeof(buf), "%.1f ns", ns);
+    return buf;
+}
+
+int main(int argc, char** argv) {
+    Config cfg;
+    const char* filter = nullptr;
+    const char* jsonPath = nullptr;
+    bool list = false, verbose = false;
+    for (int i = 1; i < argc; ++i) {
+        auto value = [&](const char* flag) -> const char* {
+            if (std::strcmp(argv[i], flag) != 0) return nullptr;
+            if (i + 1 >= argc) { std::fprintf(stderr, "%s needs a value\n", flag); std::exit(2); }
+            return argv[++i];
+        };
+        if (const char* v = value("--filter")) filter = v;
+        else if (const char* v = value("--reps")) cfg.reps = (uint32_t)std::strtoul(v, nullptr, 10);
+        else if (const char* v = value("--warmup")) cfg.warmup = (uint32_t)std::strtoul(v, nullptr, 10);
+        else if (const char* v = value("--min-rep-ms")) cfg.minRepMs = std::strtod(v, nullptr);
+        else if (const char* v = value("--json")) jsonPath = v;
+        else if (std::strcmp(argv[i], "--list") == 0) list = true;
+        else if (std::strcmp(argv[i], "--verbose") == 0) verbose = true;
+        else {
+            std::fprintf(stderr, "usage: %s [--filter substr] [--reps N] [--warmup N] [--min-rep-ms X] [--json out.json] [--list] [--verbose]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    // Engine code logs per call (e.g. every glTF load); keep the table readable unless asked
+    if (!verbose) eng::log::setLevel(eng::log::Level::Warn);
+    // Engine paths that fan out (terrain generation, BVH builds) are measured the way the sandbox runs them
+    eng::jobs::init();
+    eng::io::init(); // glTF loads read through it, as in the sandbox
+
+    // Registration order depends on static initialization across files; run in name order instead
+    std::vector<Entry> entries = registry();
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.name < b.name; });
+
+    std::vector<Result> results;
+    if (!list) std::printf("%-44s %12s %12s %12s %14s\n", "benchmark", "median", "p95", "ns/op", "bytes/op");
+    for (const Entry& e : entries) {
+        if (filter && e.name.find(filter) == std::string::npos) continue;
+        if (list) { std::printf("%s\n", e.name.c_str()); continue; }
+        State st(cfg, e.arg);
+        e.fn(st);
+        Result r = summarize(e.name, st);
+        std::printf("%-44s %12s %12s %12.2f %14.1f\n", r.name.c_str(), human(r.medianNs).c_str(), human(r.p95Ns).c_str(), r.nsPerOp, r.bytesPerOp);
+        std::fflush(stdout);
+        results.push_back(r);
+    }
+    if (jsonPath && !list) {
+        if (!writeJson(jsonPath, cfg, results)) { std::fprintf(stderr, "cannot write %s\n", jsonPath); return 1; }
+        std::printf("wrote %s\n", jsonPath);
+    }
+    eng::io::shutdown();
+    eng::jobs::shutdown();
+    return 0;
+}
@@ -130,7 +130,7 @@ def main():
         if not exe:
             print("[ERROR] Cannot run; executable not found.")
             sys.exit(2)
-        # Ensure shaders are copied next to the executable (handled by CMake POST_BUILD), just run
+        # Shaders are embedded in the binary, so the working directory does not matter
         try:
             run([exe])
         except subprocess.CalledProcessError as e:
@@ -0,0 +1,30 @@
+# Converts a compiled SPIR-V binary into a header holding a constexpr uint32_t array.
+# Usage: cmake -DINPUT=<file.spv> -DOUTPUT=<file.h> -DSYMBOL=<identifier> -P embed_spirv.cmake
+file(READ "${INPUT}" _hex HEX)
+string(LENGTH "${_hex}" _len)
+math(EXPR _rem "${_len} % 8")
+if (_len EQUAL 0 OR NOT _rem EQUAL 0)
+  message(FATAL_ERROR "${INPUT} is not a valid SPIR-V binary (size must be a multiple of 4)")
+endif()
+
+# SPIR-V words are little-endian: reverse each group of four bytes
+string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1u," _words "${_hex}")
+# CMake regexes have no {n} quantifier, so spell out eight words per line
+string(REPEAT "0x[0-9a-f]+u," 8 _line)
+string(REGEX REPLACE "(${_line})" "\\1\n        " _words "${_words}")
+
+get_filename_component(_src "${INPUT}" NAME)
+file(WRITE "${OUTPUT}.tmp"
+"// Generated from ${_src} by embed_spirv.cmake - do not edit.
+#pragma once
+#include <cstdint>
+
+namespace eng::renderer::spirv {
+    inline constexpr std::uint32_t ${SYMBOL}[] = {
+        ${_words}
+    };
+}
+")
+# Only touch the header when the contents changed to avoid needless rebuilds
+execute_process(COMMAND ${CMAKE_COMMAND} -E copy_if_different "${OUTPUT}.tmp" "${OUTPUT}")
+file(REMOVE "${OUTPUT}.tmp")
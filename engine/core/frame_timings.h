@@ -0,0 +1,77 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "log.h"
+
+// Per-frame timing capture for benchmark runs (e.g. camera path replays):
+//   eng::time::FrameTimings ft;
+//   ft.add({ frame, t, cpuMs, gpuMs });     once per frame; gpuMs < 0 when no GPU sample arrived
+//   ft.writeCsv("run.csv"); ft.logSummary("replay");
+// The summary reports percentiles, which unlike averages are not dominated by a few hitches.
+
+namespace eng::time {
+    struct FrameTiming {
+        uint32_t frame = 0;
+        float t = 0.0f;      // simulated seconds
+        float cpuMs = 0.0f;  // wall time of the frame on the main thread
+        float gpuMs = -1.0f; // GPU "frame" scope, < 0 = none
+    };
+
+    struct Percentiles { float p50 = 0.0f, p90 = 0.0f, p95 = 0.0f, p99 = 0.0f, max = 0.0f, mean = 0.0f; size_t count = 0; };
+
+    inline Percentiles percentiles(std::vector<float> v) {
+        Percentiles p; p.count = v.size();
+        if (v.empty()) return p;
+        std::sort(v.begin(), v.end());
+        auto at = [&](double q) { return v[(size_t)std::max(std::ceil(q * v.size()), 1.0) - 1]; }; // nearest rank
+        p.p50 = at(0.50); p.p90 = at(0.90); p.p95 = at(0.95); p.p99 = at(0.99); p.max = v.back();
+        double sum = 0.0;
+        for (float x : v) sum += x;
+        p.mean = (float)(sum / v.size());
+        return p;
+    }
+
+    class FrameTimings {
+    public:
+        void clear() { frames_.clear(); }
+        void reserve(size_t n) { frames_.reserve(n); }
+        void add(const FrameTiming& f) { frames_.push_back(f); }
+        const std::vector<FrameTiming>& frames() const { return frames_; }
+
+        Percentiles cpu() const {
+            std::vector<float> v; v.reserve(frames_.size());
+            for (const auto& f : frames_) v.push_back(f.cpuMs);
+            return percentiles(std::move(v));
+        }
+        Percentiles gpu() const {
+            std::vector<float> v; v.reserve(frames_.size());
+            for (const auto& f : frames_) if (f.gpuMs >= 0.0f) v.push_back(f.gpuMs);
+            return percentiles(std::move(v));
+        }
+
+        bool writeCsv(const std::string& path) const {
+            std::FILE* f = std::fopen(path.c_str(), "wb");
+            if (!f) return false;
+            std::fputs("frame,t,cpu_ms,gpu_ms\n", f);
+            for (const auto& r : frames_) {
+                if (r.gpuMs >= 0.0f) std::fprintf(f, "%u,%.4f,%.4f,%.4f\n", r.frame, r.t, r.cpuMs, r.gpuMs);
+                else std::fprintf(f, "%u,%.4f,%.4f,\n", r.frame, r.t, r.cpuMs);
+            }
+            return std::fclose(f) == 0;
+        }
+
+        void logSummary(const char* label) const {
+            Percentiles c = cpu(), g = gpu();
+            eng::log::info("%s: %zu frames", label, frames_.size());
+            eng::log::info("  cpu ms  mean %6.2f  p50 %6.2f  p90 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f", c.mean, c.p50, c.p90, c.p95, c.p99, c.max);
+            if (g.count) eng::log::info("  gpu ms  mean %6.2f  p50 %6.2f  p90 %6.2f  p95 %6.2f  p99 %6.2f  max %6.2f  (%zu samples)", g.mean, g.p50, g.p90, g.p95, g.p99, g.max, g.count);
+            else eng::log::info("  gpu ms  no samples (GPU timestamps unavailable)");
+        }
+    private:
+        std::vector<FrameTiming> frames_;
+    };
+}
@@ -0,0 +1,309 @@
+#include "jobs.h"
+#include "log.h"
+#include "profiler.h"
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace eng::jobs {
+
+struct Access {
+    static std::atomic<uint32_t>& pending(Group& g) { return g.pending_; }
+    static std::atomic<uint32_t>& finishing(Group& g) { return g.finishing_; }
+    static std::mutex& mutex(Group& g) { return g.mutex_; }
+    static std::vector<Job*>& continuations(Group& g) { return g.continuations_; }
+};
+
+namespace {
+    // Chase-Lev deque (Le, Pop, Cohen, Zappa Nardelli: "Correct and Efficient Work-Stealing for Weak
+    // Memory Models"), fixed capacity: push() fails instead of growing.
+    class WorkDeque {
+    public:
+        explicit WorkDeque(uint32_t capacity) : mask_(capacity - 1), buf_(new std::atomic<Job*>[capacity]) {}
+
+        bool push(Job* job) { // owner only
+            int64_t b = bottom_.load(std::memory_order_relaxed), t = top_.load(std::memory_order_acquire);
+            if (b - t > (int64_t)mask_) return false;
+            buf_[b & mask_].store(job, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            bottom_.store(b + 1, std::memory_order_relaxed);
+            return true;
+        }
+
+        Job* pop() { // owner only
+            int64_t b = bottom_.load(std::memory_order_relaxed) - 1;
+            bottom_.store(b, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t t = top_.load(std::memory_order_relaxed);
+            if (t > b) { bottom_.store(b + 1, std::memory_order_relaxed); return nullptr; }
+            Job* job = buf_[b & mask_].load(std::memory_order_relaxed);
+            if (t == b) {
+                // Last item: race the thieves for it
+                if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) job = nullptr;
+                bottom_.store(b + 1, std::memory_order_relaxed);
+            }
+            return job;
+        }
+
+        Job* steal() { // any thread
+            int64_t t = top_.load(std::memory_order_acquire);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            int64_t b = bottom_.load(std::memory_order_acquire);
+            if (t >= b) return nullptr;
+            Job* job = buf_[t & mask_].load(std::memory_order_relaxed);
+            if (!top_.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) return nullptr;
+            return job;
+        }
+
+        bool empty() const { return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed); }
+    private:
+        alignas(64) std::atomic<int64_t> top_{0};
+        alignas(64) std::atomic<int64_t> bottom_{0};
+        int64_t mask_;
+        std::unique_ptr<std::atomic<Job*>[]> buf_;
+    };
+
+    struct Scheduler {
+        std::vector<std::unique_ptr<WorkDeque>> deques; // [0] main thread, [i] worker i
+        std::vector<std::thread> threads;
+        std::mutex sharedMutex;
+        std::deque<Job*> shared;                        // from threads without a deque, and deque overflow
+        std::atomic<size_t> sharedSize{0};
+        std::mutex mainMutex;
+        std::vector<Job*> mainJobs;
+        std::atomic<bool> stop{false};
+        // Sleeping: a worker registers in `sleepers` before its last look for work and a submitter
+        // checks it after publishing the job (both seq_cst), so one of them always sees the other.
+        std::atomic<int> sleepers{0};
+        std::mutex sleepMutex;
+        std::condition_variable wake;
+        uint64_t epoch = 0; // guarded by sleepMutex
+    };
+
+    std::atomic<Scheduler*> g_sched{nullptr};
+    thread_local int t_index = -1;
+    thread_local uint64_t t_rng = 0;
+
+    uint32_t nextRandom() {
+        if (!t_rng) t_rng = 0x9E3779B97F4A7C15ull ^ (uint64_t)(uintptr_t)&t_rng;
+        t_rng ^= t_rng << 13; t_rng ^= t_rng >> 7; t_rng ^= t_rng << 17;
+        return (uint32_t)t_rng;
+    }
+
+    void notify(Scheduler& s) {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (s.sleepers.load(std::memory_order_relaxed) == 0) return;
+        { std::lock_guard<std::mutex> lock(s.sleepMutex); ++s.epoch; }
+        s.wake.notify_one();
+    }
+
+    void finish(Group& g) {
+        Access::finishing(g).fetch_add(1, std::memory_order_acq_rel);
+        if (Access::pending(g).fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            std::vector<Job*> ready;
+            {
+                std::lock_guard<std::mutex> lock(Access::mutex(g));
+                ready.swap(Access::continuations(g));
+            }
+            for (Job* j : ready) {
+                // Already counted in their own group by submitAfter()
+                Scheduler* s = g_sched.load(std::memory_order_acquire);
+                if (!s) { Group* jg = j->group; j->execute(); delete j; finish(*jg); continue; }
+                if (t_index < 0 || !s->deques[t_index]->push(j)) {
+                    std::lock_guard<std::mutex> lock(s->sharedMutex);
+                    s->shared.push_back(j); s->sharedSize.fetch_add(1, std::memory_order_relaxed);
+                }
+                notify(*s);
+            }
+        }
+        Access::finishing(g).fetch_sub(1, std::memory_order_release); // last touch of g
+    }
+
+    void execute(Job* job) {
+        Group* g = job->group;
+        job->execute();
+        delete job;
+        finish(*g);
+    }
+
+    void enqueue(Scheduler& s, Job* job) {
+        if (t_index < 0 || !s.deques[t_index]->push(job)) {
+            std::lock_guard<std::mutex> lock(s.sharedMutex);
+            s.shared.push_back(job);
+            s.sharedSize.fetch_add(1, std::memory_order_relaxed);
+        }
+        notify(s);
+    }
+
+    Job* takeShared(Scheduler& s) {
+        if (s.sharedSize.load(std::memory_order_relaxed) == 0) return nullptr;
+        std::lock_guard<std::mutex> lock(s.sharedMutex);
+        if (s.shared.empty()) return nullptr;
+        Job* j = s.shared.front(); s.shared.pop_front();
+        s.sharedSize.fetch_sub(1, std::memory_order_relaxed);
+        return j;
+    }
+
+    Job* takeMain(Scheduler& s) {
+        std::lock_guard<std::mutex> lock(s.mainMutex);
+        if (s.mainJobs.empty()) return nullptr;
+        Job* j = s.mainJobs.front();
+        s.mainJobs.erase(s.mainJobs.begin());
+        return j;
+    }
+
+    Job* findJob(Scheduler& s) {
+        if (t_index >= 0) if (Job* j = s.deques[t_index]->pop()) return j;
+        if (Job* j = takeShared(s)) return j;
+        // Steal from a random victim onwards, so thieves spread out
+        size_t n = s.deques.size(), start = nextRandom() % n;
+        for (size_t k = 0; k < n; ++k) {
+            size_t v = (start + k) % n;
+            if ((int)v == t_index) continue;
+            if (Job* j = s.deques[v]->steal()) return j;
+        }
+        return nullptr;
+    }
+
+    void pinCurrentThread(unsigned core) {
+#if defined(_WIN32)
+        SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)1 << (core % (8 * sizeof(DWORD_PTR))));
+#elif defined(__linux__)
+        cpu_set_t set; CPU_ZERO(&set); CPU_SET(core % CPU_SETSIZE, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) eng::log::warn("Jobs: could not pin a worker to core %u", core);
+#else
+        (void)core; // not supported (e.g. macOS has no hard affinity)
+#endif
+    }
+
+    void workerLoop(Scheduler& s, int index, bool pin) {
+        ENG_PROFILE_THREAD("job worker");
+        t_index = index;
+        if (pin) pinCurrentThread((unsigned)index % std::max(1u, std::thread::hardware_concurrency()));
+        while (!s.stop.load(std::memory_order_acquire)) {
+            if (Job* j = findJob(s)) { execute(j); continue; }
+            // Brief spin before sleeping: jobs often arrive in bursts
+            Job* j = nullptr;
+            for (int i = 0; i < 64 && !j; ++i) { std::this_thread::yield(); j = findJob(s); }
+            if (j) { execute(j); continue; }
+            uint64_t seen;
+            { std::lock_guard<std::mutex> lock(s.sleepMutex); seen = s.epoch; }
+            s.sleepers.fetch_add(1, std::memory_order_seq_cst);
+            j = findJob(s);
+            if (j) { s.sleepers.fetch_sub(1, std::memory_order_relaxed); execute(j); continue; }
+            {
+                std::unique_lock<std::mutex> lock(s.sleepMutex);
+                s.wake.wait(lock, [&] { return s.epoch != seen || s.stop.load(std::memory_order_acquire); });
+            }
+            s.sleepers.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+bool init(const Config& cfg) {
+    if (g_sched.load()) return true;
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+    unsigned workers = cfg.workers ? cfg.workers : hw - 1;
+    uint32_t capacity = 1;
+    while (capacity < std::max(cfg.dequeCapacity, 2u)) capacity <<= 1;
+    auto* s = new Scheduler();
+    for (unsigned i = 0; i <= workers; ++i) s->deques.push_back(std::make_unique<WorkDeque>(capacity));
+    t_index = 0;
+    if (cfg.pinThreads) pinCurrentThread(0);
+    g_sched.store(s, std::memory_order_release);
+    for (unsigned i = 1; i <= workers; ++i) s->threads.emplace_back(workerLoop, std::ref(*s), (int)i, cfg.pinThreads);
+    eng::log::info("Job system: %u workers + main thread%s", workers, cfg.pinThreads ? ", pinned" : "");
+    return true;
+}
+
+void shutdown() {
+    Scheduler* s = g_sched.load();
+    if (!s) return;
+    s->stop.store(true, std::memory_order_release);
+    { std::lock_guard<std::mutex> lock(s->sleepMutex); ++s->epoch; }
+    s->wake.notify_all();
+    for (auto& t : s->threads) t.join();
+    // Finish what is left here; anything it submits runs inline once the scheduler is gone
+    g_sched.store(nullptr, std::memory_order_release);
+    std::vector<Job*> left;
+    for (auto& d : s->deques) while (Job* j = d->steal()) left.push_back(j);
+    left.insert(left.end(), s->shared.begin(), s->shared.end());
+    left.insert(left.end(), s->mainJobs.begin(), s->mainJobs.end());
+    for (Job* j : left) execute(j);
+    t_index = -1;
+    delete s;
+}
+
+bool running() { return g_sched.load(std::memory_order_acquire) != nullptr; }
+
+unsigned threadCount() {
+    Scheduler* s = g_sched.load(std::memory_order_acquire);
+    return s ? (unsigned)s->deques.size() : 1u;
+}
+
+int threadIndex() { return t_index; }
+
+void submit(Group& g, Job* job) {
+    job->group = &g;
+    Access::pending(g).fetch_add(1, std::memory_order_relaxed);
+    Scheduler* s = g_sched.load(std::memory_order_acquire);
+    if (!s) { execute(job); return; }
+    enqueue(*s, job);
+}
+
+void submitAfter(Group& dependency, Group& g, Job* job) {
+    job->group = &g;
+    Access::pending(g).fetch_add(1, std::memory_order_relaxed);
+    {
+        std::lock_guard<std::mutex> lock(Access::mutex(dependency));
+        if (Access::pending(dependency).load(std::memory_order_acquire) != 0) { Access::continuations(dependency).push_back(job); return; }
+    }
+    Scheduler* s = g_sched.load(std::memory_order_acquire);
+    if (!s) { execute(job); return; }
+    enqueue(*s, job);
+}
+
+void submitMain(Group& g, Job* job) {
+    job->group = &g;
+    Access::pending(g).fetch_add(1, std::memory_order_relaxed);
+    Scheduler* s = g_sched.load(std::memory_order_acquire);
+    if (!s) { execute(job); return; }
+    std::lock_guard<std::mutex> lock(s->mainMutex);
+    s->mainJobs.push_back(job);
+}
+
+void wait(Group& g) {
+    ENG_PROFILE_FUNCTION();
+    while (!g.done()) {
+        Scheduler* s = g_sched.load(std::memory_order_acquire);
+        if (!s) { std::this_thread::yield(); continue; }
+        Job* j = t_index == 0 ? takeMain(*s) : nullptr;
+        if (!j) j = findJob(*s);
+        if (j) execute(j);
+        else std::this_thread::yield();
+    }
+}
+
+void pumpMain() {
+    Scheduler* s = g_sched.load(std::memory_order_acquire);
+    if (!s || t_index != 0) return;
+    std::vector<Job*> jobs;
+    { std::lock_guard<std::mutex> lock(s->mainMutex); jobs.swap(s->mainJobs); }
+    for (Job* j : jobs) execute(j);
+}
+
+bool detail::localQueueEmpty() {
+    Scheduler* s = g_sched.load(std::memory_order_acquire);
+    return !s || t_index < 0 || s->deques[t_index]->empty();
+}
+
+} // namespace eng::jobs
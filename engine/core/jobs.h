@@ -0,0 +1,124 @@
+#pragma once
+#include "memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Shared work-stealing job system.
+//   eng::jobs::init();                                   once, from the main thread
+//   eng::jobs::Group g;
+//   eng::jobs::run(g, [&] { ... });                      any thread
+//   eng::jobs::after(g, next, [&] { ... });              runs once g has drained; counted in next
+//   eng::jobs::runOnMain(g, [&] { glfw... });            executed by the main thread only
+//   eng::jobs::parallelFor(0, n, [&](size_t b, size_t e) { ... });
+//   eng::jobs::wait(g);                                  executes other jobs until g is done
+// Each worker owns a Chase-Lev deque: it pushes and pops at the bottom, idle workers steal from
+// the top, so related work stays on one core until someone runs dry. Threads without a deque
+// submit through a shared queue. Before init() (or after shutdown()) every job runs inline on
+// the submitting thread, so code using jobs works unchanged in tools and single-threaded runs.
+// Main-thread jobs run in pumpMain() (once per frame) and while the main thread waits.
+
+namespace eng::jobs {
+    struct Config {
+        unsigned workers = 0;        // 0 = one per hardware thread besides the main thread
+        bool pinThreads = false;     // pin the main thread to core 0 and worker i to core i
+        uint32_t dequeCapacity = 4096; // per worker, power of two; overflow goes to the shared queue
+    };
+
+    class Group;
+
+    struct Job {
+        virtual ~Job() = default;
+        virtual void execute() = 0;
+        Group* group = nullptr;
+        // Jobs are small and short-lived: they come from the thread-local pools, not the heap
+        static void* operator new(size_t bytes) { return memory::poolAllocate(bytes); }
+        static void operator delete(void* p, size_t bytes) { memory::poolDeallocate(p, bytes); }
+    };
+
+    // Counts a set of unfinished jobs. Jobs registered with after() are scheduled when the count
+    // drops to zero. A group may be reused once done; it must be done before it is destroyed.
+    class Group {
+    public:
+        Group() = default;
+        Group(const Group&) = delete; Group& operator=(const Group&) = delete;
+        bool done() const { return pending_.load(std::memory_order_acquire) == 0 && finishing_.load(std::memory_order_acquire) == 0; }
+    private:
+        friend struct Access;
+        std::atomic<uint32_t> pending_{0};
+        std::atomic<uint32_t> finishing_{0}; // threads still touching the group after their decrement
+        std::mutex mutex_;                  // guards continuations_
+        std::vector<Job*> continuations_;
+    };
+
+    bool init(const Config& cfg = {});
+    void shutdown(); // joins the workers, then runs whatever is still queued; no other thread may submit meanwhile
+    bool running();
+    unsigned threadCount();   // workers + the main thread; 1 when not running
+    int threadIndex();        // 0 main thread, 1.. workers, -1 any other thread
+
+    // Ownership of job passes to the system
+    void submit(Group& g, Job* job);
+    void submitAfter(Group& dependency, Group& g, Job* job);
+    void submitMain(Group& g, Job* job);
+
+    void wait(Group& g);
+    void pumpMain(); // main thread only
+
+    template <class F> struct FnJob final : Job {
+        F fn;
+        explicit FnJob(F&& f) : fn(std::move(f)) {}
+        explicit FnJob(const F& f) : fn(f) {}
+        void execute() override { fn(); }
+    };
+
+    template <class F> void run(Group& g, F&& fn) { submit(g, new FnJob<std::decay_t<F>>(std::forward<F>(fn))); }
+    template <class F> void after(Group& dependency, Group& g, F&& fn) { submitAfter(dependency, g, new FnJob<std::decay_t<F>>(std::forward<F>(fn))); }
+    template <class F> void runOnMain(Group& g, F&& fn) { submitMain(g, new FnJob<std::decay_t<F>>(std::forward<F>(fn))); }
+
+    namespace detail {
+        bool localQueueEmpty(); // the calling worker's deque is empty (true for threads without one)
+
+        // Lazy binary splitting: a range hands its upper half to the deque only while the deque is
+        // empty, i.e. while every earlier half has been stolen; otherwise it works through grain-sized
+        // chunks itself. Busy machines split little, idle ones split until every worker has work.
+        template <class F> void splitRun(size_t b, size_t e, size_t grain, F& fn, Group& g);
+
+        template <class F> struct RangeJob final : Job {
+            size_t b, e, grain; F* fn; Group* g;
+            RangeJob(size_t b_, size_t e_, size_t grain_, F* fn_, Group* g_) : b(b_), e(e_), grain(grain_), fn(fn_), g(g_) {}
+            void execute() override { splitRun(b, e, grain, *fn, *g); }
+        };
+
+        template <class F> void splitRun(size_t b, size_t e, size_t grain, F& fn, Group& g) {
+            while (e - b > grain) {
+                if (localQueueEmpty()) {
+                    size_t mid = b + (e - b) / 2;
+                    submit(g, new RangeJob<F>(mid, e, grain, &fn, &g));
+                    e = mid;
+                } else {
+                    fn(b, b + grain);
+                    b += grain;
+                }
+            }
+            if (b < e) fn(b, e);
+        }
+    }
+
+    // fn(begin, end) over sub-ranges of [begin, end); returns when all are done. grain is the
+    // smallest range worth a job (0 = about 16 chunks per thread).
+    template <class F> void parallelFor(size_t begin, size_t end, F&& fn, size_t grain = 0) {
+        if (end <= begin) return;
+        size_t n = end - begin;
+        if (grain == 0) grain = std::max<size_t>(1, n / (threadCount() * 16));
+        if (!running() || threadCount() == 1 || n <= grain) { fn(begin, end); return; }
+        Group g;
+        detail::splitRun(begin, end, grain, fn, g);
+        wait(g);
+    }
+}
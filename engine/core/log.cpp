@@ -0,0 +1,414 @@
+#include "log.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+using namespace eng::log;
+using namespace eng::log::detail;
+
+namespace {
+    std::atomic<bool> g_alive{true}; // false once the backend has shut down; later logs are written synchronously
+
+    // Record layout in a thread ring (8-byte aligned):
+    //   u32 size (whole record incl. header; kPad marks filler up to the ring end)
+    //   u8 level, 3 bytes pad, u64 wall-clock ns, const char* fmt, encoded args...
+    constexpr uint32_t kPad = 0xFFFFFFFFu;
+    constexpr size_t kHeader = 8 + 8 + sizeof(const char*);
+    constexpr size_t kRingBytes = 256 * 1024;
+
+    inline size_t align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+    struct Ring {
+        std::unique_ptr<uint8_t[]> data{ new uint8_t[kRingBytes] };
+        std::atomic<uint64_t> head{0};    // written by the owning thread
+        std::atomic<uint64_t> tail{0};    // written by the flush thread
+        std::atomic<bool> retired{false}; // owning thread exited
+        uint64_t reserved = 0;            // producer-local: head of the record being written
+    };
+
+    struct FileSink {
+        std::string path;
+        std::FILE* file = nullptr;
+        size_t bytes = 0, maxBytes = 0;
+        int maxFiles = 0;
+    };
+
+    struct Line { uint64_t ns; Level lvl; std::string text; };
+
+    struct Backend {
+        std::atomic<uint8_t> minLevel{(uint8_t)Level::Info};
+        std::atomic<bool> console{true};
+        std::atomic<uint64_t> dropped{0};
+
+        std::mutex mutex; // guards rings list, sinks, and the flush handshake
+        std::condition_variable wake, flushed;
+        std::vector<std::shared_ptr<Ring>> rings;
+        std::vector<FileSink> files;
+        uint64_t flushRequested = 0, flushCompleted = 0;
+        bool running = false, stopping = false;
+        std::thread worker;
+
+        ~Backend() { stop(); g_alive.store(false); }
+        void start();
+        void stop();
+        void run();
+        bool drain(std::vector<Line>& out);
+        void emit(std::vector<Line>& lines);
+    };
+
+    Backend& backend() { static Backend b; return b; }
+
+    struct RingHolder {
+        std::shared_ptr<Ring> ring;
+        ~RingHolder() { if (ring) ring->retired.store(true, std::memory_order_release); }
+    };
+
+    Ring& threadRing() {
+        thread_local RingHolder holder;
+        if (!holder.ring) {
+            holder.ring = std::make_shared<Ring>();
+            Backend& b = backend();
+            std::lock_guard<std::mutex> lock(b.mutex);
+            b.rings.push_back(holder.ring);
+            b.start();
+        }
+        return *holder.ring;
+    }
+
+    uint64_t wallNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+    }
+
+    const char* levelTag(Level l) {
+        switch (l) {
+            case Level::Debug: return "[DEBUG] ";
+            case Level::Info: return "[INFO] ";
+            case Level::Warn: return "[WARN] ";
+            default: return "[ERROR] ";
+        }
+    }
+
+    struct Arg { Tag tag; uint64_t bits; const char* str; uint32_t len; };
+
+    const uint8_t* decodeArg(const uint8_t* p, const uint8_t* end, Arg& a) {
+        if (p >= end) return nullptr;
+        a.tag = (Tag)*p++;
+        if (a.tag == Tag::Str) {
+            std::memcpy(&a.len, p, sizeof(a.len)); p += sizeof(a.len);
+            a.str = (const char*)p; return p + a.len;
+        }
+        std::memcpy(&a.bits, p, 8); return p + 8;
+    }
+
+    // snprintf straight into out; long results (wide fields, huge %f) are not truncated
+    template<typename T> void appendf(std::string& out, const char* spec, T v) {
+        char buf[128];
+        int len = std::snprintf(buf, sizeof(buf), spec, v);
+        if (len <= 0) return;
+        if ((size_t)len < sizeof(buf)) { out.append(buf, (size_t)len); return; }
+        size_t at = out.size();
+        out.resize(at + (size_t)len + 1);
+        std::snprintf(&out[at], (size_t)len + 1, spec, v);
+        out.resize(at + (size_t)len);
+    }
+
+    int64_t asInt(const Arg& a) {
+        if (a.tag == Tag::F64) { double d; std::memcpy(&d, &a.bits, 8); return (int64_t)d; }
+        return a.tag == Tag::Str ? 0 : (int64_t)a.bits;
+    }
+
+    // printf-compatible formatting of the captured arguments. Flags, width and precision (including
+    // `*`, which takes the next argument) are resolved here; each conversion is then re-issued
+    // through snprintf with the length modifier normalised to the captured 64-bit type. Strings
+    // are captured with their length, so their width and precision are applied directly.
+    void format(std::string& out, const char* fmt, const uint8_t* args, const uint8_t* end) {
+        for (const char* f = fmt; *f; ++f) {
+            if (*f != '%') { out += *f; continue; }
+            if (f[1] == '%') { out += '%'; ++f; continue; }
+            const char* start = f;
+            const char* s = f + 1;
+            char flags[8]; size_t nflags = 0;
+            while (*s && std::strchr("-+ #0", *s)) { if (nflags < sizeof(flags) - 1) flags[nflags++] = *s; ++s; }
+            bool left = std::memchr(flags, '-', nflags) != nullptr;
+            bool missing = false;
+            auto star = [&]() -> int64_t {
+                Arg a{};
+                const uint8_t* next = decodeArg(args, end, a);
+                if (!next) { missing = true; return 0; }
+                args = next;
+                return asInt(a);
+            };
+            int64_t width = -1, precision = -1;
+            if (*s == '*') { width = star(); ++s; if (width < 0) { left = true; width = -width; } }
+            else if (*s >= '0' && *s <= '9') { width = 0; while (*s >= '0' && *s <= '9') width = width * 10 + (*s++ - '0'); }
+            if (*s == '.') {
+                ++s; precision = 0;
+                if (*s == '*') { precision = star(); ++s; if (precision < 0) precision = -1; }
+                else while (*s >= '0' && *s <= '9') precision = precision * 10 + (*s++ - '0');
+            }
+            while (*s && std::strchr("hlLqjzt", *s)) ++s; // dropped: the captured type decides
+            char conv = *s;
+            if (!conv) break;
+            f = s;
+            Arg a{};
+            const uint8_t* next = missing ? nullptr : decodeArg(args, end, a);
+            if (!next) { out += "<missing>"; continue; }
+            args = next;
+
+            if (a.tag == Tag::Str) {
+                size_t len = precision >= 0 ? std::min<size_t>(a.len, (size_t)precision) : a.len;
+                size_t padding = width > (int64_t)len ? (size_t)width - len : 0;
+                if (!left) out.append(padding, ' ');
+                out.append(a.str, len);
+                if (left) out.append(padding, ' ');
+                continue;
+            }
+            if (conv == 's') conv = a.tag == Tag::F64 ? 'g' : a.tag == Tag::U64 ? 'u' : a.tag == Tag::Ptr ? 'p' : 'd';
+            bool floatConv = std::strchr("eEfFgGaA", conv) != nullptr;
+            bool intConv = std::strchr("diouxXc", conv) != nullptr;
+            if (!floatConv && !intConv && conv != 'p') { out.append(start, f + 1 - start); continue; } // unsupported conversion: emit verbatim
+
+            // Rebuild the spec with the resolved numbers: % flags [width] [.precision] [ll] conv
+            char spec[64];
+            int n = std::snprintf(spec, sizeof(spec), "%%%s%.*s", left ? "-" : "", (int)nflags, flags);
+            if (width >= 0) n += std::snprintf(spec + n, sizeof(spec) - n, "%lld", (long long)std::min<int64_t>(width, 1 << 20));
+            if (precision >= 0 && conv != 'c' && conv != 'p') n += std::snprintf(spec + n, sizeof(spec) - n, ".%lld", (long long)std::min<int64_t>(precision, 1 << 20));
+            if (floatConv) {
+                double d; if (a.tag == Tag::F64) std::memcpy(&d, &a.bits, 8); else d = a.tag == Tag::I64 ? (double)(int64_t)a.bits : (double)a.bits;
+                spec[n++] = conv; spec[n] = 0; appendf(out, spec, d);
+            } else if (conv == 'p') {
+                spec[n++] = 'p'; spec[n] = 0; appendf(out, spec, (void*)(uintptr_t)a.bits);
+            } else {
+                uint64_t v = (uint64_t)asInt(a);
+                if (conv == 'c') { spec[n++] = 'c'; spec[n] = 0; appendf(out, spec, (int)v); }
+                else {
+                    spec[n++] = 'l'; spec[n++] = 'l'; spec[n++] = conv; spec[n] = 0;
+                    if (conv == 'd' || conv == 'i') appendf(out, spec, (long long)v); else appendf(out, spec, (unsigned long long)v);
+                }
+            }
+        }
+    }
+
+    void appendTimestamp(std::string& out, uint64_t ns) {
+        std::time_t secs = (std::time_t)(ns / 1000000000ull);
+        std::tm tm{};
+#if defined(_WIN32)
+        localtime_s(&tm, &secs);
+#else
+        localtime_r(&secs, &tm);
+#endif
+        char buf[32];
+        std::snprintf(buf, sizeof(buf), "%02d:%02d:%02d.%03u ", tm.tm_hour, tm.tm_min, tm.tm_sec, (unsigned)((ns / 1000000ull) % 1000));
+        out += buf;
+    }
+
+    void formatRecord(std::string& out, Level lvl, uint64_t ns, const char* fmt, const uint8_t* args, const uint8_t* end) {
+        appendTimestamp(out, ns);
+        out += levelTag(lvl);
+        format(out, fmt, args, end);
+        out += '\n';
+    }
+
+    void Backend::start() {
+        if (running) return;
+        running = true; stopping = false;
+        worker = std::thread([this] { run(); });
+    }
+
+    void Backend::stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) return;
+            stopping = true;
+            g_alive.store(false); // from here on, callers format synchronously
+        }
+        wake.notify_all();
+        worker.join();
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+        for (auto& f : files) if (f.file) { std::fclose(f.file); f.file = nullptr; }
+        files.clear();
+    }
+
+    bool Backend::drain(std::vector<Line>& out) {
+        std::vector<std::shared_ptr<Ring>> snapshot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            snapshot = rings;
+        }
+        bool any = false;
+        for (auto& r : snapshot) {
+            uint64_t tail = r->tail.load(std::memory_order_relaxed);
+            uint64_t head = r->head.load(std::memory_order_acquire);
+            while (tail < head) {
+                const uint8_t* rec = r->data.get() + (tail % kRingBytes);
+                uint32_t size; std::memcpy(&size, rec, 4);
+                if (size == kPad) { tail += kRingBytes - (tail % kRingBytes); continue; }
+                Line line; line.lvl = (Level)rec[4];
+                const char* fmt;
+                std::memcpy(&line.ns, rec + 8, 8);
+                std::memcpy(&fmt, rec + 16, sizeof(fmt));
+                formatRecord(line.text, line.lvl, line.ns, fmt, rec + kHeader, rec + size);
+                out.push_back(std::move(line));
+                tail += align8(size);
+                any = true;
+            }
+            r->tail.store(tail, std::memory_order_release);
+        }
+        // Forget rings whose thread has exited and which are fully drained
+        std::lock_guard<std::mutex> lock(mutex);
+        rings.erase(std::remove_if(rings.begin(), rings.end(), [](const std::shared_ptr<Ring>& r) {
+            return r->retired.load(std::memory_order_acquire) && r->tail.load() == r->head.load(std::memory_order_acquire);
+        }), rings.end());
+        return any;
+    }
+
+    void rotate(FileSink& f) {
+        if (f.file) std::fclose(f.file);
+        for (int i = f.maxFiles - 1; i >= 1; --i) {
+            std::string from = f.path + "." + std::to_string(i), to = f.path + "." + std::to_string(i + 1);
+            std::remove(to.c_str()); std::rename(from.c_str(), to.c_str());
+        }
+        if (f.maxFiles > 0) { std::string to = f.path + ".1"; std::remove(to.c_str()); std::rename(f.path.c_str(), to.c_str()); }
+        f.file = std::fopen(f.path.c_str(), "wb");
+        f.bytes = 0;
+    }
+
+    void Backend::emit(std::vector<Line>& lines) {
+        // Merge threads into a single timeline
+        std::stable_sort(lines.begin(), lines.end(), [](const Line& a, const Line& b) { return a.ns < b.ns; });
+        uint64_t lost = dropped.exchange(0);
+        if (lost) lines.push_back({wallNs(), Level::Warn, "[WARN] log buffer full, dropped " + std::to_string(lost) + " messages\n"});
+        bool toConsole = console.load();
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& l : lines) {
+            if (toConsole) std::fputs(l.text.c_str(), l.lvl >= Level::Warn ? stderr : stdout);
+            for (auto& f : files) {
+                if (!f.file) continue;
+                if (f.maxBytes && f.bytes + l.text.size() > f.maxBytes) rotate(f);
+                if (f.file) { std::fputs(l.text.c_str(), f.file); f.bytes += l.text.size(); }
+            }
+        }
+        if (toConsole) { std::fflush(stdout); std::fflush(stderr); }
+        for (auto& f : files) if (f.file) std::fflush(f.file);
+    }
+
+    void Backend::run() {
+        std::vector<Line> lines;
+        for (;;) {
+            uint64_t request;
+            bool exiting;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait_for(lock, std::chrono::milliseconds(10));
+                request = flushRequested;
+                exiting = stopping;
+            }
+            lines.clear();
+            drain(lines);
+            if (!lines.empty() || dropped.load()) emit(lines);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                flushCompleted = request;
+            }
+            flushed.notify_all();
+            if (exiting) break;
+        }
+    }
+}
+
+namespace eng::log {
+    void setLevel(Level lvl) { backend().minLevel.store((uint8_t)lvl); }
+    Level level() { return (Level)backend().minLevel.load(); }
+    void setConsole(bool enabled) { backend().console.store(enabled); }
+
+    bool addFileSink(const char* path, size_t maxBytes, int maxFiles) {
+        Backend& b = backend();
+        std::lock_guard<std::mutex> lock(b.mutex);
+        FileSink f; f.path = path; f.maxBytes = maxBytes; f.maxFiles = maxFiles;
+        f.file = std::fopen(path, "ab");
+        if (!f.file) return false;
+        std::fseek(f.file, 0, SEEK_END);
+        f.bytes = (size_t)std::max(0L, std::ftell(f.file));
+        b.files.push_back(std::move(f));
+        return true;
+    }
+
+    void flush() {
+        Backend& b = backend();
+        std::unique_lock<std::mutex> lock(b.mutex);
+        if (!b.running) return;
+        uint64_t gen = ++b.flushRequested;
+        b.wake.notify_all();
+        b.flushed.wait(lock, [&] { return b.flushCompleted >= gen || !b.running; });
+    }
+
+    void shutdown() { backend().stop(); }
+
+    namespace detail {
+        bool enabled(Level lvl) { return (uint8_t)lvl >= backend().minLevel.load(std::memory_order_relaxed); }
+
+        // Records that cannot go through a ring (backend stopped, or larger than half a ring)
+        // are built here and written synchronously by commit()
+        thread_local std::vector<uint8_t> t_sync;
+        thread_local bool t_isSync = false;
+
+        static void writeHeader(uint8_t* p, size_t size, Level lvl, const char* fmt) {
+            uint32_t sz = (uint32_t)size; std::memcpy(p, &sz, 4);
+            p[4] = (uint8_t)lvl;
+            uint64_t ns = wallNs(); std::memcpy(p + 8, &ns, 8);
+            std::memcpy(p + 16, &fmt, sizeof(fmt));
+        }
+
+        uint8_t* begin(Level lvl, const char* fmt, size_t bytes) {
+            size_t size = kHeader + bytes;
+            size_t need = align8(size);
+            if (!g_alive.load(std::memory_order_relaxed) || need > kRingBytes / 2) {
+                t_sync.resize(size);
+                writeHeader(t_sync.data(), size, lvl, fmt);
+                t_isSync = true;
+                return t_sync.data() + kHeader;
+            }
+            Ring& r = threadRing();
+            uint64_t head = r.head.load(std::memory_order_relaxed);
+            uint64_t tail = r.tail.load(std::memory_order_acquire);
+            size_t off = head % kRingBytes;
+            size_t pad = (kRingBytes - off < need) ? kRingBytes - off : 0;
+            if (head + pad + need - tail > kRingBytes) { backend().dropped.fetch_add(1, std::memory_order_relaxed); return nullptr; }
+            if (pad) { std::memcpy(r.data.get() + off, &kPad, 4); head += pad; off = 0; }
+            uint8_t* p = r.data.get() + off;
+            writeHeader(p, size, lvl, fmt);
+            r.reserved = head + need;
+            return p + kHeader;
+        }
+
+        void commit(Level lvl) {
+            if (t_isSync) {
+                t_isSync = false;
+                const uint8_t* p = t_sync.data();
+                uint64_t ns; const char* fmt;
+                std::memcpy(&ns, p + 8, 8); std::memcpy(&fmt, p + 16, sizeof(fmt));
+                std::string text;
+                formatRecord(text, lvl, ns, fmt, p + kHeader, p + t_sync.size());
+                std::fputs(text.c_str(), lvl >= Level::Warn ? stderr : stdout);
+                return;
+            }
+            Ring& r = threadRing();
+            uint64_t prev = r.head.load(std::memory_order_relaxed);
+            r.head.store(r.reserved, std::memory_order_release);
+            // Wake the flusher early for errors, or when this ring just crossed half full
+            uint64_t used = r.reserved - r.tail.load(std::memory_order_relaxed);
+            bool crossed = used >= kRingBytes / 2 && used - (r.reserved - prev) < kRingBytes / 2;
+            if (lvl >= Level::Error || crossed) backend().wake.notify_one();
+        }
+    }
+}
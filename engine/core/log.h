@@ -1,27 +1,89 @@
 #pragma once
-#include <cstdio>
-#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+
+// Asynchronous printf-style logging.
+// The calling thread only copies the format pointer, a timestamp and the raw arguments into its
+// own ring buffer; a background thread formats and writes to stdout/stderr and optional file sinks.
+// Format strings must be string literals (they are read later); string arguments are copied.
+// Levels below ENG_LOG_MIN_LEVEL (0=debug .. 3=error) compile to nothing.
+
+#ifndef ENG_LOG_MIN_LEVEL
+#define ENG_LOG_MIN_LEVEL 0
+#endif
 
 namespace eng::log {
-    inline void info(const char* fmt, ...) {
-        va_list args; va_start(args, fmt);
-        std::fputs("[INFO] ", stdout);
-        std::vfprintf(stdout, fmt, args);
-        std::fputc('\n', stdout);
-        va_end(args);
+    enum class Level : uint8_t { Debug = 0, Info = 1, Warn = 2, Error = 3, Off = 4 };
+
+    void setLevel(Level lvl);          // runtime filter, default Info
+    Level level();
+    bool addFileSink(const char* path, size_t maxBytes = 8u << 20, int maxFiles = 3); // rotates path -> path.1 .. path.N
+    void setConsole(bool enabled);     // stdout/stderr sink, on by default
+    void flush();                      // blocks until everything logged so far reached the sinks
+    void shutdown();                   // flushes and stops the background thread (also done at exit)
+
+    namespace detail {
+        enum class Tag : uint8_t { I64, U64, F64, Str, Ptr };
+
+        bool enabled(Level lvl);
+        // Reserves a record of `bytes` payload in the calling thread's ring; nullptr if full (message dropped)
+        uint8_t* begin(Level lvl, const char* fmt, size_t bytes);
+        void commit(Level lvl);
+
+        template<typename T> constexpr bool isStr() {
+            using D = std::decay_t<T>;
+            return std::is_same_v<D, const char*> || std::is_same_v<D, char*> || std::is_same_v<D, std::string>;
+        }
+        inline size_t strLen(const char* s) { return s ? std::strlen(s) : 0; }
+        inline size_t strLen(const std::string& s) { return s.size(); }
+        inline const char* strPtr(const char* s) { return s ? s : ""; }
+        inline const char* strPtr(const std::string& s) { return s.c_str(); }
+
+        template<typename T> size_t argSize(const T& v) {
+            if constexpr (isStr<T>()) return 1 + sizeof(uint32_t) + strLen(v);
+            else return 1 + sizeof(uint64_t);
+        }
+
+        template<typename T> uint8_t* encode(uint8_t* p, const T& v) {
+            using D = std::decay_t<T>;
+            if constexpr (isStr<T>()) {
+                uint32_t n = (uint32_t)strLen(v);
+                *p++ = (uint8_t)Tag::Str; std::memcpy(p, &n, sizeof(n)); p += sizeof(n);
+                std::memcpy(p, strPtr(v), n); return p + n;
+            } else {
+                Tag tag; uint64_t bits = 0;
+                if constexpr (std::is_floating_point_v<D>) { tag = Tag::F64; double d = (double)v; std::memcpy(&bits, &d, 8); }
+                else if constexpr (std::is_pointer_v<D> || std::is_null_pointer_v<D>) { tag = Tag::Ptr; bits = (uint64_t)(uintptr_t)v; }
+                else if constexpr (std::is_enum_v<D>) { tag = Tag::I64; bits = (uint64_t)(int64_t)v; }
+                else if constexpr (std::is_signed_v<D>) { tag = Tag::I64; bits = (uint64_t)(int64_t)v; }
+                else { static_assert(std::is_integral_v<D>, "unsupported log argument type"); tag = Tag::U64; bits = (uint64_t)v; }
+                *p++ = (uint8_t)tag; std::memcpy(p, &bits, 8); return p + 8;
+            }
+        }
+
+        template<typename... Args> void write(Level lvl, const char* fmt, const Args&... args) {
+            if (!enabled(lvl)) return;
+            size_t bytes = (size_t{0} + ... + argSize(args));
+            uint8_t* p = begin(lvl, fmt, bytes);
+            if (!p) return;
+            ((p = encode(p, args)), ...);
+            commit(lvl);
+        }
+    }
+
+    template<typename... Args> inline void debug(const char* fmt, const Args&... args) {
+        if constexpr (ENG_LOG_MIN_LEVEL <= 0) detail::write(Level::Debug, fmt, args...);
+    }
+    template<typename... Args> inline void info(const char* fmt, const Args&... args) {
+        if constexpr (ENG_LOG_MIN_LEVEL <= 1) detail::write(Level::Info, fmt, args...);
     }
-    inline void warn(const char* fmt, ...) {
-        va_list args; va_start(args, fmt);
-        std::fputs("[WARN] ", stderr);
-        std::vfprintf(stderr, fmt, args);
-        std::fputc('\n', stderr);
-        va_end(args);
+    template<typename... Args> inline void warn(const char* fmt, const Args&... args) {
+        if constexpr (ENG_LOG_MIN_LEVEL <= 2) detail::write(Level::Warn, fmt, args...);
     }
-    inline void error(const char* fmt, ...) {
-        va_list args; va_start(args, fmt);
-        std::fputs("[ERROR] ", stderr);
-        std::vfprintf(stderr, fmt, args);
-        std::fputc('\n', stderr);
-        va_end(args);
+    template<typename... Args> inline void error(const char* fmt, const Args&... args) {
+        if constexpr (ENG_LOG_MIN_LEVEL <= 3) detail::write(Level::Error, fmt, args...);
     }
 }
@@ -0,0 +1,283 @@
+#include "memory.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+namespace eng::memory {
+
+namespace {
+    std::atomic<uint64_t> g_allocations{0}, g_frees{0}, g_bytes{0};
+    thread_local AllocationStats t_stats; // trivially destructible: usable during thread teardown
+}
+
+#if defined(ENG_COUNT_ALLOCATIONS) && ENG_COUNT_ALLOCATIONS
+bool countingEnabled() { return true; }
+#else
+bool countingEnabled() { return false; }
+#endif
+
+AllocationStats globalStats() {
+    AllocationStats s;
+    s.allocations = g_allocations.load(std::memory_order_relaxed);
+    s.frees = g_frees.load(std::memory_order_relaxed);
+    s.bytes = g_bytes.load(std::memory_order_relaxed);
+    return s;
+}
+
+AllocationStats threadStats() { return t_stats; }
+
+// ---- LinearArena ----
+
+static size_t alignUp(size_t v, size_t a) { return (v + a - 1) & ~(a - 1); }
+
+LinearArena::LinearArena(size_t capacity) : capacity_(capacity) {
+    if (capacity_) base_ = static_cast<char*>(::operator new(capacity_, std::align_val_t(64)));
+}
+
+LinearArena::~LinearArena() { release(); }
+
+LinearArena::LinearArena(LinearArena&& o) noexcept
+    : base_(o.base_), capacity_(o.capacity_), offset_(o.offset_), highWater_(o.highWater_), overflowBytes_(o.overflowBytes_), overflow_(o.overflow_) {
+    o.base_ = nullptr; o.capacity_ = o.offset_ = o.highWater_ = o.overflowBytes_ = 0; o.overflow_ = nullptr;
+}
+
+LinearArena& LinearArena::operator=(LinearArena&& o) noexcept {
+    if (this == &o) return *this;
+    release();
+    base_ = o.base_; capacity_ = o.capacity_; offset_ = o.offset_; highWater_ = o.highWater_; overflowBytes_ = o.overflowBytes_; overflow_ = o.overflow_;
+    o.base_ = nullptr; o.capacity_ = o.offset_ = o.highWater_ = o.overflowBytes_ = 0; o.overflow_ = nullptr;
+    return *this;
+}
+
+void LinearArena::release() {
+    while (overflow_) { Overflow* next = overflow_->next; ::operator delete(overflow_); overflow_ = next; }
+    if (base_) ::operator delete(base_, std::align_val_t(64));
+    base_ = nullptr;
+}
+
+void* LinearArena::allocate(size_t bytes, size_t align) {
+    if (bytes == 0) bytes = 1;
+    size_t at = alignUp(offset_, align);
+    if (at + bytes <= capacity_) { offset_ = at + bytes; return base_ + at; }
+    // Past the block: a heap block per allocation, header first, freed on reset(). operator new
+    // only guarantees max_align_t, so stricter alignments get room to align within the block.
+    size_t extra = align > alignof(std::max_align_t) ? align : 0;
+    auto* block = static_cast<Overflow*>(::operator new(alignUp(sizeof(Overflow), alignof(std::max_align_t)) + extra + bytes));
+    block->next = overflow_; overflow_ = block;
+    overflowBytes_ += bytes;
+    return reinterpret_cast<void*>(alignUp((uintptr_t)block + sizeof(Overflow), std::max(align, alignof(std::max_align_t))));
+}
+
+void LinearArena::reset() {
+    highWater_ = std::max(highWater_, offset_ + overflowBytes_);
+    if (overflow_) {
+        // Grow once to cover the whole last cycle, with headroom, instead of overflowing every cycle
+        while (overflow_) { Overflow* next = overflow_->next; ::operator delete(overflow_); overflow_ = next; }
+        if (base_) ::operator delete(base_, std::align_val_t(64));
+        capacity_ = alignUp(highWater_ + highWater_ / 4, 4096);
+        base_ = static_cast<char*>(::operator new(capacity_, std::align_val_t(64)));
+    }
+    offset_ = 0; overflowBytes_ = 0;
+}
+
+// ---- FrameArena ----
+
+FrameArena::FrameArena(uint32_t frames, size_t capacityPerFrame) {
+    arenas_.reserve(std::max(frames, 1u));
+    for (uint32_t i = 0; i < std::max(frames, 1u); ++i) arenas_.emplace_back(capacityPerFrame);
+}
+
+void FrameArena::beginFrame(uint64_t frame) {
+    index_ = (uint32_t)(frame % arenas_.size());
+    arenas_[index_].reset();
+}
+
+size_t FrameArena::highWater() const {
+    size_t h = 0;
+    for (const auto& a : arenas_) h = std::max(h, a.highWater());
+    return h;
+}
+
+// ---- Thread-local pools ----
+//
+// Each thread owns one pool per size class. Pools carve 64 KiB pages, aligned to their size so a
+// block finds its page (and through it the owning pool) by masking its address. Frees from the
+// owning thread go straight onto its free list; frees from other threads are pushed onto the
+// pool's lock-free remote list, which the owner takes over when its own list runs dry. When a
+// thread exits with blocks still alive, its pools are left in place (and their pages leaked) so
+// those blocks can still be freed safely.
+
+namespace {
+    constexpr size_t kPageSize = 64 * 1024;
+    constexpr size_t kClasses[] = { 16, 32, 64, 128, 256, 512 };
+    constexpr int kClassCount = (int)(sizeof(kClasses) / sizeof(kClasses[0]));
+    static_assert(kClasses[kClassCount - 1] == kMaxPoolBlock, "largest size class must match kMaxPoolBlock");
+
+    struct Cache;
+    struct Pool;
+    struct Node { Node* next; };
+    struct alignas(16) Page { Pool* owner; Page* next; };
+
+    struct Pool {
+        Cache* cache = nullptr;
+        size_t blockSize = 0;
+        Node* free = nullptr;
+        Page* pages = nullptr;
+        uint64_t pageCount = 0;
+        std::atomic<Node*> remote{nullptr};
+        std::atomic<int64_t> live{0};
+
+        void* allocate() {
+            if (!free) free = remote.exchange(nullptr, std::memory_order_acquire);
+            if (!free) grow();
+            Node* n = free; free = n->next;
+            live.fetch_add(1, std::memory_order_relaxed);
+            return n;
+        }
+        void grow() {
+            auto* page = static_cast<Page*>(::operator new(kPageSize, std::align_val_t(kPageSize)));
+            page->owner = this; page->next = pages; pages = page; ++pageCount;
+            char* first = reinterpret_cast<char*>(page) + sizeof(Page);
+            size_t count = (kPageSize - sizeof(Page)) / blockSize;
+            for (size_t i = count; i-- > 0;) {
+                Node* n = reinterpret_cast<Node*>(first + i * blockSize);
+                n->next = free; free = n;
+            }
+        }
+        void freeLocal(void* p) {
+            Node* n = static_cast<Node*>(p); n->next = free; free = n;
+            live.fetch_sub(1, std::memory_order_relaxed);
+        }
+        void freeRemote(void* p) {
+            Node* n = static_cast<Node*>(p);
+            n->next = remote.load(std::memory_order_relaxed);
+            while (!remote.compare_exchange_weak(n->next, n, std::memory_order_release, std::memory_order_relaxed)) {}
+            live.fetch_sub(1, std::memory_order_relaxed);
+        }
+        void releasePages() {
+            while (pages) { Page* next = pages->next; ::operator delete(pages, std::align_val_t(kPageSize)); pages = next; }
+        }
+    };
+
+    struct Cache {
+        Pool pools[kClassCount];
+        Cache() { for (int i = 0; i < kClassCount; ++i) { pools[i].cache = this; pools[i].blockSize = kClasses[i]; } }
+    };
+
+    thread_local Cache* t_cache = nullptr;
+    thread_local bool t_exiting = false;
+
+    // Runs at thread exit: hands the pools back if nothing is alive, otherwise orphans them
+    struct CacheReaper {
+        ~CacheReaper() {
+            Cache* c = t_cache;
+            t_exiting = true; t_cache = nullptr;
+            if (!c) return;
+            bool alive = false;
+            for (auto& p : c->pools) alive |= p.live.load(std::memory_order_acquire) != 0;
+            if (alive) return; // later frees find the pool through their page and go to its remote list
+            for (auto& p : c->pools) p.releasePages();
+            delete c;
+        }
+    };
+    thread_local CacheReaper t_reaper;
+
+    Cache& cache() {
+        if (!t_cache) {
+            t_cache = new Cache();
+            if (!t_exiting) (void)&t_reaper; // odr-use registers the reaper for this thread
+        }
+        return *t_cache;
+    }
+
+    int sizeClass(size_t bytes) {
+        int c = 0;
+        while (kClasses[c] < bytes) ++c;
+        return c;
+    }
+}
+
+void* poolAllocate(size_t bytes) {
+    if (bytes > kMaxPoolBlock) return ::operator new(bytes);
+    return cache().pools[sizeClass(std::max<size_t>(bytes, 1))].allocate();
+}
+
+void poolDeallocate(void* p, size_t bytes) {
+    if (!p) return;
+    if (bytes > kMaxPoolBlock) { ::operator delete(p); return; }
+    Page* page = reinterpret_cast<Page*>(reinterpret_cast<uintptr_t>(p) & ~(uintptr_t)(kPageSize - 1));
+    Pool* pool = page->owner;
+    if (pool->cache == t_cache) pool->freeLocal(p);
+    else pool->freeRemote(p);
+}
+
+PoolStats threadPoolStats() {
+    PoolStats s;
+    if (!t_cache) return s;
+    for (const auto& p : t_cache->pools) { s.liveBlocks += (uint64_t)std::max<int64_t>(0, p.live.load(std::memory_order_relaxed)); s.pages += p.pageCount; }
+    return s;
+}
+
+} // namespace eng::memory
+
+// ---- Counting global operator new/delete ----
+
+#if defined(ENG_COUNT_ALLOCATIONS) && ENG_COUNT_ALLOCATIONS
+namespace {
+    inline void countAlloc(size_t n) {
+        eng::memory::t_stats.allocations++; eng::memory::t_stats.bytes += n;
+        eng::memory::g_allocations.fetch_add(1, std::memory_order_relaxed);
+        eng::memory::g_bytes.fetch_add(n, std::memory_order_relaxed);
+    }
+    inline void countFree() {
+        eng::memory::t_stats.frees++;
+        eng::memory::g_frees.fetch_add(1, std::memory_order_relaxed);
+    }
+    void* countedAlloc(size_t n) {
+        countAlloc(n);
+        if (void* p = std::malloc(n ? n : 1)) return p;
+        throw std::bad_alloc();
+    }
+    void* countedAlignedAlloc(size_t n, size_t align) {
+        countAlloc(n);
+#if defined(_WIN32)
+        if (void* p = _aligned_malloc(n ? n : 1, align)) return p;
+#else
+        if (void* p = std::aligned_alloc(align, ((n ? n : 1) + align - 1) & ~(align - 1))) return p;
+#endif
+        throw std::bad_alloc();
+    }
+    void countedFree(void* p) { if (p) { countFree(); std::free(p); } }
+    void countedAlignedFree(void* p) {
+        if (!p) return;
+        countFree();
+#if defined(_WIN32)
+        _aligned_free(p);
+#else
+        std::free(p);
+#endif
+    }
+}
+
+void* operator new(size_t n) { return countedAlloc(n); }
+void* operator new[](size_t n) { return countedAlloc(n); }
+void* operator new(size_t n, std::align_val_t a) { return countedAlignedAlloc(n, (size_t)a); }
+void* operator new[](size_t n, std::align_val_t a) { return countedAlignedAlloc(n, (size_t)a); }
+void* operator new(size_t n, const std::nothrow_t&) noexcept { try { return countedAlloc(n); } catch (...) { return nullptr; } }
+void* operator new[](size_t n, const std::nothrow_t&) noexcept { try { return countedAlloc(n); } catch (...) { return nullptr; } }
+void* operator new(size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { try { return countedAlignedAlloc(n, (size_t)a); } catch (...) { return nullptr; } }
+void* operator new[](size_t n, std::align_val_t a, const std::nothrow_t&) noexcept { try { return countedAlignedAlloc(n, (size_t)a); } catch (...) { return nullptr; } }
+void operator delete(void* p) noexcept { countedFree(p); }
+void operator delete[](void* p) noexcept { countedFree(p); }
+void operator delete(void* p, size_t) noexcept { countedFree(p); }
+void operator delete[](void* p, size_t) noexcept { countedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { countedAlignedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { countedAlignedFree(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept { countedAlignedFree(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept { countedAlignedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedAlignedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { countedAlignedFree(p); }
+#endif
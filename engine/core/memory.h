@@ -0,0 +1,124 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// Allocators for hot paths that would otherwise churn the general heap.
+//   LinearArena      bump allocator; reset() frees everything at once
+//   FrameArena       one LinearArena per frame in flight, reset when its frame slot comes around
+//   poolAllocate()   fixed-size blocks from per-thread size-class pools (16..512 bytes)
+//   ArenaAllocator / PoolAllocator  STL adapters, e.g. ArenaVector<T> or std::map<K, V, L, PoolAllocator<...>>
+// Allocation counting: with ENG_COUNT_ALLOCATIONS=1 (CMake: -DENGINE_COUNT_ALLOCATIONS=ON) the global
+// operator new/delete are replaced by counting versions, so a scope can assert it did not touch the heap:
+//   eng::memory::AllocationScope scope; ...; scope.allocations() == 0
+
+namespace eng::memory {
+    struct AllocationStats {
+        uint64_t allocations = 0, frees = 0, bytes = 0; // bytes requested, not freed
+    };
+
+    bool countingEnabled();          // false: the stats below stay zero
+    AllocationStats globalStats();   // every thread since start
+    AllocationStats threadStats();   // the calling thread since it started
+
+    // Counts the calling thread's heap traffic from construction on
+    class AllocationScope {
+    public:
+        AllocationScope() : start_(threadStats()) {}
+        uint64_t allocations() const { return threadStats().allocations - start_.allocations; }
+        uint64_t bytes() const { return threadStats().bytes - start_.bytes; }
+        void restart() { start_ = threadStats(); }
+    private:
+        AllocationStats start_;
+    };
+
+    // Single-threaded bump allocator over one block. Allocations past the block still succeed from
+    // the heap; the next reset() then grows the block to the high-water mark, so a workload of
+    // stable size stops allocating after its first cycle. Destructors are never run.
+    class LinearArena {
+    public:
+        explicit LinearArena(size_t capacity = 0);
+        ~LinearArena();
+        LinearArena(LinearArena&& o) noexcept;
+        LinearArena& operator=(LinearArena&& o) noexcept;
+        LinearArena(const LinearArena&) = delete; LinearArena& operator=(const LinearArena&) = delete;
+
+        void* allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+        template <class T> T* allocArray(size_t n) {
+            static_assert(std::is_trivially_destructible_v<T>, "arena memory is released without running destructors");
+            return static_cast<T*>(allocate(n * sizeof(T), alignof(T)));
+        }
+        void reset();
+
+        size_t used() const { return offset_ + overflowBytes_; }
+        size_t capacity() const { return capacity_; }
+        size_t highWater() const { return highWater_; }  // most bytes in use before a reset
+        size_t overflowBytes() const { return overflowBytes_; } // this cycle, beyond the block
+    private:
+        struct Overflow { Overflow* next; };
+        char* base_ = nullptr;
+        size_t capacity_ = 0, offset_ = 0, highWater_ = 0, overflowBytes_ = 0;
+        Overflow* overflow_ = nullptr;
+        void release();
+    };
+
+    // Per-frame scratch memory, double-buffered (or more) for frames in flight: memory handed out
+    // while recording frame N stays valid until beginFrame(N + frames). Single-threaded, like the
+    // frame it serves.
+    class FrameArena {
+    public:
+        explicit FrameArena(uint32_t frames = 2, size_t capacityPerFrame = 1u << 20);
+        void beginFrame(uint64_t frame); // resets slot frame % frames
+        LinearArena& current() { return arenas_[index_]; }
+        template <class T> T* allocArray(size_t n) { return current().template allocArray<T>(n); }
+        size_t highWater() const;
+    private:
+        std::vector<LinearArena> arenas_;
+        uint32_t index_ = 0;
+    };
+
+    // Fixed-size blocks from the calling thread's pools; sizes above kMaxPoolBlock go to the heap.
+    // A block may be freed on any thread (it returns to its owner's pool), but bytes must match.
+    constexpr size_t kMaxPoolBlock = 512;
+    void* poolAllocate(size_t bytes);
+    void poolDeallocate(void* p, size_t bytes);
+
+    struct PoolStats { uint64_t liveBlocks = 0, pages = 0; };
+    PoolStats threadPoolStats(); // the calling thread's pools
+
+    template <class T> class ArenaAllocator {
+    public:
+        using value_type = T;
+        explicit ArenaAllocator(LinearArena& arena) : arena_(&arena) {}
+        template <class U> ArenaAllocator(const ArenaAllocator<U>& o) : arena_(o.arena()) {}
+        T* allocate(size_t n) { return static_cast<T*>(arena_->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) {} // reclaimed by the arena's reset()
+        LinearArena* arena() const { return arena_; }
+        template <class U> bool operator==(const ArenaAllocator<U>& o) const { return arena_ == o.arena(); }
+        template <class U> bool operator!=(const ArenaAllocator<U>& o) const { return arena_ != o.arena(); }
+    private:
+        LinearArena* arena_;
+    };
+
+    template <class T> using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+    // Node containers (list, map, set) allocate one element at a time, which is what the pools suit
+    template <class T> class PoolAllocator {
+    public:
+        using value_type = T;
+        PoolAllocator() = default;
+        template <class U> PoolAllocator(const PoolAllocator<U>&) {}
+        T* allocate(size_t n) {
+            if (alignof(T) > alignof(std::max_align_t)) return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t(alignof(T))));
+            return static_cast<T*>(poolAllocate(n * sizeof(T)));
+        }
+        void deallocate(T* p, size_t n) {
+            if (alignof(T) > alignof(std::max_align_t)) ::operator delete(p, std::align_val_t(alignof(T)));
+            else poolDeallocate(p, n * sizeof(T));
+        }
+        template <class U> bool operator==(const PoolAllocator<U>&) const { return true; }
+        template <class U> bool operator!=(const PoolAllocator<U>&) const { return false; }
+    };
+}
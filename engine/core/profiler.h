@@ -0,0 +1,135 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Scoped CPU zones with Chrome/Perfetto trace export.
+//   ENG_PROFILE_SCOPE("name")   time the enclosing block
+//   ENG_PROFILE_FUNCTION()      same, named after the function
+//   ENG_PROFILE_THREAD("name")  label the calling thread in the trace
+// Zones compile to nothing unless ENG_PROFILER is defined to 1 (CMake: -DENGINE_PROFILER=ON).
+// Names must outlive the export (string literals or __func__).
+
+namespace eng::profiler {
+    using clock = std::chrono::steady_clock;
+
+    inline uint64_t nowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now().time_since_epoch()).count();
+    }
+
+    struct Event { const char* name; uint64_t startNs; uint64_t endNs; };
+
+    // Single-producer ring owned by one thread. The writer never blocks; once full the
+    // oldest events are overwritten and the exporter drops anything it may have torn.
+    struct ThreadBuffer {
+        static constexpr uint32_t kCapacity = 1u << 16;
+        std::unique_ptr<Event[]> events{ new Event[kCapacity] };
+        std::atomic<uint64_t> head{0};
+        uint32_t tid = 0;
+        const char* name = nullptr;
+
+        void push(const char* n, uint64_t start, uint64_t end) {
+            uint64_t h = head.load(std::memory_order_relaxed);
+            events[h & (kCapacity - 1)] = { n, start, end };
+            head.store(h + 1, std::memory_order_release);
+        }
+    };
+
+    struct Registry {
+        std::mutex mutex; // only taken when a thread records its first event, and on export
+        std::vector<std::shared_ptr<ThreadBuffer>> threads;
+        static Registry& get() { static Registry r; return r; }
+    };
+
+    inline ThreadBuffer& threadBuffer() {
+        thread_local std::shared_ptr<ThreadBuffer> buf = [] {
+            auto b = std::make_shared<ThreadBuffer>();
+            Registry& r = Registry::get();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            b->tid = (uint32_t)r.threads.size() + 1;
+            r.threads.push_back(b);
+            return b;
+        }();
+        return *buf;
+    }
+
+    inline void setThreadName(const char* name) { threadBuffer().name = name; }
+
+    struct Zone {
+        const char* name; uint64_t start;
+        explicit Zone(const char* n) : name(n), start(nowNs()) {}
+        ~Zone() { threadBuffer().push(name, start, nowNs()); }
+        Zone(const Zone&) = delete; Zone& operator=(const Zone&) = delete;
+    };
+
+    inline void writeJsonString(std::FILE* f, const char* s) {
+        std::fputc('"', f);
+        for (; *s; ++s) {
+            if (*s == '"' || *s == '\\') { std::fputc('\\', f); std::fputc(*s, f); }
+            else if ((unsigned char)*s < 0x20) std::fprintf(f, "\\u%04x", (unsigned)*s);
+            else std::fputc(*s, f);
+        }
+        std::fputc('"', f);
+    }
+
+    // Writes every buffered zone as Chrome trace "complete" events (load in chrome://tracing or ui.perfetto.dev).
+    // Safe to call while other threads keep recording.
+    inline bool writeChromeTrace(const char* path) {
+        std::FILE* f = std::fopen(path, "wb");
+        if (!f) return false;
+        std::vector<std::shared_ptr<ThreadBuffer>> threads;
+        {
+            Registry& r = Registry::get();
+            std::lock_guard<std::mutex> lock(r.mutex);
+            threads = r.threads;
+        }
+        std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n", f);
+        bool first = true;
+        auto sep = [&] { if (!first) std::fputs(",\n", f); first = false; };
+        std::vector<Event> copy;
+        for (auto& t : threads) {
+            if (t->name) {
+                sep();
+                std::fprintf(f, "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":", t->tid);
+                writeJsonString(f, t->name);
+                std::fputs("}}", f);
+            }
+            uint64_t end = t->head.load(std::memory_order_acquire);
+            uint64_t begin = end > ThreadBuffer::kCapacity ? end - ThreadBuffer::kCapacity : 0;
+            copy.assign(end - begin, Event{});
+            for (uint64_t i = begin; i < end; ++i) copy[i - begin] = t->events[i & (ThreadBuffer::kCapacity - 1)];
+            // Anything the writer lapped while we were copying may be torn, including the slot of
+            // event `after`, which it may be writing right now (it publishes only once done)
+            uint64_t after = t->head.load(std::memory_order_acquire);
+            uint64_t safe = after >= ThreadBuffer::kCapacity ? after - ThreadBuffer::kCapacity + 1 : 0;
+            for (uint64_t i = std::max(begin, safe); i < end; ++i) {
+                const Event& e = copy[i - begin];
+                sep();
+                std::fprintf(f, "{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,\"name\":",
+                             t->tid, e.startNs / 1000.0, (e.endNs - e.startNs) / 1000.0);
+                writeJsonString(f, e.name);
+                std::fputc('}', f);
+            }
+        }
+        std::fputs("\n]}\n", f);
+        return std::fclose(f) == 0;
+    }
+}
+
+#define ENG_PROFILE_CONCAT_(a, b) a##b
+#define ENG_PROFILE_CONCAT(a, b) ENG_PROFILE_CONCAT_(a, b)
+
+#if defined(ENG_PROFILER) && ENG_PROFILER
+    #define ENG_PROFILE_SCOPE(name) ::eng::profiler::Zone ENG_PROFILE_CONCAT(engProfileZone_, __LINE__)(name)
+    #define ENG_PROFILE_FUNCTION() ENG_PROFILE_SCOPE(__func__)
+    #define ENG_PROFILE_THREAD(name) ::eng::profiler::setThreadName(name)
+#else
+    #define ENG_PROFILE_SCOPE(name) ((void)0)
+    #define ENG_PROFILE_FUNCTION() ((void)0)
+    #define ENG_PROFILE_THREAD(name) ((void)0)
+#endif
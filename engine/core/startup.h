@@ -0,0 +1,76 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "log.h"
+#include "profiler.h"
+
+// Startup timeline: wall-clock phases recorded from any thread while the engine comes up, then
+// logged once as one report so overlapping work (Vulkan init, asset loading, terrain generation)
+// is visible at a glance.
+//   eng::startup::Phase p("terrain generate");   time the enclosing block as one phase
+//   eng::startup::mark("first frame");           zero-length milestone
+//   eng::startup::report();                      log every phase so far, ordered by start
+// Phases also show up as profiler zones. Names must be string literals.
+
+namespace eng::startup {
+    using clock = std::chrono::steady_clock;
+
+    struct Record { const char* name; clock::time_point start, end; std::thread::id thread; };
+
+    struct Timeline {
+        std::mutex mutex;
+        clock::time_point origin = clock::now(); // first use, i.e. process launch for all practical purposes
+        std::thread::id mainThread = std::this_thread::get_id();
+        std::vector<Record> records;
+        static Timeline& get() { static Timeline t; return t; }
+    };
+
+    inline void record(const char* name, clock::time_point start, clock::time_point end) {
+        Timeline& t = Timeline::get();
+        std::lock_guard<std::mutex> lock(t.mutex);
+        t.records.push_back({ name, start, end, std::this_thread::get_id() });
+    }
+
+    inline void mark(const char* name) { auto now = clock::now(); record(name, now, now); }
+
+    struct Phase {
+        // Touches the timeline first so its origin never postdates the phase start
+        explicit Phase(const char* n) : name(n), start((Timeline::get(), clock::now())) {}
+        ~Phase() { record(name, start, clock::now()); }
+        Phase(const Phase&) = delete; Phase& operator=(const Phase&) = delete;
+    private:
+        const char* name; clock::time_point start;
+#if defined(ENG_PROFILER) && ENG_PROFILER
+        ::eng::profiler::Zone zone{name};
+#endif
+    };
+
+    // One line per phase: thread lane, start and end relative to launch, duration. The summary
+    // compares the summed phase time with the wall-clock span, i.e. how much the threads overlapped.
+    inline void report() {
+        Timeline& t = Timeline::get();
+        std::vector<Record> recs;
+        { std::lock_guard<std::mutex> lock(t.mutex); recs = t.records; }
+        if (recs.empty()) return;
+        std::stable_sort(recs.begin(), recs.end(), [](const Record& a, const Record& b) { return a.start < b.start; });
+        std::vector<std::thread::id> lanes{ t.mainThread };
+        auto ms = [&](clock::time_point p) { return std::chrono::duration<double, std::milli>(p - t.origin).count(); };
+        double busy = 0.0, span = 0.0;
+        eng::log::info("Startup timeline (ms since launch):");
+        for (const Record& r : recs) {
+            size_t lane = std::find(lanes.begin(), lanes.end(), r.thread) - lanes.begin();
+            if (lane == lanes.size()) lanes.push_back(r.thread);
+            std::string who = lane ? "worker " + std::to_string(lane) : "main";
+            double s = ms(r.start), e = ms(r.end);
+            busy += e - s; span = std::max(span, e);
+            if (e > s) eng::log::info("  %-9s %8.1f .. %8.1f %8.1f ms  %s", who, s, e, e - s, r.name);
+            else eng::log::info("  %-9s %8.1f                       %s", who, s, r.name);
+        }
+        eng::log::info("Startup: %.1f ms wall clock, %.1f ms of phases across %zu threads (%.2fx overlap)",
+                       span, busy, lanes.size(), span > 0.0 ? busy / span : 1.0);
+    }
+}
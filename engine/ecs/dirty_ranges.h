@@ -0,0 +1,47 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace eng::ecs {
+    // Collects the buffer slots touched since the last upload and coalesces them into ranges, so
+    // a GPU mirror of component data (transforms, lights, instance data) copies only what changed:
+    //   reg.changed<Transform>(lastSync, [&](Entity e, const Transform& t) { mirror[slot(e)] = pack(t); dirty.mark(slot(e)); });
+    //   for (auto r : dirty.build(4)) upload(r.first, r.count);
+    //   dirty.clear(); lastSync = reg.tick();
+    class DirtyRanges {
+    public:
+        struct Range { uint32_t first = 0, count = 0; };
+
+        void mark(uint32_t slot) { slots_.push_back(slot); }
+        void clear() { slots_.clear(); ranges_.clear(); }
+        bool empty() const { return slots_.empty(); }
+
+        // Sorted, disjoint ranges. Slots separated by at most `gap` clean slots are merged: copying
+        // a few unchanged elements is cheaper than another copy command.
+        const std::vector<Range>& build(uint32_t gap = 0) {
+            ranges_.clear();
+            std::sort(slots_.begin(), slots_.end());
+            for (uint32_t s : slots_) {
+                if (!ranges_.empty()) {
+                    Range& r = ranges_.back();
+                    uint32_t end = r.first + r.count;
+                    if (s < end) continue; // duplicate
+                    if (s - end <= gap) { r.count = s + 1 - r.first; continue; }
+                }
+                ranges_.push_back({ s, 1 });
+            }
+            return ranges_;
+        }
+
+        // Elements covered by the last build()
+        uint64_t coveredSlots() const {
+            uint64_t n = 0;
+            for (const Range& r : ranges_) n += r.count;
+            return n;
+        }
+    private:
+        std::vector<uint32_t> slots_;
+        std::vector<Range> ranges_;
+    };
+}
@@ -1,29 +1,198 @@
 #pragma once
+#include <algorithm>
+#include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <unordered_map>
 #include <typeindex>
 #include <memory>
+#include <utility>
+#include <vector>
+
+// Components live in one hash map per type. Every component carries the tick it was added and
+// last changed at; the registry tick advances once per frame (advance()). Systems remember the
+// tick they last ran at and ask for what happened since:
+//   ecs::Tick last = 0;
+//   reg.changed<Transform>(last, [&](Entity e, const Transform& t) { upload(e, t); }); // includes added
+//   reg.removed<Transform>(last, [&](Entity e) { release(e); });
+//   last = reg.tick(); reg.advance();
+// Changes are only seen when made through emplace(), patch() or markChanged(); writing through
+// Storage::data directly bypasses tracking. A component removed and added back within one tick may
+// be reported twice by changed(). Observers (onAdded/onChanged/onRemoved) run inline inside the
+// call that caused them.
 
 namespace eng::ecs {
     using Entity = std::uint32_t;
+    using Tick = std::uint32_t;
+
+    struct ComponentTicks { Tick added = 0, changed = 0; };
+
+    // Append-only log in tick order. Trimming only moves the head past old entries; the dead
+    // prefix is compacted away once it outgrows the live part, so each entry is moved at most
+    // once on average instead of the whole retained log shifting every tick.
+    struct TickLog {
+        struct Entry { Entity entity; Tick tick; };
+        std::vector<Entry> entries;
+        size_t head = 0;
+
+        auto begin() const { return entries.begin() + (std::ptrdiff_t)head; }
+        auto end() const { return entries.end(); }
+        size_t size() const { return entries.size() - head; }
+        void push_back(Entry e) { entries.push_back(e); }
+        void clear() { entries.clear(); head = 0; }
+        // Drops entries older than `oldest`, passing each to dropped(const Entry&)
+        template<typename F> void trim(Tick oldest, F&& dropped) {
+            auto first = begin(), last = std::partition_point(first, end(), [oldest](const Entry& l) { return l.tick < oldest; });
+            for (auto it = first; it != last; ++it) dropped(*it);
+            head += (size_t)(last - first);
+            if (head == entries.size()) clear();
+            else if (head > entries.size() - head) { entries.erase(entries.begin(), entries.begin() + (std::ptrdiff_t)head); head = 0; }
+        }
+    };
 
-    struct IStorage { virtual ~IStorage() = default; };
+    struct IStorage {
+        virtual ~IStorage() = default;
+        virtual bool remove(Entity e, Tick now) = 0;
+        virtual void trim(Tick oldest) = 0;
+    };
 
     template<typename T>
     struct Storage : IStorage {
         std::unordered_map<Entity, T> data;
+        std::unordered_map<Entity, ComponentTicks> ticks;
+        // Logs trimmed to the registry's retention window. An entity is logged at most once per
+        // tick; older entries whose tick no longer matches are stale.
+        using LogEntry = TickLog::Entry;
+        TickLog changeLog, removeLog;
+        std::unordered_map<Entity, Tick> lastRemoved; // latest removal per entity within the window
+        Tick logStart = 0; // entries for ticks >= logStart are complete
+        std::vector<std::function<void(Entity, const T&)>> addedObservers, changedObservers;
+        std::vector<std::function<void(Entity)>> removedObservers;
+
+        bool remove(Entity e, Tick now) override {
+            if (!data.erase(e)) return false;
+            ticks.erase(e);
+            Tick& last = lastRemoved[e];
+            if (last != now) removeLog.push_back({e, now}); // once per tick, like the change log
+            last = now;
+            for (auto& fn : removedObservers) fn(e);
+            return true;
+        }
+        void trim(Tick oldest) override {
+            if (oldest <= logStart) return;
+            changeLog.trim(oldest, [](const LogEntry&) {});
+            // An entity's latest removal leaves the window with its log entry
+            removeLog.trim(oldest, [this](const LogEntry& l) {
+                auto it = lastRemoved.find(l.entity);
+                if (it != lastRemoved.end() && it->second == l.tick) lastRemoved.erase(it);
+            });
+            logStart = oldest;
+        }
+        void touch(Entity e, ComponentTicks& t, Tick now) {
+            if (t.changed == now) return; // already logged this tick
+            t.changed = now;
+            changeLog.push_back({e, now});
+        }
     };
 
     class Registry {
         std::unordered_map<std::type_index, std::unique_ptr<IStorage>> stores;
         Entity next{1};
+        Tick now{1};          // tick 0 means "never": since = 0 sees everything
+        Tick retention{64};   // ticks of change/remove history kept for incremental queries
     public:
         Entity create() { return next++; }
+        Entity nextEntity() const { return next; }
+        void setNextEntity(Entity e) { next = e; } // snapshot restore
+
+        Tick tick() const { return now; }
+        // Ends the current tick. Queries with `since` older than the retention window still see
+        // every added/changed component (by scanning), but removals that old are forgotten.
+        void advance() {
+            ++now;
+            if (now > retention) for (auto& [type, s] : stores) s->trim(now - retention);
+        }
+        void setRetention(Tick ticks) { retention = std::max<Tick>(ticks, 1); }
+
+        // Adds the component, or replaces it (which counts as a change)
         template<typename T>
         T& emplace(Entity e, T value = {}) {
             auto& s = getOrCreate<T>();
-            return s.data.emplace(e, std::move(value)).first->second;
+            auto [it, inserted] = s.data.insert_or_assign(e, std::move(value));
+            ComponentTicks& t = s.ticks[e];
+            if (inserted) t.added = now;
+            s.touch(e, t, now);
+            for (auto& fn : inserted ? s.addedObservers : s.changedObservers) fn(e, it->second);
+            return it->second;
+        }
+
+        template<typename T>
+        const T* get(Entity e) const {
+            const Storage<T>* s = find<T>();
+            if (!s) return nullptr;
+            auto it = s->data.find(e);
+            return it == s->data.end() ? nullptr : &it->second;
+        }
+
+        // Mutates the component through fn(T&) and records the change; false if e has no T
+        template<typename T, typename F>
+        bool patch(Entity e, F&& fn) {
+            auto& s = getOrCreate<T>();
+            auto it = s.data.find(e);
+            if (it == s.data.end()) return false;
+            fn(it->second);
+            s.touch(e, s.ticks[e], now);
+            for (auto& cb : s.changedObservers) cb(e, it->second);
+            return true;
+        }
+        template<typename T>
+        bool markChanged(Entity e) { return patch<T>(e, [](T&) {}); }
+
+        template<typename T>
+        bool remove(Entity e) { Storage<T>* s = find<T>(); return s && s->remove(e, now); }
+        void destroy(Entity e) { for (auto& [type, s] : stores) s->remove(e, now); }
+
+        template<typename T>
+        ComponentTicks ticksOf(Entity e) const {
+            const Storage<T>* s = find<T>();
+            if (!s) return {};
+            auto it = s->ticks.find(e);
+            return it == s->ticks.end() ? ComponentTicks{} : it->second;
+        }
+
+        // ---- Queries: fn runs for every component matching the filter since tick `since` (exclusive)
+
+        template<typename T, typename F>
+        void each(F&& fn) {
+            if (Storage<T>* s = find<T>()) for (auto& [e, v] : s->data) fn(e, v);
         }
+        template<typename T, typename F>
+        void added(Tick since, F&& fn) const {
+            filter<T>(since, [since](const ComponentTicks& t) { return t.added > since; }, fn);
+        }
+        // Added components count as changed
+        template<typename T, typename F>
+        void changed(Tick since, F&& fn) const {
+            filter<T>(since, [since](const ComponentTicks& t) { return t.changed > since; }, fn);
+        }
+        // Removed since `since` and not added back; fn(Entity)
+        template<typename T, typename F>
+        void removed(Tick since, F&& fn) const {
+            const Storage<T>* s = find<T>();
+            if (!s) return;
+            auto first = std::partition_point(s->removeLog.begin(), s->removeLog.end(), [since](const typename Storage<T>::LogEntry& l) { return l.tick <= since; });
+            for (auto it = first; it != s->removeLog.end(); ++it) {
+                // Skip if added back since, or removed again later (a later entry reports it)
+                if (s->data.count(it->entity) || s->lastRemoved.find(it->entity)->second != it->tick) continue;
+                fn(it->entity);
+            }
+        }
+
+        // ---- Observers: run synchronously inside emplace/patch/remove
+        template<typename T, typename F> void onAdded(F&& fn) { getOrCreate<T>().addedObservers.emplace_back(std::forward<F>(fn)); }
+        template<typename T, typename F> void onChanged(F&& fn) { getOrCreate<T>().changedObservers.emplace_back(std::forward<F>(fn)); }
+        template<typename T, typename F> void onRemoved(F&& fn) { getOrCreate<T>().removedObservers.emplace_back(std::forward<F>(fn)); }
+
         template<typename T>
         Storage<T>& getOrCreate() {
             auto it = stores.find(std::type_index(typeid(T)));
@@ -32,6 +201,35 @@ namespace eng::ecs {
             }
             return *static_cast<Storage<T>*>(it->second.get());
         }
+        template<typename T>
+        Storage<T>* find() {
+            auto it = stores.find(std::type_index(typeid(T)));
+            return it == stores.end() ? nullptr : static_cast<Storage<T>*>(it->second.get());
+        }
+        template<typename T>
+        const Storage<T>* find() const {
+            auto it = stores.find(std::type_index(typeid(T)));
+            return it == stores.end() ? nullptr : static_cast<const Storage<T>*>(it->second.get());
+        }
+
+    private:
+        // Walks the change log when it still covers `since`, so the cost follows the number of
+        // changes; otherwise falls back to scanning every component's ticks
+        template<typename T, typename P, typename F>
+        void filter(Tick since, P&& match, F& fn) const {
+            const Storage<T>* s = find<T>();
+            if (!s) return;
+            if (since + 1 < s->logStart) {
+                for (auto& [e, t] : s->ticks) if (match(t)) fn(e, std::as_const(s->data.find(e)->second));
+                return;
+            }
+            auto first = std::partition_point(s->changeLog.begin(), s->changeLog.end(), [since](const typename Storage<T>::LogEntry& l) { return l.tick <= since; });
+            for (auto it = first; it != s->changeLog.end(); ++it) {
+                auto t = s->ticks.find(it->entity);
+                // Removed, or changed again later (a later entry reports it)
+                if (t == s->ticks.end() || t->second.changed != it->tick || !match(t->second)) continue;
+                fn(it->entity, std::as_const(s->data.find(it->entity)->second));
+            }
+        }
     };
 }
-
@@ -0,0 +1,206 @@
+#include "snapshot.h"
+#include "../core/log.h"
+#include "../core/profiler.h"
+#include <algorithm>
+#include <cstdio>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace eng::ecs {
+
+static constexpr char kMagic[4] = { 'E', 'C', 'S', 'S' };
+static constexpr uint32_t kVersion = 1;
+static constexpr uint32_t kFlagDelta = 1;
+
+struct SnapshotHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t flags;
+    Tick tick, baseTick;
+    Entity nextEntity;
+    uint32_t typeCount;
+    uint32_t reserved;
+};
+
+struct TypeHeader {
+    uint64_t id;           // FNV-1a of the registered name
+    uint32_t rawSize;      // sizeof(T) for raw types (checked on load), 0 for serialized ones
+    uint32_t reserved;
+    uint64_t count, removedCount;
+    uint64_t payloadBytes; // unpadded
+};
+static_assert(sizeof(SnapshotHeader) % 8 == 0 && sizeof(TypeHeader) % 8 == 0, "blocks stay 8-byte aligned");
+
+static size_t pad8(size_t n) { return (n + 7) & ~(size_t)7; }
+
+bool saveSnapshot(const Registry& reg, const SnapshotTypes& types, std::vector<uint8_t>& out, Tick since) {
+    ENG_PROFILE_FUNCTION();
+    out.clear();
+    // Removals older than the retention window are forgotten; a delta would silently keep those
+    // entities alive, so write everything instead
+    if (since && !std::all_of(types.entries().begin(), types.entries().end(), [&](const auto& e) { return e.hasHistory(reg, since); })) {
+        eng::log::debug("Snapshot base tick %u is older than the removal history, saving a full snapshot", since);
+        since = 0;
+    }
+    SnapshotHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion; h.flags = since ? kFlagDelta : 0;
+    h.tick = reg.tick(); h.baseTick = since; h.nextEntity = reg.nextEntity();
+    h.typeCount = (uint32_t)types.entries().size();
+    out.resize(sizeof(h));
+    std::memcpy(out.data(), &h, sizeof(h));
+
+    // Each type block is written in place; its header is filled in once the counts are known
+    std::vector<Entity> removed; // scratch reused across types
+    for (const auto& e : types.entries()) {
+        removed.clear();
+        size_t headerAt = out.size();
+        out.resize(headerAt + sizeof(TypeHeader));
+        TypeHeader th{};
+        th.id = e.id; th.rawSize = e.rawSize;
+        auto saved = e.save(e, reg, since, out, removed);
+        th.count = saved.count; th.payloadBytes = saved.payloadBytes; th.removedCount = removed.size();
+        out.resize(out.size() + pad8((size_t)th.payloadBytes) - (size_t)th.payloadBytes, 0);
+        size_t removedAt = out.size();
+        out.resize(removedAt + pad8(removed.size() * sizeof(Entity)), 0);
+        if (!removed.empty()) std::memcpy(out.data() + removedAt, removed.data(), removed.size() * sizeof(Entity));
+        std::memcpy(out.data() + headerAt, &th, sizeof(th));
+    }
+    return true;
+}
+
+bool saveSnapshot(const Registry& reg, const SnapshotTypes& types, const std::string& path, Tick since) {
+    std::vector<uint8_t> bytes;
+    if (!saveSnapshot(reg, types, bytes, since)) return false;
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) { eng::log::error("Cannot write snapshot '%s'", path); return false; }
+    bool ok = std::fwrite(bytes.data(), 1, bytes.size(), f) == bytes.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) { eng::log::error("Failed to write snapshot '%s'", path); return false; }
+    return true;
+}
+
+bool loadSnapshot(Registry& reg, const SnapshotTypes& types, const uint8_t* data, size_t size, SnapshotInfo* info) {
+    ENG_PROFILE_FUNCTION();
+    SnapshotHeader h{};
+    if (size < sizeof(h)) { eng::log::error("Snapshot too small (%zu bytes)", size); return false; }
+    std::memcpy(&h, data, sizeof(h));
+    if (std::memcmp(h.magic, kMagic, sizeof(kMagic)) != 0 || h.version != kVersion) {
+        eng::log::error("Not a version %u ECS snapshot", kVersion);
+        return false;
+    }
+    const bool delta = (h.flags & kFlagDelta) != 0;
+    SnapshotInfo si;
+    si.version = h.version; si.delta = delta; si.tick = h.tick; si.baseTick = h.baseTick; si.types = h.typeCount; si.bytes = size;
+
+    // Validate the whole layout and decode every payload before touching the registry, so a
+    // truncated or corrupt file changes nothing
+    struct Block { const SnapshotTypes::Entry* entry; TypeHeader th; const uint8_t* ids; const uint8_t* payload; const uint8_t* removed; std::shared_ptr<void> staged; };
+    std::vector<Block> blocks;
+    size_t at = sizeof(h);
+    for (uint32_t t = 0; t < h.typeCount; ++t) {
+        TypeHeader th{};
+        if (size - at < sizeof(th)) { eng::log::error("Snapshot truncated in type %u", t); return false; }
+        std::memcpy(&th, data + at, sizeof(th));
+        at += sizeof(th);
+        // Sizes are checked against what is left before multiplying, so corrupt counts cannot overflow
+        size_t left = size - at;
+        if (th.count > left / sizeof(Entity) || th.removedCount > left / sizeof(Entity) || th.payloadBytes > left) { eng::log::error("Snapshot truncated in type %u", t); return false; }
+        size_t idBytes = pad8((size_t)th.count * sizeof(Entity)), payloadBytes = pad8((size_t)th.payloadBytes), removedBytes = pad8((size_t)th.removedCount * sizeof(Entity));
+        if (idBytes + payloadBytes + removedBytes > left) { eng::log::error("Snapshot truncated in type %u", t); return false; }
+        Block b{ nullptr, th, data + at, data + at + idBytes, data + at + idBytes + payloadBytes, nullptr };
+        at += idBytes + payloadBytes + removedBytes;
+        for (const auto& e : types.entries()) if (e.id == th.id) b.entry = &e;
+        if (!b.entry) continue; // not registered in this build
+        if (b.entry->rawSize != th.rawSize || (th.rawSize && th.payloadBytes != th.count * th.rawSize)) {
+            eng::log::error("Snapshot type '%s' has a different layout (%u bytes per component, expected %u)", b.entry->name, th.rawSize, b.entry->rawSize);
+            return false;
+        }
+        blocks.push_back(std::move(b));
+    }
+    for (Block& b : blocks) {
+        ByteReader payload{ b.payload, b.payload + b.th.payloadBytes };
+        if (!b.entry->decode(*b.entry, b.th.count, payload, b.staged)) { eng::log::error("Snapshot type '%s' has a corrupt payload", b.entry->name); return false; }
+    }
+
+    if (!delta) {
+        for (const auto& e : types.entries()) {
+            bool present = std::any_of(blocks.begin(), blocks.end(), [&](const Block& b) { return b.entry == &e; });
+            if (!present) e.clear(reg);
+        }
+    }
+    for (Block& b : blocks) {
+        b.entry->apply(reg, delta, reinterpret_cast<const Entity*>(b.ids), b.th.count, b.payload, b.staged.get(), reinterpret_cast<const Entity*>(b.removed), b.th.removedCount);
+        b.staged.reset(); // decoded values are moved out; free them before the next block
+        si.components += b.th.count;
+    }
+    reg.setNextEntity(delta ? std::max(reg.nextEntity(), h.nextEntity) : h.nextEntity);
+    if (info) *info = si;
+    return true;
+}
+
+namespace {
+    // Read-only view of a whole file; the pages are read on first touch
+    class MappedFile {
+    public:
+        explicit MappedFile(const std::string& path) {
+#if defined(_WIN32)
+            file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+            if (file_ == INVALID_HANDLE_VALUE) return;
+            LARGE_INTEGER sz{};
+            if (!GetFileSizeEx(file_, &sz) || sz.QuadPart == 0) return;
+            mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping_) return;
+            data_ = static_cast<const uint8_t*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+            if (data_) size_ = (size_t)sz.QuadPart;
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return;
+            struct stat st{};
+            if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+                void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p != MAP_FAILED) {
+                    data_ = static_cast<const uint8_t*>(p); size_ = (size_t)st.st_size;
+                    ::madvise(p, size_, MADV_SEQUENTIAL);
+                }
+            }
+            ::close(fd); // the mapping keeps the file open
+#endif
+        }
+        ~MappedFile() {
+#if defined(_WIN32)
+            if (data_) UnmapViewOfFile(data_);
+            if (mapping_) CloseHandle(mapping_);
+            if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+#else
+            if (data_) ::munmap(const_cast<uint8_t*>(data_), size_);
+#endif
+        }
+        MappedFile(const MappedFile&) = delete; MappedFile& operator=(const MappedFile&) = delete;
+        const uint8_t* data() const { return data_; }
+        size_t size() const { return size_; }
+    private:
+        const uint8_t* data_ = nullptr;
+        size_t size_ = 0;
+#if defined(_WIN32)
+        HANDLE file_ = INVALID_HANDLE_VALUE, mapping_ = nullptr;
+#endif
+    };
+}
+
+bool loadSnapshot(Registry& reg, const SnapshotTypes& types, const std::string& path, SnapshotInfo* info) {
+    MappedFile file(path);
+    if (!file.data()) { eng::log::error("Cannot open snapshot '%s'", path); return false; }
+    if (!loadSnapshot(reg, types, file.data(), file.size(), info)) { eng::log::error("Failed to load snapshot '%s'", path); return false; }
+    return true;
+}
+
+}
@@ -0,0 +1,254 @@
+#pragma once
+#include "ecs.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// Binary world snapshots.
+//   ecs::SnapshotTypes types;
+//   types.add<Position>("Position");                         trivially copyable: copied as raw bytes
+//   types.add<Name>("Name", writeName, readName);            anything else: per-type serializer
+//   ecs::saveSnapshot(reg, types, "world.ecss");             full
+//   ecs::saveSnapshot(reg, types, "delta.ecss", baseTick);   only what was added/changed/removed after baseTick
+//   ecs::loadSnapshot(reg, types, "world.ecss");             memory-maps the file and restores from the mapping
+// Types are matched by name, so a snapshot loads into any build that registers the same names;
+// types the loader does not know are skipped. A full load replaces every registered type's
+// components (change queries across it see everything as added, removals are not reported) and
+// restores the entity counter. A delta goes through emplace/remove, so observers and change
+// tracking see exactly what it changes; apply it to a registry holding its base state. Removals
+// are only remembered for the registry's retention window, so a delta against an older base is
+// written as a full snapshot instead (SnapshotInfo::delta tells which one was loaded).
+// Loading validates the layout and decodes every serialized payload before it changes anything:
+// a truncated or corrupt snapshot is rejected and the registry is left as it was.
+//
+// Format, native endianness, every block 8-byte aligned:
+//   SnapshotHeader, then per type: TypeHeader, entity ids [count], payload [payloadBytes], removed ids [removedCount]
+
+namespace eng::ecs {
+    struct SnapshotInfo {
+        uint32_t version = 0;
+        bool delta = false;
+        Tick tick = 0;       // registry tick when saved; the base for the next delta
+        Tick baseTick = 0;   // delta only
+        uint32_t types = 0;
+        uint64_t components = 0, bytes = 0;
+    };
+
+    // Appends raw bytes; custom serializers write through it
+    struct ByteWriter {
+        std::vector<uint8_t>& out;
+        void bytes(const void* p, size_t n) { const uint8_t* b = static_cast<const uint8_t*>(p); out.insert(out.end(), b, b + n); }
+        template <class T> void pod(const T& v) { static_assert(std::is_trivially_copyable_v<T>); bytes(&v, sizeof(T)); }
+        void string(const std::string& s) { pod((uint32_t)s.size()); bytes(s.data(), s.size()); }
+    };
+
+    // Bounds-checked reads; every call fails once the data runs out
+    struct ByteReader {
+        const uint8_t* p; const uint8_t* end;
+        bool bytes(void* dst, size_t n) { if ((size_t)(end - p) < n) { p = end; return false; } std::memcpy(dst, p, n); p += n; return true; }
+        template <class T> bool pod(T& v) { static_assert(std::is_trivially_copyable_v<T>); return bytes(&v, sizeof(T)); }
+        bool string(std::string& s) {
+            uint32_t n = 0;
+            if (!pod(n) || (size_t)(end - p) < n) return false;
+            s.assign(reinterpret_cast<const char*>(p), n); p += n;
+            return true;
+        }
+    };
+
+    class SnapshotTypes {
+    public:
+        template <class T> using WriteFn = void (*)(const T&, ByteWriter&);
+        template <class T> using ReadFn = bool (*)(ByteReader&, T&);
+
+        template <class T> void add(const char* name) {
+            static_assert(std::is_trivially_copyable_v<T>, "use add(name, write, read) for types that are not trivially copyable");
+            types_.push_back(entry<T>(name, sizeof(T)));
+        }
+        template <class T> void add(const char* name, WriteFn<T> write, ReadFn<T> read) {
+            Entry e = entry<T>(name, 0);
+            e.write = reinterpret_cast<void (*)()>(write); e.read = reinterpret_cast<void (*)()>(read);
+            types_.push_back(std::move(e));
+        }
+
+        // Type-erased per-type operations; used by saveSnapshot/loadSnapshot
+        struct Entry {
+            std::string name;
+            uint64_t id = 0;        // FNV-1a of name
+            uint32_t rawSize = 0;   // sizeof(T) for raw types, 0 for serialized ones
+            void (*write)() = nullptr; void (*read)() = nullptr; // the custom serializer, cast back per type
+            // Appends the padded entity ids, then the unpadded payload, to out; removed receives the
+            // removals (deltas only)
+            struct Saved { uint64_t count = 0, payloadBytes = 0; };
+            Saved (*save)(const Entry&, const Registry&, Tick since, std::vector<uint8_t>& out, std::vector<Entity>& removed) = nullptr;
+            // False if removals after `since` are no longer known (older than the retention window)
+            bool (*hasHistory)(const Registry&, Tick since) = nullptr;
+            // Loads run in two passes. decode parses a serialized payload into staged values (raw
+            // payloads need none, their size is already checked) and is the only step that can fail;
+            // apply then restores the block, delta blocks through emplace/remove.
+            bool (*decode)(const Entry&, uint64_t count, ByteReader payload, std::shared_ptr<void>& staged) = nullptr;
+            void (*apply)(Registry&, bool delta, const Entity* ids, uint64_t count, const uint8_t* payload, void* staged, const Entity* removed, uint64_t removedCount) = nullptr;
+            void (*clear)(Registry&) = nullptr; // full loads: for registered types the snapshot lacks
+        };
+        const std::vector<Entry>& entries() const { return types_; }
+
+    private:
+        std::vector<Entry> types_;
+
+        static uint64_t hashName(const char* s) {
+            uint64_t h = 0xcbf29ce484222325ull;
+            for (; *s; ++s) { h ^= (uint8_t)*s; h *= 0x100000001b3ull; }
+            return h;
+        }
+
+        template <class T> static Entry entry(const char* name, uint32_t rawSize) {
+            Entry e;
+            e.name = name; e.id = hashName(name); e.rawSize = rawSize;
+            e.save = [](const Entry& self, const Registry& reg, Tick since, std::vector<uint8_t>& out, std::vector<Entity>& removed) -> Entry::Saved {
+                const Storage<T>* s = reg.find<T>();
+                if (!s) return {};
+                if constexpr (std::is_trivially_copyable_v<T>) {
+                    if (self.rawSize && since == 0) { // both sections sized up front, filled in one walk
+                        size_t n = s->data.size(), at = out.size();
+                        out.resize(at + pad8(n * sizeof(Entity)) + n * sizeof(T));
+                        uint8_t* idDst = out.data() + at;
+                        uint8_t* dst = idDst + pad8(n * sizeof(Entity));
+                        std::memset(idDst + n * sizeof(Entity), 0, pad8(n * sizeof(Entity)) - n * sizeof(Entity));
+                        for (const auto& [id, v] : s->data) {
+                            std::memcpy(idDst, &id, sizeof(Entity)); idDst += sizeof(Entity);
+                            std::memcpy(dst, &v, sizeof(T)); dst += sizeof(T);
+                        }
+                        return { n, n * sizeof(T) };
+                    }
+                }
+                // Otherwise the storage is walked twice (ids, then payload) in the same order;
+                // deltas keep the values the change query handed out
+                std::vector<Entity> ids;
+                std::vector<const T*> values;
+                if (since == 0) {
+                    ids.reserve(s->data.size());
+                    for (const auto& [id, v] : s->data) ids.push_back(id);
+                } else {
+                    reg.changed<T>(since, [&](Entity id, const T& v) { ids.push_back(id); values.push_back(&v); });
+                    reg.removed<T>(since, [&](Entity id) { removed.push_back(id); });
+                }
+                appendPadded(out, ids.data(), ids.size());
+                size_t at = out.size();
+                if constexpr (std::is_trivially_copyable_v<T>) {
+                    if (self.rawSize) {
+                        out.resize(at + ids.size() * sizeof(T));
+                        uint8_t* dst = out.data() + at;
+                        if (since == 0) for (const auto& [id, v] : s->data) { std::memcpy(dst, &v, sizeof(T)); dst += sizeof(T); }
+                        else for (const T* v : values) { std::memcpy(dst, v, sizeof(T)); dst += sizeof(T); }
+                        return { ids.size(), out.size() - at };
+                    }
+                }
+                ByteWriter w{out};
+                auto write = reinterpret_cast<WriteFn<T>>(self.write);
+                if (since == 0) for (const auto& [id, v] : s->data) write(v, w);
+                else for (const T* v : values) write(*v, w);
+                return { ids.size(), out.size() - at };
+            };
+            e.hasHistory = [](const Registry& reg, Tick since) {
+                const Storage<T>* s = reg.find<T>();
+                return !s || since + 1 >= s->logStart;
+            };
+            e.decode = [](const Entry& self, uint64_t count, ByteReader payload, std::shared_ptr<void>& staged) {
+                if constexpr (std::is_trivially_copyable_v<T>) {
+                    if (self.rawSize) return true;
+                }
+                auto values = std::make_shared<std::vector<T>>();
+                auto read = reinterpret_cast<ReadFn<T>>(self.read);
+                for (uint64_t i = 0; i < count; ++i) {
+                    T v{};
+                    if (!read(payload, v)) return false;
+                    values->push_back(std::move(v));
+                }
+                staged = std::move(values);
+                return true;
+            };
+            e.apply = [](Registry& reg, bool delta, const Entity* ids, uint64_t count, const uint8_t* payload, void* staged, const Entity* removed, uint64_t removedCount) {
+                auto* values = static_cast<std::vector<T>*>(staged);
+                auto take = [&](uint64_t i, T& v) {
+                    if (values) v = std::move((*values)[i]);
+                    else if constexpr (std::is_trivially_copyable_v<T>) std::memcpy(&v, payload + i * sizeof(T), sizeof(T));
+                };
+                if (delta) {
+                    for (uint64_t i = 0; i < removedCount; ++i) { Entity id; std::memcpy(&id, removed + i, sizeof(id)); reg.remove<T>(id); }
+                    for (uint64_t i = 0; i < count; ++i) {
+                        Entity id; std::memcpy(&id, ids + i, sizeof(id));
+                        T v{};
+                        take(i, v);
+                        reg.emplace<T>(id, std::move(v));
+                    }
+                    return;
+                }
+                // Full: assign into the storage directly (reusing the nodes of entities that already
+                // exist), record everything as added at the current tick, then drop what the
+                // snapshot does not have
+                Storage<T>& s = reg.getOrCreate<T>();
+                resetLogs(s, reg.tick());
+                Tick now = reg.tick();
+                s.data.reserve((size_t)count); s.ticks.reserve((size_t)count);
+                Entity maxId = 0;
+                for (uint64_t i = 0; i < count; ++i) {
+                    Entity id; std::memcpy(&id, ids + i, sizeof(id));
+                    T v{};
+                    take(i, v);
+                    s.data.insert_or_assign(id, std::move(v));
+                    s.ticks[id] = { now, now };
+                    maxId = std::max(maxId, id);
+                }
+                if (s.data.size() > count) {
+                    // Ids are dense counters, so usually a bitmap; its size is bounded by the component
+                    // counts so ids from a corrupt file cannot blow it up, sparse ids use a sorted copy
+                    std::vector<uint8_t> keep;
+                    std::vector<Entity> sorted;
+                    if ((size_t)maxId < 2 * (s.data.size() + (size_t)count)) {
+                        keep.assign((size_t)maxId + 1, 0);
+                        for (uint64_t i = 0; i < count; ++i) { Entity id; std::memcpy(&id, ids + i, sizeof(id)); keep[id] = 1; }
+                    } else {
+                        sorted.resize((size_t)count);
+                        std::memcpy(sorted.data(), ids, (size_t)count * sizeof(Entity));
+                        std::sort(sorted.begin(), sorted.end());
+                    }
+                    auto kept = [&](Entity id) { return keep.empty() ? std::binary_search(sorted.begin(), sorted.end(), id) : id <= maxId && keep[id]; };
+                    for (auto it = s.data.begin(); it != s.data.end();) {
+                        if (kept(it->first)) { ++it; continue; }
+                        s.ticks.erase(it->first);
+                        it = s.data.erase(it);
+                    }
+                }
+            };
+            e.clear = [](Registry& reg) {
+                Storage<T>& s = reg.getOrCreate<T>();
+                s.data.clear(); s.ticks.clear();
+                resetLogs(s, reg.tick());
+            };
+            return e;
+        }
+
+        static size_t pad8(size_t n) { return (n + 7) & ~(size_t)7; }
+        template <class T> static void appendPadded(std::vector<uint8_t>& out, const T* data, size_t count) {
+            size_t at = out.size(), bytes = count * sizeof(T);
+            out.resize(at + pad8(bytes));
+            if (bytes) std::memcpy(out.data() + at, data, bytes);
+            std::memset(out.data() + at + bytes, 0, pad8(bytes) - bytes);
+        }
+
+        // A full restore is not logged; queries from before it fall back to scanning
+        template <class T> static void resetLogs(Storage<T>& s, Tick now) {
+            s.changeLog.clear(); s.removeLog.clear(); s.lastRemoved.clear();
+            s.logStart = now + 1;
+        }
+    };
+
+    // since = 0 writes everything; otherwise a delta of what changed after tick `since`, or a full
+    // snapshot when `since` is older than the registry's removal history
+    bool saveSnapshot(const Registry& reg, const SnapshotTypes& types, std::vector<uint8_t>& out, Tick since = 0);
+    bool saveSnapshot(const Registry& reg, const SnapshotTypes& types, const std::string& path, Tick since = 0);
+    bool loadSnapshot(Registry& reg, const SnapshotTypes& types, const uint8_t* data, size_t size, SnapshotInfo* info = nullptr);
+    bool loadSnapshot(Registry& reg, const SnapshotTypes& types, const std::string& path, SnapshotInfo* info = nullptr);
+}
@@ -0,0 +1,222 @@
+#include "spatial_hash.h"
+#include "../core/profiler.h"
+#include "../scene/transform.h"
+#include <algorithm>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENG_SPATIAL_SSE2 1
+#endif
+
+namespace eng::ecs {
+
+static constexpr size_t kMinBuckets = 1024;
+static constexpr float kMaxCell = 1073741824.0f; // 2^30: cell coordinates stay in int32 for any input
+
+static size_t nextPow2(size_t n) { size_t p = 1; while (p < n) p <<= 1; return p; }
+
+SpatialHash::SpatialHash(float cellSize, float rebuildFraction)
+    : cellSize_(std::max(cellSize, 1e-4f)), invCellSize_(1.0f / cellSize_), rebuildFraction_(rebuildFraction), buckets_(kMinBuckets) {}
+
+SpatialHash::Cell SpatialHash::cellOf(float x, float y, float z) const {
+    auto c = [this](float v) { return (int32_t)std::floor(std::clamp(v * invCellSize_, -kMaxCell, kMaxCell)); };
+    return { c(x), c(y), c(z) };
+}
+
+uint32_t SpatialHash::bucketOf(const Cell& c) const {
+    uint32_t h = (uint32_t)c.x * 73856093u ^ (uint32_t)c.y * 19349663u ^ (uint32_t)c.z * 83492791u;
+    h ^= h >> 16; h *= 0x45d9f3bu; h ^= h >> 16; // the table is masked, so fold the high bits down
+    return h & (uint32_t)(buckets_.size() - 1);
+}
+
+void SpatialHash::place(Entity e, const glm::vec3& p, uint32_t bucket) {
+    if (e >= slots_.size()) slots_.resize((size_t)e + 1);
+    auto& b = buckets_[bucket];
+    slots_[e] = { bucket, (uint32_t)b.size() };
+    b.push_back({ p.x, p.y, p.z, e });
+}
+
+void SpatialHash::unlink(Entity e) {
+    Slot s = slots_[e];
+    auto& b = buckets_[s.bucket];
+    if (s.index + 1 != b.size()) { b[s.index] = b.back(); slots_[b[s.index].entity].index = s.index; }
+    b.pop_back();
+    slots_[e].bucket = kNone;
+}
+
+void SpatialHash::insert(Entity e, const glm::vec3& p) {
+    uint32_t bucket = bucketOf(cellOf(p.x, p.y, p.z));
+    if (contains(e)) {
+        ++stats_.moved;
+        Slot s = slots_[e];
+        if (s.bucket == bucket) { Entry& en = buckets_[bucket][s.index]; en.x = p.x; en.y = p.y; en.z = p.z; return; }
+        unlink(e);
+        place(e, p, bucket);
+        return;
+    }
+    ++stats_.added;
+    place(e, p, bucket);
+    if (++count_ > 2 * buckets_.size()) resize(count_);
+}
+
+bool SpatialHash::erase(Entity e) {
+    if (!contains(e)) return false;
+    unlink(e);
+    --count_; ++stats_.removed;
+    return true;
+}
+
+void SpatialHash::clear() {
+    for (auto& b : buckets_) b.clear();
+    slots_.clear();
+    count_ = 0;
+    lastSync_ = 0; // the next update() rebuilds
+}
+
+void SpatialHash::resize(size_t entities) {
+    size_t target = nextPow2(std::max(entities, kMinBuckets));
+    if (target <= buckets_.size()) return;
+    std::vector<Entry> all;
+    all.reserve(count_);
+    for (const auto& b : buckets_) all.insert(all.end(), b.begin(), b.end());
+    buckets_.assign(target, {});
+    for (const Entry& en : all) place(en.entity, glm::vec3(en.x, en.y, en.z), bucketOf(cellOf(en.x, en.y, en.z)));
+}
+
+void SpatialHash::rebuild(const Registry& reg) {
+    ENG_PROFILE_FUNCTION();
+    const Storage<scene::Transform>* s = reg.find<scene::Transform>();
+    size_t n = s ? s->data.size() : 0;
+    size_t target = nextPow2(std::max(n, kMinBuckets));
+    if (target != buckets_.size()) buckets_.assign(target, {});
+    else for (auto& b : buckets_) b.clear(); // keeps each bucket's capacity for the next rebuild
+    slots_.assign(reg.nextEntity(), Slot{});
+    if (s) for (const auto& [e, t] : s->data) place(e, t.position, bucketOf(cellOf(t.position.x, t.position.y, t.position.z)));
+    count_ = n;
+    lastSync_ = reg.tick();
+    ++stats_.rebuilds;
+}
+
+void SpatialHash::update(const Registry& reg) {
+    ENG_PROFILE_FUNCTION();
+    const Storage<scene::Transform>* s = reg.find<scene::Transform>();
+    // The tick of the last sync may have gone on changing after it, so it is applied again; that is
+    // harmless, only current positions and current absences are read
+    const Tick since = lastSync_ - 1;
+    // First sync, or removals older than the registry's retention window have been forgotten
+    if (lastSync_ == 0 || (s && since + 1 < s->logStart)) { rebuild(reg); return; }
+    pending_.clear();
+    reg.changed<scene::Transform>(since, [&](Entity e, const scene::Transform& t) { pending_.push_back({ e, t.position }); });
+    if ((double)pending_.size() > rebuildFraction_ * (double)std::max<size_t>(count_, 1)) { rebuild(reg); return; }
+    reg.removed<scene::Transform>(since, [&](Entity e) { erase(e); });
+    for (const auto& [e, p] : pending_) insert(e, p);
+    lastSync_ = reg.tick();
+}
+
+bool SpatialHash::bucketsFor(const Cell& lo, const Cell& hi, std::vector<uint32_t>& out) const {
+    const uint64_t limit = buckets_.size();
+    uint64_t nx = (uint64_t)((int64_t)hi.x - lo.x + 1), ny = (uint64_t)((int64_t)hi.y - lo.y + 1), nz = (uint64_t)((int64_t)hi.z - lo.z + 1);
+    if (nx > limit || nx * ny > limit || nx * ny * nz > limit) return false;
+    out.clear();
+    for (int32_t z = lo.z; z <= hi.z; ++z)
+        for (int32_t y = lo.y; y <= hi.y; ++y)
+            for (int32_t x = lo.x; x <= hi.x; ++x) out.push_back(bucketOf({ x, y, z }));
+    if (out.size() > 1) { std::sort(out.begin(), out.end()); out.erase(std::unique(out.begin(), out.end()), out.end()); }
+    return true;
+}
+
+template <class Filter>
+void SpatialHash::scan(const Cell& lo, const Cell& hi, Filter&& filter) const {
+    thread_local std::vector<uint32_t> list; // concurrent readers each have their own
+    if (bucketsFor(lo, hi, list)) { for (uint32_t b : list) if (!buckets_[b].empty()) filter(buckets_[b]); }
+    else for (const auto& b : buckets_) if (!b.empty()) filter(b);
+}
+
+namespace {
+    // emit(entry, squared distance) for every entry of the bucket within sqrt(r2) of c
+    template <class EntryT, class Emit>
+    void filterRadius(const std::vector<EntryT>& b, float cx, float cy, float cz, float r2, Emit&& emit) {
+        size_t i = 0, n = b.size();
+#ifdef ENG_SPATIAL_SSE2
+        // Four entries are one 4x4 block: transposed, the rows are x, y, z and the entity bits
+        const __m128 vcx = _mm_set1_ps(cx), vcy = _mm_set1_ps(cy), vcz = _mm_set1_ps(cz), vr2 = _mm_set1_ps(r2);
+        for (; i + 4 <= n; i += 4) {
+            const float* p = &b[i].x;
+            __m128 x = _mm_load_ps(p), y = _mm_load_ps(p + 4), z = _mm_load_ps(p + 8), w = _mm_load_ps(p + 12);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128 dx = _mm_sub_ps(x, vcx), dy = _mm_sub_ps(y, vcy), dz = _mm_sub_ps(z, vcz);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(d2, vr2));
+            if (!mask) continue;
+            alignas(16) float d[4];
+            _mm_store_ps(d, d2);
+            for (int k = 0; k < 4; ++k) if (mask & (1 << k)) emit(b[i + k], d[k]);
+        }
+#endif
+        for (; i < n; ++i) {
+            float dx = b[i].x - cx, dy = b[i].y - cy, dz = b[i].z - cz;
+            float d2 = dx * dx + dy * dy + dz * dz;
+            if (d2 <= r2) emit(b[i], d2);
+        }
+    }
+
+    template <class EntryT>
+    void filterBox(const std::vector<EntryT>& b, const glm::vec3& lo, const glm::vec3& hi, std::vector<Entity>& out) {
+        size_t i = 0, n = b.size();
+#ifdef ENG_SPATIAL_SSE2
+        const __m128 lx = _mm_set1_ps(lo.x), ly = _mm_set1_ps(lo.y), lz = _mm_set1_ps(lo.z);
+        const __m128 hx = _mm_set1_ps(hi.x), hy = _mm_set1_ps(hi.y), hz = _mm_set1_ps(hi.z);
+        for (; i + 4 <= n; i += 4) {
+            const float* p = &b[i].x;
+            __m128 x = _mm_load_ps(p), y = _mm_load_ps(p + 4), z = _mm_load_ps(p + 8), w = _mm_load_ps(p + 12);
+            _MM_TRANSPOSE4_PS(x, y, z, w);
+            __m128 in = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(x, lx), _mm_cmple_ps(x, hx)), _mm_and_ps(_mm_cmpge_ps(y, ly), _mm_cmple_ps(y, hy)));
+            int mask = _mm_movemask_ps(_mm_and_ps(in, _mm_and_ps(_mm_cmpge_ps(z, lz), _mm_cmple_ps(z, hz))));
+            for (int k = 0; mask && k < 4; ++k) if (mask & (1 << k)) out.push_back(b[i + k].entity);
+        }
+#endif
+        for (; i < n; ++i)
+            if (b[i].x >= lo.x && b[i].x <= hi.x && b[i].y >= lo.y && b[i].y <= hi.y && b[i].z >= lo.z && b[i].z <= hi.z) out.push_back(b[i].entity);
+    }
+}
+
+void SpatialHash::queryRadius(const glm::vec3& c, float radius, std::vector<Entity>& out) const {
+    if (!count_ || !(radius >= 0.0f)) return;
+    const float r2 = radius * radius;
+    scan(cellOf(c.x - radius, c.y - radius, c.z - radius), cellOf(c.x + radius, c.y + radius, c.z + radius), [&](const std::vector<Entry>& b) {
+        filterRadius(b, c.x, c.y, c.z, r2, [&](const Entry& en, float) { out.push_back(en.entity); });
+    });
+}
+
+void SpatialHash::queryAabb(const glm::vec3& lo, const glm::vec3& hi, std::vector<Entity>& out) const {
+    if (!count_ || !(lo.x <= hi.x && lo.y <= hi.y && lo.z <= hi.z)) return;
+    scan(cellOf(lo.x, lo.y, lo.z), cellOf(hi.x, hi.y, hi.z), [&](const std::vector<Entry>& b) { filterBox(b, lo, hi, out); });
+}
+
+// Radius queries that double until k entities are inside: every entity within the final radius is
+// a candidate, so the k closest of them are the k closest overall
+void SpatialHash::nearest(const glm::vec3& p, uint32_t k, std::vector<Entity>& out, float maxDistance) const {
+    out.clear();
+    if (!k || !count_ || !(maxDistance >= 0.0f)) return;
+    thread_local std::vector<std::pair<float, Entity>> candidates;
+    const size_t want = std::min<size_t>(k, count_);
+    for (float r = cellSize_;; r *= 2.0f) {
+        const float reach = std::min(r, maxDistance);
+        candidates.clear();
+        scan(cellOf(p.x - reach, p.y - reach, p.z - reach), cellOf(p.x + reach, p.y + reach, p.z + reach), [&](const std::vector<Entry>& b) {
+            filterRadius(b, p.x, p.y, p.z, reach * reach, [&](const Entry& en, float d2) { candidates.push_back({ d2, en.entity }); });
+        });
+        if (candidates.size() >= want || reach >= maxDistance || std::isinf(reach)) break;
+    }
+    size_t n = std::min(candidates.size(), want);
+    std::partial_sort(candidates.begin(), candidates.begin() + n, candidates.end());
+    for (size_t i = 0; i < n; ++i) out.push_back(candidates[i].second);
+}
+
+size_t SpatialHash::memoryBytes() const {
+    size_t bytes = buckets_.capacity() * sizeof(buckets_[0]) + slots_.capacity() * sizeof(Slot) + pending_.capacity() * sizeof(pending_[0]);
+    for (const auto& b : buckets_) bytes += b.capacity() * sizeof(Entry);
+    return bytes;
+}
+
+}
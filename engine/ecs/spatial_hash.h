@@ -0,0 +1,81 @@
+#pragma once
+#include "ecs.h"
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Proximity queries over entity positions. Space is cut into cubic cells of `cellSize`; each cell
+// hashes to one bucket of a power-of-two table, and a bucket holds the positions of its entities
+// packed as 16-byte {x, y, z, entity} entries that queries filter four at a time. Cells that
+// collide share a bucket; the exact distance/box test weeds out what does not match.
+//
+// As a system it mirrors scene::Transform::position, following the registry's change tracking:
+//   ecs::SpatialHash grid(8.0f);
+//   grid.update(reg);                                   once per frame, before the readers
+//   grid.queryRadius(p, 25.0f, hits);                   from any number of threads
+//   grid.nearest(p, 8, hits);
+// update() applies moved/added/removed transforms one by one, or re-buckets everything when more
+// than `rebuildFraction` of the entities changed. Queries are const and may run concurrently with
+// each other, but not with update(), insert(), move(), erase() or rebuild().
+//
+// Pick cellSize around the typical query radius: much smaller and a query visits many cells,
+// much larger and it filters many far-away entries.
+
+namespace eng::ecs {
+    class SpatialHash {
+    public:
+        explicit SpatialHash(float cellSize = 8.0f, float rebuildFraction = 0.25f);
+
+        // Syncs with every scene::Transform in the registry changed since the last update()
+        void update(const Registry& reg);
+        // Re-buckets the registry's transforms from scratch
+        void rebuild(const Registry& reg);
+
+        // Manual maintenance, for positions that do not come from scene::Transform
+        void insert(Entity e, const glm::vec3& p); // or move, if already present
+        void move(Entity e, const glm::vec3& p) { insert(e, p); }
+        bool erase(Entity e);
+        void clear();
+
+        // Results are appended, in no particular order. Bounds are inclusive.
+        void queryRadius(const glm::vec3& center, float radius, std::vector<Entity>& out) const;
+        void queryAabb(const glm::vec3& lo, const glm::vec3& hi, std::vector<Entity>& out) const;
+        // Up to k entities closest to p within maxDistance, nearest first (replaces out's contents)
+        void nearest(const glm::vec3& p, uint32_t k, std::vector<Entity>& out, float maxDistance = FLT_MAX) const;
+
+        bool contains(Entity e) const { return e < slots_.size() && slots_[e].bucket != kNone; }
+        size_t size() const { return count_; }
+        float cellSize() const { return cellSize_; }
+        size_t bucketCount() const { return buckets_.size(); }
+        size_t memoryBytes() const;
+
+        struct Stats { uint64_t moved = 0, added = 0, removed = 0, rebuilds = 0; };
+        const Stats& stats() const { return stats_; } // cumulative, for profiling
+
+    private:
+        static constexpr uint32_t kNone = UINT32_MAX;
+        struct alignas(16) Entry { float x, y, z; Entity entity; };
+        struct Slot { uint32_t bucket = kNone, index = 0; }; // where an entity's entry lives
+        struct Cell { int32_t x, y, z; };
+
+        float cellSize_, invCellSize_, rebuildFraction_;
+        std::vector<std::vector<Entry>> buckets_;
+        std::vector<Slot> slots_; // by entity id; ids are dense counters
+        size_t count_ = 0;
+        Tick lastSync_ = 0;
+        Stats stats_;
+        std::vector<std::pair<Entity, glm::vec3>> pending_; // update() scratch
+
+        Cell cellOf(float x, float y, float z) const;
+        uint32_t bucketOf(const Cell& c) const;
+        void resize(size_t entities); // table sized for this many entities; re-buckets
+        void place(Entity e, const glm::vec3& p, uint32_t bucket);
+        void unlink(Entity e);
+        // Buckets overlapping the cell range [lo, hi], each once; false if the range covers so many
+        // cells that scanning every bucket is cheaper
+        bool bucketsFor(const Cell& lo, const Cell& hi, std::vector<uint32_t>& out) const;
+        template <class Filter> void scan(const Cell& lo, const Cell& hi, Filter&& filter) const;
+    };
+}
@@ -0,0 +1,433 @@
+#include "async_io.h"
+#include "../core/log.h"
+#include "../core/profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#define ENG_IO_URING 1
+#endif
+
+namespace eng::io {
+
+namespace {
+    struct Counters { std::atomic<uint64_t> files{0}, bytes{0}, failed{0}; };
+    Counters gStats;
+
+    struct Request {
+        FileData data;
+        ReadCallback done;                // either this...
+        std::promise<FileData> promise;   // ...or the future handed out
+        // IoUring progress
+        int fd = -1;
+        uint64_t size = 0, submitted = 0;
+        uint32_t inflight = 0;
+        bool queued = false; // still has chunks to queue
+    };
+
+    void count(FileData& d) {
+        gStats.files.fetch_add(1, std::memory_order_relaxed);
+        gStats.bytes.fetch_add(d.bytes.size(), std::memory_order_relaxed);
+        if (!d.ok()) { gStats.failed.fetch_add(1, std::memory_order_relaxed); d.bytes.clear(); }
+    }
+
+    void finish(Request* r) {
+        count(r->data);
+        if (r->done) r->done(std::move(r->data));
+        else r->promise.set_value(std::move(r->data));
+        delete r;
+    }
+
+    // Whole file on the calling thread
+    void readBlocking(FileData& d) {
+#if defined(_WIN32)
+        HANDLE f = CreateFileA(d.path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (f == INVALID_HANDLE_VALUE) { d.error = GetLastError() == ERROR_FILE_NOT_FOUND || GetLastError() == ERROR_PATH_NOT_FOUND ? ENOENT : EIO; return; }
+        LARGE_INTEGER sz{};
+        if (!GetFileSizeEx(f, &sz)) { CloseHandle(f); d.error = EIO; return; }
+        d.bytes.resize((size_t)sz.QuadPart);
+        size_t done = 0;
+        while (done < d.bytes.size()) {
+            DWORD n = 0, want = (DWORD)std::min<size_t>(d.bytes.size() - done, 1u << 30);
+            if (!ReadFile(f, d.bytes.data() + done, want, &n, nullptr) || n == 0) { d.error = EIO; break; }
+            done += n;
+        }
+        CloseHandle(f);
+#else
+        int fd = ::open(d.path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { d.error = errno; return; }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) { d.error = errno; ::close(fd); return; }
+        d.bytes.resize((size_t)st.st_size);
+        size_t done = 0;
+        while (done < d.bytes.size()) {
+            ssize_t n = ::pread(fd, d.bytes.data() + done, d.bytes.size() - done, (off_t)done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) { d.error = n < 0 ? errno : EIO; break; } // EIO: the file shrank under us
+            done += (size_t)n;
+        }
+        ::close(fd);
+#endif
+    }
+
+    class Service {
+    public:
+        virtual ~Service() = default; // completes everything submitted
+        virtual void submit(std::vector<Request*>& batch) = 0;
+    };
+
+    class ThreadPool final : public Service {
+    public:
+        explicit ThreadPool(unsigned threads) {
+            for (unsigned i = 0; i < std::max(threads, 1u); ++i) threads_.emplace_back([this] { ENG_PROFILE_THREAD("io"); run(); });
+        }
+        ~ThreadPool() override {
+            { std::lock_guard<std::mutex> lock(mutex_); stop_ = true; }
+            cv_.notify_all();
+            for (auto& t : threads_) t.join();
+        }
+        void submit(std::vector<Request*>& batch) override {
+            { std::lock_guard<std::mutex> lock(mutex_); queue_.insert(queue_.end(), batch.begin(), batch.end()); }
+            if (batch.size() == 1) cv_.notify_one(); else cv_.notify_all();
+        }
+    private:
+        std::vector<std::thread> threads_;
+        std::mutex mutex_;
+        std::condition_variable cv_;
+        std::deque<Request*> queue_;
+        bool stop_ = false;
+
+        void run() {
+            std::unique_lock<std::mutex> lock(mutex_);
+            for (;;) {
+                cv_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty()) return; // stopping and drained
+                Request* r = queue_.front(); queue_.pop_front();
+                lock.unlock();
+                readBlocking(r->data);
+                finish(r);
+                lock.lock();
+            }
+        }
+    };
+
+#if defined(ENG_IO_URING)
+    // io_uring through the raw system calls (no liburing dependency). The ring thread opens each
+    // file, queues its chunks, and sleeps in io_uring_enter until a read or a wakeup completes;
+    // wakeups are a poll on an eventfd that submit() writes to.
+    class Uring final : public Service {
+    public:
+        bool start(const Config& cfg) {
+            depth_ = std::clamp<uint32_t>(cfg.queueDepth, 1, 4096);
+            chunk_ = std::max<uint32_t>(cfg.chunkBytes, 4096);
+            io_uring_params p{};
+            ring_ = (int)syscall(__NR_io_uring_setup, depth_ + 1, &p); // +1: the wakeup poll
+            if (ring_ < 0) { eng::log::warn("io_uring unavailable (%s); using the I/O thread pool", std::strerror(errno)); return false; }
+            if (!(p.features & IORING_FEAT_SINGLE_MMAP) || !supportsRead()) { eng::log::warn("io_uring too old (needs Linux 5.6); using the I/O thread pool"); return false; }
+            ringBytes_ = std::max<size_t>(p.sq_off.array + p.sq_entries * sizeof(unsigned), p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe));
+            ringMem_ = mmap(nullptr, ringBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQ_RING);
+            sqeBytes_ = p.sq_entries * sizeof(io_uring_sqe);
+            void* sqes = mmap(nullptr, sqeBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_, IORING_OFF_SQES);
+            if (ringMem_ == MAP_FAILED || sqes == MAP_FAILED) {
+                if (ringMem_ == MAP_FAILED) ringMem_ = nullptr;
+                if (sqes != MAP_FAILED) munmap(sqes, sqeBytes_);
+                eng::log::warn("io_uring: cannot map the rings; using the I/O thread pool");
+                return false;
+            }
+            uint8_t* m = static_cast<uint8_t*>(ringMem_);
+            sqHead_ = (unsigned*)(m + p.sq_off.head); sqTail_ = (unsigned*)(m + p.sq_off.tail);
+            sqMask_ = *(unsigned*)(m + p.sq_off.ring_mask); sqEntries_ = p.sq_entries; sqArray_ = (unsigned*)(m + p.sq_off.array);
+            cqHead_ = (unsigned*)(m + p.cq_off.head); cqTail_ = (unsigned*)(m + p.cq_off.tail);
+            cqMask_ = *(unsigned*)(m + p.cq_off.ring_mask); cqes_ = (io_uring_cqe*)(m + p.cq_off.cqes);
+            sqes_ = static_cast<io_uring_sqe*>(sqes);
+            wakeFd_ = eventfd(0, EFD_CLOEXEC);
+            if (wakeFd_ < 0) { eng::log::warn("io_uring: no eventfd (%s); using the I/O thread pool", std::strerror(errno)); return false; }
+            chunks_.resize(depth_);
+            for (uint32_t i = depth_; i-- > 0;) freeChunks_.push_back(i);
+            thread_ = std::thread([this] { ENG_PROFILE_THREAD("io_uring"); loop(); });
+            return true;
+        }
+        ~Uring() override {
+            if (thread_.joinable()) {
+                stop_.store(true, std::memory_order_release);
+                wake();
+                thread_.join();
+            }
+            if (sqes_) munmap(sqes_, sqeBytes_);
+            if (ringMem_) munmap(ringMem_, ringBytes_);
+            if (wakeFd_ >= 0) ::close(wakeFd_);
+            if (ring_ >= 0) ::close(ring_);
+        }
+        void submit(std::vector<Request*>& batch) override {
+            { std::lock_guard<std::mutex> lock(mutex_); incoming_.insert(incoming_.end(), batch.begin(), batch.end()); }
+            wake();
+        }
+
+    private:
+        static constexpr uint64_t kWake = 0; // user_data of the eventfd poll; chunks are index + 1
+        struct Chunk { Request* request; uint64_t offset; uint32_t length; };
+
+        int ring_ = -1, wakeFd_ = -1;
+        void* ringMem_ = nullptr; size_t ringBytes_ = 0, sqeBytes_ = 0;
+        unsigned *sqHead_ = nullptr, *sqTail_ = nullptr, *sqArray_ = nullptr, sqMask_ = 0, sqEntries_ = 0;
+        unsigned *cqHead_ = nullptr, *cqTail_ = nullptr, cqMask_ = 0;
+        io_uring_sqe* sqes_ = nullptr;
+        io_uring_cqe* cqes_ = nullptr;
+        uint32_t depth_ = 0, chunk_ = 0;
+        std::thread thread_;
+        std::atomic<bool> stop_{false};
+        std::mutex mutex_;
+        std::vector<Request*> incoming_;  // guarded by mutex_
+        // Ring thread only
+        std::deque<Request*> opened_;     // files with chunks left to queue
+        std::vector<Chunk> chunks_;
+        std::vector<uint32_t> freeChunks_, retry_;
+        uint32_t inflight_ = 0;           // chunk reads in the kernel
+        bool wakeArmed_ = false;
+
+        bool supportsRead() {
+            std::vector<uint8_t> mem(sizeof(io_uring_probe) + 256 * sizeof(io_uring_probe_op), 0);
+            auto* probe = reinterpret_cast<io_uring_probe*>(mem.data());
+            if (syscall(__NR_io_uring_register, ring_, IORING_REGISTER_PROBE, probe, 256) < 0) return false;
+            return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+        }
+        void wake() { uint64_t one = 1; ssize_t n = ::write(wakeFd_, &one, sizeof(one)); (void)n; }
+
+        io_uring_sqe* nextSqe() {
+            unsigned tail = *sqTail_;
+            if (tail - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE) >= sqEntries_) return nullptr;
+            io_uring_sqe* sqe = &sqes_[tail & sqMask_];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqArray_[tail & sqMask_] = tail & sqMask_;
+            return sqe;
+        }
+        void pushSqe() { __atomic_store_n(sqTail_, *sqTail_ + 1, __ATOMIC_RELEASE); }
+
+        bool queueChunk(uint32_t id) {
+            io_uring_sqe* sqe = nextSqe();
+            if (!sqe) return false;
+            const Chunk& c = chunks_[id];
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = c.request->fd;
+            sqe->addr = (uint64_t)(uintptr_t)(c.request->data.bytes.data() + c.offset);
+            sqe->len = c.length;
+            sqe->off = c.offset;
+            sqe->user_data = (uint64_t)id + 1;
+            pushSqe();
+            ++inflight_;
+            return true;
+        }
+
+        void open(Request* r) {
+            r->fd = ::open(r->data.path.c_str(), O_RDONLY | O_CLOEXEC);
+            struct stat st{};
+            if (r->fd < 0 || ::fstat(r->fd, &st) != 0) { r->data.error = errno; finishFile(r); return; }
+            r->size = (uint64_t)st.st_size;
+            if (r->size == 0) { finishFile(r); return; }
+            r->data.bytes.resize((size_t)r->size);
+            r->queued = true;
+            opened_.push_back(r);
+        }
+        void finishFile(Request* r) {
+            if (r->fd >= 0) ::close(r->fd);
+            r->fd = -1;
+            finish(r);
+        }
+
+        // Queues what fits: retries of short reads first, then new chunks in submission order
+        void fill() {
+            if (!wakeArmed_) {
+                if (io_uring_sqe* sqe = nextSqe()) {
+                    sqe->opcode = IORING_OP_POLL_ADD;
+                    sqe->fd = wakeFd_;
+                    sqe->poll_events = POLLIN;
+                    sqe->user_data = kWake;
+                    pushSqe();
+                    wakeArmed_ = true;
+                }
+            }
+            while (!retry_.empty() && queueChunk(retry_.back())) retry_.pop_back();
+            while (!opened_.empty() && !freeChunks_.empty()) {
+                Request* r = opened_.front();
+                if (r->data.error) { // a chunk failed: queue nothing more, finish once the rest is back
+                    opened_.pop_front();
+                    r->queued = false;
+                    if (r->inflight == 0) finishFile(r);
+                    continue;
+                }
+                uint32_t id = freeChunks_.back();
+                chunks_[id] = { r, r->submitted, (uint32_t)std::min<uint64_t>(chunk_, r->size - r->submitted) };
+                if (!queueChunk(id)) break;
+                freeChunks_.pop_back();
+                r->submitted += chunks_[id].length;
+                ++r->inflight;
+                if (r->submitted == r->size) { opened_.pop_front(); r->queued = false; }
+            }
+        }
+
+        void complete(uint64_t userData, int res) {
+            if (userData == kWake) {
+                uint64_t v; ssize_t n = ::read(wakeFd_, &v, sizeof(v)); (void)n;
+                wakeArmed_ = false;
+                return;
+            }
+            --inflight_;
+            uint32_t id = (uint32_t)(userData - 1);
+            Chunk& c = chunks_[id];
+            Request* r = c.request;
+            if (res == -EAGAIN || res == -EINTR) { retry_.push_back(id); return; }
+            if (res > 0 && (uint32_t)res < c.length) { c.offset += (uint32_t)res; c.length -= (uint32_t)res; retry_.push_back(id); return; }
+            if (res < 0) r->data.error = -res;
+            else if (res == 0) r->data.error = EIO; // the file shrank under us
+            freeChunks_.push_back(id);
+            if (--r->inflight == 0 && !r->queued) finishFile(r); // failed files still queued are finished by fill()
+        }
+
+        void loop() {
+            std::vector<Request*> batch;
+            for (;;) {
+                batch.clear();
+                { std::lock_guard<std::mutex> lock(mutex_); batch.swap(incoming_); }
+                for (Request* r : batch) open(r);
+                fill();
+                bool idle = opened_.empty() && retry_.empty() && inflight_ == 0;
+                if (idle && stop_.load(std::memory_order_acquire)) {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    if (incoming_.empty()) return;
+                    continue;
+                }
+                unsigned toSubmit = *sqTail_ - __atomic_load_n(sqHead_, __ATOMIC_ACQUIRE);
+                int ret = (int)syscall(__NR_io_uring_enter, ring_, toSubmit, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+                if (ret < 0 && errno != EINTR && errno != EBUSY && errno != EAGAIN) {
+                    eng::log::error("io_uring_enter failed: %s", std::strerror(errno));
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+                unsigned head = *cqHead_, tail = __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE);
+                for (; head != tail; ++head) {
+                    const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                    complete(cqe.user_data, cqe.res);
+                }
+                __atomic_store_n(cqHead_, head, __ATOMIC_RELEASE);
+            }
+        }
+    };
+#endif
+
+    std::mutex gMutex;
+    std::unique_ptr<Service> gService; // guarded by gMutex
+    Backend gBackend = Backend::Inline;
+
+    // Hands the batch to the service, or reads it right here when none is running
+    void dispatch(std::vector<Request*>& batch) {
+        {
+            std::lock_guard<std::mutex> lock(gMutex);
+            if (gService) { gService->submit(batch); return; }
+        }
+        for (Request* r : batch) { readBlocking(r->data); finish(r); }
+    }
+}
+
+bool init(const Config& cfg) {
+    std::lock_guard<std::mutex> lock(gMutex);
+    if (gService) return true;
+    Backend want = cfg.backend;
+#if defined(ENG_IO_URING)
+    if (want == Backend::IoUring) {
+        auto ring = std::make_unique<Uring>();
+        if (ring->start(cfg)) { gService = std::move(ring); gBackend = Backend::IoUring; }
+        else want = Backend::ThreadPool;
+    }
+#else
+    if (want == Backend::IoUring) want = Backend::ThreadPool;
+#endif
+    if (!gService && want == Backend::ThreadPool) { gService = std::make_unique<ThreadPool>(cfg.threads); gBackend = Backend::ThreadPool; }
+    eng::log::info("Async I/O: %s", backendName(gBackend));
+    return gBackend != Backend::Inline || cfg.backend == Backend::Inline;
+}
+
+void shutdown() {
+    std::unique_ptr<Service> service;
+    {
+        std::lock_guard<std::mutex> lock(gMutex);
+        service = std::move(gService);
+        gBackend = Backend::Inline;
+    }
+    service.reset(); // joins after completing what was submitted; new reads already run inline
+}
+
+Backend backend() { std::lock_guard<std::mutex> lock(gMutex); return gBackend; }
+
+const char* backendName(Backend b) {
+    switch (b) {
+        case Backend::IoUring: return "io_uring";
+        case Backend::ThreadPool: return "thread pool";
+        default: return "inline";
+    }
+}
+
+std::future<FileData> read(std::string path) {
+    Request* r = new Request;
+    r->data.path = std::move(path);
+    std::future<FileData> f = r->promise.get_future();
+    std::vector<Request*> batch{ r };
+    dispatch(batch);
+    return f;
+}
+
+void read(std::string path, ReadCallback done) {
+    Request* r = new Request;
+    r->data.path = std::move(path);
+    r->done = std::move(done);
+    std::vector<Request*> batch{ r };
+    dispatch(batch);
+}
+
+std::vector<std::future<FileData>> readBatch(const std::vector<std::string>& paths) {
+    std::vector<std::future<FileData>> futures;
+    std::vector<Request*> batch;
+    futures.reserve(paths.size()); batch.reserve(paths.size());
+    for (const std::string& p : paths) {
+        Request* r = new Request;
+        r->data.path = p;
+        futures.push_back(r->promise.get_future());
+        batch.push_back(r);
+    }
+    dispatch(batch);
+    return futures;
+}
+
+FileData readNow(const std::string& path) {
+    ENG_PROFILE_FUNCTION();
+    FileData d;
+    d.path = path;
+    readBlocking(d);
+    count(d);
+    return d;
+}
+
+Stats stats() {
+    return { gStats.files.load(std::memory_order_relaxed), gStats.bytes.load(std::memory_order_relaxed), gStats.failed.load(std::memory_order_relaxed) };
+}
+
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <string>
+#include <vector>
+
+// Asynchronous whole-file reads for asset loading.
+//   eng::io::init();                                          once, at startup
+//   auto f = eng::io::read("scene.bin");                      std::future<io::FileData>
+//   eng::io::read("a.png", [](io::FileData&& d) { ... });     callback, on an I/O thread
+//   auto fs = eng::io::readBatch({ "a.bin", "b.bin" });       submitted together
+//   io::FileData d = eng::io::readNow("pipeline_cache.bin");  blocking, on the calling thread
+// On Linux reads go through io_uring: one thread owns the ring, splits files into chunkBytes reads
+// and keeps up to queueDepth of them in flight, so a batch of files costs about one trip to the
+// disk instead of one per file. Elsewhere, or where the kernel refuses io_uring (older than 5.6,
+// or blocked by a container's seccomp policy), a small thread pool issues blocking reads in
+// parallel. Before init() (or after shutdown()) every read runs inline on the caller and its future
+// is ready on return, so loaders work unchanged in tools. All functions are thread-safe.
+
+namespace eng::io {
+    enum class Backend { Inline, ThreadPool, IoUring };
+
+    struct Config {
+        Backend backend = Backend::IoUring; // preferred; IoUring falls back to ThreadPool
+        unsigned threads = 4;               // ThreadPool workers
+        uint32_t queueDepth = 64;           // IoUring: reads in flight
+        uint32_t chunkBytes = 1u << 20;     // IoUring: larger files are read in pieces of this size
+    };
+
+    struct FileData {
+        std::string path;
+        std::vector<uint8_t> bytes;
+        int error = 0; // errno value; 0 = read completely
+        bool ok() const { return error == 0; }
+    };
+    // Runs on an I/O thread (the ring thread for IoUring): keep it short, hand real work to jobs
+    using ReadCallback = std::function<void(FileData&&)>;
+
+    bool init(const Config& cfg = {}); // false if the requested backend could not start (Inline is used)
+    void shutdown();                   // completes every read already submitted
+    Backend backend();
+    const char* backendName(Backend b);
+
+    std::future<FileData> read(std::string path);
+    void read(std::string path, ReadCallback done);
+    std::vector<std::future<FileData>> readBatch(const std::vector<std::string>& paths);
+    FileData readNow(const std::string& path);
+
+    struct Stats { uint64_t files = 0, bytes = 0, failed = 0; };
+    Stats stats(); // totals since startup, every backend
+}
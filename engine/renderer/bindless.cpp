@@ -0,0 +1,129 @@
+#include "bindless.h"
+#include "../core/log.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace eng::renderer;
+
+static uint32_t findMemoryType(VkPhysicalDevice physical, uint32_t typeFilter, VkMemoryPropertyFlags props) {
+    VkPhysicalDeviceMemoryProperties memProps{}; vkGetPhysicalDeviceMemoryProperties(physical, &memProps);
+    for (uint32_t i=0;i<memProps.memoryTypeCount;++i) if ((typeFilter & (1u<<i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) return i;
+    return UINT32_MAX;
+}
+
+bool BindlessDescriptors::supported(VkPhysicalDevice physical) {
+    // Descriptor indexing is core in Vulkan 1.2; older devices take the per-material descriptor set path
+    VkPhysicalDeviceProperties props{}; vkGetPhysicalDeviceProperties(physical, &props);
+    if (props.apiVersion < VK_API_VERSION_1_2) return false;
+    VkPhysicalDeviceDescriptorIndexingFeatures di{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+    VkPhysicalDeviceFeatures2 f2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2}; f2.pNext = &di;
+    vkGetPhysicalDeviceFeatures2(physical, &f2);
+    return di.shaderSampledImageArrayNonUniformIndexing && di.descriptorBindingSampledImageUpdateAfterBind &&
+           di.descriptorBindingPartiallyBound && di.descriptorBindingUpdateUnusedWhilePending && di.runtimeDescriptorArray;
+}
+
+void BindlessDescriptors::enableFeatures(VkPhysicalDeviceDescriptorIndexingFeatures& f) {
+    f.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+    f.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+    f.descriptorBindingPartiallyBound = VK_TRUE;
+    f.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+    f.runtimeDescriptorArray = VK_TRUE;
+}
+
+bool BindlessDescriptors::init(VkPhysicalDevice physical, VkDevice device, uint32_t framesInFlight) {
+    device_ = device;
+    VkPhysicalDeviceDescriptorIndexingProperties dip{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES};
+    VkPhysicalDeviceProperties2 p2{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2}; p2.pNext = &dip;
+    vkGetPhysicalDeviceProperties2(physical, &p2);
+    textureCapacity_ = std::min({ kMaxTextures, dip.maxDescriptorSetUpdateAfterBindSampledImages,
+                                  dip.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+    // Set 0: texture array
+    VkDescriptorSetLayoutBinding tb{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCapacity_, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
+    VkDescriptorBindingFlags tflags = VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT |
+                                      VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+    VkDescriptorSetLayoutBindingFlagsCreateInfo bfci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO};
+    bfci.bindingCount = 1; bfci.pBindingFlags = &tflags;
+    VkDescriptorSetLayoutCreateInfo tlci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+    tlci.pNext = &bfci; tlci.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+    tlci.bindingCount = 1; tlci.pBindings = &tb;
+    if (vkCreateDescriptorSetLayout(device_, &tlci, nullptr, &textureLayout_) != VK_SUCCESS) { shutdown(); return false; }
+
+    VkDescriptorPoolSize tps{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, textureCapacity_};
+    VkDescriptorPoolCreateInfo tpci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    tpci.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT; tpci.maxSets = 1; tpci.poolSizeCount = 1; tpci.pPoolSizes = &tps;
+    if (vkCreateDescriptorPool(device_, &tpci, nullptr, &texturePool_) != VK_SUCCESS) { shutdown(); return false; }
+    VkDescriptorSetAllocateInfo tai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    tai.descriptorPool = texturePool_; tai.descriptorSetCount = 1; tai.pSetLayouts = &textureLayout_;
+    if (vkAllocateDescriptorSets(device_, &tai, &textureSet_) != VK_SUCCESS) { textureSet_ = VK_NULL_HANDLE; shutdown(); return false; }
+
+    // Set 1: material table; a plain (not update-after-bind) set per frame region
+    VkDescriptorSetLayoutBinding mb{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
+    VkDescriptorSetLayoutCreateInfo mlci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO}; mlci.bindingCount = 1; mlci.pBindings = &mb;
+    if (vkCreateDescriptorSetLayout(device_, &mlci, nullptr, &materialLayout_) != VK_SUCCESS) { shutdown(); return false; }
+
+    regionSize_ = sizeof(GpuMaterial) * kMaxMaterials; // a multiple of any minStorageBufferOffsetAlignment
+    VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO}; bci.size = regionSize_ * framesInFlight; bci.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT; bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bci, nullptr, &materialBuf_) != VK_SUCCESS) { shutdown(); return false; }
+    VkMemoryRequirements mr{}; vkGetBufferMemoryRequirements(device_, materialBuf_, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO}; mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = findMemoryType(physical, mr.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (mai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device_, &mai, nullptr, &materialMem_) != VK_SUCCESS) { shutdown(); return false; }
+    vkBindBufferMemory(device_, materialBuf_, materialMem_, 0);
+    void* ptr = nullptr; if (vkMapMemory(device_, materialMem_, 0, VK_WHOLE_SIZE, 0, &ptr) != VK_SUCCESS) { shutdown(); return false; }
+    materialPtr_ = static_cast<uint8_t*>(ptr);
+
+    VkDescriptorPoolSize mps{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, framesInFlight};
+    VkDescriptorPoolCreateInfo mpci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO}; mpci.maxSets = framesInFlight; mpci.poolSizeCount = 1; mpci.pPoolSizes = &mps;
+    if (vkCreateDescriptorPool(device_, &mpci, nullptr, &materialPool_) != VK_SUCCESS) { shutdown(); return false; }
+    std::vector<VkDescriptorSetLayout> layouts(framesInFlight, materialLayout_);
+    materialSets_.resize(framesInFlight);
+    VkDescriptorSetAllocateInfo mai2{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    mai2.descriptorPool = materialPool_; mai2.descriptorSetCount = framesInFlight; mai2.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device_, &mai2, materialSets_.data()) != VK_SUCCESS) { materialSets_.clear(); shutdown(); return false; }
+    for (uint32_t i = 0; i < framesInFlight; ++i) {
+        VkDescriptorBufferInfo bi{materialBuf_, regionSize_ * i, regionSize_};
+        VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        w.dstSet = materialSets_[i]; w.dstBinding = 0; w.descriptorCount = 1; w.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; w.pBufferInfo = &bi;
+        vkUpdateDescriptorSets(device_, 1, &w, 0, nullptr);
+    }
+    eng::log::info("Bindless descriptors: %u texture slots, %u materials", textureCapacity_, kMaxMaterials);
+    return true;
+}
+
+void BindlessDescriptors::shutdown() {
+    if (!device_) return;
+    if (texturePool_) { vkDestroyDescriptorPool(device_, texturePool_, nullptr); texturePool_ = VK_NULL_HANDLE; }
+    if (materialPool_) { vkDestroyDescriptorPool(device_, materialPool_, nullptr); materialPool_ = VK_NULL_HANDLE; }
+    textureSet_ = VK_NULL_HANDLE; materialSets_.clear();
+    if (textureLayout_) { vkDestroyDescriptorSetLayout(device_, textureLayout_, nullptr); textureLayout_ = VK_NULL_HANDLE; }
+    if (materialLayout_) { vkDestroyDescriptorSetLayout(device_, materialLayout_, nullptr); materialLayout_ = VK_NULL_HANDLE; }
+    if (materialBuf_) { vkDestroyBuffer(device_, materialBuf_, nullptr); materialBuf_ = VK_NULL_HANDLE; }
+    if (materialMem_) { vkFreeMemory(device_, materialMem_, nullptr); materialMem_ = VK_NULL_HANDLE; materialPtr_ = nullptr; }
+    freeSlots_.clear(); nextSlot_ = 0;
+    device_ = VK_NULL_HANDLE;
+}
+
+uint32_t BindlessDescriptors::allocTexture(VkImageView view, VkSampler sampler) {
+    uint32_t slot;
+    if (!freeSlots_.empty()) { slot = freeSlots_.back(); freeSlots_.pop_back(); }
+    else if (nextSlot_ < textureCapacity_) slot = nextSlot_++;
+    else return kInvalid;
+    VkDescriptorImageInfo ii{sampler, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    w.dstSet = textureSet_; w.dstBinding = 0; w.dstArrayElement = slot;
+    w.descriptorCount = 1; w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; w.pImageInfo = &ii;
+    vkUpdateDescriptorSets(device_, 1, &w, 0, nullptr);
+    return slot;
+}
+
+void BindlessDescriptors::freeTexture(uint32_t slot) {
+    if (slot != kInvalid) freeSlots_.push_back(slot);
+}
+
+void BindlessDescriptors::bind(VkCommandBuffer cmd, VkPipelineLayout layout, uint32_t frameSlot, const std::vector<GpuMaterial>& materials) {
+    size_t count = std::min<size_t>(materials.size(), kMaxMaterials);
+    std::memcpy(materialPtr_ + regionSize_ * frameSlot, materials.data(), count * sizeof(GpuMaterial));
+    VkDescriptorSet sets[2] = { textureSet_, materialSets_[frameSlot] };
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 2, sets, 0, nullptr);
+}
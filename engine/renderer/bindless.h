@@ -0,0 +1,55 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+
+namespace eng::renderer {
+    // Material record read by mesh_bindless.frag (std430)
+    struct GpuMaterial {
+        float baseColorFactor[4] = {1.0f, 1.0f, 1.0f, 1.0f};
+        uint32_t baseColorTexture = 0; // slot in the bindless texture array
+        uint32_t pad[3] = {};
+    };
+    static_assert(sizeof(GpuMaterial) == 32, "GpuMaterial must match the std430 layout in mesh_bindless.frag");
+
+    // Descriptor-indexing resources for the mesh pass, bound once per pass:
+    //   set 0: sampler2D textures[]  (update-after-bind, partially bound)
+    //   set 1: readonly buffer Materials { GpuMaterial materials[]; }, one region per frame in flight
+    // Texture slots may be written while earlier frames are in flight as long as those frames do not
+    // use the slot, so a slot is only recycled once no frame references it (free it via the deletion queue).
+    // Materials are rewritten each frame into that frame's region, so draws pick up slot changes safely.
+    class BindlessDescriptors {
+    public:
+        static constexpr uint32_t kMaxTextures = 4096;
+        static constexpr uint32_t kMaxMaterials = 4096;
+        static constexpr uint32_t kInvalid = UINT32_MAX;
+
+        // Needs the descriptor indexing features below; query with supported() before creating the device
+        static bool supported(VkPhysicalDevice physical);
+        static void enableFeatures(VkPhysicalDeviceDescriptorIndexingFeatures& f);
+
+        bool init(VkPhysicalDevice physical, VkDevice device, uint32_t framesInFlight);
+        void shutdown();
+        bool enabled() const { return textureSet_ != VK_NULL_HANDLE; }
+
+        VkDescriptorSetLayout textureLayout() const { return textureLayout_; }
+        VkDescriptorSetLayout materialLayout() const { return materialLayout_; }
+
+        uint32_t allocTexture(VkImageView view, VkSampler sampler); // kInvalid when the array is full
+        void freeTexture(uint32_t slot);
+
+        // Writes this frame's material region and binds sets 0 and 1 with a single call
+        void bind(VkCommandBuffer cmd, VkPipelineLayout layout, uint32_t frameSlot, const std::vector<GpuMaterial>& materials);
+    private:
+        VkDevice device_{};
+        uint32_t textureCapacity_ = 0;
+        VkDescriptorSetLayout textureLayout_{}, materialLayout_{};
+        VkDescriptorPool texturePool_{}, materialPool_{};
+        VkDescriptorSet textureSet_{};
+        std::vector<VkDescriptorSet> materialSets_;
+        VkBuffer materialBuf_{}; VkDeviceMemory materialMem_{}; uint8_t* materialPtr_ = nullptr;
+        VkDeviceSize regionSize_ = 0;
+        std::vector<uint32_t> freeSlots_;
+        uint32_t nextSlot_ = 0;
+    };
+}
@@ -0,0 +1,130 @@
+#include "clustered_lighting.h"
+#include "shader_registry.h"
+#include "../core/log.h"
+#include <cstring>
+
+using namespace eng::renderer;
+
+static uint32_t findMemoryType(VkPhysicalDevice physical, uint32_t typeFilter, VkMemoryPropertyFlags props) {
+    VkPhysicalDeviceMemoryProperties memProps{}; vkGetPhysicalDeviceMemoryProperties(physical, &memProps);
+    for (uint32_t i=0;i<memProps.memoryTypeCount;++i) if ((typeFilter & (1u<<i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) return i;
+    return UINT32_MAX;
+}
+
+bool ClusteredLighting::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, VkBuffer& buf, VkDeviceMemory& mem) {
+    VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO}; bci.size = size; bci.usage = usage; bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bci, nullptr, &buf) != VK_SUCCESS) { buf = VK_NULL_HANDLE; return false; }
+    VkMemoryRequirements mr{}; vkGetBufferMemoryRequirements(device_, buf, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO}; mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = findMemoryType(physical_, mr.memoryTypeBits, props);
+    if (mai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device_, &mai, nullptr, &mem) != VK_SUCCESS) { mem = VK_NULL_HANDLE; return false; }
+    vkBindBufferMemory(device_, buf, mem, 0);
+    return true;
+}
+
+bool ClusteredLighting::init(VkPhysicalDevice physical, VkDevice device, ShaderRegistry& shaders, VkPipelineCache cache, uint32_t framesInFlight) {
+    physical_ = physical; device_ = device;
+    VkShaderModule mod = shaders.get(ShaderId::LightClusterComp);
+    if (!mod) { shutdown(); return false; }
+
+    VkShaderStageFlags stages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+    VkDescriptorSetLayoutBinding b[4] = {
+        {0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, stages, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, stages, nullptr},
+    };
+    VkDescriptorSetLayoutCreateInfo lci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO}; lci.bindingCount = 4; lci.pBindings = b;
+    if (vkCreateDescriptorSetLayout(device_, &lci, nullptr, &setLayout_) != VK_SUCCESS) { shutdown(); return false; }
+    VkPipelineLayoutCreateInfo plci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO}; plci.setLayoutCount = 1; plci.pSetLayouts = &setLayout_;
+    if (vkCreatePipelineLayout(device_, &plci, nullptr, &layout_) != VK_SUCCESS) { shutdown(); return false; }
+
+    // Regions are multiples of 256 bytes, so every binding offset meets any device's alignment
+    hostSlot_ = kParamsRegion + kLightsRegion;
+    clusterSlot_ = kCountsRegion + kIndicesRegion;
+    static_assert(kCountsRegion % 256 == 0 && kLightsRegion % 256 == 0, "cluster buffer regions must stay 256-byte aligned");
+    if (!createBuffer(hostSlot_ * framesInFlight, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, hostBuf_, hostMem_) ||
+        !createBuffer(clusterSlot_ * framesInFlight, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, clusterBuf_, clusterMem_)) {
+        shutdown(); return false;
+    }
+    void* ptr = nullptr; if (vkMapMemory(device_, hostMem_, 0, VK_WHOLE_SIZE, 0, &ptr) != VK_SUCCESS) { shutdown(); return false; }
+    hostPtr_ = static_cast<uint8_t*>(ptr);
+
+    VkDescriptorPoolSize sizes[2] = { {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, framesInFlight}, {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * framesInFlight} };
+    VkDescriptorPoolCreateInfo pci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO}; pci.maxSets = framesInFlight; pci.poolSizeCount = 2; pci.pPoolSizes = sizes;
+    if (vkCreateDescriptorPool(device_, &pci, nullptr, &pool_) != VK_SUCCESS) { shutdown(); return false; }
+    std::vector<VkDescriptorSetLayout> layouts(framesInFlight, setLayout_);
+    sets_.resize(framesInFlight);
+    VkDescriptorSetAllocateInfo ai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    ai.descriptorPool = pool_; ai.descriptorSetCount = framesInFlight; ai.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device_, &ai, sets_.data()) != VK_SUCCESS) { sets_.clear(); shutdown(); return false; }
+    for (uint32_t s = 0; s < framesInFlight; ++s) {
+        VkDescriptorBufferInfo bufs[4] = {
+            {hostBuf_, hostSlot_ * s, sizeof(ClusterParams)},
+            {hostBuf_, hostSlot_ * s + kParamsRegion, kLightsRegion},
+            {clusterBuf_, clusterSlot_ * s, kCountsRegion},
+            {clusterBuf_, clusterSlot_ * s + kCountsRegion, kIndicesRegion},
+        };
+        VkWriteDescriptorSet w[4]{};
+        for (uint32_t i = 0; i < 4; ++i) {
+            w[i] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}; w[i].dstSet = sets_[s]; w[i].dstBinding = i; w[i].descriptorCount = 1;
+            w[i].descriptorType = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; w[i].pBufferInfo = &bufs[i];
+        }
+        vkUpdateDescriptorSets(device_, 4, w, 0, nullptr);
+    }
+
+    pipeline_ = buildPipeline(shaders, cache);
+    if (!pipeline_) { shutdown(); return false; }
+    eng::log::info("Clustered lighting: %ux%ux%u clusters, up to %u lights (%u per cluster)",
+                   kClusterX, kClusterY, kClusterZ, kMaxLights, kMaxLightsPerCluster);
+    return true;
+}
+
+VkPipeline ClusteredLighting::buildPipeline(ShaderRegistry& shaders, VkPipelineCache cache) const {
+    VkShaderModule mod = shaders.get(ShaderId::LightClusterComp);
+    if (!mod || !layout_) return VK_NULL_HANDLE;
+    VkComputePipelineCreateInfo cpci{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    cpci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; cpci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT; cpci.stage.module = mod; cpci.stage.pName = "main";
+    cpci.layout = layout_;
+    VkPipeline p{};
+    if (vkCreateComputePipelines(device_, cache, 1, &cpci, nullptr, &p) != VK_SUCCESS) return VK_NULL_HANDLE;
+    return p;
+}
+
+void ClusteredLighting::shutdown() {
+    if (!device_) return;
+    if (pipeline_) { vkDestroyPipeline(device_, pipeline_, nullptr); pipeline_ = VK_NULL_HANDLE; }
+    if (pool_) { vkDestroyDescriptorPool(device_, pool_, nullptr); pool_ = VK_NULL_HANDLE; }
+    sets_.clear();
+    if (layout_) { vkDestroyPipelineLayout(device_, layout_, nullptr); layout_ = VK_NULL_HANDLE; }
+    if (setLayout_) { vkDestroyDescriptorSetLayout(device_, setLayout_, nullptr); setLayout_ = VK_NULL_HANDLE; }
+    for (auto* b : { &hostBuf_, &clusterBuf_ }) { if (*b) vkDestroyBuffer(device_, *b, nullptr); *b = VK_NULL_HANDLE; }
+    for (auto* m : { &hostMem_, &clusterMem_ }) { if (*m) vkFreeMemory(device_, *m, nullptr); *m = VK_NULL_HANDLE; }
+    hostPtr_ = nullptr;
+    device_ = VK_NULL_HANDLE;
+}
+
+void ClusteredLighting::setLights(std::vector<GpuLight> lights) {
+    if (lights.size() > kMaxLights) {
+        eng::log::warn("Clustered lighting: %zu lights, only the first %u are used", lights.size(), kMaxLights);
+        lights.resize(kMaxLights);
+    }
+    lights_ = std::move(lights);
+}
+
+void ClusteredLighting::update(VkCommandBuffer cmd, uint32_t frameSlot, ClusterParams params) {
+    if (!enabled()) return;
+    params.grid[3] = (uint32_t)lights_.size();
+    uint8_t* slot = hostPtr_ + hostSlot_ * frameSlot;
+    std::memcpy(slot, &params, sizeof(params));
+    if (!lights_.empty()) std::memcpy(slot + kParamsRegion, lights_.data(), lights_.size() * sizeof(GpuLight));
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline_);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, layout_, 0, 1, &sets_[frameSlot], 0, nullptr);
+    vkCmdDispatch(cmd, (kClusterCount + 63) / 64, 1, 1);
+
+    VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; mb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 1, &mb, 0, nullptr, 0, nullptr);
+}
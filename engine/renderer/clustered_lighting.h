@@ -0,0 +1,59 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "light_clusters.h"
+
+namespace eng::renderer {
+    class ShaderRegistry;
+    enum class ShaderId : uint32_t;
+
+    // Clustered forward lighting: each frame light_cluster.comp bins the light list into the
+    // froxel grid of light_clusters.h, and fragment shaders (clustered_lighting.glsl) loop over
+    // their own cluster's lights only. One descriptor set per frame in flight is bound at set 0
+    // of the compute pass and set 2 of the graphics passes:
+    //   0: ClusterParams (uniform)   1: GpuLight[]   2: per-cluster counts   3: per-cluster light indices
+    class ClusteredLighting {
+    public:
+        bool init(VkPhysicalDevice physical, VkDevice device, ShaderRegistry& shaders, VkPipelineCache cache, uint32_t framesInFlight);
+        void shutdown();
+        bool enabled() const { return pipeline_ != VK_NULL_HANDLE; }
+
+        VkDescriptorSetLayout setLayout() const { return setLayout_; }
+        VkDescriptorSet descriptor(uint32_t frameSlot) const { return sets_[frameSlot]; }
+
+        // Lights beyond kMaxLights are ignored; takes effect at the next update()
+        void setLights(std::vector<GpuLight> lights);
+        uint32_t lightCount() const { return (uint32_t)lights_.size(); }
+        // Once per frame after the slot's fence wait, outside a render pass: uploads the lights and
+        // assigns them to clusters for this frame's camera (params.grid[3] is filled in here)
+        void update(VkCommandBuffer cmd, uint32_t frameSlot, ClusterParams params);
+
+        // Shader hot reload: builds a pipeline from the registry's current light_cluster.comp (any
+        // thread, VK_NULL_HANDLE on failure); replacePipeline() installs it between frames and returns
+        // the old one, which the caller retires once frames in flight are done with it
+        VkPipeline buildPipeline(ShaderRegistry& shaders, VkPipelineCache cache) const;
+        VkPipeline replacePipeline(VkPipeline pipeline) { std::swap(pipeline_, pipeline); return pipeline; }
+    private:
+        static constexpr VkDeviceSize kParamsRegion = 256;
+        static constexpr VkDeviceSize kLightsRegion = sizeof(GpuLight) * kMaxLights;
+        static constexpr VkDeviceSize kCountsRegion = sizeof(uint32_t) * kClusterCount;
+        static constexpr VkDeviceSize kIndicesRegion = sizeof(uint32_t) * kClusterCount * kMaxLightsPerCluster;
+
+        VkPhysicalDevice physical_{};
+        VkDevice device_{};
+        VkDescriptorSetLayout setLayout_{};
+        VkPipelineLayout layout_{};
+        VkPipeline pipeline_{};
+        VkDescriptorPool pool_{};
+        std::vector<VkDescriptorSet> sets_;
+        // Per slot: params + lights (host visible), counts + indices (device local)
+        VkBuffer hostBuf_{}; VkDeviceMemory hostMem_{}; uint8_t* hostPtr_ = nullptr;
+        VkBuffer clusterBuf_{}; VkDeviceMemory clusterMem_{};
+        VkDeviceSize hostSlot_ = 0, clusterSlot_ = 0;
+        std::vector<GpuLight> lights_;
+
+        bool createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, VkBuffer& buf, VkDeviceMemory& mem);
+    };
+}
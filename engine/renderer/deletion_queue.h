@@ -0,0 +1,28 @@
+#pragma once
+#include <cstdint>
+#include <deque>
+#include <functional>
+
+namespace eng::renderer {
+    // Defers destruction of GPU objects until the frame that last used them has finished.
+    // Entries pushed while recording frame N run once flush(N) (or a later frame) is called,
+    // i.e. after frame N's fence has signaled. Frame numbers must be pushed in non-decreasing order.
+    class DeletionQueue {
+    public:
+        void push(uint64_t frame, std::function<void()> fn) { entries_.push_back({frame, std::move(fn)}); }
+        void flush(uint64_t completedFrame) {
+            while (!entries_.empty() && entries_.front().frame <= completedFrame) {
+                entries_.front().fn();
+                entries_.pop_front();
+            }
+        }
+        void flushAll() {
+            for (auto& e : entries_) e.fn();
+            entries_.clear();
+        }
+        bool empty() const { return entries_.empty(); }
+    private:
+        struct Entry { uint64_t frame; std::function<void()> fn; };
+        std::deque<Entry> entries_;
+    };
+}
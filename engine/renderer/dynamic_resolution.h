@@ -0,0 +1,68 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+namespace eng::renderer {
+    struct DynamicResolutionSettings {
+        float targetMs = 16.0f;        // GPU frame budget
+        float headroom = 0.9f;         // aim for this fraction of the budget, so noise stays under it
+        float minScale = 0.5f, maxScale = 1.0f; // per-axis render scale bounds
+        float smoothing = 0.15f;       // weight of each new sample in the moving average
+        float deadband = 0.05f;        // relative error tolerated before the scale moves
+        float maxStep = 0.1f;          // largest per-axis scale change per adjustment
+        uint32_t settleFrames = 3;     // samples to wait after a change; GPU timings arrive frames late
+        uint32_t upscaleFrames = 30;   // consecutive under-budget samples needed before scaling back up
+    };
+
+    // Picks the per-axis render scale from measured GPU frame times. GPU cost is taken to follow
+    // the pixel count, i.e. scale^2, so the next scale is scale * sqrt(target / smoothed). Drops
+    // react after settleFrames, raises only after a sustained run under budget, which keeps the
+    // scale from oscillating around the budget.
+    class DynamicResolution {
+    public:
+        void configure(const DynamicResolutionSettings& s) { s_ = s; scale_ = std::clamp(scale_, s_.minScale, s_.maxScale); }
+        const DynamicResolutionSettings& settings() const { return s_; }
+        void reset() { scale_ = s_.maxScale; avgMs_ = 0.0f; settle_ = 0; under_ = 0; }
+
+        // One GPU frame time sample (ms); returns the scale to render the next frame at
+        float update(float gpuMs) {
+            if (!(gpuMs > 0.0f)) return scale_;
+            if (settle_ > 0) { --settle_; return scale_; } // still timing frames from before the last change
+            avgMs_ = avgMs_ > 0.0f ? avgMs_ + (gpuMs - avgMs_) * s_.smoothing : gpuMs;
+            float goal = s_.targetMs * s_.headroom;
+            float err = avgMs_ / goal - 1.0f;
+            bool spike = gpuMs > s_.targetMs * 1.5f;
+            if (err > s_.deadband || spike) {
+                under_ = 0;
+                // A spike far over budget acts on the raw sample rather than waiting for the average
+                adjust(std::sqrt(goal / (spike ? gpuMs : avgMs_)));
+            } else if (err < -s_.deadband && scale_ < s_.maxScale) {
+                if (++under_ >= s_.upscaleFrames) { under_ = 0; adjust(std::sqrt(goal / avgMs_)); }
+            } else under_ = 0;
+            return scale_;
+        }
+
+        float scale() const { return scale_; }
+        float averageMs() const { return avgMs_; }
+
+        // Render extent for a full extent at the given scale: at least 1, never above the full size
+        static uint32_t scaled(uint32_t full, float scale) {
+            uint32_t v = (uint32_t)std::lround(full * scale);
+            return std::clamp(v, 1u, std::max(full, 1u));
+        }
+    private:
+        DynamicResolutionSettings s_;
+        float scale_ = 1.0f, avgMs_ = 0.0f;
+        uint32_t settle_ = 0, under_ = 0;
+
+        void adjust(float factor) {
+            factor = std::clamp(factor, 1.0f - s_.maxStep, 1.0f + s_.maxStep);
+            float next = std::clamp(scale_ * factor, s_.minScale, s_.maxScale);
+            if (next == scale_) return;
+            scale_ = next;
+            // Restart the average once the frames rendered at the old scale have been timed
+            avgMs_ = 0.0f; settle_ = s_.settleFrames;
+        }
+    };
+}
@@ -0,0 +1,71 @@
+#include "geometry_arena.h"
+#include "deletion_queue.h"
+#include "../core/log.h"
+
+using namespace eng::renderer;
+
+static uint32_t findMemoryType(VkPhysicalDevice physical, uint32_t typeFilter, VkMemoryPropertyFlags props) {
+    VkPhysicalDeviceMemoryProperties memProps{}; vkGetPhysicalDeviceMemoryProperties(physical, &memProps);
+    for (uint32_t i=0;i<memProps.memoryTypeCount;++i) if ((typeFilter & (1u<<i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) return i;
+    return UINT32_MAX;
+}
+
+bool GeometryArena::init(VkPhysicalDevice physical, VkDevice device, VkDeviceSize capacity, DeletionQueue* deletions) {
+    device_ = device; deletions_ = deletions;
+
+    VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO}; bci.size = capacity; bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    bci.usage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
+    if (vkCreateBuffer(device_, &bci, nullptr, &buffer_) != VK_SUCCESS) { buffer_ = VK_NULL_HANDLE; shutdown(); return false; }
+    VkMemoryRequirements mr{}; vkGetBufferMemoryRequirements(device_, buffer_, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO}; mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = findMemoryType(physical, mr.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (mai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device_, &mai, nullptr, &memory_) != VK_SUCCESS) { memory_ = VK_NULL_HANDLE; shutdown(); return false; }
+    vkBindBufferMemory(device_, buffer_, memory_, 0);
+    void* ptr = nullptr; if (vkMapMemory(device_, memory_, 0, VK_WHOLE_SIZE, 0, &ptr) != VK_SUCCESS) { shutdown(); return false; }
+    mapped_ = static_cast<uint8_t*>(ptr);
+
+    VkDescriptorSetLayoutBinding b{0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_VERTEX_BIT, nullptr};
+    VkDescriptorSetLayoutCreateInfo lci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO}; lci.bindingCount = 1; lci.pBindings = &b;
+    if (vkCreateDescriptorSetLayout(device_, &lci, nullptr, &setLayout_) != VK_SUCCESS) { shutdown(); return false; }
+    VkDescriptorPoolSize size{VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1};
+    VkDescriptorPoolCreateInfo pci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO}; pci.maxSets = 1; pci.poolSizeCount = 1; pci.pPoolSizes = &size;
+    if (vkCreateDescriptorPool(device_, &pci, nullptr, &pool_) != VK_SUCCESS) { shutdown(); return false; }
+    VkDescriptorSetAllocateInfo ai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO}; ai.descriptorPool = pool_; ai.descriptorSetCount = 1; ai.pSetLayouts = &setLayout_;
+    if (vkAllocateDescriptorSets(device_, &ai, &set_) != VK_SUCCESS) { shutdown(); return false; }
+    VkDescriptorBufferInfo bi{buffer_, 0, VK_WHOLE_SIZE};
+    VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}; w.dstSet = set_; w.dstBinding = 0; w.descriptorCount = 1;
+    w.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; w.pBufferInfo = &bi;
+    vkUpdateDescriptorSets(device_, 1, &w, 0, nullptr);
+
+    alloc_.reset(capacity);
+    eng::log::info("Geometry arena: %.1f MiB", capacity / 1048576.0);
+    return true;
+}
+
+void GeometryArena::shutdown() {
+    if (!device_) return;
+    if (pool_) { vkDestroyDescriptorPool(device_, pool_, nullptr); pool_ = VK_NULL_HANDLE; }
+    set_ = VK_NULL_HANDLE;
+    if (setLayout_) { vkDestroyDescriptorSetLayout(device_, setLayout_, nullptr); setLayout_ = VK_NULL_HANDLE; }
+    if (buffer_) { vkDestroyBuffer(device_, buffer_, nullptr); buffer_ = VK_NULL_HANDLE; }
+    if (memory_) { vkFreeMemory(device_, memory_, nullptr); memory_ = VK_NULL_HANDLE; }
+    mapped_ = nullptr;
+    alloc_.reset(0);
+    device_ = VK_NULL_HANDLE;
+}
+
+GeometryRange GeometryArena::allocate(VkDeviceSize size, VkDeviceSize alignment) {
+    uint64_t offset = alloc_.allocate(size, alignment);
+    if (offset == RangeAllocator::kInvalid) {
+        eng::log::error("Geometry arena full: %.2f MiB requested, %.2f of %.2f MiB used, largest free block %.2f MiB",
+                        size / 1048576.0, alloc_.used() / 1048576.0, alloc_.capacity() / 1048576.0, alloc_.largestFree() / 1048576.0);
+        return {};
+    }
+    return { offset, size };
+}
+
+void GeometryArena::release(const GeometryRange& r, uint64_t frameIndex) {
+    if (!r.valid()) return;
+    if (deletions_) deletions_->push(frameIndex, [this, r] { alloc_.free(r.offset, r.size); });
+    else alloc_.free(r.offset, r.size);
+}
@@ -0,0 +1,49 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include "range_allocator.h"
+
+namespace eng::renderer {
+    class DeletionQueue;
+
+    struct GeometryRange {
+        VkDeviceSize offset = 0, size = 0;
+        bool valid() const { return size > 0; }
+        // Element index of the range start, for ranges allocated with alignment == stride
+        uint32_t first(VkDeviceSize stride) const { return (uint32_t)(offset / stride); }
+    };
+
+    // One buffer holding all vertex, index and instance data. Shaders pull vertices from it as a
+    // storage buffer (geometry_arena.glsl, descriptor set 3) and it is the index buffer of every
+    // indexed draw, so draws can reference any geometry without rebinding. Ranges are suballocated
+    // with their element stride as alignment, which makes offset / stride the element index that
+    // draws pass as firstVertex / vertexOffset / firstIndex / firstInstance.
+    class GeometryArena {
+    public:
+        bool init(VkPhysicalDevice physical, VkDevice device, VkDeviceSize capacity, DeletionQueue* deletions);
+        void shutdown();
+        bool enabled() const { return buffer_ != VK_NULL_HANDLE; }
+
+        // Invalid (size 0) range when the arena is full
+        GeometryRange allocate(VkDeviceSize size, VkDeviceSize alignment);
+        // Host-visible and persistently mapped: write straight into a freshly allocated range
+        void* data(const GeometryRange& r) const { return mapped_ + r.offset; }
+        uint8_t* mapped() const { return mapped_; } // offset 0, for code that works in raw offsets
+        // The range becomes reusable once frames up to frameIndex have finished with it
+        void release(const GeometryRange& r, uint64_t frameIndex);
+
+        VkBuffer buffer() const { return buffer_; }
+        VkDescriptorSetLayout setLayout() const { return setLayout_; }
+        VkDescriptorSet descriptor() const { return set_; }
+        const RangeAllocator& allocator() const { return alloc_; }
+    private:
+        VkDevice device_{};
+        DeletionQueue* deletions_ = nullptr;
+        VkBuffer buffer_{}; VkDeviceMemory memory_{};
+        uint8_t* mapped_ = nullptr;
+        VkDescriptorSetLayout setLayout_{};
+        VkDescriptorPool pool_{};
+        VkDescriptorSet set_{};
+        RangeAllocator alloc_;
+    };
+}
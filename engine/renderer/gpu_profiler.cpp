@@ -0,0 +1,170 @@
+#include "gpu_profiler.h"
+#include "../core/log.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace eng::renderer;
+
+static constexpr VkQueryPipelineStatisticFlags kStatFlags =
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+static constexpr uint32_t kStatCount = 5;
+
+bool GpuProfiler::init(VkPhysicalDevice physical, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, bool pipelineStats) {
+    device_ = device;
+    uint32_t qCount = 0; vkGetPhysicalDeviceQueueFamilyProperties(physical, &qCount, nullptr);
+    std::vector<VkQueueFamilyProperties> qprops(qCount); vkGetPhysicalDeviceQueueFamilyProperties(physical, &qCount, qprops.data());
+    uint32_t validBits = queueFamily < qCount ? qprops[queueFamily].timestampValidBits : 0;
+    if (validBits == 0) { eng::log::warn("GPU profiler disabled: queue family has no timestamp support"); return false; }
+    tsMask_ = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+    VkPhysicalDeviceProperties props{}; vkGetPhysicalDeviceProperties(physical, &props);
+    nsPerTick_ = props.limits.timestampPeriod;
+
+    slots_.assign(framesInFlight, Slot{});
+    VkQueryPoolCreateInfo qci{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+    qci.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    qci.queryCount = framesInFlight * kMaxScopes * 2;
+    if (vkCreateQueryPool(device_, &qci, nullptr, &tsPool_) != VK_SUCCESS) { tsPool_ = VK_NULL_HANDLE; return false; }
+    if (pipelineStats) {
+        VkQueryPoolCreateInfo sci{VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO};
+        sci.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        sci.queryCount = framesInFlight;
+        sci.pipelineStatistics = kStatFlags;
+        if (vkCreateQueryPool(device_, &sci, nullptr, &statsPool_) != VK_SUCCESS) statsPool_ = VK_NULL_HANDLE;
+    }
+    return true;
+}
+
+void GpuProfiler::shutdown() {
+    if (tsPool_) { vkDestroyQueryPool(device_, tsPool_, nullptr); tsPool_ = VK_NULL_HANDLE; }
+    if (statsPool_) { vkDestroyQueryPool(device_, statsPool_, nullptr); statsPool_ = VK_NULL_HANDLE; }
+    slots_.clear(); history_.clear();
+}
+
+uint16_t GpuProfiler::historyIndex(const char* name) {
+    for (size_t i = 0; i < history_.size(); ++i)
+        if (history_[i].name == name || std::strcmp(history_[i].name, name) == 0) return (uint16_t)i;
+    history_.push_back({name, std::vector<float>(), 0, 0.0f, 0});
+    history_.back().ms.reserve(kHistory);
+    return (uint16_t)(history_.size() - 1);
+}
+
+void GpuProfiler::collect(uint32_t slotIndex) {
+    Slot& slot = slots_[slotIndex];
+    if (slot.pending && slot.scopeCount > 0) {
+        // [value, availability] pairs; no WAIT bit, the slot's fence has already signaled
+        uint64_t data[kMaxScopes * 2 * 2]{};
+        uint32_t n = slot.scopeCount * 2;
+        VkResult res = vkGetQueryPoolResults(device_, tsPool_, slotIndex * kMaxScopes * 2, n, sizeof(uint64_t) * 2 * n, data,
+                                             sizeof(uint64_t) * 2, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+        if (res == VK_SUCCESS || res == VK_NOT_READY) {
+            for (uint32_t s = 0; s < slot.scopeCount; ++s) {
+                const uint64_t* b = &data[s * 4];
+                if (!b[1] || !b[3]) continue;
+                uint64_t ticks = ((b[2] & tsMask_) - (b[0] & tsMask_)) & tsMask_;
+                History& h = history_[slot.history[s]];
+                h.last = (float)(ticks * nsPerTick_ * 1e-6);
+                if (h.ms.size() < kHistory) h.ms.push_back(h.last); else h.ms[h.next] = h.last;
+                h.next = (h.next + 1) % kHistory;
+                ++h.total;
+            }
+        }
+    }
+    if (slot.statsPending && statsPool_) {
+        uint64_t v[kStatCount + 1]{};
+        if (vkGetQueryPoolResults(device_, statsPool_, slotIndex, 1, sizeof(v), v, sizeof(v),
+                                  VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT) == VK_SUCCESS && v[kStatCount]) {
+            // Results are packed in bit order of the enabled flags
+            pipeStats_ = { v[0], v[1], v[2], v[3], v[4] };
+        }
+    }
+    slot.pending = slot.statsPending = false;
+    slot.scopeCount = 0;
+}
+
+void GpuProfiler::beginFrame(VkCommandBuffer cmd, uint32_t slot) {
+    if (!tsPool_) return;
+    cur_ = slot % (uint32_t)slots_.size();
+    collect(cur_);
+    vkCmdResetQueryPool(cmd, tsPool_, cur_ * kMaxScopes * 2, kMaxScopes * 2);
+    slots_[cur_].pending = true;
+    if (statsPool_) {
+        vkCmdResetQueryPool(cmd, statsPool_, cur_, 1);
+        vkCmdBeginQuery(cmd, statsPool_, cur_, 0);
+        slots_[cur_].statsPending = true;
+    }
+    if (logInterval_ > 0.0f) {
+        auto now = eng::time::clock::now();
+        if (eng::time::seconds_f(now - lastLog_).count() >= logInterval_) { lastLog_ = now; logSummary(); }
+    }
+}
+
+void GpuProfiler::endFrame(VkCommandBuffer cmd) {
+    if (statsPool_ && slots_[cur_].statsPending) vkCmdEndQuery(cmd, statsPool_, cur_);
+}
+
+uint32_t GpuProfiler::beginScope(VkCommandBuffer cmd, const char* name) {
+    if (!tsPool_) return UINT32_MAX;
+    Slot& slot = slots_[cur_];
+    if (slot.scopeCount >= kMaxScopes) return UINT32_MAX;
+    uint32_t s = slot.scopeCount++;
+    slot.history[s] = historyIndex(name);
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, tsPool_, cur_ * kMaxScopes * 2 + s * 2);
+    return s;
+}
+
+void GpuProfiler::endScope(VkCommandBuffer cmd, uint32_t scope) {
+    if (scope == UINT32_MAX) return;
+    vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, tsPool_, cur_ * kMaxScopes * 2 + scope * 2 + 1);
+}
+
+std::vector<GpuScopeStats> GpuProfiler::stats() const {
+    std::vector<GpuScopeStats> out;
+    out.reserve(history_.size());
+    std::vector<float> sorted;
+    for (const History& h : history_) {
+        GpuScopeStats st; st.name = h.name; st.lastMs = h.last; st.samples = (uint32_t)h.ms.size();
+        if (!h.ms.empty()) {
+            sorted = h.ms;
+            std::sort(sorted.begin(), sorted.end());
+            double sum = 0.0; for (float v : sorted) sum += v;
+            st.minMs = sorted.front();
+            st.avgMs = sum / sorted.size();
+            st.p99Ms = sorted[std::min(sorted.size() - 1, (size_t)(sorted.size() * 0.99))];
+        }
+        out.push_back(st);
+    }
+    return out;
+}
+
+float GpuProfiler::latestMs(const char* name, uint64_t* sequence) const {
+    for (const History& h : history_) {
+        if (h.name != name && std::strcmp(h.name, name) != 0) continue;
+        if (sequence) *sequence = h.total;
+        return h.last;
+    }
+    if (sequence) *sequence = 0;
+    return 0.0f;
+}
+
+void GpuProfiler::logSummary() {
+    auto all = stats();
+    if (all.empty()) return;
+    std::string line = "GPU ms avg/min/p99:";
+    char buf[128];
+    for (const auto& s : all) {
+        std::snprintf(buf, sizeof(buf), " %s %.2f/%.2f/%.2f", s.name, s.avgMs, s.minMs, s.p99Ms);
+        line += buf;
+    }
+    if (statsPool_) {
+        std::snprintf(buf, sizeof(buf), " | prims %llu, frag invocations %llu",
+                      (unsigned long long)pipeStats_.clipPrimitives, (unsigned long long)pipeStats_.fsInvocations);
+        line += buf;
+    }
+    eng::log::info("%s", line.c_str());
+}
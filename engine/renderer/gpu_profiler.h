@@ -0,0 +1,71 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <vector>
+#include "../core/time.h"
+
+namespace eng::renderer {
+    struct GpuScopeStats {
+        const char* name = nullptr;
+        double lastMs = 0.0, minMs = 0.0, avgMs = 0.0, p99Ms = 0.0;
+        uint32_t samples = 0;
+    };
+
+    // Counters from VK_QUERY_TYPE_PIPELINE_STATISTICS over the whole frame (needs the
+    // pipelineStatisticsQuery device feature; all zero otherwise).
+    struct GpuPipelineStats {
+        uint64_t iaVertices = 0, iaPrimitives = 0, vsInvocations = 0, clipPrimitives = 0, fsInvocations = 0;
+    };
+
+    // Named GPU timing scopes via vkCmdWriteTimestamp. Query pools are ring-buffered per frame
+    // in flight and read back when that slot comes around again (its fence has already been
+    // waited on), so collecting results never stalls. Scope names must be string literals.
+    class GpuProfiler {
+    public:
+        static constexpr uint32_t kMaxScopes = 16;     // per frame
+        static constexpr uint32_t kHistory = 256;      // samples kept per scope for min/avg/p99
+
+        bool init(VkPhysicalDevice physical, VkDevice device, uint32_t queueFamily, uint32_t framesInFlight, bool pipelineStats);
+        void shutdown();
+        bool enabled() const { return tsPool_ != VK_NULL_HANDLE; }
+
+        // Call outside a render pass: beginFrame after the slot's fence wait, endFrame after the last pass.
+        void beginFrame(VkCommandBuffer cmd, uint32_t slot);
+        void endFrame(VkCommandBuffer cmd);
+        uint32_t beginScope(VkCommandBuffer cmd, const char* name);
+        void endScope(VkCommandBuffer cmd, uint32_t scope);
+
+        std::vector<GpuScopeStats> stats() const;
+        // Newest sample of one scope (0 before any), cheap enough for every frame unlike stats().
+        // sequence, when given, receives the scope's total sample count, which only advances on new data.
+        float latestMs(const char* name, uint64_t* sequence = nullptr) const;
+        const GpuPipelineStats& pipelineStats() const { return pipeStats_; }
+        void setLogInterval(float seconds) { logInterval_ = seconds; } // 0 disables the periodic log line
+
+        struct Scope {
+            Scope(GpuProfiler& p, VkCommandBuffer cmd, const char* name) : p_(p), cmd_(cmd), id_(p.beginScope(cmd, name)) {}
+            ~Scope() { p_.endScope(cmd_, id_); }
+            Scope(const Scope&) = delete; Scope& operator=(const Scope&) = delete;
+        private:
+            GpuProfiler& p_; VkCommandBuffer cmd_; uint32_t id_;
+        };
+    private:
+        struct Slot { uint32_t scopeCount = 0; uint16_t history[kMaxScopes]{}; bool pending = false; bool statsPending = false; };
+        struct History { const char* name; std::vector<float> ms; uint32_t next = 0; float last = 0.0f; uint64_t total = 0; };
+
+        VkDevice device_{};
+        VkQueryPool tsPool_{}, statsPool_{};
+        double nsPerTick_ = 1.0;
+        uint64_t tsMask_ = ~0ull;
+        std::vector<Slot> slots_;
+        uint32_t cur_ = 0;
+        std::vector<History> history_;
+        GpuPipelineStats pipeStats_{};
+        float logInterval_ = 5.0f;
+        eng::time::clock::time_point lastLog_ = eng::time::clock::now();
+
+        void collect(uint32_t slot);
+        uint16_t historyIndex(const char* name);
+        void logSummary();
+    };
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace eng::renderer {
+    // CPU reference for the Hi-Z pyramid built by hiz_reduce.comp; the renderer bench checks it and
+    // times it. Must stay in sync with the shader's region bounds.
+
+    // Level 0 of the pyramid is the largest power of two not above the depth extent
+    inline uint32_t hizLevel0Size(uint32_t v) {
+        uint32_t p = 1;
+        while (p * 2 <= v) p *= 2;
+        return p;
+    }
+
+    inline uint32_t hizLevelCount(uint32_t w, uint32_t h) {
+        uint32_t n = 1;
+        for (uint32_t m = std::max(w, h); m > 1; m /= 2) ++n;
+        return n;
+    }
+
+    // Each destination texel takes the max (farthest) depth of every source texel it overlaps.
+    // The region is rounded outwards, so a non-integer ratio never drops a source texel.
+    inline void hizReduceReference(const float* src, uint32_t srcW, uint32_t srcH, float* dst, uint32_t dstW, uint32_t dstH) {
+        for (uint32_t y = 0; y < dstH; ++y) {
+            uint32_t y0 = y * srcH / dstH, y1 = std::max(((y + 1) * srcH + dstH - 1) / dstH, y0 + 1);
+            for (uint32_t x = 0; x < dstW; ++x) {
+                uint32_t x0 = x * srcW / dstW, x1 = std::max(((x + 1) * srcW + dstW - 1) / dstW, x0 + 1);
+                float d = 0.0f;
+                for (uint32_t sy = y0; sy < y1; ++sy)
+                    for (uint32_t sx = x0; sx < x1; ++sx) d = std::max(d, src[sy * srcW + sx]);
+                dst[y * dstW + x] = d;
+            }
+        }
+    }
+
+    // Full pyramid for a row-major depth buffer; levels[0] is hizLevel0Size() of each axis, the last is 1x1
+    inline std::vector<std::vector<float>> buildHiZReference(const float* depth, uint32_t width, uint32_t height) {
+        uint32_t w = hizLevel0Size(width), h = hizLevel0Size(height);
+        std::vector<std::vector<float>> levels(hizLevelCount(w, h));
+        const float* src = depth; uint32_t sw = width, sh = height;
+        for (auto& level : levels) {
+            level.resize((size_t)w * h);
+            hizReduceReference(src, sw, sh, level.data(), w, h);
+            src = level.data(); sw = w; sh = h;
+            w = std::max(w / 2, 1u); h = std::max(h / 2, 1u);
+        }
+        return levels;
+    }
+}
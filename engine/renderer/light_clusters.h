@@ -0,0 +1,103 @@
+#pragma once
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+namespace eng::renderer {
+    // Froxel grid shared by light_cluster.comp, clustered_lighting.glsl and the CPU reference below:
+    // kClusterX x kClusterY screen tiles, kClusterZ slices spaced exponentially between near and far.
+    constexpr uint32_t kClusterX = 16, kClusterY = 9, kClusterZ = 24;
+    constexpr uint32_t kClusterCount = kClusterX * kClusterY * kClusterZ;
+    constexpr uint32_t kMaxLightsPerCluster = 128; // further lights in a crowded cluster are dropped
+    constexpr uint32_t kMaxLights = 4096;
+
+    enum class LightType : uint32_t { Point = 0, Spot = 1 };
+
+    // Light record (std430), world space
+    struct GpuLight {
+        float position[3] = {}; float range = 1.0f;
+        float color[3] = {1.0f, 1.0f, 1.0f}; float intensity = 1.0f;
+        float direction[3] = {0.0f, -1.0f, 0.0f}; float cosOuter = -1.0f; // spot only
+        float cosInner = -1.0f; uint32_t type = 0; float pad[2] = {};
+    };
+    static_assert(sizeof(GpuLight) == 64, "GpuLight must match the std430 layout in clustered_lighting.glsl");
+
+    // Per-frame cluster parameters (std140)
+    struct ClusterParams {
+        float view[16];
+        float invProj[16];
+        uint32_t grid[4];  // x, y, z, light count
+        float screen[4];   // width, height, near, far
+        float slice[4];    // scale, bias: slice = floor(log(viewDepth) * scale + bias)
+    };
+    static_assert(sizeof(ClusterParams) == 176, "ClusterParams must match the std140 layout in clustered_lighting.glsl");
+
+    inline ClusterParams makeClusterParams(const glm::mat4& view, const glm::mat4& proj, float nearPlane, float farPlane,
+                                           float width, float height, uint32_t lightCount) {
+        ClusterParams p{};
+        glm::mat4 invProj = glm::inverse(proj);
+        for (int c = 0; c < 4; ++c) for (int r = 0; r < 4; ++r) { p.view[c * 4 + r] = view[c][r]; p.invProj[c * 4 + r] = invProj[c][r]; }
+        p.grid[0] = kClusterX; p.grid[1] = kClusterY; p.grid[2] = kClusterZ; p.grid[3] = lightCount;
+        p.screen[0] = width; p.screen[1] = height; p.screen[2] = nearPlane; p.screen[3] = farPlane;
+        float logRatio = std::log(farPlane / nearPlane);
+        p.slice[0] = kClusterZ / logRatio;
+        p.slice[1] = -(float)kClusterZ * std::log(nearPlane) / logRatio;
+        return p;
+    }
+
+    inline glm::mat4 clusterMat(const float* m) {
+        glm::mat4 r;
+        for (int c = 0; c < 4; ++c) for (int k = 0; k < 4; ++k) r[c][k] = m[c * 4 + k];
+        return r;
+    }
+
+    // View-space bounds of cluster (x, y, z). View space looks down -z; slice z spans view depths
+    // near * (far / near)^(z / kClusterZ) .. near * (far / near)^((z + 1) / kClusterZ).
+    inline void clusterBounds(const ClusterParams& p, uint32_t x, uint32_t y, uint32_t z, glm::vec3& lo, glm::vec3& hi) {
+        glm::mat4 invProj = clusterMat(p.invProj);
+        float n = p.screen[2], f = p.screen[3];
+        float d0 = n * std::pow(f / n, (float)z / kClusterZ), d1 = n * std::pow(f / n, (float)(z + 1) / kClusterZ);
+        lo = glm::vec3(1e30f); hi = glm::vec3(-1e30f);
+        for (int i = 0; i < 4; ++i) {
+            glm::vec2 ndc(((float)x + (i & 1)) / kClusterX * 2.0f - 1.0f, ((float)y + (i >> 1)) / kClusterY * 2.0f - 1.0f);
+            glm::vec4 v = invProj * glm::vec4(ndc, 0.0f, 1.0f);
+            glm::vec3 ray = glm::vec3(v) / v.w;
+            ray /= -ray.z; // point on the tile corner's ray at view depth 1
+            for (float d : { d0, d1 }) { lo = glm::min(lo, ray * d); hi = glm::max(hi, ray * d); }
+        }
+    }
+
+    inline bool sphereIntersectsAabb(const glm::vec3& c, float r, const glm::vec3& lo, const glm::vec3& hi) {
+        glm::vec3 q = glm::clamp(c, lo, hi) - c;
+        return glm::dot(q, q) <= r * r;
+    }
+
+    // CPU reference of light_cluster.comp: counts[c] lights for cluster c, listed at
+    // indices[c * kMaxLightsPerCluster ...] in ascending light order. Spot lights use their range sphere.
+    inline void assignLightsReference(const ClusterParams& p, const std::vector<GpuLight>& lights,
+                                      std::vector<uint32_t>& counts, std::vector<uint32_t>& indices) {
+        counts.assign(kClusterCount, 0);
+        indices.assign((size_t)kClusterCount * kMaxLightsPerCluster, 0);
+        glm::mat4 view = clusterMat(p.view);
+        std::vector<glm::vec4> spheres;
+        for (const auto& l : lights) spheres.push_back(glm::vec4(glm::vec3(view * glm::vec4(l.position[0], l.position[1], l.position[2], 1.0f)), l.range));
+        for (uint32_t z = 0; z < kClusterZ; ++z)
+            for (uint32_t y = 0; y < kClusterY; ++y)
+                for (uint32_t x = 0; x < kClusterX; ++x) {
+                    uint32_t c = (z * kClusterY + y) * kClusterX + x;
+                    glm::vec3 lo, hi; clusterBounds(p, x, y, z, lo, hi);
+                    for (uint32_t i = 0; i < (uint32_t)spheres.size() && counts[c] < kMaxLightsPerCluster; ++i)
+                        if (sphereIntersectsAabb(glm::vec3(spheres[i]), spheres[i].w, lo, hi)) indices[(size_t)c * kMaxLightsPerCluster + counts[c]++] = i;
+                }
+    }
+
+    // Cluster holding a fragment at window position (px, py) and positive view depth
+    inline uint32_t clusterIndex(const ClusterParams& p, float px, float py, float viewDepth) {
+        uint32_t x = std::min((uint32_t)(px / p.screen[0] * kClusterX), kClusterX - 1);
+        uint32_t y = std::min((uint32_t)(py / p.screen[1] * kClusterY), kClusterY - 1);
+        int z = (int)std::floor(std::log(std::max(viewDepth, 1e-6f)) * p.slice[0] + p.slice[1]);
+        return ((uint32_t)std::clamp(z, 0, (int)kClusterZ - 1) * kClusterY + y) * kClusterX + x;
+    }
+}
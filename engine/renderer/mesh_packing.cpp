@@ -0,0 +1,77 @@
+#include "mesh_packing.h"
+#include "../core/profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+
+using namespace eng::renderer;
+
+bool eng::renderer::packMeshes(const std::vector<scene::Mesh>& meshes, const MeshArena& arena,
+                               const std::function<uint32_t(int material)>& gpuMaterial, PackedGeometry& out) {
+    ENG_PROFILE_FUNCTION();
+    out = {};
+    size_t totalInstances = 0;
+    for (const auto& mesh : meshes) totalInstances += mesh.instances.size();
+    GpuInstance* dstInstances = nullptr;
+    if (totalInstances > 0) {
+        out.instanceBytes = totalInstances * sizeof(GpuInstance);
+        out.instanceOffset = arena.allocate(out.instanceBytes, sizeof(GpuInstance));
+        if (out.instanceOffset == RangeAllocator::kInvalid) { out.instanceBytes = 0; return false; }
+        dstInstances = reinterpret_cast<GpuInstance*>(arena.base + out.instanceOffset);
+    }
+    out.meshes.reserve(meshes.size());
+    out.instances.reserve(totalInstances);
+
+    for (const auto& mesh : meshes) {
+        PackedMesh p;
+        p.material = mesh.material;
+        p.indexCount = static_cast<uint32_t>(mesh.indices.size());
+        p.vertexCount = static_cast<uint32_t>(mesh.vertices.size());
+        p.firstInstance = static_cast<uint32_t>(out.instances.size());
+        p.instanceCount = static_cast<uint32_t>(mesh.instances.size());
+        if (!mesh.vertices.empty()) {
+            uint64_t bytes = mesh.vertices.size() * sizeof(scene::MeshVertex);
+            p.vertexOffset = arena.allocate(bytes, sizeof(scene::MeshVertex));
+            if (p.vertexOffset == RangeAllocator::kInvalid) { out.meshes.push_back(p); return false; }
+            p.vertexBytes = bytes;
+            std::memcpy(arena.base + p.vertexOffset, mesh.vertices.data(), bytes);
+            p.firstVertex = static_cast<uint32_t>(p.vertexOffset / sizeof(scene::MeshVertex));
+        }
+        if (!mesh.indices.empty()) {
+            uint64_t bytes = mesh.indices.size() * sizeof(uint32_t);
+            p.indexOffset = arena.allocate(bytes, sizeof(uint32_t));
+            if (p.indexOffset == RangeAllocator::kInvalid) { out.meshes.push_back(p); return false; }
+            p.indexBytes = bytes;
+            std::memcpy(arena.base + p.indexOffset, mesh.indices.data(), bytes);
+            p.firstIndex = static_cast<uint32_t>(p.indexOffset / sizeof(uint32_t));
+        }
+
+        glm::vec3 lo(FLT_MAX), hi(-FLT_MAX);
+        glm::vec2 uvLo(FLT_MAX), uvHi(-FLT_MAX);
+        for (const auto& v : mesh.vertices) {
+            lo = glm::min(lo, v.position); hi = glm::max(hi, v.position);
+            uvLo = glm::min(uvLo, v.texCoord); uvHi = glm::max(uvHi, v.texCoord);
+        }
+        glm::vec3 center(0.0f); float radius = 0.0f;
+        if (!mesh.vertices.empty()) {
+            center = (lo + hi) * 0.5f;
+            radius = glm::length(hi - lo) * 0.5f;
+            p.uvSpan = std::max(std::max(uvHi.x - uvLo.x, uvHi.y - uvLo.y), 1e-3f);
+        }
+        uint32_t material = gpuMaterial ? gpuMaterial(mesh.material) : 0;
+        for (const auto& m : mesh.instances) {
+            // Bounding sphere under the instance transform, scaled by its largest axis
+            float scale = std::max(std::max(glm::length(glm::vec3(m[0])), glm::length(glm::vec3(m[1]))), glm::length(glm::vec3(m[2])));
+            out.instances.push_back({ glm::vec3(m * glm::vec4(center, 1.0f)), radius * scale, (uint32_t)out.meshes.size() });
+            GpuInstance gi{};
+            std::memcpy(gi.model, &m[0][0], sizeof(gi.model));
+            gi.material = material;
+            *dstInstances++ = gi;
+        }
+        out.meshes.push_back(p);
+
+        out.vertices += mesh.vertices.size();
+        out.expandedBytes += (mesh.vertices.size() * sizeof(scene::MeshVertex) + mesh.indices.size() * sizeof(uint32_t)) * mesh.instances.size();
+    }
+    return true;
+}
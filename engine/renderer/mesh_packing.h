@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include <glm/glm.hpp>
+#include "range_allocator.h"
+#include "../scene/gltf_loader.h"
+
+namespace eng::renderer {
+    // Mesh instance record in the geometry arena (MESH_INSTANCE_WORDS in geometry_arena.glsl)
+    struct GpuInstance {
+        float model[16];   // column-major world transform
+        uint32_t material; // bindless material index, unused otherwise
+        uint32_t pad[3];
+    };
+    static_assert(sizeof(GpuInstance) == 80, "GpuInstance must match MESH_INSTANCE_WORDS in geometry_arena.glsl");
+    static_assert(sizeof(eng::scene::MeshVertex) == 32, "MeshVertex must match MESH_VERTEX_WORDS in geometry_arena.glsl");
+
+    // Where one mesh landed; byte offsets are RangeAllocator::kInvalid for an empty section
+    struct PackedMesh {
+        uint64_t vertexOffset = RangeAllocator::kInvalid, vertexBytes = 0;
+        uint64_t indexOffset = RangeAllocator::kInvalid, indexBytes = 0;
+        uint32_t firstVertex = 0, vertexCount = 0, firstIndex = 0, indexCount = 0; // arena element indices
+        uint32_t firstInstance = 0, instanceCount = 0; // into PackedGeometry::instances
+        int material = -1;
+        float uvSpan = 1.0f; // largest UV extent across the mesh
+    };
+    // World-space bounding sphere of one instance; draw is the index of its mesh
+    struct PackedInstance { glm::vec3 center{0.0f}; float radius = 0.0f; uint32_t draw = 0; };
+
+    struct PackedGeometry {
+        uint64_t instanceOffset = RangeAllocator::kInvalid, instanceBytes = 0; // every GpuInstance, mesh by mesh
+        std::vector<PackedMesh> meshes;
+        std::vector<PackedInstance> instances;
+        size_t vertices = 0;      // unique vertices across all meshes
+        size_t expandedBytes = 0; // vertex + index bytes had every instance its own copy
+    };
+
+    // The arena being filled: allocate(size, alignment) returns a byte offset into base, or
+    // RangeAllocator::kInvalid when full
+    struct MeshArena {
+        std::function<uint64_t(uint64_t size, uint64_t alignment)> allocate;
+        uint8_t* base = nullptr;
+    };
+
+    // CPU side of uploading scene meshes: one instance range for all meshes, then each mesh's
+    // vertices and indices copied into ranges of their own (aligned to the element size, so
+    // offsets become firstVertex / firstIndex), bounds and UV span per mesh, and a GpuInstance and
+    // culling sphere per instance. gpuMaterial maps a scene material to GpuInstance::material.
+    // False when the arena is full; out then holds what was allocated so it can be released.
+    bool packMeshes(const std::vector<scene::Mesh>& meshes, const MeshArena& arena,
+                    const std::function<uint32_t(int material)>& gpuMaterial, PackedGeometry& out);
+}
@@ -0,0 +1,363 @@
+#include "occlusion_culler.h"
+#include "deletion_queue.h"
+#include "hiz_reference.h"
+#include "shader_registry.h"
+#include "../core/log.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+using namespace eng::renderer;
+
+static uint32_t findMemoryType(VkPhysicalDevice physical, uint32_t typeFilter, VkMemoryPropertyFlags props) {
+    VkPhysicalDeviceMemoryProperties memProps{}; vkGetPhysicalDeviceMemoryProperties(physical, &memProps);
+    for (uint32_t i=0;i<memProps.memoryTypeCount;++i) if ((typeFilter & (1u<<i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) return i;
+    return UINT32_MAX;
+}
+
+static VkPipeline createComputePipeline(VkDevice device, VkPipelineCache cache, VkShaderModule mod, VkPipelineLayout layout) {
+    VkComputePipelineCreateInfo ci{VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
+    ci.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; ci.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT; ci.stage.module = mod; ci.stage.pName = "main";
+    ci.layout = layout;
+    VkPipeline p{};
+    if (vkCreateComputePipelines(device, cache, 1, &ci, nullptr, &p) != VK_SUCCESS) return VK_NULL_HANDLE;
+    return p;
+}
+
+// The eye is the point whose clip-space x, y and w are all zero (rows 0, 1 and 3 of the column-major vp)
+static bool eyeFromViewProj(const float* m, glm::vec3& eye) {
+    const int rows[3] = { 0, 1, 3 };
+    glm::mat3 a; glm::vec3 b;
+    for (int r = 0; r < 3; ++r) {
+        for (int c = 0; c < 3; ++c) a[c][r] = m[c * 4 + rows[r]];
+        b[r] = -m[12 + rows[r]];
+    }
+    if (std::fabs(glm::determinant(a)) < 1e-12f) return false; // orthographic: no single eye point
+    eye = glm::inverse(a) * b;
+    return true;
+}
+
+bool OcclusionCuller::init(VkPhysicalDevice physical, VkDevice device, ShaderRegistry& shaders, VkPipelineCache cache,
+                           uint32_t framesInFlight, DeletionQueue* deletions) {
+    physical_ = physical; device_ = device; deletions_ = deletions; framesInFlight_ = framesInFlight;
+    VkShaderModule reduceMod = shaders.get(ShaderId::HiZReduceComp);
+    VkShaderModule cullMod = shaders.get(ShaderId::OcclusionCullComp);
+    if (!reduceMod || !cullMod) { shutdown(); return false; }
+
+    VkDescriptorSetLayoutBinding rb[2] = {
+        {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+    };
+    VkDescriptorSetLayoutCreateInfo rlci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO}; rlci.bindingCount = 2; rlci.pBindings = rb;
+    if (vkCreateDescriptorSetLayout(device_, &rlci, nullptr, &reduceSetLayout_) != VK_SUCCESS) { shutdown(); return false; }
+    VkDescriptorSetLayoutBinding cb[5] = {
+        {0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {3, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+        {4, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT, nullptr},
+    };
+    VkDescriptorSetLayoutCreateInfo clci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO}; clci.bindingCount = 5; clci.pBindings = cb;
+    if (vkCreateDescriptorSetLayout(device_, &clci, nullptr, &cullSetLayout_) != VK_SUCCESS) { shutdown(); return false; }
+
+    VkPushConstantRange pcr{VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(int32_t) * 4};
+    VkPipelineLayoutCreateInfo rplci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO};
+    rplci.setLayoutCount = 1; rplci.pSetLayouts = &reduceSetLayout_; rplci.pushConstantRangeCount = 1; rplci.pPushConstantRanges = &pcr;
+    if (vkCreatePipelineLayout(device_, &rplci, nullptr, &reduceLayout_) != VK_SUCCESS) { shutdown(); return false; }
+    VkPipelineLayoutCreateInfo cplci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO}; cplci.setLayoutCount = 1; cplci.pSetLayouts = &cullSetLayout_;
+    if (vkCreatePipelineLayout(device_, &cplci, nullptr, &cullLayout_) != VK_SUCCESS) { shutdown(); return false; }
+    reducePipeline_ = createComputePipeline(device_, cache, reduceMod, reduceLayout_);
+    if (!reducePipeline_) { shutdown(); return false; }
+
+    // Nearest filtering: a pyramid texel is a bound, blending neighbours would break it
+    VkSamplerCreateInfo sci{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sci.magFilter = sci.minFilter = VK_FILTER_NEAREST; sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sci.addressModeU = sci.addressModeV = sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(device_, &sci, nullptr, &sampler_) != VK_SUCCESS) { shutdown(); return false; }
+
+    if (!createBuffer(kSlotSize * framesInFlight_, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+                      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, frameBuf_, frameMem_)) { shutdown(); return false; }
+    void* ptr = nullptr; if (vkMapMemory(device_, frameMem_, 0, VK_WHOLE_SIZE, 0, &ptr) != VK_SUCCESS) { shutdown(); return false; }
+    framePtr_ = static_cast<uint8_t*>(ptr);
+    slotPending_.assign(framesInFlight_, false);
+
+    // Created last: enabled() keys off it
+    cullPipeline_ = createComputePipeline(device_, cache, cullMod, cullLayout_);
+    if (!cullPipeline_) { shutdown(); return false; }
+    return true;
+}
+
+VkPipeline OcclusionCuller::buildPipeline(ShaderId id, ShaderRegistry& shaders, VkPipelineCache cache) const {
+    VkPipelineLayout layout = id == ShaderId::HiZReduceComp ? reduceLayout_ : id == ShaderId::OcclusionCullComp ? cullLayout_ : VK_NULL_HANDLE;
+    VkShaderModule mod = layout ? shaders.get(id) : VK_NULL_HANDLE;
+    return mod ? createComputePipeline(device_, cache, mod, layout) : VK_NULL_HANDLE;
+}
+
+VkPipeline OcclusionCuller::replacePipeline(ShaderId id, VkPipeline pipeline) {
+    std::swap(id == ShaderId::HiZReduceComp ? reducePipeline_ : cullPipeline_, pipeline);
+    return pipeline;
+}
+
+void OcclusionCuller::shutdown() {
+    if (!device_) return;
+    if (pool_) { vkDestroyDescriptorPool(device_, pool_, nullptr); pool_ = VK_NULL_HANDLE; }
+    reduceSets_.clear(); cullSets_.clear();
+    for (auto v : mipViews_) vkDestroyImageView(device_, v, nullptr);
+    mipViews_.clear();
+    if (pyramidView_) { vkDestroyImageView(device_, pyramidView_, nullptr); pyramidView_ = VK_NULL_HANDLE; }
+    if (pyramid_) { vkDestroyImage(device_, pyramid_, nullptr); pyramid_ = VK_NULL_HANDLE; }
+    if (pyramidMem_) { vkFreeMemory(device_, pyramidMem_, nullptr); pyramidMem_ = VK_NULL_HANDLE; }
+    for (auto* b : { &drawBuf_, &indirectBuf_, &frameBuf_ }) { if (*b) vkDestroyBuffer(device_, *b, nullptr); *b = VK_NULL_HANDLE; }
+    for (auto* m : { &drawMem_, &indirectMem_, &frameMem_ }) { if (*m) vkFreeMemory(device_, *m, nullptr); *m = VK_NULL_HANDLE; }
+    framePtr_ = nullptr; drawCount_ = 0;
+    if (sampler_) { vkDestroySampler(device_, sampler_, nullptr); sampler_ = VK_NULL_HANDLE; }
+    for (auto* p : { &reducePipeline_, &cullPipeline_ }) { if (*p) vkDestroyPipeline(device_, *p, nullptr); *p = VK_NULL_HANDLE; }
+    for (auto* l : { &reduceLayout_, &cullLayout_ }) { if (*l) vkDestroyPipelineLayout(device_, *l, nullptr); *l = VK_NULL_HANDLE; }
+    for (auto* l : { &reduceSetLayout_, &cullSetLayout_ }) { if (*l) vkDestroyDescriptorSetLayout(device_, *l, nullptr); *l = VK_NULL_HANDLE; }
+    havePyramid_ = false;
+    device_ = VK_NULL_HANDLE;
+}
+
+bool OcclusionCuller::createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, VkBuffer& buf, VkDeviceMemory& mem) {
+    VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO}; bci.size = size; bci.usage = usage; bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bci, nullptr, &buf) != VK_SUCCESS) { buf = VK_NULL_HANDLE; return false; }
+    VkMemoryRequirements mr{}; vkGetBufferMemoryRequirements(device_, buf, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO}; mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = findMemoryType(physical_, mr.memoryTypeBits, props);
+    if (mai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device_, &mai, nullptr, &mem) != VK_SUCCESS) {
+        vkDestroyBuffer(device_, buf, nullptr); buf = VK_NULL_HANDLE; mem = VK_NULL_HANDLE;
+        return false;
+    }
+    vkBindBufferMemory(device_, buf, mem, 0);
+    return true;
+}
+
+void OcclusionCuller::destroyPyramid(uint64_t frameIndex) {
+    if (!pyramid_) return;
+    deletions_->push(frameIndex, [dev = device_, img = pyramid_, mem = pyramidMem_, view = pyramidView_, mips = mipViews_] {
+        for (auto v : mips) vkDestroyImageView(dev, v, nullptr);
+        vkDestroyImageView(dev, view, nullptr);
+        vkDestroyImage(dev, img, nullptr);
+        vkFreeMemory(dev, mem, nullptr);
+    });
+    pyramid_ = VK_NULL_HANDLE; pyramidMem_ = VK_NULL_HANDLE; pyramidView_ = VK_NULL_HANDLE;
+    mipViews_.clear();
+    levels_ = 0;
+}
+
+bool OcclusionCuller::resize(VkImage depthImage, VkImageView depthView, VkFormat depthFormat, VkExtent2D extent, uint64_t frameIndex) {
+    if (!enabled()) return false;
+    destroyPyramid(frameIndex);
+    havePyramid_ = false;
+    depthImage_ = depthImage; depthView_ = depthView; depthExtent_ = extent;
+    bool stencil = depthFormat == VK_FORMAT_D16_UNORM_S8_UINT || depthFormat == VK_FORMAT_D24_UNORM_S8_UINT || depthFormat == VK_FORMAT_D32_SFLOAT_S8_UINT;
+    depthAspect_ = VK_IMAGE_ASPECT_DEPTH_BIT | (stencil ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+
+    pyramidExtent_ = { hizLevel0Size(extent.width), hizLevel0Size(extent.height) };
+    levels_ = hizLevelCount(pyramidExtent_.width, pyramidExtent_.height);
+    VkImageCreateInfo ici{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    ici.imageType = VK_IMAGE_TYPE_2D; ici.format = VK_FORMAT_R32_SFLOAT;
+    ici.extent = { pyramidExtent_.width, pyramidExtent_.height, 1 };
+    ici.mipLevels = levels_; ici.arrayLayers = 1; ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL; ici.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_STORAGE_BIT;
+    if (vkCreateImage(device_, &ici, nullptr, &pyramid_) != VK_SUCCESS) { pyramid_ = VK_NULL_HANDLE; return false; }
+    VkMemoryRequirements mr{}; vkGetImageMemoryRequirements(device_, pyramid_, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO}; mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = findMemoryType(physical_, mr.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (mai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device_, &mai, nullptr, &pyramidMem_) != VK_SUCCESS) {
+        vkDestroyImage(device_, pyramid_, nullptr); pyramid_ = VK_NULL_HANDLE; pyramidMem_ = VK_NULL_HANDLE;
+        return false;
+    }
+    vkBindImageMemory(device_, pyramid_, pyramidMem_, 0);
+
+    VkImageViewCreateInfo vci{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    vci.image = pyramid_; vci.viewType = VK_IMAGE_VIEW_TYPE_2D; vci.format = VK_FORMAT_R32_SFLOAT;
+    vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels_, 0, 1 };
+    bool ok = vkCreateImageView(device_, &vci, nullptr, &pyramidView_) == VK_SUCCESS;
+    mipViews_.assign(levels_, VK_NULL_HANDLE);
+    for (uint32_t i = 0; ok && i < levels_; ++i) {
+        vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+        ok = vkCreateImageView(device_, &vci, nullptr, &mipViews_[i]) == VK_SUCCESS;
+    }
+    if (!ok) { destroyPyramid(frameIndex); return false; }
+    pyramidFresh_ = true;
+    return rebuildSets(frameIndex);
+}
+
+bool OcclusionCuller::setDraws(const std::vector<CullDraw>& draws, uint64_t frameIndex) {
+    if (!enabled()) return false;
+    if (drawBuf_ || indirectBuf_) {
+        deletions_->push(frameIndex, [dev = device_, b0 = drawBuf_, m0 = drawMem_, b1 = indirectBuf_, m1 = indirectMem_] {
+            if (b0) vkDestroyBuffer(dev, b0, nullptr);
+            if (m0) vkFreeMemory(dev, m0, nullptr);
+            if (b1) vkDestroyBuffer(dev, b1, nullptr);
+            if (m1) vkFreeMemory(dev, m1, nullptr);
+        });
+    }
+    drawBuf_ = indirectBuf_ = VK_NULL_HANDLE; drawMem_ = indirectMem_ = VK_NULL_HANDLE;
+    drawCount_ = 0;
+    if (!draws.empty()) {
+        VkDeviceSize size = draws.size() * sizeof(CullDraw);
+        // Regions start on 256 bytes, a multiple of any minStorageBufferOffsetAlignment
+        indirectRegion_ = (draws.size() * sizeof(VkDrawIndexedIndirectCommand) + 255) & ~VkDeviceSize(255);
+        void* ptr = nullptr;
+        bool ok = createBuffer(size, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, drawBuf_, drawMem_) &&
+                  createBuffer(indirectRegion_ * framesInFlight_, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                               VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indirectBuf_, indirectMem_) &&
+                  vkMapMemory(device_, drawMem_, 0, size, 0, &ptr) == VK_SUCCESS;
+        if (!ok) {
+            eng::log::warn("Occlusion culling: cannot allocate buffers for %zu draws", draws.size());
+            for (auto* b : { &drawBuf_, &indirectBuf_ }) { if (*b) vkDestroyBuffer(device_, *b, nullptr); *b = VK_NULL_HANDLE; }
+            for (auto* m : { &drawMem_, &indirectMem_ }) { if (*m) vkFreeMemory(device_, *m, nullptr); *m = VK_NULL_HANDLE; }
+            rebuildSets(frameIndex);
+            return false;
+        }
+        std::memcpy(ptr, draws.data(), (size_t)size);
+        vkUnmapMemory(device_, drawMem_);
+        drawCount_ = (uint32_t)draws.size();
+    }
+    return rebuildSets(frameIndex);
+}
+
+bool OcclusionCuller::rebuildSets(uint64_t frameIndex) {
+    if (pool_) deletions_->push(frameIndex, [dev = device_, p = pool_] { vkDestroyDescriptorPool(dev, p, nullptr); });
+    pool_ = VK_NULL_HANDLE;
+    reduceSets_.clear(); cullSets_.clear();
+    if (!pyramid_) return true;
+
+    uint32_t cullCount = (drawCount_ > 0 && drawBuf_) ? framesInFlight_ : 0;
+    std::vector<VkDescriptorPoolSize> sizes = {
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, levels_ + cullCount},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, levels_},
+    };
+    if (cullCount) {
+        sizes.push_back({VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3 * cullCount});
+        sizes.push_back({VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, cullCount});
+    }
+    VkDescriptorPoolCreateInfo pci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+    pci.maxSets = levels_ + cullCount; pci.poolSizeCount = (uint32_t)sizes.size(); pci.pPoolSizes = sizes.data();
+    if (vkCreateDescriptorPool(device_, &pci, nullptr, &pool_) != VK_SUCCESS) { pool_ = VK_NULL_HANDLE; return false; }
+
+    std::vector<VkDescriptorSetLayout> layouts(levels_, reduceSetLayout_);
+    layouts.resize(levels_ + cullCount, cullSetLayout_);
+    std::vector<VkDescriptorSet> sets(layouts.size());
+    VkDescriptorSetAllocateInfo ai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    ai.descriptorPool = pool_; ai.descriptorSetCount = (uint32_t)sets.size(); ai.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device_, &ai, sets.data()) != VK_SUCCESS) return false;
+    reduceSets_.assign(sets.begin(), sets.begin() + levels_);
+    cullSets_.assign(sets.begin() + levels_, sets.end());
+
+    // Level i reads level i - 1 (level 0 reads the depth attachment) and writes level i
+    for (uint32_t i = 0; i < levels_; ++i) {
+        VkDescriptorImageInfo src = i == 0 ? VkDescriptorImageInfo{sampler_, depthView_, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL}
+                                           : VkDescriptorImageInfo{sampler_, mipViews_[i - 1], VK_IMAGE_LAYOUT_GENERAL};
+        VkDescriptorImageInfo dst{VK_NULL_HANDLE, mipViews_[i], VK_IMAGE_LAYOUT_GENERAL};
+        VkWriteDescriptorSet w[2]{};
+        w[0] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}; w[0].dstSet = reduceSets_[i]; w[0].dstBinding = 0;
+        w[0].descriptorCount = 1; w[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; w[0].pImageInfo = &src;
+        w[1] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}; w[1].dstSet = reduceSets_[i]; w[1].dstBinding = 1;
+        w[1].descriptorCount = 1; w[1].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE; w[1].pImageInfo = &dst;
+        vkUpdateDescriptorSets(device_, 2, w, 0, nullptr);
+    }
+    for (uint32_t s = 0; s < cullCount; ++s) {
+        VkDescriptorImageInfo pyr{sampler_, pyramidView_, VK_IMAGE_LAYOUT_GENERAL};
+        VkDescriptorBufferInfo bufs[4] = {
+            {drawBuf_, 0, VK_WHOLE_SIZE},
+            {indirectBuf_, indirectRegion_ * s, indirectRegion_},
+            {frameBuf_, kSlotSize * s + kParamsSize, sizeof(uint32_t) * 4},
+            {frameBuf_, kSlotSize * s, sizeof(Params)},
+        };
+        VkWriteDescriptorSet w[5]{};
+        for (uint32_t b = 0; b < 5; ++b) { w[b] = {VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET}; w[b].dstSet = cullSets_[s]; w[b].dstBinding = b; w[b].descriptorCount = 1; }
+        w[0].descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; w[0].pImageInfo = &pyr;
+        for (uint32_t b = 1; b < 4; ++b) { w[b].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER; w[b].pBufferInfo = &bufs[b - 1]; }
+        w[4].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER; w[4].pBufferInfo = &bufs[3];
+        vkUpdateDescriptorSets(device_, 5, w, 0, nullptr);
+    }
+    return true;
+}
+
+void OcclusionCuller::cull(VkCommandBuffer cmd, uint32_t frameSlot, const float* vp16, bool occlusion) {
+    if (!enabled() || drawCount_ == 0 || cullSets_.empty()) return;
+    Params p{};
+    std::memcpy(p.pyramidVp, pyramidVp_, sizeof(p.pyramidVp));
+    // Gribb-Hartmann planes from the rows of the column-major vp. The near plane uses the
+    // GL-style -w bound, which lies in front of Vulkan's 0 and so only ever keeps more.
+    const float* m = vp16;
+    auto row = [&](int r) { return glm::vec4(m[r], m[4 + r], m[8 + r], m[12 + r]); };
+    glm::vec4 planes[6] = { row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2), row(3) - row(2) };
+    for (int i = 0; i < 6; ++i) {
+        float len = glm::length(glm::vec3(planes[i]));
+        glm::vec4 pl = len > 0.0f ? planes[i] / len : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+        std::memcpy(p.planes[i], &pl[0], sizeof(p.planes[i]));
+    }
+    p.pyramidSize[0] = (float)pyramidExtent_.width; p.pyramidSize[1] = (float)pyramidExtent_.height;
+    p.drawCount = drawCount_;
+    p.maxLevel = (float)(levels_ - 1);
+    glm::vec3 eyeNow(0.0f), eyeThen(0.0f);
+    p.occlusion = occlusion && havePyramid_ && eyeFromViewProj(vp16, eyeNow) && eyeFromViewProj(pyramidVp_, eyeThen);
+    p.inflate = p.occlusion ? glm::length(eyeNow - eyeThen) : 0.0f;
+
+    uint8_t* region = framePtr_ + kSlotSize * frameSlot;
+    std::memcpy(region, &p, sizeof(p));
+    std::memset(region + kParamsSize, 0, sizeof(uint32_t) * 4); // counters; the slot's fence has signaled
+
+    // The pyramid's last writes were made visible to compute by buildPyramid()
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cullPipeline_);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, cullLayout_, 0, 1, &cullSets_[frameSlot], 0, nullptr);
+    vkCmdDispatch(cmd, (drawCount_ + 63) / 64, 1, 1);
+
+    VkMemoryBarrier mb{VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    mb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; mb.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_HOST_BIT,
+                         0, 1, &mb, 0, nullptr, 0, nullptr);
+    slotPending_[frameSlot] = true;
+}
+
+void OcclusionCuller::buildPyramid(VkCommandBuffer cmd, const float* vp16, VkExtent2D rendered) {
+    if (!enabled() || reduceSets_.empty()) return;
+    VkImageMemoryBarrier b[2]{};
+    b[0] = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    b[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT; b[0].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    b[0].oldLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL; b[0].newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    b[0].srcQueueFamilyIndex = b[0].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b[0].image = depthImage_; b[0].subresourceRange = { depthAspect_, 0, 1, 0, 1 };
+    // Overwriting the pyramid only has to wait for this frame's cull reads (execution dependency)
+    b[1] = {VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    b[1].srcAccessMask = 0; b[1].dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+    b[1].oldLayout = pyramidFresh_ ? VK_IMAGE_LAYOUT_UNDEFINED : VK_IMAGE_LAYOUT_GENERAL; b[1].newLayout = VK_IMAGE_LAYOUT_GENERAL;
+    b[1].srcQueueFamilyIndex = b[1].dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b[1].image = pyramid_; b[1].subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels_, 0, 1 };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+                         0, 0, nullptr, 0, nullptr, 2, b);
+    pyramidFresh_ = false;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, reducePipeline_);
+    VkExtent2D src = { std::clamp(rendered.width, 1u, depthExtent_.width), std::clamp(rendered.height, 1u, depthExtent_.height) };
+    VkExtent2D dst = pyramidExtent_;
+    for (uint32_t i = 0; i < levels_; ++i) {
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, reduceLayout_, 0, 1, &reduceSets_[i], 0, nullptr);
+        int32_t push[4] = { (int32_t)src.width, (int32_t)src.height, (int32_t)dst.width, (int32_t)dst.height };
+        vkCmdPushConstants(cmd, reduceLayout_, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(push), push);
+        vkCmdDispatch(cmd, (dst.width + 7) / 8, (dst.height + 7) / 8, 1);
+        // Level i feeds level i + 1, and the last one next frame's cull
+        VkImageMemoryBarrier lb{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+        lb.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT; lb.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        lb.oldLayout = lb.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+        lb.srcQueueFamilyIndex = lb.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        lb.image = pyramid_; lb.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, i, 1, 0, 1 };
+        vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &lb);
+        src = dst;
+        dst = { std::max(dst.width / 2, 1u), std::max(dst.height / 2, 1u) };
+    }
+    std::memcpy(pyramidVp_, vp16, sizeof(pyramidVp_));
+    havePyramid_ = true;
+}
+
+void OcclusionCuller::collect(uint32_t frameSlot) {
+    if (!framePtr_ || frameSlot >= slotPending_.size() || !slotPending_[frameSlot]) return;
+    uint32_t c[4]; std::memcpy(c, framePtr_ + kSlotSize * frameSlot + kParamsSize, sizeof(c));
+    stats_ = { c[0], c[1], c[2] };
+    slotPending_[frameSlot] = false;
+}
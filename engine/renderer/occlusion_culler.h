@@ -0,0 +1,108 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include <cstdint>
+#include <vector>
+
+namespace eng::renderer {
+    class DeletionQueue;
+    class ShaderRegistry;
+    enum class ShaderId : uint32_t;
+
+    // Per-draw input of occlusion_cull.comp (std430); each produces one VkDrawIndexedIndirectCommand
+    struct CullDraw {
+        glm::vec4 sphere{0.0f}; // world-space bounding sphere: center, radius
+        uint32_t indexCount = 0, firstIndex = 0, firstInstance = 0; int32_t vertexOffset = 0;
+    };
+    static_assert(sizeof(CullDraw) == 32, "CullDraw must match the std430 layout in occlusion_cull.comp");
+
+    struct OcclusionStats { uint32_t tested = 0, frustumCulled = 0, occlusionCulled = 0; };
+
+    // GPU frustum and Hi-Z occlusion culling for indexed draws.
+    // buildPyramid() reduces the depth attachment into a max-depth mip chain after the main pass.
+    // The next frame's cull() tests every draw's bounding sphere against it and writes one indexed
+    // indirect command per draw (instanceCount 0 when culled). Testing against the previous frame
+    // is what makes occluders free, at the price of one frame of latency for disocclusion; the
+    // test reprojects through the pyramid's own view-projection and pads the sphere by the camera
+    // movement since, so camera motion alone does not cull visible objects.
+    class OcclusionCuller {
+    public:
+        // Needs a depth format usable as a sampled image; false leaves the culler disabled
+        bool init(VkPhysicalDevice physical, VkDevice device, ShaderRegistry& shaders, VkPipelineCache cache,
+                  uint32_t framesInFlight, DeletionQueue* deletions);
+        void shutdown();
+        bool enabled() const { return cullPipeline_ != VK_NULL_HANDLE; }
+
+        // The depth attachment was (re)created: rebuild the pyramid to match. Drops the history, so
+        // the next frame is frustum culled only. Replaced objects are retired through the deletion queue.
+        bool resize(VkImage depthImage, VkImageView depthView, VkFormat depthFormat, VkExtent2D extent, uint64_t frameIndex);
+        bool setDraws(const std::vector<CullDraw>& draws, uint64_t frameIndex);
+        uint32_t drawCount() const { return drawCount_; }
+
+        // Outside a render pass, before the draws reading indirectBuffer(); occlusion=false only frustum culls
+        void cull(VkCommandBuffer cmd, uint32_t frameSlot, const float* vp16, bool occlusion);
+        // After the pass that wrote depth with vp16 into the rendered corner of the depth image (smaller
+        // than its extent under dynamic resolution). That corner is reduced onto the whole pyramid, so
+        // pyramid UVs keep matching the viewport. Leaves the depth image in SHADER_READ_ONLY_OPTIMAL.
+        void buildPyramid(VkCommandBuffer cmd, const float* vp16, VkExtent2D rendered);
+        VkBuffer indirectBuffer() const { return indirectBuf_; }
+        VkDeviceSize indirectOffset(uint32_t frameSlot) const { return indirectRegion_ * frameSlot; }
+
+        // After the slot's fence wait: latch that frame's counters into stats()
+        void collect(uint32_t frameSlot);
+        OcclusionStats stats() const { return stats_; }
+
+        // Shader hot reload: builds the pipeline of HiZReduceComp or OcclusionCullComp from the
+        // registry's current module (any thread, VK_NULL_HANDLE on failure or another id);
+        // replacePipeline() installs it between frames and returns the old one for the caller to retire
+        VkPipeline buildPipeline(ShaderId id, ShaderRegistry& shaders, VkPipelineCache cache) const;
+        VkPipeline replacePipeline(ShaderId id, VkPipeline pipeline);
+    private:
+        struct Params {
+            float pyramidVp[16];
+            float planes[6][4];
+            float pyramidSize[2];
+            uint32_t drawCount, occlusion;
+            float inflate, maxLevel;
+        };
+        static constexpr VkDeviceSize kParamsSize = 256;  // per-slot region: Params, then the counters
+        static constexpr VkDeviceSize kSlotSize = 512;
+        static_assert(sizeof(Params) <= kParamsSize, "Params must fit its region");
+
+        VkPhysicalDevice physical_{};
+        VkDevice device_{};
+        DeletionQueue* deletions_ = nullptr;
+        uint32_t framesInFlight_ = 0;
+        VkDescriptorSetLayout reduceSetLayout_{}, cullSetLayout_{};
+        VkPipelineLayout reduceLayout_{}, cullLayout_{};
+        VkPipeline reducePipeline_{}, cullPipeline_{};
+        VkSampler sampler_{};
+
+        // Pyramid (R32_SFLOAT, kept in GENERAL) and the depth attachment it is built from
+        VkImage pyramid_{}; VkDeviceMemory pyramidMem_{}; VkImageView pyramidView_{};
+        std::vector<VkImageView> mipViews_;
+        VkExtent2D pyramidExtent_{}; uint32_t levels_ = 0;
+        VkImage depthImage_{}; VkImageView depthView_{}; VkImageAspectFlags depthAspect_ = 0; VkExtent2D depthExtent_{};
+        bool pyramidFresh_ = false; // still needs its UNDEFINED -> GENERAL transition
+        bool havePyramid_ = false;  // holds a reduced depth buffer from pyramidVp_
+        float pyramidVp_[16]{};
+
+        // Draws, per-slot indirect commands and per-slot params/counters (host visible)
+        VkBuffer drawBuf_{}; VkDeviceMemory drawMem_{};
+        VkBuffer indirectBuf_{}; VkDeviceMemory indirectMem_{};
+        VkDeviceSize indirectRegion_ = 0;
+        uint32_t drawCount_ = 0;
+        VkBuffer frameBuf_{}; VkDeviceMemory frameMem_{}; uint8_t* framePtr_ = nullptr;
+        std::vector<bool> slotPending_;
+        OcclusionStats stats_;
+
+        // One reduce set per pyramid level and one cull set per frame slot, all from a single pool
+        // that is replaced whenever the pyramid or the draw buffers change
+        VkDescriptorPool pool_{};
+        std::vector<VkDescriptorSet> reduceSets_, cullSets_;
+
+        bool createBuffer(VkDeviceSize size, VkBufferUsageFlags usage, VkMemoryPropertyFlags props, VkBuffer& buf, VkDeviceMemory& mem);
+        bool rebuildSets(uint64_t frameIndex);
+        void destroyPyramid(uint64_t frameIndex);
+    };
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <map>
+
+namespace eng::renderer {
+    // First-fit suballocator over [0, capacity). Free blocks are kept sorted by offset and merged
+    // with their neighbours on free(), so a range released in any order becomes reusable as one
+    // block. Alignment need not be a power of two (vertex strides such as 28 bytes are common).
+    class RangeAllocator {
+    public:
+        static constexpr uint64_t kInvalid = UINT64_MAX;
+
+        void reset(uint64_t capacity) {
+            free_.clear(); capacity_ = capacity; used_ = 0;
+            if (capacity) free_[0] = capacity;
+        }
+
+        // Offset of a new [offset, offset + size) range, or kInvalid when no free block fits
+        uint64_t allocate(uint64_t size, uint64_t alignment = 1) {
+            if (size == 0) return kInvalid;
+            if (alignment == 0) alignment = 1;
+            for (auto it = free_.begin(); it != free_.end(); ++it) {
+                uint64_t start = it->first, end = it->first + it->second;
+                uint64_t offset = (start + alignment - 1) / alignment * alignment;
+                if (offset + size > end) continue;
+                free_.erase(it);
+                if (offset > start) free_[start] = offset - start;              // alignment padding stays free
+                if (offset + size < end) free_[offset + size] = end - offset - size;
+                used_ += size;
+                return offset;
+            }
+            return kInvalid;
+        }
+
+        // Returns a range obtained from allocate() with the same size
+        void free(uint64_t offset, uint64_t size) {
+            if (size == 0 || offset == kInvalid) return;
+            used_ -= size;
+            auto next = free_.lower_bound(offset);
+            if (next != free_.end() && offset + size == next->first) { size += next->second; next = free_.erase(next); }
+            if (next != free_.begin()) {
+                auto prev = std::prev(next);
+                if (prev->first + prev->second == offset) { prev->second += size; return; }
+            }
+            free_[offset] = size;
+        }
+
+        uint64_t capacity() const { return capacity_; }
+        uint64_t used() const { return used_; }
+        size_t freeBlocks() const { return free_.size(); }
+        uint64_t largestFree() const {
+            uint64_t best = 0;
+            for (const auto& b : free_) best = b.second > best ? b.second : best;
+            return best;
+        }
+    private:
+        std::map<uint64_t, uint64_t> free_; // offset -> size
+        uint64_t capacity_ = 0, used_ = 0;
+    };
+}
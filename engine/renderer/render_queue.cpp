@@ -0,0 +1,29 @@
+#include "render_queue.h"
+#include "../core/profiler.h"
+#include <utility>
+
+using namespace eng::renderer;
+
+void RenderQueue::sort() {
+    ENG_PROFILE_FUNCTION();
+    const size_t n = items_.size();
+    if (n < 2) return;
+    scratch_.resize(n);
+
+    // One read of the keys builds all eight byte histograms
+    uint32_t counts[8][256] = {};
+    for (const RenderItem& it : items_)
+        for (int b = 0; b < 8; ++b) ++counts[b][(it.key >> (b * 8)) & 0xFF];
+
+    RenderItem* src = items_.data();
+    RenderItem* dst = scratch_.data();
+    for (int b = 0; b < 8; ++b) {
+        uint32_t* c = counts[b];
+        if (c[(src[0].key >> (b * 8)) & 0xFF] == n) continue; // every key has the same byte here
+        uint32_t offset = 0;
+        for (int d = 0; d < 256; ++d) { uint32_t k = c[d]; c[d] = offset; offset += k; }
+        for (size_t i = 0; i < n; ++i) dst[c[(src[i].key >> (b * 8)) & 0xFF]++] = src[i];
+        std::swap(src, dst);
+    }
+    if (src != items_.data()) items_.swap(scratch_);
+}
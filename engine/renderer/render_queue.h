@@ -0,0 +1,77 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace eng::renderer {
+    // 64-bit draw sort keys, most significant field first:
+    //   opaque:      pass:2 | pipeline:8 | material:16 | depth:24 (front to back) | unused:14
+    //   transparent: pass:2 | depth:24 (back to front) | pipeline:8 | material:16 | unused:14
+    // Sorting ascending groups opaque draws by pipeline, then material, and orders each group
+    // front to back for early-z; transparent draws sort strictly far to near.
+    enum class DrawPass : uint32_t { DepthPrepass = 0, Opaque = 1, Transparent = 3 };
+
+    namespace sortkey {
+        constexpr uint32_t kPipelineBits = 8, kMaterialBits = 16, kDepthBits = 24;
+        constexpr uint32_t kMaxPipeline = (1u << kPipelineBits) - 1, kMaxMaterial = (1u << kMaterialBits) - 1;
+
+        // View depth mapped linearly onto [0, 2^24) between 0 and farPlane
+        inline uint32_t quantizeDepth(float viewDepth, float farPlane) {
+            float t = farPlane > 0.0f ? viewDepth / farPlane : 0.0f;
+            t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+            return (uint32_t)(t * (float)((1u << kDepthBits) - 1));
+        }
+        inline uint64_t opaque(DrawPass pass, uint32_t pipeline, uint32_t material, uint32_t depth) {
+            return (uint64_t)pass << 62 | (uint64_t)(pipeline & kMaxPipeline) << 54 | (uint64_t)(material & kMaxMaterial) << 38 |
+                   (uint64_t)(depth & 0xFFFFFFu) << 14;
+        }
+        inline uint64_t transparent(uint32_t pipeline, uint32_t material, uint32_t depth) {
+            return (uint64_t)DrawPass::Transparent << 62 | (uint64_t)(~depth & 0xFFFFFFu) << 38 |
+                   (uint64_t)(pipeline & kMaxPipeline) << 30 | (uint64_t)(material & kMaxMaterial) << 14;
+        }
+        inline DrawPass pass(uint64_t key) { return (DrawPass)(key >> 62); }
+        inline uint32_t pipeline(uint64_t key) { return (uint32_t)(key >> (pass(key) == DrawPass::Transparent ? 30 : 54)) & kMaxPipeline; }
+        inline uint32_t material(uint64_t key) { return (uint32_t)(key >> (pass(key) == DrawPass::Transparent ? 14 : 38)) & kMaxMaterial; }
+    }
+
+    struct RenderItem { uint64_t key; uint32_t payload; }; // payload: caller's draw index
+
+    struct RenderQueueStats {
+        uint32_t draws = 0;
+        uint32_t pipelineBinds = 0, materialBinds = 0; // state changes actually issued
+        uint32_t pipelineBindsSkipped = 0, materialBindsSkipped = 0; // redundant ones elided
+    };
+
+    // Per-frame list of draws: push() everything, sort(), then submit() binds pipeline and material
+    // only when they differ from the previous draw's.
+    class RenderQueue {
+    public:
+        void clear() { items_.clear(); }
+        void reserve(size_t n) { items_.reserve(n); scratch_.reserve(n); }
+        void push(uint64_t key, uint32_t payload) { items_.push_back({key, payload}); }
+        size_t size() const { return items_.size(); }
+        const std::vector<RenderItem>& items() const { return items_; }
+
+        // Stable LSD radix sort on the key, 8 bits per pass; passes whose byte is the same for
+        // every item are skipped, so sparse keys cost fewer than 8 passes.
+        void sort();
+
+        template <class BindPipeline, class BindMaterial, class Draw>
+        RenderQueueStats submit(BindPipeline&& bindPipeline, BindMaterial&& bindMaterial, Draw&& draw) const {
+            RenderQueueStats st;
+            uint32_t boundPipeline = UINT32_MAX, boundMaterial = UINT32_MAX;
+            for (const RenderItem& it : items_) {
+                uint32_t p = sortkey::pipeline(it.key), m = sortkey::material(it.key);
+                if (p != boundPipeline) { bindPipeline(p); boundPipeline = p; boundMaterial = UINT32_MAX; ++st.pipelineBinds; }
+                else ++st.pipelineBindsSkipped;
+                if (m != boundMaterial) { bindMaterial(m); boundMaterial = m; ++st.materialBinds; }
+                else ++st.materialBindsSkipped;
+                draw(it.payload);
+                ++st.draws;
+            }
+            return st;
+        }
+    private:
+        std::vector<RenderItem> items_, scratch_;
+    };
+}
@@ -0,0 +1,172 @@
+#include "shader_registry.h"
+#include "../core/log.h"
+#include "../platform/async_io.h"
+#include "shaders/terrain_points_vert.h"
+#include "shaders/terrain_points_frag.h"
+#include "shaders/mesh_vert.h"
+#include "shaders/mesh_frag.h"
+#include "shaders/mesh_bindless_frag.h"
+#include "shaders/hiz_reduce_comp.h"
+#include "shaders/occlusion_cull_comp.h"
+#include "shaders/light_cluster_comp.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+using namespace eng::renderer;
+
+struct EmbeddedShader { const char* file; const uint32_t* code; size_t bytes; };
+
+static const EmbeddedShader kEmbedded[] = {
+    { "terrain_points.vert", spirv::terrain_points_vert, sizeof(spirv::terrain_points_vert) },
+    { "terrain_points.frag", spirv::terrain_points_frag, sizeof(spirv::terrain_points_frag) },
+    { "mesh.vert",           spirv::mesh_vert,           sizeof(spirv::mesh_vert) },
+    { "mesh.frag",           spirv::mesh_frag,           sizeof(spirv::mesh_frag) },
+    { "mesh_bindless.frag",  spirv::mesh_bindless_frag,  sizeof(spirv::mesh_bindless_frag) },
+    { "hiz_reduce.comp",     spirv::hiz_reduce_comp,     sizeof(spirv::hiz_reduce_comp) },
+    { "occlusion_cull.comp", spirv::occlusion_cull_comp, sizeof(spirv::occlusion_cull_comp) },
+    { "light_cluster.comp",  spirv::light_cluster_comp,  sizeof(spirv::light_cluster_comp) },
+};
+static_assert(sizeof(kEmbedded) / sizeof(kEmbedded[0]) == (size_t)ShaderId::Count, "kEmbedded out of sync with ShaderId");
+
+const char* ShaderRegistry::name(ShaderId id) { return kEmbedded[(size_t)id].file; }
+
+VkShaderModule ShaderRegistry::createModule(const uint32_t* code, size_t bytes) {
+    VkShaderModuleCreateInfo ci{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
+    ci.codeSize = bytes; ci.pCode = code;
+    VkShaderModule mod{};
+    if (vkCreateShaderModule(device_, &ci, nullptr, &mod) != VK_SUCCESS) return VK_NULL_HANDLE;
+    return mod;
+}
+
+VkShaderModule ShaderRegistry::get(ShaderId id) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    VkShaderModule& mod = modules_[(size_t)id];
+    if (!mod) {
+        const EmbeddedShader& e = kEmbedded[(size_t)id];
+        mod = createModule(e.code, e.bytes);
+        if (!mod) eng::log::error("Failed to create shader module %s", e.file);
+    }
+    return mod;
+}
+
+void ShaderRegistry::shutdown() {
+    stopWatching();
+    if (!device_) return;
+    for (auto& m : modules_) { if (m) vkDestroyShaderModule(device_, m, nullptr); m = VK_NULL_HANDLE; }
+    for (auto m : retired_) vkDestroyShaderModule(device_, m, nullptr);
+    retired_.clear();
+    device_ = VK_NULL_HANDLE;
+}
+
+#if defined(ENG_SHADER_HOT_RELOAD)
+
+static std::string quoted(const std::string& s) { return "\"" + s + "\""; }
+
+static std::vector<uint32_t> readSpirv(const std::string& path) {
+    eng::io::FileData d = eng::io::readNow(path);
+    std::vector<uint32_t> words(d.ok() && d.bytes.size() % 4 == 0 ? d.bytes.size() / 4 : 0);
+    if (!words.empty()) std::memcpy(words.data(), d.bytes.data(), d.bytes.size());
+    return words;
+}
+
+// The shader's source and every file it #includes, transitively; include paths are relative to the
+// including file, as glslangValidator resolves them
+static void collectSources(const std::filesystem::path& file, std::vector<std::filesystem::path>& out) {
+    if (std::find(out.begin(), out.end(), file) != out.end()) return;
+    out.push_back(file);
+    eng::io::FileData d = eng::io::readNow(file.string());
+    if (!d.ok()) return;
+    std::string text(d.bytes.begin(), d.bytes.end());
+    for (size_t pos = text.find("#include"); pos != std::string::npos; pos = text.find("#include", pos)) {
+        pos += 8;
+        size_t open = text.find_first_of("\"\n", pos);
+        if (open == std::string::npos || text[open] != '"') continue;
+        size_t close = text.find_first_of("\"\n", open + 1);
+        if (close == std::string::npos || text[close] != '"') continue;
+        collectSources((file.parent_path() / text.substr(open + 1, close - open - 1)).lexically_normal(), out);
+        pos = close + 1;
+    }
+}
+
+bool ShaderRegistry::startWatching(ReloadFn onReload) {
+    std::lock_guard<std::mutex> lock(watchMutex_);
+    if (watching_) return true;
+    watching_ = true;
+    watcher_ = std::thread([this, fn = std::move(onReload)] { watchLoop(fn); });
+    eng::log::info("Shader hot reload: watching %s", ENG_SHADER_SOURCE_DIR);
+    return true;
+}
+
+void ShaderRegistry::watchLoop(ReloadFn onReload) {
+    namespace fs = std::filesystem;
+    constexpr size_t N = (size_t)ShaderId::Count;
+    // Per shader: its source files and their write times. Editing any of them recompiles the shader
+    // (a shared include recompiles every shader using it), and the list is rescanned since the
+    // edit may have changed the includes.
+    std::vector<fs::path> sources[N];
+    std::vector<fs::file_time_type> stamps[N];
+    std::error_code ec;
+    auto scan = [&](size_t i) {
+        sources[i].clear();
+        collectSources(fs::path(ENG_SHADER_SOURCE_DIR) / kEmbedded[i].file, sources[i]);
+        stamps[i].clear();
+        for (const fs::path& p : sources[i]) stamps[i].push_back(fs::last_write_time(p, ec));
+    };
+    for (size_t i = 0; i < N; ++i) scan(i);
+
+    std::unique_lock<std::mutex> lock(watchMutex_);
+    while (watching_) {
+        watchCv_.wait_for(lock, std::chrono::milliseconds(250));
+        if (!watching_) break;
+        lock.unlock();
+        for (size_t i = 0; i < N; ++i) {
+            bool changed = false;
+            for (size_t s = 0; s < sources[i].size() && !changed; ++s) {
+                auto t = fs::last_write_time(sources[i][s], ec);
+                changed = !ec && t != stamps[i][s];
+            }
+            if (!changed) continue;
+            scan(i);
+            fs::path src = sources[i].front();
+
+            fs::path out = fs::temp_directory_path(ec) / (std::string("vkthing_") + kEmbedded[i].file + ".spv");
+            std::string cmd = quoted(ENG_GLSLANG_VALIDATOR) + " -V " + quoted(src.string()) + " -o " + quoted(out.string());
+#if defined(_WIN32)
+            cmd = quoted(cmd); // cmd.exe strips the outermost pair of quotes
+#endif
+            if (std::system(cmd.c_str()) != 0) { eng::log::warn("Shader %s failed to compile; keeping previous version", kEmbedded[i].file); continue; }
+            auto words = readSpirv(out.string());
+            VkShaderModule mod = words.empty() ? VK_NULL_HANDLE : createModule(words.data(), words.size() * 4);
+            if (!mod) { eng::log::warn("Shader %s produced unusable SPIR-V", kEmbedded[i].file); continue; }
+            {
+                std::lock_guard<std::mutex> mlock(mutex_);
+                if (modules_[i]) retired_.push_back(modules_[i]);
+                modules_[i] = mod;
+            }
+            eng::log::info("Reloaded shader %s", kEmbedded[i].file);
+            if (onReload) onReload((ShaderId)i);
+        }
+        lock.lock();
+    }
+}
+
+void ShaderRegistry::stopWatching() {
+    {
+        std::lock_guard<std::mutex> lock(watchMutex_);
+        watching_ = false;
+    }
+    watchCv_.notify_all();
+    if (watcher_.joinable()) watcher_.join();
+}
+
+#else
+
+bool ShaderRegistry::startWatching(ReloadFn) { return false; }
+void ShaderRegistry::stopWatching() {}
+
+#endif
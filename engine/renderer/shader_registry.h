@@ -0,0 +1,42 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace eng::renderer {
+    enum class ShaderId : uint32_t { TerrainPointsVert, TerrainPointsFrag, MeshVert, MeshFrag, MeshBindlessFrag,
+                                     HiZReduceComp, OcclusionCullComp, LightClusterComp, Count };
+
+    // One VkShaderModule per embedded SPIR-V blob, created on first use and shared by all pipelines.
+    // In ENG_SHADER_HOT_RELOAD builds the GLSL sources can be watched from a background thread;
+    // a shader whose source or any file it #includes changed is recompiled, its module swapped,
+    // then onReload(id) runs on that thread.
+    class ShaderRegistry {
+    public:
+        void init(VkDevice device) { device_ = device; }
+        void shutdown();
+        VkShaderModule get(ShaderId id);
+        static const char* name(ShaderId id);
+
+        using ReloadFn = std::function<void(ShaderId)>;
+        bool startWatching(ReloadFn onReload); // false when hot reload is compiled out
+        void stopWatching();
+    private:
+        VkDevice device_{};
+        std::mutex mutex_;
+        VkShaderModule modules_[(size_t)ShaderId::Count]{};
+        std::vector<VkShaderModule> retired_; // swapped-out modules, may still be referenced by in-progress builds
+        std::thread watcher_;
+        std::mutex watchMutex_;
+        std::condition_variable watchCv_;
+        bool watching_ = false;
+
+        VkShaderModule createModule(const uint32_t* code, size_t bytes);
+        void watchLoop(ReloadFn onReload);
+    };
+}
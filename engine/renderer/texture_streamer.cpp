@@ -0,0 +1,398 @@
+#include "texture_streamer.h"
+#include "deletion_queue.h"
+#include "bindless.h"
+#include "../core/log.h"
+#include "../core/profiler.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+// Declarations only; STB_IMAGE_IMPLEMENTATION is compiled into the application together with tinygltf
+#include <stb_image.h>
+
+using namespace eng::renderer;
+
+static constexpr VkFormat kFormat = VK_FORMAT_R8G8B8A8_UNORM; // the mesh pass shades without sRGB conversion
+static constexpr uint32_t kSetsPerPool = 256;
+static constexpr uint64_t kHoldFrames = 120; // keep a texture's detail this long after it was last requested
+
+static uint32_t findMemoryType(VkPhysicalDevice physical, uint32_t typeFilter, VkMemoryPropertyFlags props) {
+    VkPhysicalDeviceMemoryProperties memProps{}; vkGetPhysicalDeviceMemoryProperties(physical, &memProps);
+    for (uint32_t i=0;i<memProps.memoryTypeCount;++i) if ((typeFilter & (1u<<i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) return i;
+    return UINT32_MAX;
+}
+
+static void imageBarrier(VkCommandBuffer cmd, VkImage image, uint32_t levels, VkImageLayout from, VkImageLayout to,
+                         VkAccessFlags srcAccess, VkAccessFlags dstAccess, VkPipelineStageFlags srcStage, VkPipelineStageFlags dstStage) {
+    VkImageMemoryBarrier b{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    b.oldLayout = from; b.newLayout = to;
+    b.srcAccessMask = srcAccess; b.dstAccessMask = dstAccess;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED; b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = image;
+    b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, levels, 0, 1 };
+    vkCmdPipelineBarrier(cmd, srcStage, dstStage, 0, 0, nullptr, 0, nullptr, 1, &b);
+}
+
+// Full RGBA8 mip chain with a 2x2 box filter; odd edges reuse the last row/column.
+static void buildMipChain(const uint8_t* src, uint32_t w, uint32_t h, std::vector<uint8_t>& pixels, std::vector<size_t>& offsets) {
+    uint32_t levels = 1; while ((std::max(w, h) >> levels) > 0) ++levels;
+    offsets.resize(levels);
+    size_t total = 0;
+    for (uint32_t l = 0; l < levels; ++l) { offsets[l] = total; total += (size_t)std::max(1u, w >> l) * std::max(1u, h >> l) * 4; }
+    pixels.resize(total);
+    std::memcpy(pixels.data(), src, (size_t)w * h * 4);
+    for (uint32_t l = 1; l < levels; ++l) {
+        uint32_t pw = std::max(1u, w >> (l - 1)), ph = std::max(1u, h >> (l - 1));
+        uint32_t cw = std::max(1u, w >> l), ch = std::max(1u, h >> l);
+        const uint8_t* p = pixels.data() + offsets[l - 1];
+        uint8_t* c = pixels.data() + offsets[l];
+        for (uint32_t y = 0; y < ch; ++y) {
+            const uint8_t* r0 = p + (size_t)std::min(2 * y, ph - 1) * pw * 4;
+            const uint8_t* r1 = p + (size_t)std::min(2 * y + 1, ph - 1) * pw * 4;
+            for (uint32_t x = 0; x < cw; ++x) {
+                uint32_t x0 = std::min(2 * x, pw - 1) * 4, x1 = std::min(2 * x + 1, pw - 1) * 4;
+                for (uint32_t k = 0; k < 4; ++k)
+                    *c++ = (uint8_t)((r0[x0 + k] + r0[x1 + k] + r1[x0 + k] + r1[x1 + k] + 2) >> 2);
+            }
+        }
+    }
+}
+
+bool TextureStreamer::init(VkPhysicalDevice physical, VkDevice device, uint32_t framesInFlight, DeletionQueue* deletions,
+                           BindlessDescriptors* bindless, VkDeviceSize uploadBytesPerFrame) {
+    ENG_PROFILE_FUNCTION();
+    physical_ = physical; device_ = device; deletions_ = deletions; bindless_ = bindless;
+
+    VkDescriptorSetLayoutBinding binding{0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr};
+    VkDescriptorSetLayoutCreateInfo dlci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO}; dlci.bindingCount = 1; dlci.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device_, &dlci, nullptr, &setLayout_) != VK_SUCCESS) return false;
+
+    VkSamplerCreateInfo sci{VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO};
+    sci.magFilter = VK_FILTER_LINEAR; sci.minFilter = VK_FILTER_LINEAR; sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    sci.addressModeU = sci.addressModeV = sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+    sci.maxLod = VK_LOD_CLAMP_NONE;
+    if (vkCreateSampler(device_, &sci, nullptr, &sampler_) != VK_SUCCESS) return false;
+
+    // Staging ring: one slice per frame in flight, reused once that slot's fence has signaled
+    sliceSize_ = (uploadBytesPerFrame + 15) & ~VkDeviceSize(15);
+    VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO}; bci.size = sliceSize_ * framesInFlight; bci.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT; bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bci, nullptr, &staging_) != VK_SUCCESS) return false;
+    VkMemoryRequirements mr{}; vkGetBufferMemoryRequirements(device_, staging_, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO}; mai.allocationSize = mr.size;
+    mai.memoryTypeIndex = findMemoryType(physical_, mr.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    if (mai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device_, &mai, nullptr, &stagingMem_) != VK_SUCCESS) return false;
+    vkBindBufferMemory(device_, staging_, stagingMem_, 0);
+    void* ptr = nullptr; if (vkMapMemory(device_, stagingMem_, 0, VK_WHOLE_SIZE, 0, &ptr) != VK_SUCCESS) return false;
+    stagingPtr_ = static_cast<uint8_t*>(ptr);
+
+    Texture white; white.name = "white"; white.decoded = true;
+    white.width = white.height = white.levels = 1; white.pixels = {255, 255, 255, 255}; white.offsets = {0};
+    textures_.push_back(std::move(white));
+
+    stop_ = false;
+    return true;
+}
+
+void TextureStreamer::destroy(const Gpu& g) {
+    if (g.set) vkFreeDescriptorSets(device_, g.pool, 1, &g.set);
+    if (g.slot != UINT32_MAX && bindless_) bindless_->freeTexture(g.slot);
+    if (g.view) vkDestroyImageView(device_, g.view, nullptr);
+    if (g.image) vkDestroyImage(device_, g.image, nullptr);
+    if (g.memory) vkFreeMemory(device_, g.memory, nullptr);
+}
+
+void TextureStreamer::shutdown() {
+    stop_ = true;
+    jobs::wait(decodes_);
+    done_.clear();
+    if (!device_) return;
+    // The caller has idled the device and flushed the deletion queue
+    for (const auto& t : textures_) { destroy(t.live); destroy(t.pending); }
+    textures_.clear();
+    for (auto p : pools_) vkDestroyDescriptorPool(device_, p, nullptr);
+    pools_.clear();
+    if (sampler_) { vkDestroySampler(device_, sampler_, nullptr); sampler_ = VK_NULL_HANDLE; }
+    if (setLayout_) { vkDestroyDescriptorSetLayout(device_, setLayout_, nullptr); setLayout_ = VK_NULL_HANDLE; }
+    if (staging_) { vkDestroyBuffer(device_, staging_, nullptr); staging_ = VK_NULL_HANDLE; }
+    if (stagingMem_) { vkFreeMemory(device_, stagingMem_, nullptr); stagingMem_ = VK_NULL_HANDLE; stagingPtr_ = nullptr; }
+    device_ = VK_NULL_HANDLE;
+}
+
+TextureStreamer::Handle TextureStreamer::add(std::vector<uint8_t> encoded, std::string name) {
+    Handle h = (Handle)textures_.size();
+    textures_.emplace_back();
+    textures_.back().name = std::move(name);
+    if (encoded.empty()) {
+        textures_.back().failed = true;
+        eng::log::warn("Texture '%s' has no image data", textures_.back().name);
+        return h;
+    }
+    ++decoding_;
+    jobs::run(decodes_, [this, h, encoded = std::move(encoded)] { decode(h, encoded); });
+    return h;
+}
+
+void TextureStreamer::decode(Handle tex, const std::vector<uint8_t>& encoded) {
+    if (stop_.load(std::memory_order_relaxed)) return;
+    ENG_PROFILE_SCOPE("texture decode");
+    Decoded d; d.tex = tex;
+    int w = 0, h = 0, n = 0;
+    stbi_uc* px = stbi_load_from_memory(encoded.data(), (int)encoded.size(), &w, &h, &n, 4);
+    if (px && w > 0 && h > 0) {
+        d.width = (uint32_t)w; d.height = (uint32_t)h;
+        buildMipChain(px, d.width, d.height, d.pixels, d.offsets);
+        d.levels = (uint32_t)d.offsets.size();
+    }
+    if (px) stbi_image_free(px);
+    std::lock_guard<std::mutex> lock(mutex_);
+    done_.push_back(std::move(d));
+}
+
+void TextureStreamer::collectDecoded() {
+    std::vector<Decoded> done;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done.swap(done_);
+    }
+    for (auto& d : done) {
+        --decoding_;
+        Texture& t = textures_[d.tex];
+        if (d.levels == 0) { t.failed = true; eng::log::warn("Failed to decode texture '%s'", t.name); continue; }
+        t.width = d.width; t.height = d.height; t.levels = d.levels;
+        t.pixels = std::move(d.pixels); t.offsets = std::move(d.offsets);
+        t.decoded = true;
+    }
+}
+
+void TextureStreamer::request(Handle tex, float pixelsPerUv) {
+    if (tex < textures_.size()) textures_[tex].demand = std::max(textures_[tex].demand, pixelsPerUv);
+}
+
+uint32_t TextureStreamer::minTop(const Texture& t) const {
+    uint32_t top = 0;
+    while (top + 1 < t.levels && std::max(std::max(1u, t.width >> top), std::max(1u, t.height >> top)) > kMinResidentDim) ++top;
+    return top;
+}
+
+void TextureStreamer::planResidency() {
+    ENG_PROFILE_FUNCTION();
+    struct Plan { Handle tex; uint32_t desired, floor; float priority; };
+    std::vector<Plan> plans;
+    uint64_t total = 0, resident = 0;
+    for (Handle h = 0; h < textures_.size(); ++h) {
+        Texture& t = textures_[h];
+        resident += t.live.bytes;
+        if (!t.decoded) continue;
+        if (t.demand > 0.0f) { t.heldDemand = t.demand; t.heldFrame = frameIndex_; }
+        else if (frameIndex_ - t.heldFrame > kHoldFrames) t.heldDemand = 0.0f;
+        uint32_t floor = minTop(t), desired = floor;
+        if (t.heldDemand > 0.0f) {
+            // Mip whose texel density matches the screen: log2(texels per UV / pixels per UV)
+            float lod = std::log2((float)std::max(t.width, t.height) / t.heldDemand);
+            desired = lod <= 0.0f ? 0u : std::min((uint32_t)lod, floor);
+        }
+        plans.push_back({h, desired, floor, t.demand});
+        total += chainBytes(t, desired);
+    }
+
+    // Over budget: textures not seen this frame lose detail first, then the least demanded ones
+    if (total > budget_) {
+        std::sort(plans.begin(), plans.end(), [&](const Plan& a, const Plan& b) {
+            if (a.priority != b.priority) return a.priority < b.priority;
+            return textures_[a.tex].heldDemand < textures_[b.tex].heldDemand;
+        });
+        for (auto& p : plans) {
+            const Texture& t = textures_[p.tex];
+            while (total > budget_ && p.desired < p.floor) {
+                total -= chainBytes(t, p.desired) - chainBytes(t, p.desired + 1);
+                ++p.desired;
+            }
+            if (total <= budget_) break;
+        }
+    }
+
+    bool overBudget = resident > budget_;
+    for (const auto& p : plans) {
+        Texture& t = textures_[p.tex];
+        uint32_t target = p.floor; // first residency is the coarse chain so something shows quickly
+        if (t.live.image) {
+            uint32_t cur = t.live.top;
+            // Promote immediately; demote lazily (two levels, or when over budget) to avoid thrashing
+            target = (p.desired < cur || p.desired > cur + 1 || (p.desired > cur && overBudget)) ? p.desired : cur;
+        }
+        if (t.pending.image) {
+            if (t.pending.top == target) continue;
+            retire(t.pending); t.nextLevel = -1;
+        }
+        if (t.live.image && target == t.live.top) continue;
+        beginChain(t, target);
+    }
+    for (auto& t : textures_) t.demand = 0.0f;
+}
+
+bool TextureStreamer::beginChain(Texture& t, uint32_t top) {
+    Gpu g; g.top = top;
+    VkImageCreateInfo ici{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = kFormat;
+    ici.extent = { std::max(1u, t.width >> top), std::max(1u, t.height >> top), 1 };
+    ici.mipLevels = t.levels - top; ici.arrayLayers = 1; ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL; ici.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    ici.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device_, &ici, nullptr, &g.image) != VK_SUCCESS) return false;
+    VkMemoryRequirements mr{}; vkGetImageMemoryRequirements(device_, g.image, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    mai.allocationSize = mr.size; mai.memoryTypeIndex = findMemoryType(physical_, mr.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (mai.memoryTypeIndex == UINT32_MAX || vkAllocateMemory(device_, &mai, nullptr, &g.memory) != VK_SUCCESS) {
+        vkDestroyImage(device_, g.image, nullptr);
+        eng::log::warn("Out of memory streaming texture '%s'", t.name);
+        return false;
+    }
+    vkBindImageMemory(device_, g.image, g.memory, 0);
+    g.bytes = mr.size;
+    VkImageViewCreateInfo vci{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    vci.image = g.image; vci.viewType = VK_IMAGE_VIEW_TYPE_2D; vci.format = kFormat;
+    vci.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, ici.mipLevels, 0, 1 };
+    if (vkCreateImageView(device_, &vci, nullptr, &g.view) != VK_SUCCESS) {
+        vkDestroyImage(device_, g.image, nullptr); vkFreeMemory(device_, g.memory, nullptr);
+        return false;
+    }
+    t.pending = g;
+    t.nextLevel = (int)t.levels - 1;
+    t.nextRow = 0;
+    t.pendingFresh = true;
+    return true;
+}
+
+bool TextureStreamer::upload(VkCommandBuffer cmd, Texture& t, uint32_t frameSlot, VkDeviceSize& used) {
+    uint32_t top = t.pending.top;
+    uint32_t levelCount = t.levels - top;
+    if (t.pendingFresh) {
+        imageBarrier(cmd, t.pending.image, levelCount, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                     0, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT);
+        t.pendingFresh = false;
+    }
+    VkDeviceSize sliceOffset = sliceSize_ * frameSlot;
+    // Coarsest level first; a level too large for what is left of the slice is split into row bands
+    while (t.nextLevel >= (int)top) {
+        uint32_t level = (uint32_t)t.nextLevel;
+        uint32_t w = std::max(1u, t.width >> level), h = std::max(1u, t.height >> level);
+        VkDeviceSize rowBytes = (VkDeviceSize)w * 4;
+        if (used >= sliceSize_) return false;
+        uint32_t rows = (uint32_t)std::min<VkDeviceSize>(h - t.nextRow, (sliceSize_ - used) / rowBytes);
+        if (rows == 0) return false;
+        size_t bytes = (size_t)(rows * rowBytes);
+        std::memcpy(stagingPtr_ + sliceOffset + used, t.pixels.data() + t.offsets[level] + t.nextRow * rowBytes, bytes);
+        VkBufferImageCopy region{};
+        region.bufferOffset = sliceOffset + used;
+        region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, level - top, 0, 1 };
+        region.imageOffset = { 0, (int32_t)t.nextRow, 0 };
+        region.imageExtent = { w, rows, 1 };
+        vkCmdCopyBufferToImage(cmd, staging_, t.pending.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+        used = (used + bytes + 15) & ~VkDeviceSize(15);
+        uploadedBytes_ += bytes;
+        t.nextRow += rows;
+        if (t.nextRow == h) { t.nextRow = 0; --t.nextLevel; }
+    }
+    imageBarrier(cmd, t.pending.image, levelCount, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+                 VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
+    finishChain(t);
+    return true;
+}
+
+bool TextureStreamer::finishChain(Texture& t) {
+    bool ok;
+    if (bindless_) { t.pending.slot = bindless_->allocTexture(t.pending.view, sampler_); ok = t.pending.slot != BindlessDescriptors::kInvalid; }
+    else { t.pending.set = allocateSet(t.pending.view, t.pending.pool); ok = t.pending.set != VK_NULL_HANDLE; }
+    if (!ok) {
+        eng::log::warn("No descriptor set for texture '%s'", t.name);
+        retire(t.pending); t.nextLevel = -1;
+        return false;
+    }
+    if (t.live.image && t.pending.top > t.live.top) ++evictions_;
+    retire(t.live);
+    t.live = t.pending;
+    t.pending = Gpu{};
+    t.nextLevel = -1;
+    return true;
+}
+
+void TextureStreamer::retire(Gpu& g) {
+    if (g.image) {
+        // Frames still in flight may sample the old image (or copy into an abandoned chain)
+        deletions_->push(frameIndex_, [this, g] { destroy(g); });
+    }
+    g = Gpu{};
+}
+
+VkDescriptorSet TextureStreamer::allocateSet(VkImageView view, VkDescriptorPool& poolOut) {
+    VkDescriptorSet set = VK_NULL_HANDLE;
+    VkDescriptorSetAllocateInfo ai{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO};
+    ai.descriptorSetCount = 1; ai.pSetLayouts = &setLayout_;
+    for (auto it = pools_.rbegin(); it != pools_.rend() && !set; ++it) {
+        ai.descriptorPool = *it;
+        if (vkAllocateDescriptorSets(device_, &ai, &set) == VK_SUCCESS) poolOut = *it; else set = VK_NULL_HANDLE;
+    }
+    if (!set) {
+        VkDescriptorPoolSize size{VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, kSetsPerPool};
+        VkDescriptorPoolCreateInfo pci{VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO};
+        pci.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT; // sets are freed individually when chains are retired
+        pci.maxSets = kSetsPerPool; pci.poolSizeCount = 1; pci.pPoolSizes = &size;
+        VkDescriptorPool pool{};
+        if (vkCreateDescriptorPool(device_, &pci, nullptr, &pool) != VK_SUCCESS) return VK_NULL_HANDLE;
+        pools_.push_back(pool);
+        ai.descriptorPool = pool;
+        if (vkAllocateDescriptorSets(device_, &ai, &set) != VK_SUCCESS) return VK_NULL_HANDLE;
+        poolOut = pool;
+    }
+    VkDescriptorImageInfo ii{sampler_, view, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
+    VkWriteDescriptorSet w{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+    w.dstSet = set; w.dstBinding = 0; w.descriptorCount = 1; w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER; w.pImageInfo = &ii;
+    vkUpdateDescriptorSets(device_, 1, &w, 0, nullptr);
+    return set;
+}
+
+void TextureStreamer::update(VkCommandBuffer cmd, uint32_t frameSlot, uint64_t frameIndex) {
+    ENG_PROFILE_FUNCTION();
+    if (!device_) return;
+    frameIndex_ = frameIndex;
+    collectDecoded();
+    planResidency();
+
+    // Textures with nothing resident go first, then the ones covering the most screen
+    std::vector<Handle> order;
+    for (Handle h = 0; h < textures_.size(); ++h) if (textures_[h].pending.image) order.push_back(h);
+    std::sort(order.begin(), order.end(), [&](Handle a, Handle b) {
+        bool ra = textures_[a].live.image != VK_NULL_HANDLE, rb = textures_[b].live.image != VK_NULL_HANDLE;
+        if (ra != rb) return !ra;
+        return textures_[a].heldDemand > textures_[b].heldDemand;
+    });
+    VkDeviceSize used = 0;
+    for (Handle h : order) if (!upload(cmd, textures_[h], frameSlot, used)) break;
+}
+
+VkDescriptorSet TextureStreamer::descriptor(Handle tex) const {
+    if (textures_.empty()) return VK_NULL_HANDLE;
+    if (tex < textures_.size() && textures_[tex].live.set) return textures_[tex].live.set;
+    return textures_[kWhite].live.set;
+}
+
+uint32_t TextureStreamer::slot(Handle tex) const {
+    if (textures_.empty()) return BindlessDescriptors::kInvalid;
+    if (tex < textures_.size() && textures_[tex].live.slot != BindlessDescriptors::kInvalid) return textures_[tex].live.slot;
+    return textures_[kWhite].live.slot;
+}
+
+TextureStreamerStats TextureStreamer::stats() const {
+    TextureStreamerStats s;
+    s.textures = (uint32_t)textures_.size();
+    s.decoding = decoding_;
+    for (const auto& t : textures_) {
+        if (t.pending.image) ++s.uploading;
+        if (t.live.image) ++s.resident;
+        s.residentBytes += t.live.bytes + t.pending.bytes;
+    }
+    s.budgetBytes = budget_;
+    s.uploadedBytes = uploadedBytes_;
+    s.evictions = evictions_;
+    return s;
+}
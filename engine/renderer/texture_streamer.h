@@ -0,0 +1,108 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include "../core/jobs.h"
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace eng::renderer {
+    class DeletionQueue;
+    class BindlessDescriptors;
+
+    struct TextureStreamerStats {
+        uint32_t textures = 0, decoding = 0, uploading = 0, resident = 0;
+        uint64_t residentBytes = 0, budgetBytes = 0;
+        uint64_t uploadedBytes = 0, evictions = 0; // totals since init
+    };
+
+    // Streams RGBA8 textures into VRAM under a byte budget.
+    // Encoded images are decoded (stb_image) and mip-mapped as jobs (eng::jobs). The render thread
+    // uploads mip chains through a per-frame staging ring, coarsest level first, and resizes each
+    // texture's resident mip range to the screen-space size reported through request(). When the
+    // budget is exceeded the least-demanded textures drop detail first. A texture that is not
+    // resident yet samples as white. With a BindlessDescriptors table each resident chain gets an
+    // array slot (slot()); otherwise it gets its own descriptor set (descriptor()).
+    class TextureStreamer {
+    public:
+        using Handle = uint32_t;
+        static constexpr Handle kWhite = 0;            // 1x1 white, resident from the first frame
+        static constexpr uint32_t kMinResidentDim = 64; // coarsest chain uploaded first and never evicted
+
+        bool init(VkPhysicalDevice physical, VkDevice device, uint32_t framesInFlight, DeletionQueue* deletions,
+                  BindlessDescriptors* bindless = nullptr, VkDeviceSize uploadBytesPerFrame = 8u << 20);
+        void shutdown();
+
+        Handle add(std::vector<uint8_t> encoded, std::string name); // decoding starts immediately
+        // Screen-space feedback for this frame: the texture spans `pixelsPerUv` screen pixels per UV unit
+        void request(Handle tex, float pixelsPerUv);
+        // Once per frame, after the slot's fence wait and outside a render pass: records uploads and
+        // swaps finished mip chains in. Replaced images are retired through the deletion queue.
+        void update(VkCommandBuffer cmd, uint32_t frameSlot, uint64_t frameIndex);
+
+        VkDescriptorSetLayout setLayout() const { return setLayout_; }
+        VkDescriptorSet descriptor(Handle tex) const; // set 0: combined image sampler at binding 0
+        uint32_t slot(Handle tex) const;              // bindless array slot; BindlessDescriptors::kInvalid if none
+
+        void setBudget(uint64_t bytes) { budget_ = bytes; }
+        TextureStreamerStats stats() const;
+    private:
+        struct Gpu {
+            VkImage image{}; VkDeviceMemory memory{}; VkImageView view{};
+            VkDescriptorSet set{}; VkDescriptorPool pool{};
+            uint32_t slot = UINT32_MAX; // bindless array slot
+            uint32_t top = 0;   // most detailed mip level held; the image stores levels [top, levels)
+            uint64_t bytes = 0;
+        };
+        struct Texture {
+            std::string name;
+            bool decoded = false, failed = false;
+            // CPU mip chain, level 0 first, tightly packed RGBA8
+            uint32_t width = 0, height = 0, levels = 0;
+            std::vector<uint8_t> pixels;
+            std::vector<size_t> offsets;
+            Gpu live;               // sampled by draws
+            Gpu pending;            // replacement chain being uploaded
+            int nextLevel = -1;     // upload cursor into `pending`, counting down to pending.top
+            uint32_t nextRow = 0;
+            bool pendingFresh = false; // still needs its UNDEFINED -> TRANSFER_DST barrier
+            float demand = 0.0f;    // max pixels per UV requested this frame
+            float heldDemand = 0.0f; uint64_t heldFrame = 0; // last non-zero demand, kept for a while
+        };
+        struct Decoded { Handle tex; uint32_t width = 0, height = 0, levels = 0; std::vector<uint8_t> pixels; std::vector<size_t> offsets; };
+
+        VkPhysicalDevice physical_{};
+        VkDevice device_{};
+        DeletionQueue* deletions_ = nullptr;
+        BindlessDescriptors* bindless_ = nullptr;
+        uint64_t frameIndex_ = 0;
+        VkDescriptorSetLayout setLayout_{};
+        std::vector<VkDescriptorPool> pools_;
+        VkSampler sampler_{};
+        VkBuffer staging_{}; VkDeviceMemory stagingMem_{}; uint8_t* stagingPtr_ = nullptr;
+        VkDeviceSize sliceSize_ = 0;
+        std::vector<Texture> textures_;
+        uint64_t budget_ = 256ull << 20;
+        uint64_t uploadedBytes_ = 0, evictions_ = 0;
+        uint32_t decoding_ = 0;
+
+        // Decode jobs
+        jobs::Group decodes_;
+        std::atomic<bool> stop_{false}; // queued decodes skip their work
+        std::mutex mutex_;              // guards done_
+        std::vector<Decoded> done_;
+
+        void decode(Handle tex, const std::vector<uint8_t>& encoded);
+        void collectDecoded();
+        void planResidency();
+        bool upload(VkCommandBuffer cmd, Texture& t, uint32_t frameSlot, VkDeviceSize& used);
+        bool beginChain(Texture& t, uint32_t top);
+        bool finishChain(Texture& t);
+        void retire(Gpu& g);
+        void destroy(const Gpu& g);
+        VkDescriptorSet allocateSet(VkImageView view, VkDescriptorPool& poolOut);
+        uint32_t minTop(const Texture& t) const;
+        uint64_t chainBytes(const Texture& t, uint32_t top) const { return t.pixels.size() - t.offsets[top]; }
+    };
+}
@@ -3,12 +3,33 @@
 #include <vector>
 #include <cstring>
 #include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
 #include <stdexcept>
+#include <filesystem>
+#include <future>
+#include "../core/jobs.h"
+#include "../core/log.h"
+#include "../core/time.h"
+#include "../core/profiler.h"
+#include "../core/startup.h"
 #include "../terrain/terrain.h"
 #include "../scene/gltf_loader.h"
+#include "../scene/light.h"
 
 using namespace eng::renderer;
 
+static_assert(sizeof(eng::terrain::Vertex) == 28, "terrain::Vertex must match TERRAIN_VERTEX_WORDS in geometry_arena.glsl");
+
+// Fixed at startup: all scene geometry is suballocated from it
+static constexpr VkDeviceSize kGeometryArenaBytes = 256ull << 20;
+
+// Pipeline ids in the scene render queue's keys, in submission order within a pass
+static constexpr uint32_t kPrepassPipeline = 0, kMeshPipeline = 1, kTerrainPipeline = 2;
+// Payload of the single mesh item that stands for the bindless indirect multi-draw
+static constexpr uint32_t kAllMeshDraws = UINT32_MAX;
+
 static bool hasExt(const char* name) {
     uint32_t count = 0; vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
     std::vector<VkExtensionProperties> exts(count); vkEnumerateInstanceExtensionProperties(nullptr, &count, exts.data());
@@ -24,6 +45,7 @@ static bool hasLayer(const char* name) {
 }
 
 bool VulkanRenderer::createInstance() {
+    ENG_PROFILE_FUNCTION();
     uint32_t extCount = 0; const char** glfwExts = glfwGetRequiredInstanceExtensions(&extCount);
     std::vector<const char*> exts(glfwExts, glfwExts + extCount);
     if (hasExt(VK_KHR_PORTABILITY_ENUMERATION_EXTENSION_NAME))
@@ -55,10 +77,11 @@ static VKAPI_ATTR VkBool32 VKAPI_CALL dbgCallback(
     VkDebugUtilsMessageTypeFlagsEXT,
     const VkDebugUtilsMessengerCallbackDataEXT* data,
     void*) {
-    const char* sev = (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) ? "ERROR" :
-                      (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) ? "WARN" :
-                      (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) ? "INFO" : "VERBOSE";
-    fprintf(stderr, "[Vulkan][%s] %s\n", sev, data->pMessage);
+    // May be called from driver threads; the message text is copied into the log ring
+    if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT) eng::log::error("[Vulkan] %s", data->pMessage);
+    else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT) eng::log::warn("[Vulkan] %s", data->pMessage);
+    else if (severity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT) eng::log::info("[Vulkan] %s", data->pMessage);
+    else eng::log::debug("[Vulkan] %s", data->pMessage);
     return VK_FALSE;
 }
 
@@ -73,10 +96,12 @@ void VulkanRenderer::setupDebug() {
 }
 
 bool VulkanRenderer::createSurface() {
+    ENG_PROFILE_FUNCTION();
     return glfwCreateWindowSurface(instance_, window_, nullptr, &surface_) == VK_SUCCESS;
 }
 
 bool VulkanRenderer::pickPhysicalDevice() {
+    ENG_PROFILE_FUNCTION();
     uint32_t count = 0; vkEnumeratePhysicalDevices(instance_, &count, nullptr);
     if (count == 0) return false;
     std::vector<VkPhysicalDevice> gpus(count); vkEnumeratePhysicalDevices(instance_, &count, gpus.data());
@@ -95,6 +120,7 @@ bool VulkanRenderer::pickPhysicalDevice() {
 }
 
 bool VulkanRenderer::createDevice() {
+    ENG_PROFILE_FUNCTION();
     float prio = 1.0f;
     VkDeviceQueueCreateInfo qci{VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO};
     qci.queueFamilyIndex = graphicsQueueFamily_;
@@ -102,18 +128,33 @@ bool VulkanRenderer::createDevice() {
     qci.pQueuePriorities = &prio;
 
     const char* devExts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    VkPhysicalDeviceFeatures supported{}; vkGetPhysicalDeviceFeatures(physical_, &supported);
+    VkPhysicalDeviceFeatures features{};
+    features.pipelineStatisticsQuery = supported.pipelineStatisticsQuery; // optional, used by the GPU profiler
+    pipelineStatsSupported_ = supported.pipelineStatisticsQuery == VK_TRUE;
+    // Optional, used by GPU-culled mesh draws (one multi-draw, material index in firstInstance)
+    features.multiDrawIndirect = supported.multiDrawIndirect;
+    features.drawIndirectFirstInstance = supported.drawIndirectFirstInstance;
+    multiDrawIndirect_ = supported.multiDrawIndirect == VK_TRUE;
+    drawIndirectFirstInstance_ = supported.drawIndirectFirstInstance == VK_TRUE;
+    VkPhysicalDeviceDescriptorIndexingFeatures indexing{VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+    bindlessSupported_ = BindlessDescriptors::supported(physical_);
+    if (bindlessSupported_) BindlessDescriptors::enableFeatures(indexing);
     VkDeviceCreateInfo dci{VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
     dci.queueCreateInfoCount = 1;
     dci.pQueueCreateInfos = &qci;
     dci.enabledExtensionCount = 1;
     dci.ppEnabledExtensionNames = devExts;
+    dci.pEnabledFeatures = &features;
+    dci.pNext = bindlessSupported_ ? &indexing : nullptr;
     if (vkCreateDevice(physical_, &dci, nullptr, &device_) != VK_SUCCESS) return false;
     vkGetDeviceQueue(device_, graphicsQueueFamily_, 0, &graphicsQueue_);
     presentQueue_ = graphicsQueue_;
     return true;
 }
 
-bool VulkanRenderer::createSwapchain() {
+bool VulkanRenderer::createSwapchain(VkSwapchainKHR oldSwapchain) {
+    ENG_PROFILE_FUNCTION();
     VkSurfaceCapabilitiesKHR caps{}; vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physical_, surface_, &caps);
     uint32_t fmtCount=0; vkGetPhysicalDeviceSurfaceFormatsKHR(physical_, surface_, &fmtCount, nullptr);
     std::vector<VkSurfaceFormatKHR> formats(fmtCount); vkGetPhysicalDeviceSurfaceFormatsKHR(physical_, surface_, &fmtCount, formats.data());
@@ -121,7 +162,21 @@ bool VulkanRenderer::createSwapchain() {
     for (auto& f: formats) {
         if ((f.format == VK_FORMAT_B8G8R8A8_UNORM || f.format == VK_FORMAT_R8G8B8A8_UNORM) && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) { chosen = f; break; }
     }
+    if (renderPass_) {
+        // The render pass (and every pipeline built against it) is kept across recreation,
+        // so the swapchain must keep the format it was created with.
+        auto same = std::find_if(formats.begin(), formats.end(), [&](const VkSurfaceFormatKHR& f) { return f.format == swapFormat_; });
+        if (same == formats.end()) { eng::log::error("Surface no longer supports the swapchain format"); return false; }
+        chosen = *same;
+    }
     swapFormat_ = chosen.format;
+    // The frame reaches the swapchain image through a scaling blit from the scene target
+    VkFormatProperties fp{}; vkGetPhysicalDeviceFormatProperties(physical_, swapFormat_, &fp);
+    const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    if (!(caps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT) || (fp.optimalTilingFeatures & blit) != blit) {
+        eng::log::error("Swapchain format cannot be the target of a blit"); return false;
+    }
+    upscaleFilter_ = (fp.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT) ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
 
     int fbw=0, fbh=0; glfwGetFramebufferSize(window_, &fbw, &fbh);
     VkExtent2D extent{};
@@ -136,36 +191,22 @@ bool VulkanRenderer::createSwapchain() {
     sci.imageColorSpace = chosen.colorSpace;
     sci.imageExtent = extent;
     sci.imageArrayLayers = 1;
-    sci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    sci.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     sci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
     sci.preTransform = caps.currentTransform;
     sci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
     sci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
     sci.clipped = VK_TRUE;
-    sci.oldSwapchain = VK_NULL_HANDLE;
-    if (vkCreateSwapchainKHR(device_, &sci, nullptr, &swapchain_) != VK_SUCCESS) return false;
+    sci.oldSwapchain = oldSwapchain;
+    swapchain_ = VK_NULL_HANDLE;
+    if (vkCreateSwapchainKHR(device_, &sci, nullptr, &swapchain_) != VK_SUCCESS) { swapchain_ = VK_NULL_HANDLE; return false; }
     uint32_t count = 0; vkGetSwapchainImagesKHR(device_, swapchain_, &count, nullptr);
     swapImages_.resize(count); vkGetSwapchainImagesKHR(device_, swapchain_, &count, swapImages_.data());
     return true;
 }
 
-bool VulkanRenderer::createImageViews() {
-    swapViews_.resize(swapImages_.size());
-    for (size_t i=0;i<swapImages_.size();++i) {
-        VkImageViewCreateInfo ci{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
-        ci.image = swapImages_[i];
-        ci.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        ci.format = swapFormat_;
-        ci.components = {VK_COMPONENT_SWIZZLE_IDENTITY,VK_COMPONENT_SWIZZLE_IDENTITY,VK_COMPONENT_SWIZZLE_IDENTITY,VK_COMPONENT_SWIZZLE_IDENTITY};
-        ci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        ci.subresourceRange.levelCount = 1;
-        ci.subresourceRange.layerCount = 1;
-        if (vkCreateImageView(device_, &ci, nullptr, &swapViews_[i]) != VK_SUCCESS) return false;
-    }
-    return true;
-}
-
 bool VulkanRenderer::createRenderPass() {
+    ENG_PROFILE_FUNCTION();
     VkAttachmentDescription color{};
     color.format = swapFormat_;
     color.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -174,7 +215,7 @@ bool VulkanRenderer::createRenderPass() {
     color.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     color.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     color.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    color.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    color.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL; // upscaled into the swapchain image
 
     VkAttachmentReference colorRef{0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL};
     // Depth attachment
@@ -183,7 +224,7 @@ bool VulkanRenderer::createRenderPass() {
     depth.format = depthFormat_;
     depth.samples = VK_SAMPLE_COUNT_1_BIT;
     depth.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    depth.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    depth.storeOp = depthSampled_ ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE; // read by the Hi-Z build
     depth.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
     depth.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
     depth.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -196,12 +237,22 @@ bool VulkanRenderer::createRenderPass() {
     sub.pColorAttachments = &colorRef;
     sub.pDepthStencilAttachment = &depthRef;
 
-    VkSubpassDependency dep{};
-    dep.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dep.dstSubpass = 0;
-    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    // The scene targets are shared by all frames in flight: the previous frame's depth writes,
+    // Hi-Z reads and upscale blit must be done before this pass clears them
+    VkSubpassDependency deps[2]{};
+    deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    deps[0].dstSubpass = 0;
+    deps[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    deps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
+    deps[0].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    deps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+    // Color writes (and the transition to TRANSFER_SRC) before the upscale blit reads them
+    deps[1].srcSubpass = 0;
+    deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    deps[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    deps[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    deps[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
 
     VkAttachmentDescription attachments[2] = { color, depth };
     VkRenderPassCreateInfo rpci{VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO};
@@ -209,33 +260,32 @@ bool VulkanRenderer::createRenderPass() {
     rpci.pAttachments = attachments;
     rpci.subpassCount = 1;
     rpci.pSubpasses = &sub;
-    rpci.dependencyCount = 1;
-    rpci.pDependencies = &dep;
+    rpci.dependencyCount = 2;
+    rpci.pDependencies = deps;
     return vkCreateRenderPass(device_, &rpci, nullptr, &renderPass_) == VK_SUCCESS;
 }
 
 bool VulkanRenderer::createFramebuffers() {
-    framebuffers_.resize(swapViews_.size());
-    for (size_t i=0;i<swapViews_.size();++i) {
-        VkImageView views[] = { swapViews_[i], depthView_ };
-        VkFramebufferCreateInfo fci{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
-        fci.renderPass = renderPass_;
-        fci.attachmentCount = 2;
-        fci.pAttachments = views;
-        fci.width = swapExtent_.width;
-        fci.height = swapExtent_.height;
-        fci.layers = 1;
-        if (vkCreateFramebuffer(device_, &fci, nullptr, &framebuffers_[i]) != VK_SUCCESS) return false;
-    }
-    return true;
+    ENG_PROFILE_FUNCTION();
+    // Full size; each frame's render area is the renderExtent_ corner of it
+    VkImageView views[] = { sceneColorView_, depthView_ };
+    VkFramebufferCreateInfo fci{VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO};
+    fci.renderPass = renderPass_;
+    fci.attachmentCount = 2;
+    fci.pAttachments = views;
+    fci.width = swapExtent_.width;
+    fci.height = swapExtent_.height;
+    fci.layers = 1;
+    return vkCreateFramebuffer(device_, &fci, nullptr, &sceneFramebuffer_) == VK_SUCCESS;
 }
 
 bool VulkanRenderer::createCommands() {
+    ENG_PROFILE_FUNCTION();
     VkCommandPoolCreateInfo pci{VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO};
     pci.queueFamilyIndex = graphicsQueueFamily_;
     pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
     if (vkCreateCommandPool(device_, &pci, nullptr, &cmdPool_) != VK_SUCCESS) return false;
-    cmdBufs_.resize(framebuffers_.size());
+    cmdBufs_.resize(kMaxFrames); // one per frame in flight, independent of the swapchain image count
     VkCommandBufferAllocateInfo ai{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
     ai.commandPool = cmdPool_;
     ai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
@@ -245,6 +295,7 @@ bool VulkanRenderer::createCommands() {
 }
 
 bool VulkanRenderer::createSync() {
+    ENG_PROFILE_FUNCTION();
     semImageAvail_.resize(kMaxFrames);
     semRenderFinish_.resize(kMaxFrames);
     inFlight_.resize(kMaxFrames);
@@ -258,132 +309,424 @@ bool VulkanRenderer::createSync() {
     return true;
 }
 
+bool VulkanRenderer::createPipelineCache() {
+    ENG_PROFILE_FUNCTION();
+    // Reuse the on-disk blob only if its header matches this exact device/driver;
+    // drivers are allowed to reject foreign data but some crash on it instead.
+    VkPhysicalDeviceProperties props{}; vkGetPhysicalDeviceProperties(physical_, &props);
+    std::vector<uint8_t> blob;
+    if (pipelineCacheBlob_.valid()) blob = pipelineCacheBlob_.get().bytes; // missing file: empty
+    bool valid = false;
+    if (blob.size() >= sizeof(VkPipelineCacheHeaderVersionOne)) {
+        VkPipelineCacheHeaderVersionOne hdr{}; std::memcpy(&hdr, blob.data(), sizeof(hdr));
+        valid = hdr.headerSize >= sizeof(hdr) && hdr.headerSize <= blob.size() &&
+                hdr.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+                hdr.vendorID == props.vendorID && hdr.deviceID == props.deviceID &&
+                std::memcmp(hdr.pipelineCacheUUID, props.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+    if (!blob.empty() && !valid) eng::log::warn("Discarding stale pipeline cache '%s'", pipelineCachePath_.c_str());
+    pipelineCacheWarm_ = valid;
+
+    VkPipelineCacheCreateInfo ci{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+    ci.initialDataSize = valid ? blob.size() : 0;
+    ci.pInitialData = valid ? blob.data() : nullptr;
+    if (vkCreatePipelineCache(device_, &ci, nullptr, &pipelineCache_) == VK_SUCCESS) return true;
+    // Driver refused the data despite a matching header: start empty
+    pipelineCacheWarm_ = false;
+    ci.initialDataSize = 0; ci.pInitialData = nullptr;
+    return vkCreatePipelineCache(device_, &ci, nullptr, &pipelineCache_) == VK_SUCCESS;
+}
+
+std::string VulkanRenderer::defaultPipelineCachePath() {
+    namespace fs = std::filesystem;
+    if (const char* env = std::getenv("VKTHING_PIPELINE_CACHE")) return env;
+    // Not the working directory: the cache must not depend on where the binary is launched from
+    auto nonEmpty = [](const char* v) { return v && *v; };
+    fs::path dir;
+#if defined(_WIN32)
+    if (const char* v = std::getenv("LOCALAPPDATA"); nonEmpty(v)) dir = v;
+#elif defined(__APPLE__)
+    if (const char* v = std::getenv("HOME"); nonEmpty(v)) dir = fs::path(v) / "Library" / "Caches";
+#else
+    if (const char* v = std::getenv("XDG_CACHE_HOME"); nonEmpty(v)) dir = v;
+    else if (const char* h = std::getenv("HOME"); nonEmpty(h)) dir = fs::path(h) / ".cache";
+#endif
+    if (!dir.empty()) return (dir / "vkthing" / "pipeline_cache.bin").string();
+    std::error_code ec;
+    fs::path tmp = fs::temp_directory_path(ec);
+    return ec ? std::string() : (tmp / "vkthing_pipeline_cache.bin").string();
+}
+
+void VulkanRenderer::savePipelineCache() {
+    ENG_PROFILE_FUNCTION();
+    if (!pipelineCache_ || pipelineCachePath_.empty()) return;
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) return;
+    std::vector<char> data(size);
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) return;
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(pipelineCachePath_).parent_path();
+    if (!parent.empty()) std::filesystem::create_directories(parent, ec); // first run: the cache directory may not exist
+    // Write to a temp file and rename over the old one so a crash never leaves a truncated cache
+    std::string tmp = pipelineCachePath_ + ".tmp";
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) { eng::log::warn("Cannot write pipeline cache '%s'", tmp.c_str()); return; }
+    bool ok = std::fwrite(data.data(), 1, size, f) == size;
+    ok = (std::fclose(f) == 0) && ok;
+    if (ok) std::filesystem::rename(tmp, pipelineCachePath_, ec);
+    if (!ok || ec) { eng::log::warn("Failed to save pipeline cache '%s'", pipelineCachePath_.c_str()); std::filesystem::remove(tmp, ec); }
+}
+
 bool VulkanRenderer::initialize(GLFWwindow* window) {
+    ENG_PROFILE_FUNCTION();
     window_ = window;
-    if (!createInstance()) return false;
-    if (!createSurface()) return false;
-    if (!pickPhysicalDevice()) return false;
-    if (!createDevice()) return false;
-    if (!createSwapchain()) return false;
-    if (!createImageViews()) return false;
-    if (!createRenderPass()) return false;
-    if (!createDepthResources()) return false;
-    if (!createFramebuffers()) return false;
-    if (!createCommands()) return false;
-    if (!createSync()) return false;
-    // Shaders directory relative to working dir
-    if (!createTerrainPipeline("shaders")) return false;
-    createMeshPipeline("shaders");  // Optional - don't fail if mesh shaders not found
-    if (!createTerrainGeometry()) return false;
+    if (!pipelineCachePath_.empty()) pipelineCacheBlob_ = eng::io::read(pipelineCachePath_);
+    {
+        eng::startup::Phase phase("vulkan device");
+        if (!createInstance()) return false;
+        if (!createSurface()) return false;
+        if (!pickPhysicalDevice()) return false;
+        if (!createDevice()) return false;
+    }
+    {
+        eng::startup::Phase phase("swapchain + targets");
+        if (!createSwapchain(VK_NULL_HANDLE)) return false;
+        if (!createRenderPass()) return false;
+        if (!createSceneColor()) return false;
+        if (!createDepthResources()) return false;
+        if (!createFramebuffers()) return false;
+        if (!createCommands()) return false;
+        if (!createSync()) return false;
+    }
+    if (!createPipelineCache()) return false;
+    {
+        eng::startup::Phase phase("renderer services");
+        gpuProfiler_.init(physical_, device_, graphicsQueueFamily_, kMaxFrames, pipelineStatsSupported_); // optional
+        if (bindlessSupported_ && !bindless_.init(physical_, device_, kMaxFrames))
+            eng::log::warn("Bindless descriptors unavailable, using per-material descriptor sets");
+        if (!textures_.init(physical_, device_, kMaxFrames, &deletions_, bindless_.enabled() ? &bindless_ : nullptr)) return false;
+        shaders_.init(device_);
+        if (!lighting_.init(physical_, device_, shaders_, pipelineCache_, kMaxFrames)) { eng::log::error("Failed to initialize clustered lighting"); return false; }
+        if (!geometry_.init(physical_, device_, kGeometryArenaBytes, &deletions_)) { eng::log::error("Failed to create the geometry arena"); return false; }
+    }
+    auto t0 = eng::time::clock::now();
+    {
+        eng::startup::Phase phase("pipelines");
+        if (!createPipelineLayout()) return false;
+        // Pipeline compilation dominates a cold start. The mesh pipelines and the culling compute
+        // pipelines build as jobs while this thread builds the terrain pipeline; the shader
+        // registry and the pipeline cache are both internally synchronized.
+        eng::jobs::Group builds;
+        bool cullingOk = false;
+        eng::jobs::run(builds, [this] {
+            eng::startup::Phase worker("mesh pipelines");
+            createMeshPipeline(); // optional - geometry is only uploaded once a glTF scene is loaded
+        });
+        eng::jobs::run(builds, [this, &cullingOk] {
+            eng::startup::Phase worker("occlusion culler");
+            cullingOk = depthSampled_ && culler_.init(physical_, device_, shaders_, pipelineCache_, kMaxFrames, &deletions_) &&
+                        culler_.resize(depthImage_, depthView_, depthFormat_, swapExtent_, frameIndex_);
+        });
+        bool terrainOk = createTerrainPipeline();
+        eng::jobs::wait(builds);
+        if (!cullingOk) {
+            culler_.shutdown();
+            eng::log::warn("Occlusion culling unavailable, drawing every mesh");
+        }
+        if (!terrainOk) return false;
+    }
+    std::chrono::duration<double, std::milli> pipeMs = eng::time::clock::now() - t0;
+    eng::log::info("Pipelines created in %.2f ms (%s pipeline cache)", pipeMs.count(), pipelineCacheWarm_ ? "warm" : "cold");
+    shaders_.startWatching([this](ShaderId id) { onShaderReloaded(id); });
     return true;
 }
 
+void VulkanRenderer::onShaderReloaded(ShaderId id) {
+    // Runs on the shader watcher thread: compile the replacement pipeline here and
+    // let drawFrame pick it up, so frames never wait on pipeline compilation.
+    std::lock_guard<std::mutex> lock(reloadMutex_);
+    auto rebuild = [&](VkPipeline& pending, auto build) {
+        VkPipeline p{};
+        if (!build(p)) { eng::log::warn("Pipeline rebuild after %s reload failed", ShaderRegistry::name(id)); return; }
+        if (pending) vkDestroyPipeline(device_, pending, nullptr); // superseded before it was ever bound
+        pending = p;
+    };
+    switch (id) {
+    case ShaderId::TerrainPointsVert: case ShaderId::TerrainPointsFrag:
+        rebuild(pendingTerrainPipeline_, [&](VkPipeline& p) { return buildTerrainPipeline(p); });
+        break;
+    case ShaderId::MeshVert:
+        rebuild(pendingPrepassPipeline_, [&](VkPipeline& p) { return buildMeshPipeline(p, true); });
+        [[fallthrough]];
+    case ShaderId::MeshFrag: case ShaderId::MeshBindlessFrag:
+        rebuild(pendingMeshPipeline_, [&](VkPipeline& p) { return buildMeshPipeline(p); });
+        break;
+    case ShaderId::HiZReduceComp: case ShaderId::OcclusionCullComp:
+        if (culler_.enabled())
+            rebuild(id == ShaderId::HiZReduceComp ? pendingReducePipeline_ : pendingCullPipeline_,
+                    [&](VkPipeline& p) { return (p = culler_.buildPipeline(id, shaders_, pipelineCache_)) != VK_NULL_HANDLE; });
+        break;
+    case ShaderId::LightClusterComp:
+        if (lighting_.enabled()) rebuild(pendingClusterPipeline_, [&](VkPipeline& p) { return (p = lighting_.buildPipeline(shaders_, pipelineCache_)) != VK_NULL_HANDLE; });
+        break;
+    default:
+        break;
+    }
+}
+
+void VulkanRenderer::applyReloadedPipelines() {
+    std::unique_lock<std::mutex> lock(reloadMutex_, std::try_to_lock);
+    if (!lock) return; // a rebuild is in flight; pick it up next frame
+    auto retire = [&](VkPipeline old) {
+        if (old) deletions_.push(frameIndex_, [dev = device_, old] { vkDestroyPipeline(dev, old, nullptr); });
+    };
+    auto swapIn = [&](VkPipeline& live, VkPipeline& pending) {
+        if (!pending) return;
+        retire(live);
+        live = pending; pending = VK_NULL_HANDLE;
+    };
+    swapIn(pipeline_, pendingTerrainPipeline_);
+    swapIn(meshPipeline_, pendingMeshPipeline_);
+    swapIn(depthPrepassPipeline_, pendingPrepassPipeline_);
+    // Compute pipelines live in their passes, which hand back the replaced one
+    if (pendingReducePipeline_) { retire(culler_.replacePipeline(ShaderId::HiZReduceComp, pendingReducePipeline_)); pendingReducePipeline_ = VK_NULL_HANDLE; }
+    if (pendingCullPipeline_) { retire(culler_.replacePipeline(ShaderId::OcclusionCullComp, pendingCullPipeline_)); pendingCullPipeline_ = VK_NULL_HANDLE; }
+    if (pendingClusterPipeline_) { retire(lighting_.replacePipeline(pendingClusterPipeline_)); pendingClusterPipeline_ = VK_NULL_HANDLE; }
+}
+
 void VulkanRenderer::cleanupSwapchain() {
-    for (auto fb: framebuffers_) vkDestroyFramebuffer(device_, fb, nullptr);
-    framebuffers_.clear();
-    if (renderPass_) { vkDestroyRenderPass(device_, renderPass_, nullptr); renderPass_ = VK_NULL_HANDLE; }
+    if (sceneFramebuffer_) { vkDestroyFramebuffer(device_, sceneFramebuffer_, nullptr); sceneFramebuffer_ = VK_NULL_HANDLE; }
     if (depthView_ || depthImage_) { destroyDepthResources(); }
-    for (auto v: swapViews_) vkDestroyImageView(device_, v, nullptr);
-    swapViews_.clear();
+    destroySceneColor();
     if (swapchain_) { vkDestroySwapchainKHR(device_, swapchain_, nullptr); swapchain_ = VK_NULL_HANDLE; }
 }
 
 bool VulkanRenderer::recreateSwapchain() {
-    vkDeviceWaitIdle(device_);
-    cleanupSwapchain();
-    if (!createSwapchain()) return false;
-    if (!createImageViews()) return false;
-    if (!createRenderPass()) return false;
+    ENG_PROFILE_FUNCTION();
+    int fbw=0, fbh=0; glfwGetFramebufferSize(window_, &fbw, &fbh);
+    if (fbw == 0 || fbh == 0) return true; // minimized: keep the old swapchain until the window has a size again
+    swapchainDirty_ = false;
+
+    // Only extent-dependent objects are rebuilt. The render pass and pipelines stay, and the
+    // old objects are retired through the deletion queue since frames in flight still use them.
+    VkSwapchainKHR oldSwapchain = swapchain_;
+    VkFramebuffer oldFramebuffer = sceneFramebuffer_; sceneFramebuffer_ = VK_NULL_HANDLE;
+    VkImageView oldColorView = sceneColorView_; VkImage oldColorImage = sceneColor_; VkDeviceMemory oldColorMem = sceneColorMem_;
+    sceneColorView_ = VK_NULL_HANDLE; sceneColor_ = VK_NULL_HANDLE; sceneColorMem_ = VK_NULL_HANDLE;
+    VkImageView oldDepthView = depthView_; VkImage oldDepthImage = depthImage_; VkDeviceMemory oldDepthMem = depthMem_;
+    depthView_ = VK_NULL_HANDLE; depthImage_ = VK_NULL_HANDLE; depthMem_ = VK_NULL_HANDLE;
+
+    bool ok = createSwapchain(oldSwapchain);
+    deletions_.push(frameIndex_, [=, dev = device_] {
+        if (oldFramebuffer) vkDestroyFramebuffer(dev, oldFramebuffer, nullptr);
+        if (oldColorView) vkDestroyImageView(dev, oldColorView, nullptr);
+        if (oldColorImage) vkDestroyImage(dev, oldColorImage, nullptr);
+        if (oldColorMem) vkFreeMemory(dev, oldColorMem, nullptr);
+        if (oldDepthView) vkDestroyImageView(dev, oldDepthView, nullptr);
+        if (oldDepthImage) vkDestroyImage(dev, oldDepthImage, nullptr);
+        if (oldDepthMem) vkFreeMemory(dev, oldDepthMem, nullptr);
+        if (oldSwapchain) vkDestroySwapchainKHR(dev, oldSwapchain, nullptr);
+    });
+    if (!ok) return false;
+    if (!createSceneColor()) return false;
     if (!createDepthResources()) return false;
+    if (culler_.enabled() && !culler_.resize(depthImage_, depthView_, depthFormat_, swapExtent_, frameIndex_))
+        eng::log::warn("Hi-Z pyramid resize failed, occlusion tests paused");
     if (!createFramebuffers()) return false;
-    // command buffers remain valid since pool persists, but their recorded content depends on render pass/framebuffers; we'll record each frame.
     return true;
 }
 
 bool VulkanRenderer::drawFrame(float r, float g, float b) {
-    vkWaitForFences(device_, 1, &inFlight_[curFrame_], VK_TRUE, UINT64_MAX);
-    vkResetFences(device_, 1, &inFlight_[curFrame_]);
+    ENG_PROFILE_FUNCTION();
+    {
+        ENG_PROFILE_SCOPE("wait frame fence");
+        vkWaitForFences(device_, 1, &inFlight_[curFrame_], VK_TRUE, UINT64_MAX);
+    }
+    // This slot's fence means frame frameIndex_ - kMaxFrames has finished on the GPU
+    if (frameIndex_ >= kMaxFrames) deletions_.flush(frameIndex_ - kMaxFrames);
+    frameArena_.beginFrame(frameIndex_);
+    culler_.collect(curFrame_);
+    applyReloadedPipelines();
+
+    if (swapchainDirty_) {
+        if (!recreateSwapchain()) return false;
+        if (swapchainDirty_) return true; // minimized, nothing to draw into
+    }
 
     uint32_t imageIndex = 0;
-    VkResult acq = vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, semImageAvail_[curFrame_], VK_NULL_HANDLE, &imageIndex);
-    if (acq == VK_ERROR_OUT_OF_DATE_KHR) { recreateSwapchain(); return true; }
+    VkResult acq;
+    {
+        ENG_PROFILE_SCOPE("acquire image");
+        acq = vkAcquireNextImageKHR(device_, swapchain_, UINT64_MAX, semImageAvail_[curFrame_], VK_NULL_HANDLE, &imageIndex);
+    }
+    if (acq == VK_ERROR_OUT_OF_DATE_KHR) { swapchainDirty_ = true; return true; }
     if (acq != VK_SUCCESS && acq != VK_SUBOPTIMAL_KHR) return false;
+    // Only reset once we are certain to submit, otherwise the next wait on this fence would hang
+    vkResetFences(device_, 1, &inFlight_[curFrame_]);
+
+    VkCommandBuffer cmd = cmdBufs_[curFrame_];
+    recordFrame(cmd, imageIndex, r, g, b);
+
+    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_TRANSFER_BIT; // only the upscale blit touches the swapchain image
+    VkSubmitInfo si{VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    si.waitSemaphoreCount = 1; si.pWaitSemaphores = &semImageAvail_[curFrame_]; si.pWaitDstStageMask = &waitStage;
+    si.commandBufferCount = 1; si.pCommandBuffers = &cmd;
+    si.signalSemaphoreCount = 1; si.pSignalSemaphores = &semRenderFinish_[curFrame_];
+    {
+        ENG_PROFILE_SCOPE("queue submit");
+        if (vkQueueSubmit(graphicsQueue_, 1, &si, inFlight_[curFrame_]) != VK_SUCCESS) return false;
+    }
+
+    VkPresentInfoKHR pi{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
+    pi.waitSemaphoreCount = 1; pi.pWaitSemaphores = &semRenderFinish_[curFrame_];
+    pi.swapchainCount = 1; pi.pSwapchains = &swapchain_;
+    pi.pImageIndices = &imageIndex;
+    VkResult pres;
+    {
+        ENG_PROFILE_SCOPE("present");
+        pres = vkQueuePresentKHR(presentQueue_, &pi);
+    }
+    if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR) { swapchainDirty_ = true; }
+    else if (pres != VK_SUCCESS) return false;
+
+    curFrame_ = (curFrame_ + 1) % kMaxFrames;
+    ++frameIndex_;
+    return true;
+}
 
-    VkCommandBuffer cmd = cmdBufs_[imageIndex];
+void VulkanRenderer::recordFrame(VkCommandBuffer cmd, uint32_t imageIndex, float r, float g, float b) {
+    ENG_PROFILE_FUNCTION();
     vkResetCommandBuffer(cmd, 0);
     VkCommandBufferBeginInfo bi{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
     vkBeginCommandBuffer(cmd, &bi);
+    gpuProfiler_.beginFrame(cmd, curFrame_);
+    updateRenderExtent();
+    uint32_t frameScope = gpuProfiler_.beginScope(cmd, "frame");
+    {
+        GpuProfiler::Scope scope(gpuProfiler_, cmd, "texture upload");
+        requestMeshTextures();
+        textures_.update(cmd, curFrame_, frameIndex_);
+    }
+    bool culling = meshCullingActive();
+    if (culling) {
+        GpuProfiler::Scope scope(gpuProfiler_, cmd, "occlusion cull");
+        culler_.cull(cmd, curFrame_, vp_, occlusionCulling_);
+    }
+    {
+        GpuProfiler::Scope scope(gpuProfiler_, cmd, "light clustering");
+        lighting_.update(cmd, curFrame_, makeClusterParams(clusterMat(view_), clusterMat(proj_), nearPlane_, farPlane_,
+                                                           (float)renderExtent_.width, (float)renderExtent_.height, 0));
+    }
 
     VkClearValue clears[2]{}; clears[0].color = { r, g, b, 1.0f }; clears[1].depthStencil = {1.0f, 0};
     VkRenderPassBeginInfo rpbi{VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
     rpbi.renderPass = renderPass_;
-    rpbi.framebuffer = framebuffers_[imageIndex];
-    rpbi.renderArea.offset = {0,0}; rpbi.renderArea.extent = swapExtent_;
+    rpbi.framebuffer = sceneFramebuffer_;
+    rpbi.renderArea.offset = {0,0}; rpbi.renderArea.extent = renderExtent_;
     rpbi.clearValueCount = 2; rpbi.pClearValues = clears;
     vkCmdBeginRenderPass(cmd, &rpbi, VK_SUBPASS_CONTENTS_INLINE);
     // viewport/scissor
-    VkViewport vp{0.0f, 0.0f, (float)swapExtent_.width, (float)swapExtent_.height, 0.0f, 1.0f};
-    VkRect2D sc{{0,0}, swapExtent_};
+    VkViewport vp{0.0f, 0.0f, (float)renderExtent_.width, (float)renderExtent_.height, 0.0f, 1.0f};
+    VkRect2D sc{{0,0}, renderExtent_};
     vkCmdSetViewport(cmd, 0, 1, &vp);
     vkCmdSetScissor(cmd, 0, 1, &sc);
-
-    // Render GLTF meshes first (they'll be behind terrain due to depth testing)
-    renderMeshes(cmd);
-
-    // bind and draw points
-    if (pipeline_ && vbo_ && vertexCount_ > 0) {
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_);
-        struct Push { float vp[16]; float pc0[4]; float lightDir[4]; float lightColor[4]; } push{};
-        std::memcpy(push.vp, vp_, sizeof(vp_));
-        push.pc0[0] = pointSize_;
-        push.lightDir[0] = lightDir_[0]; push.lightDir[1] = lightDir_[1]; push.lightDir[2] = lightDir_[2];
-        push.lightColor[0] = lightColor_[0]; push.lightColor[1] = lightColor_[1]; push.lightColor[2] = lightColor_[2]; push.lightColor[3] = lightIntensity_;
-        vkCmdPushConstants(cmd, pipeLayout_, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Push), &push);
-        VkDeviceSize off = 0; vkCmdBindVertexBuffers(cmd, 0, 1, &vbo_, &off);
-        vkCmdDraw(cmd, vertexCount_, 1, 0, 0);
-    }
+    // Every pipeline shares pipeLayout_, so the light grid and the geometry arena stay bound across
+    // the passes below; the arena is also the index buffer of every indexed draw
+    VkDescriptorSet frameSets[2] = { lighting_.descriptor(curFrame_), geometry_.descriptor() };
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLayout_, 2, 2, frameSets, 0, nullptr);
+    vkCmdBindIndexBuffer(cmd, geometry_.buffer(), 0, VK_INDEX_TYPE_UINT32);
+
+    // The depth pre-pass, the meshes and the terrain share one render queue. Pass and pipeline
+    // lead the key, so large occluders still lay down depth first (hidden fragments of everything
+    // else fail early-z) and each pipeline is bound once
+    sceneQueue_.clear();
+    if (depthPrepass_) queueOccluders();
+    queueMeshes(culling);
+    if (pipeline_ && terrainRange_.valid()) sceneQueue_.push(sortkey::opaque(DrawPass::Opaque, kTerrainPipeline, 0, 0), 0);
+    sceneQueue_.sort();
+    submitScene(cmd, culling);
     vkCmdEndRenderPass(cmd);
+    // Next frame's occlusion tests read this frame's depth
+    if (culling && occlusionCulling_) {
+        GpuProfiler::Scope scope(gpuProfiler_, cmd, "hi-z build");
+        culler_.buildPyramid(cmd, vp_, renderExtent_);
+    }
+    // The frame scope (dynamic resolution's input) ends here: the blit waits for the swapchain
+    // image, and that wait is presentation pacing rather than GPU load
+    gpuProfiler_.endScope(cmd, frameScope);
+    {
+        GpuProfiler::Scope scope(gpuProfiler_, cmd, "upscale");
+        upscaleToSwapchain(cmd, imageIndex);
+    }
+    gpuProfiler_.endFrame(cmd);
     vkEndCommandBuffer(cmd);
+}
 
-    VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    VkSubmitInfo si{VK_STRUCTURE_TYPE_SUBMIT_INFO};
-    si.waitSemaphoreCount = 1; si.pWaitSemaphores = &semImageAvail_[curFrame_]; si.pWaitDstStageMask = &waitStage;
-    si.commandBufferCount = 1; si.pCommandBuffers = &cmd;
-    si.signalSemaphoreCount = 1; si.pSignalSemaphores = &semRenderFinish_[curFrame_];
-    if (vkQueueSubmit(graphicsQueue_, 1, &si, inFlight_[curFrame_]) != VK_SUCCESS) return false;
-
-    VkPresentInfoKHR pi{VK_STRUCTURE_TYPE_PRESENT_INFO_KHR};
-    pi.waitSemaphoreCount = 1; pi.pWaitSemaphores = &semRenderFinish_[curFrame_];
-    pi.swapchainCount = 1; pi.pSwapchains = &swapchain_;
-    pi.pImageIndices = &imageIndex;
-    VkResult pres = vkQueuePresentKHR(presentQueue_, &pi);
-    if (pres == VK_ERROR_OUT_OF_DATE_KHR || pres == VK_SUBOPTIMAL_KHR) { recreateSwapchain(); }
-    else if (pres != VK_SUCCESS) return false;
+void VulkanRenderer::updateRenderExtent() {
+    // beginFrame() has just collected the timings of the frame this slot last rendered
+    uint64_t sample = 0;
+    float ms = gpuProfiler_.latestMs("frame", &sample);
+    if (dynamicResolution_ && sample != dynResSample_) dynRes_.update(ms);
+    dynResSample_ = sample;
+    float scale = dynamicResolution_ ? dynRes_.scale() : 1.0f;
+    renderExtent_ = { DynamicResolution::scaled(swapExtent_.width, scale), DynamicResolution::scaled(swapExtent_.height, scale) };
+}
 
-    curFrame_ = (curFrame_ + 1) % kMaxFrames;
-    return true;
+void VulkanRenderer::upscaleToSwapchain(VkCommandBuffer cmd, uint32_t imageIndex) {
+    VkImageMemoryBarrier b{VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER};
+    b.srcAccessMask = 0; b.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    b.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED; b.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    b.srcQueueFamilyIndex = b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = swapImages_[imageIndex]; b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    // Source stage matches the acquire semaphore's wait stage, so the transition happens after it
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &b);
+
+    // The render pass left the scene color in TRANSFER_SRC_OPTIMAL
+    VkImageBlit region{};
+    region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.srcOffsets[1] = { (int32_t)renderExtent_.width, (int32_t)renderExtent_.height, 1 };
+    region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.dstOffsets[1] = { (int32_t)swapExtent_.width, (int32_t)swapExtent_.height, 1 };
+    vkCmdBlitImage(cmd, sceneColor_, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, swapImages_[imageIndex], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1, &region, upscaleFilter_);
+
+    b.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT; b.dstAccessMask = 0;
+    b.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL; b.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, 1, &b);
 }
 
 void VulkanRenderer::waitIdle() { if (device_) vkDeviceWaitIdle(device_); }
 
 void VulkanRenderer::shutdown() {
     if (!device_) return;
+    shaders_.stopWatching();
     vkDeviceWaitIdle(device_);
+    deletions_.flushAll();
+    savePipelineCache();
+    gpuProfiler_.shutdown();
+    culler_.shutdown();
     for (auto f: inFlight_) vkDestroyFence(device_, f, nullptr);
     for (auto s: semImageAvail_) vkDestroySemaphore(device_, s, nullptr);
     for (auto s: semRenderFinish_) vkDestroySemaphore(device_, s, nullptr);
     inFlight_.clear(); semImageAvail_.clear(); semRenderFinish_.clear();
     if (cmdPool_) { vkDestroyCommandPool(device_, cmdPool_, nullptr); cmdPool_ = VK_NULL_HANDLE; }
     cleanupSwapchain();
+    if (renderPass_) { vkDestroyRenderPass(device_, renderPass_, nullptr); renderPass_ = VK_NULL_HANDLE; }
     if (pipeline_) { vkDestroyPipeline(device_, pipeline_, nullptr); pipeline_ = VK_NULL_HANDLE; }
     if (meshPipeline_) { vkDestroyPipeline(device_, meshPipeline_, nullptr); meshPipeline_ = VK_NULL_HANDLE; }
+    if (depthPrepassPipeline_) { vkDestroyPipeline(device_, depthPrepassPipeline_, nullptr); depthPrepassPipeline_ = VK_NULL_HANDLE; }
+    for (VkPipeline* p : { &pendingTerrainPipeline_, &pendingMeshPipeline_, &pendingPrepassPipeline_,
+                           &pendingReducePipeline_, &pendingCullPipeline_, &pendingClusterPipeline_ }) { if (*p) vkDestroyPipeline(device_, *p, nullptr); *p = VK_NULL_HANDLE; }
+    shaders_.shutdown();
     if (pipeLayout_) { vkDestroyPipelineLayout(device_, pipeLayout_, nullptr); pipeLayout_ = VK_NULL_HANDLE; }
-    if (vbo_) { vkDestroyBuffer(device_, vbo_, nullptr); vbo_ = VK_NULL_HANDLE; }
-    if (vboMem_) { vkFreeMemory(device_, vboMem_, nullptr); vboMem_ = VK_NULL_HANDLE; }
-    if (meshVbo_) { vkDestroyBuffer(device_, meshVbo_, nullptr); meshVbo_ = VK_NULL_HANDLE; }
-    if (meshVboMem_) { vkFreeMemory(device_, meshVboMem_, nullptr); meshVboMem_ = VK_NULL_HANDLE; }
-    if (meshIbo_) { vkDestroyBuffer(device_, meshIbo_, nullptr); meshIbo_ = VK_NULL_HANDLE; }
-    if (meshIboMem_) { vkFreeMemory(device_, meshIboMem_, nullptr); meshIboMem_ = VK_NULL_HANDLE; }
+    if (emptySetLayout_) { vkDestroyDescriptorSetLayout(device_, emptySetLayout_, nullptr); emptySetLayout_ = VK_NULL_HANDLE; }
+    lighting_.shutdown();
+    textures_.shutdown();
+    bindless_.shutdown();
+    if (pipelineCache_) { vkDestroyPipelineCache(device_, pipelineCache_, nullptr); pipelineCache_ = VK_NULL_HANDLE; }
+    geometry_.shutdown();
+    terrainRange_ = {}; instanceRange_ = {};
+    meshDraws_.clear(); meshInstances_.clear();
     if (device_) { vkDestroyDevice(device_, nullptr); device_ = VK_NULL_HANDLE; }
     if (surface_) { vkDestroySurfaceKHR(instance_, surface_, nullptr); surface_ = VK_NULL_HANDLE; }
     if (debugMessenger_) {
@@ -396,53 +739,82 @@ void VulkanRenderer::shutdown() {
 
 void VulkanRenderer::setVP(const float* vp16) { std::memcpy(vp_, vp16, sizeof(vp_)); }
 
+void VulkanRenderer::setCamera(const float* view16, const float* proj16, float nearPlane, float farPlane) {
+    std::memcpy(view_, view16, sizeof(view_)); std::memcpy(proj_, proj16, sizeof(proj_));
+    nearPlane_ = nearPlane; farPlane_ = farPlane;
+    glm::mat4 vp = clusterMat(proj_) * clusterMat(view_);
+    std::memcpy(vp_, &vp[0][0], sizeof(vp_));
+}
+
+void VulkanRenderer::setLights(const std::vector<eng::scene::PointLight>& points, const std::vector<eng::scene::SpotLight>& spots) {
+    std::vector<GpuLight> lights; lights.reserve(points.size() + spots.size());
+    for (const auto& p : points) {
+        GpuLight g{};
+        std::memcpy(g.position, &p.position[0], sizeof(g.position)); g.range = p.range;
+        std::memcpy(g.color, &p.color[0], sizeof(g.color)); g.intensity = p.intensity;
+        g.type = (uint32_t)LightType::Point;
+        lights.push_back(g);
+    }
+    for (const auto& s : spots) {
+        GpuLight g{};
+        glm::vec3 dir = glm::normalize(s.direction);
+        std::memcpy(g.position, &s.position[0], sizeof(g.position)); g.range = s.range;
+        std::memcpy(g.color, &s.color[0], sizeof(g.color)); g.intensity = s.intensity;
+        std::memcpy(g.direction, &dir[0], sizeof(g.direction));
+        g.cosOuter = std::cos(s.outerAngle); g.cosInner = std::cos(std::min(s.innerAngle, s.outerAngle));
+        g.type = (uint32_t)LightType::Spot;
+        lights.push_back(g);
+    }
+    lighting_.setLights(std::move(lights));
+}
+
 uint32_t VulkanRenderer::findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags props) {
     VkPhysicalDeviceMemoryProperties memProps{}; vkGetPhysicalDeviceMemoryProperties(physical_, &memProps);
     for (uint32_t i=0;i<memProps.memoryTypeCount;++i) if ((typeFilter & (1u<<i)) && (memProps.memoryTypes[i].propertyFlags & props) == props) return i;
     throw std::runtime_error("No suitable memory type");
 }
 
-static std::vector<char> readFile(const char* path) {
-    std::FILE* f = std::fopen(path, "rb");
-    if (!f) return {};
-    std::fseek(f, 0, SEEK_END); long sz = std::ftell(f); std::rewind(f);
-    std::vector<char> data(sz); std::fread(data.data(), 1, sz, f); std::fclose(f); return data;
+bool VulkanRenderer::createPipelineLayout() {
+    ENG_PROFILE_FUNCTION();
+    VkPushConstantRange pcr{}; pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT; pcr.offset = 0; pcr.size = sizeof(float)*16 + sizeof(float)*4 * 3;
+    // Mesh pass descriptors: bindless texture array + material buffer when descriptor indexing is
+    // available, otherwise one base color texture set per material and an empty set 1.
+    // Set 2 is the clustered light grid, read by the mesh and terrain fragment shaders.
+    // Set 3 is the geometry arena all vertex shaders pull from.
+    if (!bindless_.enabled() && !emptySetLayout_) {
+        VkDescriptorSetLayoutCreateInfo lci{VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO};
+        if (vkCreateDescriptorSetLayout(device_, &lci, nullptr, &emptySetLayout_) != VK_SUCCESS) return false;
+    }
+    VkDescriptorSetLayout setLayouts[4] = { textures_.setLayout(), emptySetLayout_, lighting_.setLayout(), geometry_.setLayout() };
+    if (bindless_.enabled()) { setLayouts[0] = bindless_.textureLayout(); setLayouts[1] = bindless_.materialLayout(); }
+    VkPipelineLayoutCreateInfo plci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO}; plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
+    plci.setLayoutCount = 4; plci.pSetLayouts = setLayouts;
+    return vkCreatePipelineLayout(device_, &plci, nullptr, &pipeLayout_) == VK_SUCCESS;
 }
 
-bool VulkanRenderer::createTerrainPipeline(const char* shaderDir) {
-    std::vector<std::string> baseDirs = { shaderDir, "build/shaders", "build/app/sandbox/shaders" };
-    std::vector<char> vs, fs;
-    for (auto& b : baseDirs) {
-        auto v = readFile((b + "/terrain_points.vert.spv").c_str());
-        auto f = readFile((b + "/terrain_points.frag.spv").c_str());
-        if (!v.empty() && !f.empty()) { vs = std::move(v); fs = std::move(f); break; }
-    }
-    if (vs.empty() || fs.empty()) return false;
-    VkShaderModuleCreateInfo smi{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-    VkShaderModule vsMod{}, fsMod{};
-    smi.codeSize = vs.size(); smi.pCode = reinterpret_cast<const uint32_t*>(vs.data()); if (vkCreateShaderModule(device_, &smi, nullptr, &vsMod) != VK_SUCCESS) return false;
-    smi.codeSize = fs.size(); smi.pCode = reinterpret_cast<const uint32_t*>(fs.data()); if (vkCreateShaderModule(device_, &smi, nullptr, &fsMod) != VK_SUCCESS) { vkDestroyShaderModule(device_, vsMod, nullptr); return false; }
+bool VulkanRenderer::createTerrainPipeline() {
+    ENG_PROFILE_FUNCTION();
+    return buildTerrainPipeline(pipeline_);
+}
+
+bool VulkanRenderer::buildTerrainPipeline(VkPipeline& out) {
+    VkShaderModule vsMod = shaders_.get(ShaderId::TerrainPointsVert);
+    VkShaderModule fsMod = shaders_.get(ShaderId::TerrainPointsFrag);
+    if (!vsMod || !fsMod) return false;
 
     VkPipelineShaderStageCreateInfo sstages[2]{};
     sstages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; sstages[0].stage = VK_SHADER_STAGE_VERTEX_BIT; sstages[0].module = vsMod; sstages[0].pName = "main";
     sstages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO; sstages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT; sstages[1].module = fsMod; sstages[1].pName = "main";
 
-    VkVertexInputBindingDescription bind{0, (uint32_t)sizeof(eng::terrain::Vertex), VK_VERTEX_INPUT_RATE_VERTEX};
-    VkVertexInputAttributeDescription attrs[3]{};
-    attrs[0] = {0, 0, VK_FORMAT_R32G32B32_SFLOAT, (uint32_t)offsetof(eng::terrain::Vertex, pos)};
-    attrs[1] = {1, 0, VK_FORMAT_R32G32B32_SFLOAT, (uint32_t)offsetof(eng::terrain::Vertex, normal)};
-    attrs[2] = {2, 0, VK_FORMAT_R32_SFLOAT, (uint32_t)offsetof(eng::terrain::Vertex, height)};
+    // No vertex input: terrain_points.vert pulls its vertices from the geometry arena
     VkPipelineVertexInputStateCreateInfo vis{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-    vis.vertexBindingDescriptionCount = 1; vis.pVertexBindingDescriptions = &bind;
-    vis.vertexAttributeDescriptionCount = 3; vis.pVertexAttributeDescriptions = attrs;
 
     VkPipelineInputAssemblyStateCreateInfo ias{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
     ias.topology = VK_PRIMITIVE_TOPOLOGY_POINT_LIST;
 
-    VkViewport vp{0,0,(float)swapExtent_.width,(float)swapExtent_.height,0.0f,1.0f};
-    VkRect2D sc{{0,0}, swapExtent_};
+    // Viewport and scissor are dynamic, so the pipeline does not depend on the swapchain extent
     VkPipelineViewportStateCreateInfo vps{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
-    vps.viewportCount = 1; vps.pViewports = &vp; vps.scissorCount = 1; vps.pScissors = &sc;
+    vps.viewportCount = 1; vps.scissorCount = 1;
 
     VkPipelineRasterizationStateCreateInfo rs{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
     rs.polygonMode = VK_POLYGON_MODE_FILL; rs.cullMode = VK_CULL_MODE_NONE; rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE; rs.lineWidth = 1.0f;
@@ -459,10 +831,6 @@ bool VulkanRenderer::createTerrainPipeline(const char* shaderDir) {
     VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
     VkPipelineDynamicStateCreateInfo dyn{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO}; dyn.dynamicStateCount = 2; dyn.pDynamicStates = dynStates;
 
-    VkPushConstantRange pcr{}; pcr.stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT; pcr.offset = 0; pcr.size = sizeof(float)*16 + sizeof(float)*4 * 3;
-    VkPipelineLayoutCreateInfo plci{VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO}; plci.pushConstantRangeCount = 1; plci.pPushConstantRanges = &pcr;
-    if (vkCreatePipelineLayout(device_, &plci, nullptr, &pipeLayout_) != VK_SUCCESS) { vkDestroyShaderModule(device_, vsMod, nullptr); vkDestroyShaderModule(device_, fsMod, nullptr); return false; }
-
     VkGraphicsPipelineCreateInfo pci{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
     pci.stageCount = 2; pci.pStages = sstages;
     pci.pVertexInputState = &vis;
@@ -476,46 +844,36 @@ bool VulkanRenderer::createTerrainPipeline(const char* shaderDir) {
     pci.layout = pipeLayout_;
     pci.renderPass = renderPass_;
     pci.subpass = 0;
-    bool ok = vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1, &pci, nullptr, &pipeline_) == VK_SUCCESS;
-    vkDestroyShaderModule(device_, vsMod, nullptr); vkDestroyShaderModule(device_, fsMod, nullptr);
-    return ok;
-}
-
-bool VulkanRenderer::createTerrainGeometry() {
-    // Generate CPU-side vertices
-    eng::terrain::Settings settings;
-    settings.chunkPoints = 64; settings.radiusChunks = 3; settings.heightScale = 60.0f; settings.frequency = 0.0045f; settings.octaves = 5;
-    auto verts = eng::terrain::generate(settings);
-    vertexCount_ = (uint32_t)verts.size();
-    if (vertexCount_ == 0) return true;
-    VkDeviceSize size = sizeof(eng::terrain::Vertex) * vertexCount_;
-    VkBufferCreateInfo bci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO}; bci.size = size; bci.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT; bci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    if (vkCreateBuffer(device_, &bci, nullptr, &vbo_) != VK_SUCCESS) return false;
-    VkMemoryRequirements mr{}; vkGetBufferMemoryRequirements(device_, vbo_, &mr);
-    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO}; mai.allocationSize = mr.size; mai.memoryTypeIndex = findMemoryType(mr.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &mai, nullptr, &vboMem_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, vbo_, vboMem_, 0);
-    // upload
-    void* ptr = nullptr; vkMapMemory(device_, vboMem_, 0, size, 0, &ptr);
-    std::memcpy(ptr, verts.data(), (size_t)size);
-    vkUnmapMemory(device_, vboMem_);
+    return vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &pci, nullptr, &out) == VK_SUCCESS;
+}
+
+bool VulkanRenderer::loadTerrain(const std::vector<eng::terrain::Vertex>& vertices) {
+    ENG_PROFILE_FUNCTION();
+    // The previous terrain may still be drawn by frames in flight; its range is reused after them
+    geometry_.release(terrainRange_, frameIndex_);
+    terrainRange_ = {}; vertexCount_ = 0;
+    if (vertices.empty()) return true;
+    VkDeviceSize size = sizeof(eng::terrain::Vertex) * vertices.size();
+    GeometryRange range = geometry_.allocate(size, sizeof(eng::terrain::Vertex));
+    if (!range.valid()) return false;
+    std::memcpy(geometry_.data(range), vertices.data(), (size_t)size);
+    terrainRange_ = range; vertexCount_ = (uint32_t)vertices.size();
     return true;
 }
 
-bool VulkanRenderer::createMeshPipeline(const char* shaderDir) {
-    // Load mesh shaders
-    auto vsCode = readFile((std::string(shaderDir) + "/mesh.vert.spv").c_str());
-    auto fsCode = readFile((std::string(shaderDir) + "/mesh.frag.spv").c_str());
-    if (vsCode.empty() || fsCode.empty()) return false;
+bool VulkanRenderer::createMeshPipeline() {
+    ENG_PROFILE_FUNCTION();
+    if (!buildMeshPipeline(meshPipeline_)) return false;
+    if (!buildMeshPipeline(depthPrepassPipeline_, true)) eng::log::warn("Depth pre-pass pipeline creation failed");
+    return true;
+}
 
-    VkShaderModule vsMod, fsMod;
-    VkShaderModuleCreateInfo smci{VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO};
-    smci.codeSize = vsCode.size(); smci.pCode = reinterpret_cast<const uint32_t*>(vsCode.data());
-    if (vkCreateShaderModule(device_, &smci, nullptr, &vsMod) != VK_SUCCESS) return false;
-    smci.codeSize = fsCode.size(); smci.pCode = reinterpret_cast<const uint32_t*>(fsCode.data());
-    if (vkCreateShaderModule(device_, &smci, nullptr, &fsMod) != VK_SUCCESS) {
-        vkDestroyShaderModule(device_, vsMod, nullptr); return false;
-    }
+// depthOnly builds the pre-pass variant: same vertex stage (gl_Position is invariant, so depths
+// match exactly), no fragment stage and no color writes.
+bool VulkanRenderer::buildMeshPipeline(VkPipeline& out, bool depthOnly) {
+    VkShaderModule vsMod = shaders_.get(ShaderId::MeshVert);
+    VkShaderModule fsMod = shaders_.get(bindless_.enabled() ? ShaderId::MeshBindlessFrag : ShaderId::MeshFrag);
+    if (!vsMod || !fsMod) return false;
 
     VkPipelineShaderStageCreateInfo sstages[2]{};
     sstages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -523,26 +881,16 @@ bool VulkanRenderer::createMeshPipeline(const char* shaderDir) {
     sstages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
     sstages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT; sstages[1].module = fsMod; sstages[1].pName = "main";
 
-    VkVertexInputBindingDescription vibd{};
-    vibd.binding = 0; vibd.stride = sizeof(eng::scene::MeshVertex); vibd.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
-
-    VkVertexInputAttributeDescription viads[3]{};
-    viads[0].location = 0; viads[0].binding = 0; viads[0].format = VK_FORMAT_R32G32B32_SFLOAT; viads[0].offset = offsetof(eng::scene::MeshVertex, position);
-    viads[1].location = 1; viads[1].binding = 0; viads[1].format = VK_FORMAT_R32G32B32_SFLOAT; viads[1].offset = offsetof(eng::scene::MeshVertex, normal);
-    viads[2].location = 2; viads[2].binding = 0; viads[2].format = VK_FORMAT_R32G32_SFLOAT; viads[2].offset = offsetof(eng::scene::MeshVertex, texCoord);
-
+    // No vertex input: mesh.vert pulls vertices and instance data from the geometry arena
     VkPipelineVertexInputStateCreateInfo vis{VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO};
-    vis.vertexBindingDescriptionCount = 1; vis.pVertexBindingDescriptions = &vibd;
-    vis.vertexAttributeDescriptionCount = 3; vis.pVertexAttributeDescriptions = viads;
 
     VkPipelineInputAssemblyStateCreateInfo ias{VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO};
     ias.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
     ias.primitiveRestartEnable = VK_FALSE;
 
-    VkViewport vp{0,0,(float)swapExtent_.width,(float)swapExtent_.height,0.0f,1.0f};
-    VkRect2D sc{{0,0}, swapExtent_};
+    // Viewport and scissor are dynamic, so the pipeline does not depend on the swapchain extent
     VkPipelineViewportStateCreateInfo vps{VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO};
-    vps.viewportCount = 1; vps.pViewports = &vp; vps.scissorCount = 1; vps.pScissors = &sc;
+    vps.viewportCount = 1; vps.scissorCount = 1;
 
     VkPipelineRasterizationStateCreateInfo rs{VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO};
     rs.polygonMode = VK_POLYGON_MODE_FILL; rs.cullMode = VK_CULL_MODE_BACK_BIT; rs.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE; rs.lineWidth = 1.0f;
@@ -550,17 +898,18 @@ bool VulkanRenderer::createMeshPipeline(const char* shaderDir) {
     VkPipelineMultisampleStateCreateInfo ms{VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO};
     ms.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-    VkPipelineColorBlendAttachmentState cba{}; cba.colorWriteMask = 0xF;
+    VkPipelineColorBlendAttachmentState cba{}; cba.colorWriteMask = depthOnly ? 0 : 0xF;
     VkPipelineColorBlendStateCreateInfo cb{VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO}; cb.attachmentCount = 1; cb.pAttachments = &cba;
 
+    // LESS_OR_EQUAL so surfaces already laid down by the pre-pass still shade
     VkPipelineDepthStencilStateCreateInfo ds{VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO};
-    ds.depthTestEnable = VK_TRUE; ds.depthWriteEnable = VK_TRUE; ds.depthCompareOp = VK_COMPARE_OP_LESS;
+    ds.depthTestEnable = VK_TRUE; ds.depthWriteEnable = VK_TRUE; ds.depthCompareOp = depthOnly ? VK_COMPARE_OP_LESS : VK_COMPARE_OP_LESS_OR_EQUAL;
 
     VkDynamicState dynStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
     VkPipelineDynamicStateCreateInfo dyn{VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO}; dyn.dynamicStateCount = 2; dyn.pDynamicStates = dynStates;
 
     VkGraphicsPipelineCreateInfo pci{VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO};
-    pci.stageCount = 2; pci.pStages = sstages;
+    pci.stageCount = depthOnly ? 1 : 2; pci.pStages = sstages;
     pci.pVertexInputState = &vis;
     pci.pInputAssemblyState = &ias;
     pci.pViewportState = &vps;
@@ -572,134 +921,270 @@ bool VulkanRenderer::createMeshPipeline(const char* shaderDir) {
     pci.layout = pipeLayout_;
     pci.renderPass = renderPass_;
     pci.subpass = 0;
-    bool ok = vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1, &pci, nullptr, &meshPipeline_) == VK_SUCCESS;
-    vkDestroyShaderModule(device_, vsMod, nullptr); vkDestroyShaderModule(device_, fsMod, nullptr);
-    return ok;
+    return vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &pci, nullptr, &out) == VK_SUCCESS;
 }
 
 bool VulkanRenderer::createMeshGeometry(const std::vector<eng::scene::Mesh>& meshes) {
+    ENG_PROFILE_FUNCTION();
+    releaseMeshGeometry();
     if (meshes.empty()) return true;
 
-    // Calculate total vertices and indices
-    size_t totalVertices = 0;
-    size_t totalIndices = 0;
-    meshTransforms_.clear();
-
-    for (const auto& mesh : meshes) {
-        totalVertices += mesh.vertices.size();
-        totalIndices += mesh.indices.size();
-        meshTransforms_.push_back(mesh.transform);
-    }
-
-    meshVertexCount_ = static_cast<uint32_t>(totalVertices);
-    meshIndexCount_ = static_cast<uint32_t>(totalIndices);
-
-    if (totalVertices == 0) return true;
-
-    // Create vertex buffer
-    VkDeviceSize vertexSize = totalVertices * sizeof(eng::scene::MeshVertex);
-    VkBufferCreateInfo vbci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-    vbci.size = vertexSize;
-    vbci.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
-    vbci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-    if (vkCreateBuffer(device_, &vbci, nullptr, &meshVbo_) != VK_SUCCESS) return false;
-    VkMemoryRequirements vmr{};
-    vkGetBufferMemoryRequirements(device_, meshVbo_, &vmr);
-    VkMemoryAllocateInfo vmai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-    vmai.allocationSize = vmr.size;
-    vmai.memoryTypeIndex = findMemoryType(vmr.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-    if (vkAllocateMemory(device_, &vmai, nullptr, &meshVboMem_) != VK_SUCCESS) return false;
-    vkBindBufferMemory(device_, meshVbo_, meshVboMem_, 0);
-
-    // Create index buffer if we have indices
-    if (totalIndices > 0) {
-        VkDeviceSize indexSize = totalIndices * sizeof(uint32_t);
-        VkBufferCreateInfo ibci{VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
-        ibci.size = indexSize;
-        ibci.usage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
-        ibci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-
-        if (vkCreateBuffer(device_, &ibci, nullptr, &meshIbo_) != VK_SUCCESS) return false;
-        VkMemoryRequirements imr{};
-        vkGetBufferMemoryRequirements(device_, meshIbo_, &imr);
-        VkMemoryAllocateInfo imai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
-        imai.allocationSize = imr.size;
-        imai.memoryTypeIndex = findMemoryType(imr.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        if (vkAllocateMemory(device_, &imai, nullptr, &meshIboMem_) != VK_SUCCESS) return false;
-        vkBindBufferMemory(device_, meshIbo_, meshIboMem_, 0);
-
-        // Upload index data
-        void* indexPtr = nullptr;
-        vkMapMemory(device_, meshIboMem_, 0, indexSize, 0, &indexPtr);
-
-        size_t indexOffset = 0;
-        uint32_t vertexOffset = 0;
-        for (size_t i = 0; i < meshes.size(); ++i) {
-            const auto& mesh = meshes[i];
-            uint32_t* dstIndices = static_cast<uint32_t*>(indexPtr) + indexOffset;
-
-            for (size_t j = 0; j < mesh.indices.size(); ++j) {
-                dstIndices[j] = mesh.indices[j] + vertexOffset;
+    // Each unique mesh gets its own vertex and index ranges in the arena (so meshes can come and go
+    // individually) and is drawn once per instance; packMeshes does the CPU side
+    MeshArena target;
+    target.allocate = [this](uint64_t size, uint64_t alignment) {
+        GeometryRange r = geometry_.allocate(size, alignment);
+        return r.valid() ? r.offset : RangeAllocator::kInvalid;
+    };
+    target.base = geometry_.mapped();
+    PackedGeometry packed;
+    bool ok = packMeshes(meshes, target, [this](int material) { return bindless_.enabled() ? bindlessMaterial(material) : 0u; }, packed);
+
+    // Whatever was allocated is recorded, so releaseMeshGeometry() frees it after a failure too
+    if (packed.instanceBytes) {
+        instanceRange_ = { packed.instanceOffset, packed.instanceBytes };
+        instanceBase_ = instanceRange_.first(sizeof(GpuInstance));
+    }
+    meshDraws_.reserve(packed.meshes.size());
+    for (const PackedMesh& p : packed.meshes) {
+        MeshDraw d;
+        if (p.vertexBytes) d.vertices = { p.vertexOffset, p.vertexBytes };
+        if (p.indexBytes) d.indices = { p.indexOffset, p.indexBytes };
+        d.firstIndex = p.firstIndex; d.indexCount = p.indexCount;
+        d.firstVertex = p.firstVertex; d.vertexCount = p.vertexCount;
+        d.vertexOffset = static_cast<int32_t>(p.firstVertex);
+        d.firstInstance = instanceBase_ + p.firstInstance; d.instanceCount = p.instanceCount;
+        d.material = p.material;
+        d.uvSpan = p.uvSpan;
+        meshDraws_.push_back(d);
+    }
+    meshInstances_ = std::move(packed.instances);
+    if (!ok) return false;
+    meshVertexCount_ = static_cast<uint32_t>(packed.vertices);
+
+    const RangeAllocator& arena = geometry_.allocator();
+    eng::log::info("Mesh geometry: %zu unique meshes, %zu instances (%.2f MiB without instancing); arena %.2f of %.2f MiB used",
+                   meshDraws_.size(), meshInstances_.size(), packed.expandedBytes / 1048576.0, arena.used() / 1048576.0, arena.capacity() / 1048576.0);
+
+    // Indexed draws are culled on the GPU per instance; each draw's commands are consecutive and
+    // keep the CPU draw order
+    if (culler_.enabled()) {
+        std::vector<CullDraw> cullDraws;
+        for (auto& d : meshDraws_) {
+            if (d.indexCount == 0 || d.instanceCount == 0) continue;
+            d.cullIndex = (uint32_t)cullDraws.size();
+            for (uint32_t i = 0; i < d.instanceCount; ++i) {
+                const MeshInstance& inst = meshInstances_[d.firstInstance - instanceBase_ + i];
+                CullDraw cd;
+                cd.sphere = glm::vec4(inst.center, inst.radius);
+                cd.indexCount = d.indexCount; cd.firstIndex = d.firstIndex; cd.vertexOffset = d.vertexOffset;
+                cd.firstInstance = d.firstInstance + i;
+                cullDraws.push_back(cd);
             }
-
-            indexOffset += mesh.indices.size();
-            vertexOffset += static_cast<uint32_t>(mesh.vertices.size());
         }
-
-        vkUnmapMemory(device_, meshIboMem_);
+        if (!culler_.setDraws(cullDraws, frameIndex_)) for (auto& d : meshDraws_) d.cullIndex = UINT32_MAX;
     }
+    return true;
+}
 
-    // Upload vertex data
-    void* vertexPtr = nullptr;
-    vkMapMemory(device_, meshVboMem_, 0, vertexSize, 0, &vertexPtr);
+void VulkanRenderer::releaseMeshGeometry() {
+    // Frames still in flight may draw from these ranges; the arena reuses them after frameIndex_ completes
+    for (const auto& d : meshDraws_) { geometry_.release(d.vertices, frameIndex_); geometry_.release(d.indices, frameIndex_); }
+    geometry_.release(instanceRange_, frameIndex_);
+    instanceRange_ = {}; instanceBase_ = 0;
+    meshDraws_.clear();
+    meshInstances_.clear();
+    meshVertexCount_ = 0;
+    if (culler_.enabled()) culler_.setDraws({}, frameIndex_);
+}
 
-    eng::scene::MeshVertex* dstVertices = static_cast<eng::scene::MeshVertex*>(vertexPtr);
-    size_t vertexOffset = 0;
+bool VulkanRenderer::meshCullingActive() const {
+    // Indirect commands address their instance data through firstInstance, which needs the feature
+    return culler_.enabled() && culler_.drawCount() > 0 && meshPipeline_ && drawIndirectFirstInstance_;
+}
+
+uint32_t VulkanRenderer::bindlessMaterial(int material) const {
+    // Material 0 is the default, scene material i lives at i + 1
+    return (material >= 0 && material + 1u < BindlessDescriptors::kMaxMaterials &&
+            material < (int)materialTextures_.size()) ? (uint32_t)material + 1 : 0;
+}
 
-    for (const auto& mesh : meshes) {
-        std::memcpy(dstVertices + vertexOffset, mesh.vertices.data(),
-                   mesh.vertices.size() * sizeof(eng::scene::MeshVertex));
-        vertexOffset += mesh.vertices.size();
+void VulkanRenderer::queueMeshes(bool indirect) {
+    if (!meshPipeline_ || meshVertexCount_ == 0) return;
+
+    if (bindless_.enabled()) {
+        // The material index is a per-instance attribute, so the pass binds descriptors once when
+        // its pipeline is bound, and all indexed draws can go out as a single indirect multi-draw
+        uint32_t white = textures_.slot(TextureStreamer::kWhite);
+        if (white == BindlessDescriptors::kInvalid) return; // fallback texture not uploaded yet
+        gpuMaterials_.assign(materialTextures_.size() + 1, GpuMaterial{});
+        gpuMaterials_[0].baseColorTexture = white;
+        for (size_t i = 0; i < materialTextures_.size(); ++i) {
+            GpuMaterial& gm = gpuMaterials_[i + 1];
+            std::memcpy(gm.baseColorFactor, &materialFactors_[i][0], sizeof(gm.baseColorFactor));
+            gm.baseColorTexture = textures_.slot(materialTextures_[i]);
+        }
+        if (indirect) { sceneQueue_.push(sortkey::opaque(DrawPass::Opaque, kMeshPipeline, 0, 0), kAllMeshDraws); return; }
     }
 
-    vkUnmapMemory(device_, meshVboMem_);
-    return true;
+    // Draws are keyed by material and nearest-instance depth, so after sorting each material's
+    // draws are contiguous and run front to back; the queue elides redundant binds
+    sceneQueue_.reserve(sceneQueue_.size() + meshDraws_.size());
+    float* nearest = frameArena_.allocArray<float>(meshDraws_.size());
+    std::fill(nearest, nearest + meshDraws_.size(), FLT_MAX);
+    const float* m = vp_; // row 3 of the column-major view-projection gives view depth
+    for (const auto& inst : meshInstances_) {
+        float w = m[3] * inst.center.x + m[7] * inst.center.y + m[11] * inst.center.z + m[15];
+        nearest[inst.draw] = std::min(nearest[inst.draw], w - inst.radius);
+    }
+    for (uint32_t i = 0; i < (uint32_t)meshDraws_.size(); ++i) {
+        const MeshDraw& d = meshDraws_[i];
+        if (d.instanceCount == 0) continue;
+        bool hasMaterial = d.material >= 0 && d.material < (int)materialTextures_.size();
+        sceneQueue_.push(sortkey::opaque(DrawPass::Opaque, kMeshPipeline, hasMaterial ? (uint32_t)d.material + 1 : 0,
+                                         sortkey::quantizeDepth(nearest[i], farPlane_)), i);
+    }
 }
 
-void VulkanRenderer::renderMeshes(VkCommandBuffer cmd) {
-    if (!meshPipeline_ || !meshVbo_ || meshVertexCount_ == 0) return;
+void VulkanRenderer::queueOccluders() {
+    // Occluders are picked per frame by projected size: only instances covering a good part of the
+    // screen pay for being drawn twice. They are not culled, the hardware clips what is off screen.
+    constexpr float kMinScreenFraction = 0.25f;
+    constexpr size_t kMaxOccluders = 32;
+    if (!depthPrepassPipeline_ || meshInstances_.empty()) return;
+    occluders_.clear();
+    float minPx = renderExtent_.height * kMinScreenFraction;
+    for (uint32_t i = 0; i < (uint32_t)meshInstances_.size(); ++i)
+        if (meshDraws_[meshInstances_[i].draw].indexCount > 0 && projectedDiameterPx(meshInstances_[i]) >= minPx) occluders_.push_back(i);
+    if (occluders_.size() > kMaxOccluders) {
+        std::partial_sort(occluders_.begin(), occluders_.begin() + kMaxOccluders, occluders_.end(), [&](uint32_t a, uint32_t b) {
+            return projectedDiameterPx(meshInstances_[a]) > projectedDiameterPx(meshInstances_[b]);
+        });
+        occluders_.resize(kMaxOccluders);
+    }
+    const float* m = vp_;
+    for (uint32_t i : occluders_) {
+        const MeshInstance& inst = meshInstances_[i];
+        float w = m[3] * inst.center.x + m[7] * inst.center.y + m[11] * inst.center.z + m[15];
+        sceneQueue_.push(sortkey::opaque(DrawPass::DepthPrepass, kPrepassPipeline, 0, sortkey::quantizeDepth(w - inst.radius, farPlane_)), i);
+    }
+}
 
-    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, meshPipeline_);
+void VulkanRenderer::submitScene(VkCommandBuffer cmd, bool indirect) {
+    // Indexed by the pipeline id in the key
+    const VkPipeline pipelines[] = { depthPrepassPipeline_, meshPipeline_, pipeline_ };
+    static const char* const passNames[] = { "depth prepass", "mesh pass", "terrain pass" };
 
     struct Push { float vp[16]; float pc0[4]; float lightDir[4]; float lightColor[4]; } push{};
     std::memcpy(push.vp, vp_, sizeof(vp_));
-    push.pc0[0] = 1.0f;
     push.lightDir[0] = lightDir_[0]; push.lightDir[1] = lightDir_[1]; push.lightDir[2] = lightDir_[2];
     push.lightColor[0] = lightColor_[0]; push.lightColor[1] = lightColor_[1];
     push.lightColor[2] = lightColor_[2]; push.lightColor[3] = lightIntensity_;
 
-    vkCmdPushConstants(cmd, pipeLayout_, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(Push), &push);
+    // Vertices come from the geometry arena, bound with the index buffer at the start of the render pass
+    // With GPU culling, indexed draws read their commands (instanceCount 0 when culled) from the culler
+    const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+    VkBuffer indirectBuf = culler_.indirectBuffer();
+    VkDeviceSize indirectBase = culler_.indirectOffset(curFrame_);
+
+    // Each pipeline change starts the next pass: its GPU timer scope and its push constants
+    uint32_t bound = UINT32_MAX, scope = UINT32_MAX;
+    VkDescriptorSet boundSet = VK_NULL_HANDLE;
+    bool materialReady = true;
+    queueStats_ = sceneQueue_.submit(
+        [&](uint32_t p) {
+            if (scope != UINT32_MAX) gpuProfiler_.endScope(cmd, scope);
+            scope = gpuProfiler_.beginScope(cmd, passNames[p]);
+            bound = p;
+            materialReady = true;
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelines[p]);
+            // The pre-pass reads only vp; pc0 is the mesh base color factor (replaced per material) or the terrain point size
+            if (p == kTerrainPipeline) { push.pc0[0] = pointSize_; push.pc0[1] = push.pc0[2] = push.pc0[3] = 0.0f; }
+            else push.pc0[0] = push.pc0[1] = push.pc0[2] = push.pc0[3] = 1.0f;
+            vkCmdPushConstants(cmd, pipeLayout_, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0,
+                               p == kPrepassPipeline ? sizeof(vp_) : sizeof(Push), &push);
+            if (p == kMeshPipeline && bindless_.enabled()) bindless_.bind(cmd, pipeLayout_, curFrame_, gpuMaterials_);
+        },
+        // Without bindless, mesh material changes rebind the base color texture (unless materials
+        // share it) and re-push only the factor (pc0); the other pipelines have no materials
+        [&](uint32_t key) {
+            if (bound != kMeshPipeline || bindless_.enabled()) return;
+            int material = (int)key - 1;
+            VkDescriptorSet set = textures_.descriptor(material >= 0 ? materialTextures_[material] : TextureStreamer::kWhite);
+            materialReady = set != VK_NULL_HANDLE; // not even the fallback texture is resident yet
+            if (!materialReady) return;
+            if (set != boundSet) {
+                vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeLayout_, 0, 1, &set, 0, nullptr);
+                boundSet = set;
+            }
+            glm::vec4 factor = material >= 0 ? materialFactors_[material] : glm::vec4(1.0f);
+            vkCmdPushConstants(cmd, pipeLayout_, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, offsetof(Push, pc0), sizeof(float) * 4, &factor[0]);
+        },
+        [&](uint32_t i) {
+            if (bound == kPrepassPipeline) {
+                const MeshDraw& d = meshDraws_[meshInstances_[i].draw];
+                vkCmdDrawIndexed(cmd, d.indexCount, 1, d.firstIndex, d.vertexOffset, instanceBase_ + i);
+                return;
+            }
+            if (bound == kTerrainPipeline) { vkCmdDraw(cmd, vertexCount_, 1, terrainRange_.first(sizeof(eng::terrain::Vertex)), 0); return; }
+            if (i == kAllMeshDraws) {
+                uint32_t n = culler_.drawCount();
+                if (multiDrawIndirect_) vkCmdDrawIndexedIndirect(cmd, indirectBuf, indirectBase, n, stride);
+                else for (uint32_t k = 0; k < n; ++k) vkCmdDrawIndexedIndirect(cmd, indirectBuf, indirectBase + k * stride, 1, stride);
+                for (const auto& d : meshDraws_)
+                    if (d.indexCount == 0) vkCmdDraw(cmd, d.vertexCount, d.instanceCount, d.firstVertex, d.firstInstance);
+                return;
+            }
+            if (!materialReady) return;
+            const MeshDraw& d = meshDraws_[i];
+            if (d.indexCount > 0) {
+                if (indirect && d.cullIndex != UINT32_MAX) {
+                    // One command per instance, visible ones with instanceCount 1
+                    VkDeviceSize first = indirectBase + d.cullIndex * stride;
+                    if (multiDrawIndirect_) vkCmdDrawIndexedIndirect(cmd, indirectBuf, first, d.instanceCount, stride);
+                    else for (uint32_t k = 0; k < d.instanceCount; ++k) vkCmdDrawIndexedIndirect(cmd, indirectBuf, first + k * stride, 1, stride);
+                }
+                else vkCmdDrawIndexed(cmd, d.indexCount, d.instanceCount, d.firstIndex, d.vertexOffset, d.firstInstance);
+            }
+            else vkCmdDraw(cmd, d.vertexCount, d.instanceCount, d.firstVertex, d.firstInstance);
+        });
+    if (scope != UINT32_MAX) gpuProfiler_.endScope(cmd, scope);
+}
 
-    VkDeviceSize vboOffset = 0;
-    vkCmdBindVertexBuffers(cmd, 0, 1, &meshVbo_, &vboOffset);
+float VulkanRenderer::projectedDiameterPx(const MeshInstance& inst) const {
+    // Projected diameter of the instance's bounding sphere in pixels; negative when entirely behind the camera.
+    // vp_ is column-major; with an orthonormal view, |row 1| is the projection's y scale and row 3 yields view depth.
+    const float* m = vp_;
+    float yScale = std::sqrt(m[1] * m[1] + m[5] * m[5] + m[9] * m[9]);
+    float w = m[3] * inst.center.x + m[7] * inst.center.y + m[11] * inst.center.z + m[15];
+    if (w < -inst.radius) return -1.0f;
+    return w > inst.radius ? 2.0f * inst.radius * yScale / w * (renderExtent_.height * 0.5f)
+                           : 65536.0f; // camera inside the bounds
+}
 
-    if (meshIbo_ && meshIndexCount_ > 0) {
-        vkCmdBindIndexBuffer(cmd, meshIbo_, 0, VK_INDEX_TYPE_UINT32);
-        vkCmdDrawIndexed(cmd, meshIndexCount_, 1, 0, 0, 0);
-    } else {
-        vkCmdDraw(cmd, meshVertexCount_, 1, 0, 0);
+void VulkanRenderer::requestMeshTextures() {
+    // Screen-space feedback for the texture streamer: projected diameter of each instance's bounds
+    // divided by its mesh's UV extent gives the screen pixels per UV unit its material texture covers.
+    // The streamer keeps the largest request, so the nearest instance decides.
+    if (meshInstances_.empty() || materialTextures_.empty()) return;
+    for (const auto& inst : meshInstances_) {
+        const MeshDraw& d = meshDraws_[inst.draw];
+        if (d.material < 0 || d.material >= (int)materialTextures_.size()) continue;
+        float diameterPx = projectedDiameterPx(inst);
+        if (diameterPx < 0.0f) continue;
+        textures_.request(materialTextures_[d.material], diameterPx / d.uvSpan);
     }
 }
 
 void VulkanRenderer::loadGltfMeshes(const std::vector<eng::scene::Mesh>& meshes) {
+    ENG_PROFILE_FUNCTION();
     // Try to create mesh pipeline if it doesn't exist
     if (!meshPipeline_) {
-        createMeshPipeline("shaders");
+        createMeshPipeline();
     }
 
     if (!meshPipeline_) {
-        throw std::runtime_error("Failed to create mesh pipeline - mesh shaders not found");
+        throw std::runtime_error("Failed to create mesh pipeline");
     }
 
     if (!createMeshGeometry(meshes)) {
@@ -707,22 +1192,51 @@ void VulkanRenderer::loadGltfMeshes(const std::vector<eng::scene::Mesh>& meshes)
     }
 }
 
+void VulkanRenderer::loadGltfScene(eng::scene::Scene scene) {
+    ENG_PROFILE_FUNCTION();
+    // Only base color images are streamed for now; each is added once however many materials share it
+    std::vector<TextureStreamer::Handle> imageTextures(scene.images.size(), TextureStreamer::kWhite);
+    std::vector<bool> added(scene.images.size(), false);
+    materialTextures_.clear();
+    materialFactors_.clear();
+    for (const auto& mat : scene.materials) {
+        TextureStreamer::Handle tex = TextureStreamer::kWhite;
+        int img = mat.baseColorImage;
+        if (img >= 0 && img < (int)scene.images.size()) {
+            if (!added[img]) {
+                imageTextures[img] = textures_.add(std::move(scene.images[img].encoded), scene.images[img].name);
+                added[img] = true;
+            }
+            tex = imageTextures[img];
+        }
+        materialTextures_.push_back(tex);
+        materialFactors_.push_back(mat.baseColorFactor);
+    }
+    loadGltfMeshes(scene.meshes);
+}
+
 VkFormat VulkanRenderer::findDepthFormat() {
+    // Prefer a format that can also be sampled, which the Hi-Z pyramid build needs
     VkFormat candidates[] = { VK_FORMAT_D32_SFLOAT, VK_FORMAT_D24_UNORM_S8_UINT, VK_FORMAT_D16_UNORM };
-    for (VkFormat f : candidates) {
-        VkFormatProperties props{}; vkGetPhysicalDeviceFormatProperties(physical_, f, &props);
-        if (props.optimalTilingFeatures & VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT) return f;
+    const VkFormatFeatureFlags attach = VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    for (VkFormatFeatureFlags need : { attach | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT, attach }) {
+        for (VkFormat f : candidates) {
+            VkFormatProperties props{}; vkGetPhysicalDeviceFormatProperties(physical_, f, &props);
+            if ((props.optimalTilingFeatures & need) == need) { depthSampled_ = (need & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT) != 0; return f; }
+        }
     }
+    depthSampled_ = false;
     return VK_FORMAT_D32_SFLOAT;
 }
 
 bool VulkanRenderer::createDepthResources() {
+    ENG_PROFILE_FUNCTION();
     VkImageCreateInfo ici{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
     ici.imageType = VK_IMAGE_TYPE_2D;
     ici.format = depthFormat_;
     ici.extent = { swapExtent_.width, swapExtent_.height, 1 };
     ici.mipLevels = 1; ici.arrayLayers = 1; ici.samples = VK_SAMPLE_COUNT_1_BIT;
-    ici.tiling = VK_IMAGE_TILING_OPTIMAL; ici.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL; ici.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | (depthSampled_ ? VK_IMAGE_USAGE_SAMPLED_BIT : 0);
     if (vkCreateImage(device_, &ici, nullptr, &depthImage_) != VK_SUCCESS) return false;
     VkMemoryRequirements mr{}; vkGetImageMemoryRequirements(device_, depthImage_, &mr);
     VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
@@ -736,6 +1250,34 @@ bool VulkanRenderer::createDepthResources() {
     return true;
 }
 
+bool VulkanRenderer::createSceneColor() {
+    ENG_PROFILE_FUNCTION();
+    // Allocated at the full swapchain extent once; dynamic resolution only shrinks the render area
+    VkImageCreateInfo ici{VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    ici.imageType = VK_IMAGE_TYPE_2D;
+    ici.format = swapFormat_;
+    ici.extent = { swapExtent_.width, swapExtent_.height, 1 };
+    ici.mipLevels = 1; ici.arrayLayers = 1; ici.samples = VK_SAMPLE_COUNT_1_BIT;
+    ici.tiling = VK_IMAGE_TILING_OPTIMAL; ici.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    if (vkCreateImage(device_, &ici, nullptr, &sceneColor_) != VK_SUCCESS) return false;
+    VkMemoryRequirements mr{}; vkGetImageMemoryRequirements(device_, sceneColor_, &mr);
+    VkMemoryAllocateInfo mai{VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO};
+    mai.allocationSize = mr.size; mai.memoryTypeIndex = findMemoryType(mr.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (vkAllocateMemory(device_, &mai, nullptr, &sceneColorMem_) != VK_SUCCESS) return false;
+    vkBindImageMemory(device_, sceneColor_, sceneColorMem_, 0);
+    VkImageViewCreateInfo vci{VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO};
+    vci.image = sceneColor_; vci.viewType = VK_IMAGE_VIEW_TYPE_2D; vci.format = swapFormat_;
+    vci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT; vci.subresourceRange.levelCount = 1; vci.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device_, &vci, nullptr, &sceneColorView_) != VK_SUCCESS) return false;
+    return true;
+}
+
+void VulkanRenderer::destroySceneColor() {
+    if (sceneColorView_) { vkDestroyImageView(device_, sceneColorView_, nullptr); sceneColorView_ = VK_NULL_HANDLE; }
+    if (sceneColor_) { vkDestroyImage(device_, sceneColor_, nullptr); sceneColor_ = VK_NULL_HANDLE; }
+    if (sceneColorMem_) { vkFreeMemory(device_, sceneColorMem_, nullptr); sceneColorMem_ = VK_NULL_HANDLE; }
+}
+
 void VulkanRenderer::destroyDepthResources() {
     if (depthView_) { vkDestroyImageView(device_, depthView_, nullptr); depthView_ = VK_NULL_HANDLE; }
     if (depthImage_) { vkDestroyImage(device_, depthImage_, nullptr); depthImage_ = VK_NULL_HANDLE; }
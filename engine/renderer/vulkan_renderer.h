@@ -1,12 +1,28 @@
 #pragma once
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <string>
 #include <optional>
 #include <cstring>
+#include <mutex>
 #include <glm/glm.hpp>
+#include "shader_registry.h"
+#include "deletion_queue.h"
+#include "gpu_profiler.h"
+#include "texture_streamer.h"
+#include "bindless.h"
+#include "occlusion_culler.h"
+#include "clustered_lighting.h"
+#include "render_queue.h"
+#include "geometry_arena.h"
+#include "mesh_packing.h"
+#include "dynamic_resolution.h"
+#include "../core/memory.h"
+#include "../platform/async_io.h"
 struct GLFWwindow;
 
-namespace eng::scene { struct Mesh; }
+namespace eng::scene { struct Mesh; struct Scene; struct PointLight; struct SpotLight; }
+namespace eng::terrain { struct Vertex; }
 
 namespace eng::renderer {
     class VulkanRenderer {
@@ -16,10 +32,42 @@ namespace eng::renderer {
         bool drawFrame(float clearR=0.02f, float clearG=0.02f, float clearB=0.08f);
         void waitIdle();
         void setVP(const float* vp16);
+        // View and projection separately (column-major), as clustered lighting needs both; also sets the VP
+        void setCamera(const float* view16, const float* proj16, float nearPlane, float farPlane);
         void setPointSize(float sz) { pointSize_ = sz; }
+        void setPipelineCachePath(std::string path) { pipelineCachePath_ = std::move(path); } // before initialize(); empty disables persistence
+        // $VKTHING_PIPELINE_CACHE if set, else pipeline_cache.bin in the per-user cache directory
+        // (%LOCALAPPDATA%, ~/Library/Caches or $XDG_CACHE_HOME, under vkthing/), else in the temp directory
+        static std::string defaultPipelineCachePath();
+
+        // Rolling GPU timings per pass; also logged periodically (see GpuProfiler::setLogInterval)
+        GpuProfiler& gpuProfiler() { return gpuProfiler_; }
+        // Texture residency (budget, stats)
+        TextureStreamer& textures() { return textures_; }
+        // Vertex/index/instance storage of every mesh and the terrain (usage via allocator())
+        const GeometryArena& geometry() const { return geometry_; }
+        // GPU frustum + Hi-Z occlusion culling of mesh draws, and a depth-only pass for large occluders
+        void setOcclusionCulling(bool on) { occlusionCulling_ = on; }
+        void setDepthPrepass(bool on) { depthPrepass_ = on; }
+        OcclusionStats occlusionStats() const { return culler_.stats(); }
+        // Mesh pass binds issued vs elided by the sorted render queue, last recorded frame
+        RenderQueueStats renderQueueStats() const { return queueStats_; }
+        // Render scale driven by the GPU frame time: the scene is drawn into a sub-rect of a full-size
+        // target and upscaled into the swapchain image. Disabled renders at full resolution.
+        void setDynamicResolution(bool on) { dynamicResolution_ = on; if (!on) dynRes_.reset(); }
+        DynamicResolution& dynamicResolution() { return dynRes_; }
+        VkExtent2D renderExtent() const { return renderExtent_; }
+        // Local lights shading meshes and terrain through the clustered light grid (up to kMaxLights in total)
+        void setLights(const std::vector<eng::scene::PointLight>& points, const std::vector<eng::scene::SpotLight>& spots);
+
+        // Terrain point cloud (see eng::terrain::generate); replaces any previous terrain. Like the glTF
+        // loaders below it may be called at any time after initialize(), e.g. once a background load finishes.
+        bool loadTerrain(const std::vector<eng::terrain::Vertex>& vertices);
 
         // GLTF mesh support
         void loadGltfMeshes(const std::vector<eng::scene::Mesh>& meshes);
+        // Meshes plus materials; images are handed to the texture streamer and appear as they decode
+        void loadGltfScene(eng::scene::Scene scene);
     private:
         GLFWwindow* window_ = nullptr;
         VkInstance instance_{};
@@ -28,15 +76,25 @@ namespace eng::renderer {
         VkPhysicalDevice physical_{};
         VkDevice device_{};
         uint32_t graphicsQueueFamily_ = 0;
+        bool pipelineStatsSupported_ = false;
+        bool bindlessSupported_ = false;      // descriptor indexing features enabled on the device
+        bool multiDrawIndirect_ = false, drawIndirectFirstInstance_ = false;
         VkQueue graphicsQueue_{};
         VkQueue presentQueue_{};
         VkSwapchainKHR swapchain_{};
         VkFormat swapFormat_{};
         VkExtent2D swapExtent_{};
         std::vector<VkImage> swapImages_;
-        std::vector<VkImageView> swapViews_;
+        // The scene renders into an offscreen color + depth pair sized to the swapchain, using only the
+        // renderExtent_ sub-rect, then is blitted (scaled) into the acquired swapchain image
         VkRenderPass renderPass_{};
-        std::vector<VkFramebuffer> framebuffers_;
+        VkFramebuffer sceneFramebuffer_{};
+        VkImage sceneColor_{}; VkDeviceMemory sceneColorMem_{}; VkImageView sceneColorView_{};
+        VkFilter upscaleFilter_ = VK_FILTER_LINEAR;
+        DynamicResolution dynRes_;
+        bool dynamicResolution_ = true;
+        uint64_t dynResSample_ = 0;          // GPU profiler sample count last fed to dynRes_
+        VkExtent2D renderExtent_{};
         VkCommandPool cmdPool_{};
         std::vector<VkCommandBuffer> cmdBufs_;
         static constexpr int kMaxFrames = 2;
@@ -44,20 +102,67 @@ namespace eng::renderer {
         std::vector<VkSemaphore> semImageAvail_;
         std::vector<VkSemaphore> semRenderFinish_;
         std::vector<VkFence> inFlight_;
+        // Pipeline cache shared by all pipeline creation, persisted across runs
+        VkPipelineCache pipelineCache_{};
+        std::string pipelineCachePath_ = defaultPipelineCachePath();
+        std::future<eng::io::FileData> pipelineCacheBlob_; // read while the device is being created
+        bool pipelineCacheWarm_ = false;
+        ShaderRegistry shaders_;
+        GpuProfiler gpuProfiler_;
+        TextureStreamer textures_;
+        BindlessDescriptors bindless_;        // mesh pass descriptors when supported, else per-material sets
+        std::vector<GpuMaterial> gpuMaterials_;
+        OcclusionCuller culler_;              // needs a sampleable depth format
+        bool occlusionCulling_ = true, depthPrepass_ = true;
+        ClusteredLighting lighting_;          // descriptor set 2 of pipeLayout_
+        VkDescriptorSetLayout emptySetLayout_{}; // fills set 1 when the material buffer is not bindless
+        float view_[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1}, proj_[16] = {1,0,0,0, 0,1,0,0, 0,0,1,0, 0,0,0,1};
+        float nearPlane_ = 0.1f, farPlane_ = 2000.0f;
+        // Hot-reloaded pipelines built off-thread, swapped in at the next frame boundary
+        std::mutex reloadMutex_;
+        VkPipeline pendingTerrainPipeline_{}, pendingMeshPipeline_{}, pendingPrepassPipeline_{};
+        VkPipeline pendingReducePipeline_{}, pendingCullPipeline_{}, pendingClusterPipeline_{};
+        // Objects retired while frames may still reference them (pipelines, old swapchains)
+        DeletionQueue deletions_;
+        uint64_t frameIndex_ = 0;
+        bool swapchainDirty_ = false;
         // Terrain pipeline + geometry
         VkPipelineLayout pipeLayout_{};
         VkPipeline pipeline_{};
-        VkBuffer vbo_{}; VkDeviceMemory vboMem_{}; uint32_t vertexCount_ = 0;
+        GeometryRange terrainRange_; uint32_t vertexCount_ = 0;
         float vp_[16] = {0}; float pointSize_ = 3.0f;
         // Mesh pipeline + geometry
         VkPipeline meshPipeline_{};
-        VkBuffer meshVbo_{}; VkDeviceMemory meshVboMem_{};
-        VkBuffer meshIbo_{}; VkDeviceMemory meshIboMem_{};
+        VkPipeline depthPrepassPipeline_{};   // mesh.vert only, depth writes, no color
+        // All vertex, index and instance data lives in one arena that shaders pull vertices from
+        GeometryArena geometry_;
         uint32_t meshVertexCount_ = 0;
-        uint32_t meshIndexCount_ = 0;
-        std::vector<glm::mat4> meshTransforms_;
+        // One instanced draw per unique mesh so each can bind its material. Instance transforms (and the
+        // bindless material index) are read from instanceRange_ through gl_InstanceIndex.
+        struct MeshDraw {
+            GeometryRange vertices, indices;  // this mesh's arena ranges
+            uint32_t firstIndex = 0, indexCount = 0, firstVertex = 0, vertexCount = 0; // arena element indices
+            int32_t vertexOffset = 0;         // == firstVertex, for indexed draws
+            uint32_t firstInstance = 0, instanceCount = 0; // arena instance index; local index in meshInstances_ is firstInstance - instanceBase_
+            int material = -1;
+            float uvSpan = 1.0f; // largest UV extent across the mesh
+            uint32_t cullIndex = UINT32_MAX; // first of instanceCount consecutive indirect commands; indexed draws only
+        };
+        // World-space bounds per instance drive culling, occluder selection and texture streaming feedback
+        using MeshInstance = PackedInstance;
+        std::vector<MeshDraw> meshDraws_;
+        std::vector<MeshInstance> meshInstances_;
+        GeometryRange instanceRange_; uint32_t instanceBase_ = 0;
+        std::vector<uint32_t> occluders_;     // meshInstances_ indices drawn by the depth pre-pass this frame
+        RenderQueue sceneQueue_;              // pre-pass, mesh and terrain draws sorted by pass, pipeline, material, depth
+        RenderQueueStats queueStats_;
+        eng::memory::FrameArena frameArena_{kMaxFrames, 256 * 1024}; // per-frame scratch, reset when its frame slot is reused
+        // Materials: base color texture in the streamer + factor (pushed in pc0)
+        std::vector<TextureStreamer::Handle> materialTextures_;
+        std::vector<glm::vec4> materialFactors_;
         // Depth
         VkImage depthImage_{}; VkDeviceMemory depthMem_{}; VkImageView depthView_{}; VkFormat depthFormat_{};
+        bool depthSampled_ = false;           // depth format supports sampling (Hi-Z pyramid input)
         // Light
         float lightDir_[3] = {-0.5f,-1.0f,-0.25f};
         float lightColor_[3] = {1.0f, 0.98f, 0.9f};
@@ -68,27 +173,46 @@ namespace eng::renderer {
         bool createSurface();
         bool pickPhysicalDevice();
         bool createDevice();
-        bool createSwapchain();
-        bool createImageViews();
+        bool createSwapchain(VkSwapchainKHR oldSwapchain);
         bool createRenderPass();
+        bool createSceneColor();
+        void destroySceneColor();
         bool createFramebuffers();
         bool createCommands();
         bool createSync();
         void cleanupSwapchain();
         bool recreateSwapchain();
+        void recordFrame(VkCommandBuffer cmd, uint32_t imageIndex, float r, float g, float b);
+        void updateRenderExtent();
+        void upscaleToSwapchain(VkCommandBuffer cmd, uint32_t imageIndex);
+        bool createPipelineCache();
+        void savePipelineCache();
 
         // helpers
         uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags props);
-        bool createTerrainPipeline(const char* shaderDir);
-        bool createTerrainGeometry();
+        bool createPipelineLayout();
+        bool createTerrainPipeline();
+        bool buildTerrainPipeline(VkPipeline& out);
         VkFormat findDepthFormat();
         bool createDepthResources();
         void destroyDepthResources();
 
         // Mesh pipeline methods
-        bool createMeshPipeline(const char* shaderDir);
+        bool createMeshPipeline();
+        bool buildMeshPipeline(VkPipeline& out, bool depthOnly = false);
         bool createMeshGeometry(const std::vector<eng::scene::Mesh>& meshes);
-        void renderMeshes(VkCommandBuffer cmd);
+        void releaseMeshGeometry(); // ranges return to the arena once in-flight frames are done
+        void queueMeshes(bool indirect);
+        void queueOccluders();
+        void submitScene(VkCommandBuffer cmd, bool indirect);
+        bool meshCullingActive() const;
+        uint32_t bindlessMaterial(int material) const;
+        float projectedDiameterPx(const MeshInstance& inst) const;
+        void requestMeshTextures();
+
+        // Shader hot reload
+        void onShaderReloaded(ShaderId id);
+        void applyReloadedPipelines();
     public:
         void setLight(const float dir[3], const float color[3], float intensity) {
             std::memcpy(lightDir_, dir, sizeof(lightDir_));
@@ -0,0 +1,318 @@
+#include "bvh.h"
+#include "gltf_loader.h"
+#include "../core/jobs.h"
+#include "../core/profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENG_BVH_SSE2 1
+#endif
+
+namespace eng::scene {
+
+static constexpr uint32_t kBins = 12;
+static constexpr uint32_t kMaxLeafTris = 4, kMaxLeafInstances = 1;
+static constexpr uint32_t kMaxDepth = 48; // traversal stacks are sized for this; deeper ranges stay leaves
+
+static void setBounds(BvhNode& n, const Aabb& b) {
+    n.lo[0] = b.lo.x; n.lo[1] = b.lo.y; n.lo[2] = b.lo.z;
+    n.hi[0] = b.hi.x; n.hi[1] = b.hi.y; n.hi[2] = b.hi.z;
+}
+
+static Aabb nodeBounds(const BvhNode& n) {
+    return { glm::vec3(n.lo[0], n.lo[1], n.lo[2]), glm::vec3(n.hi[0], n.hi[1], n.hi[2]) };
+}
+
+// Top-down binned SAH build. `order` holds primitive ids and is permuted so every leaf covers a
+// contiguous range of it. Split cost is 1 (traversal) + (A_l N_l + A_r N_r) / A against N for a
+// leaf; ranges above maxLeaf are split even when SAH prefers a leaf (unless kMaxDepth is reached).
+static void buildTree(const std::vector<Aabb>& boxes, std::vector<uint32_t>& order, std::vector<BvhNode>& nodes, uint32_t maxLeaf) {
+    nodes.clear();
+    nodes.reserve(order.empty() ? 1 : 2 * order.size());
+    std::vector<glm::vec3> centers(boxes.size());
+    for (size_t i = 0; i < boxes.size(); ++i) centers[i] = (boxes[i].lo + boxes[i].hi) * 0.5f;
+    nodes.push_back({});
+    struct Task { uint32_t node, first, count, depth; };
+    std::vector<Task> work{ { 0, 0, (uint32_t)order.size(), 0 } };
+    while (!work.empty()) {
+        Task task = work.back(); work.pop_back();
+        Aabb bounds, centroids;
+        for (uint32_t i = task.first; i < task.first + task.count; ++i) {
+            bounds.grow(boxes[order[i]]); centroids.grow(centers[order[i]]);
+        }
+        BvhNode& node = nodes[task.node];
+        setBounds(node, bounds);
+        node.first = task.first; node.count = task.count;
+        if (task.count <= 1 || task.depth >= kMaxDepth) continue;
+
+        int bestAxis = -1; uint32_t bestSplit = 0; float bestCost = FLT_MAX;
+        glm::vec3 extent = centroids.hi - centroids.lo;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (extent[axis] <= 0.0f) continue;
+            Aabb binBox[kBins]; uint32_t binCount[kBins] = {};
+            float scale = kBins / extent[axis];
+            for (uint32_t i = task.first; i < task.first + task.count; ++i) {
+                uint32_t bin = std::min((uint32_t)((centers[order[i]][axis] - centroids.lo[axis]) * scale), kBins - 1);
+                binBox[bin].grow(boxes[order[i]]); ++binCount[bin];
+            }
+            // Sweep from the right to get every suffix, then from the left evaluating each plane
+            float rightArea[kBins]; uint32_t rightCount[kBins];
+            Aabb acc; uint32_t n = 0;
+            for (uint32_t i = kBins - 1; i > 0; --i) { acc.grow(binBox[i]); n += binCount[i]; rightArea[i] = acc.area(); rightCount[i] = n; }
+            acc = Aabb(); n = 0;
+            for (uint32_t i = 0; i + 1 < kBins; ++i) {
+                acc.grow(binBox[i]); n += binCount[i];
+                if (n == 0 || rightCount[i + 1] == 0) continue;
+                float cost = acc.area() * n + rightArea[i + 1] * rightCount[i + 1];
+                if (cost < bestCost) { bestCost = cost; bestAxis = axis; bestSplit = i + 1; }
+            }
+        }
+        float area = bounds.area();
+        float splitCost = bestAxis >= 0 && area > 0.0f ? 1.0f + bestCost / area : FLT_MAX;
+        if (splitCost >= (float)task.count && task.count <= maxLeaf) continue;
+
+        uint32_t mid;
+        if (bestAxis >= 0) {
+            float scale = kBins / extent[bestAxis];
+            auto begin = order.begin() + task.first;
+            mid = task.first + (uint32_t)(std::partition(begin, begin + task.count, [&](uint32_t p) {
+                return std::min((uint32_t)((centers[p][bestAxis] - centroids.lo[bestAxis]) * scale), kBins - 1) < bestSplit;
+            }) - begin);
+        } else {
+            mid = task.first + task.count / 2; // all centroids coincide: any split is as good
+        }
+        uint32_t left = (uint32_t)nodes.size();
+        nodes.push_back({}); nodes.push_back({});
+        BvhNode& parent = nodes[task.node]; // push_back may have moved it
+        parent.first = left; parent.count = 0;
+        work.push_back({ left + 1, mid, task.first + task.count - mid, task.depth + 1 });
+        work.push_back({ left, task.first, mid - task.first, task.depth + 1 });
+    }
+}
+
+// Ray with precomputed reciprocal direction, padded for 16-byte loads
+struct alignas(16) RayData {
+    float o[4], inv[4];
+    RayData(const glm::vec3& origin, const glm::vec3& dir) {
+        for (int a = 0; a < 3; ++a) { o[a] = origin[a]; inv[a] = dir[a] != 0.0f ? 1.0f / dir[a] : copysignf(FLT_MAX, dir[a]); }
+        o[3] = inv[3] = 0.0f;
+    }
+};
+
+// Entry distance of the ray into the node's box, or FLT_MAX when it misses within [0, tmax]
+static inline float hitBox(const BvhNode& n, const RayData& r, float tmax) {
+#ifdef ENG_BVH_SSE2
+    __m128 o = _mm_load_ps(r.o), inv = _mm_load_ps(r.inv);
+    __m128 t1 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.lo), o), inv);
+    __m128 t2 = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(n.hi), o), inv);
+    // Lane 3 holds first/count bits, not a coordinate: replace it with lane 0 before reducing
+    __m128 vmin = _mm_min_ps(t1, t2), vmax = _mm_max_ps(t1, t2);
+    vmin = _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(0, 2, 1, 0));
+    vmax = _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(0, 2, 1, 0));
+    vmin = _mm_max_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmin = _mm_max_ps(vmin, _mm_shuffle_ps(vmin, vmin, _MM_SHUFFLE(2, 3, 0, 1)));
+    vmax = _mm_min_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(1, 0, 3, 2)));
+    vmax = _mm_min_ps(vmax, _mm_shuffle_ps(vmax, vmax, _MM_SHUFFLE(2, 3, 0, 1)));
+    float tmin = std::max(_mm_cvtss_f32(vmin), 0.0f), tmax2 = std::min(_mm_cvtss_f32(vmax), tmax);
+#else
+    float tmin = 0.0f, tmax2 = tmax;
+    for (int a = 0; a < 3; ++a) {
+        float t1 = (n.lo[a] - r.o[a]) * r.inv[a], t2 = (n.hi[a] - r.o[a]) * r.inv[a];
+        tmin = std::max(tmin, std::min(t1, t2)); tmax2 = std::min(tmax2, std::max(t1, t2));
+    }
+#endif
+    return tmin <= tmax2 ? tmin : FLT_MAX;
+}
+
+// Moller-Trumbore; t in (tmin, tmax)
+static inline bool hitTriangle(const glm::vec3* v, const glm::vec3& o, const glm::vec3& d, float tmin, float tmax, float& t, float& u, float& w) {
+    glm::vec3 e1 = v[1] - v[0], e2 = v[2] - v[0];
+    glm::vec3 p = glm::cross(d, e2);
+    float det = glm::dot(e1, p);
+    if (std::abs(det) < 1e-12f) return false;
+    float invDet = 1.0f / det;
+    glm::vec3 s = o - v[0];
+    u = glm::dot(s, p) * invDet;
+    if (u < 0.0f || u > 1.0f) return false;
+    glm::vec3 q = glm::cross(s, e1);
+    w = glm::dot(d, q) * invDet;
+    if (w < 0.0f || u + w > 1.0f) return false;
+    t = glm::dot(e2, q) * invDet;
+    return t > tmin && t < tmax;
+}
+
+void Bvh::clear() {
+    blas_.clear(); instances_.clear(); tlas_.clear(); tlasIndex_.clear();
+}
+
+void Bvh::build(const std::vector<Mesh>& meshes) {
+    ENG_PROFILE_FUNCTION();
+    clear();
+    blas_.resize(meshes.size());
+
+    std::vector<uint32_t> order(meshes.size());
+    for (uint32_t i = 0; i < (uint32_t)order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return meshes[a].indices.size() > meshes[b].indices.size(); });
+    // One mesh per job; the largest are split off first, so a big mesh does not start last
+    eng::jobs::parallelFor(0, order.size(), [&](size_t begin, size_t end) {
+        ENG_PROFILE_SCOPE("bvh blas");
+        for (size_t j = begin; j < end; ++j) {
+            const Mesh& mesh = meshes[order[j]];
+            Blas& b = blas_[order[j]];
+            uint32_t triCount = (uint32_t)(mesh.indices.size() / 3);
+            std::vector<Aabb> boxes(triCount);
+            for (uint32_t t = 0; t < triCount; ++t)
+                for (int k = 0; k < 3; ++k) boxes[t].grow(mesh.vertices[mesh.indices[t * 3 + k]].position);
+            b.triIndex.resize(triCount);
+            for (uint32_t t = 0; t < triCount; ++t) b.triIndex[t] = t;
+            buildTree(boxes, b.triIndex, b.nodes, kMaxLeafTris);
+            // Positions copied in leaf order, so a leaf's triangles are one contiguous read
+            b.tris.resize((size_t)triCount * 3);
+            for (uint32_t t = 0; t < triCount; ++t)
+                for (int k = 0; k < 3; ++k) b.tris[(size_t)t * 3 + k] = mesh.vertices[mesh.indices[b.triIndex[t] * 3 + k]].position;
+        }
+    }, 1);
+
+    for (uint32_t m = 0; m < (uint32_t)meshes.size(); ++m)
+        for (const glm::mat4& xf : meshes[m].instances) {
+            Instance inst;
+            inst.mesh = m;
+            instances_.push_back(inst);
+            setTransform((uint32_t)instances_.size() - 1, xf);
+        }
+    buildTlas();
+}
+
+void Bvh::setTransform(uint32_t instance, const glm::mat4& transform) {
+    Instance& inst = instances_[instance];
+    inst.transform = transform;
+    inst.inverse = glm::inverse(transform);
+    inst.bounds = Aabb();
+    const Blas& b = blas_[inst.mesh];
+    if (b.nodes.empty() || b.tris.empty()) return;
+    // Transformed corners of the mesh box: looser than transforming every vertex, but O(1)
+    Aabb local = nodeBounds(b.nodes[0]);
+    for (int c = 0; c < 8; ++c) {
+        glm::vec3 p((c & 1) ? local.hi.x : local.lo.x, (c & 2) ? local.hi.y : local.lo.y, (c & 4) ? local.hi.z : local.lo.z);
+        inst.bounds.grow(glm::vec3(transform * glm::vec4(p, 1.0f)));
+    }
+}
+
+void Bvh::buildTlas() {
+    std::vector<Aabb> boxes(instances_.size());
+    for (size_t i = 0; i < instances_.size(); ++i) boxes[i] = instances_[i].bounds;
+    tlasIndex_.resize(instances_.size());
+    for (uint32_t i = 0; i < (uint32_t)tlasIndex_.size(); ++i) tlasIndex_[i] = i;
+    buildTree(boxes, tlasIndex_, tlas_, kMaxLeafInstances);
+}
+
+void Bvh::refit() {
+    ENG_PROFILE_FUNCTION();
+    if (tlas_.empty() || instances_.empty()) return; // a lone empty root has no children to read
+    // Children always follow their parent, so one reverse pass sees children first
+    for (size_t i = tlas_.size(); i-- > 0;) {
+        BvhNode& n = tlas_[i];
+        Aabb b;
+        if (n.count) for (uint32_t k = 0; k < n.count; ++k) b.grow(instances_[tlasIndex_[n.first + k]].bounds);
+        else { b.grow(nodeBounds(tlas_[n.first])); b.grow(nodeBounds(tlas_[n.first + 1])); }
+        setBounds(n, b);
+    }
+}
+
+template <bool AnyHit>
+bool Bvh::trace(const glm::vec3& origin, const glm::vec3& dir, float maxT, BvhHit& hit) const {
+    if (tlas_.empty() || instances_.empty()) return false;
+    const float tmin = AnyHit ? 1e-4f : 0.0f;
+    float best = maxT;
+    bool found = false;
+    RayData ray(origin, dir);
+    uint32_t stack[kMaxDepth + 2]; int sp = 0; // one pending sibling per level
+    uint32_t blasStack[kMaxDepth + 2];
+    if (hitBox(tlas_[0], ray, best) != FLT_MAX) stack[sp++] = 0;
+    while (sp > 0) {
+        const BvhNode& n = tlas_[stack[--sp]];
+        if (n.count == 0) {
+            // Nearer child on top of the stack
+            uint32_t a = n.first, b = n.first + 1;
+            float ta = hitBox(tlas_[a], ray, best), tb = hitBox(tlas_[b], ray, best);
+            if (ta > tb) { std::swap(a, b); std::swap(ta, tb); }
+            if (tb != FLT_MAX) stack[sp++] = b;
+            if (ta != FLT_MAX) stack[sp++] = a;
+            continue;
+        }
+        for (uint32_t k = 0; k < n.count; ++k) {
+            uint32_t ii = tlasIndex_[n.first + k];
+            const Instance& inst = instances_[ii];
+            const Blas& blas = blas_[inst.mesh];
+            if (blas.nodes.empty() || blas.tris.empty()) continue;
+            // Affine transforms keep t: the mesh-space ray is parameterized the same way
+            glm::vec3 o = glm::vec3(inst.inverse * glm::vec4(origin, 1.0f)), d = glm::vec3(inst.inverse * glm::vec4(dir, 0.0f));
+            RayData local(o, d);
+            int bsp = 0;
+            if (hitBox(blas.nodes[0], local, best) != FLT_MAX) blasStack[bsp++] = 0;
+            while (bsp > 0) {
+                const BvhNode& bn = blas.nodes[blasStack[--bsp]];
+                if (bn.count == 0) {
+                    uint32_t a = bn.first, b = bn.first + 1;
+                    float ta = hitBox(blas.nodes[a], local, best), tb = hitBox(blas.nodes[b], local, best);
+                    if (ta > tb) { std::swap(a, b); std::swap(ta, tb); }
+                    if (tb != FLT_MAX) blasStack[bsp++] = b;
+                    if (ta != FLT_MAX) blasStack[bsp++] = a;
+                    continue;
+                }
+                for (uint32_t t = bn.first; t < bn.first + bn.count; ++t) {
+                    float th, u, w;
+                    if (!hitTriangle(&blas.tris[(size_t)t * 3], o, d, tmin, best, th, u, w)) continue;
+                    best = th; found = true;
+                    hit.t = th; hit.instance = ii; hit.mesh = inst.mesh; hit.triangle = blas.triIndex[t]; hit.u = u; hit.v = w;
+                    if (AnyHit) return true;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+bool Bvh::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, BvhHit& hit) const {
+    return trace<false>(origin, dir, maxT, hit);
+}
+
+bool Bvh::occluded(const glm::vec3& from, const glm::vec3& to) const {
+    BvhHit hit;
+    return trace<true>(from, to - from, 1.0f - 1e-4f, hit);
+}
+
+void Bvh::query(const Aabb& box, std::vector<uint32_t>& out) const {
+    if (tlas_.empty() || instances_.empty()) return;
+    uint32_t stack[kMaxDepth + 2]; int sp = 0;
+    stack[sp++] = 0;
+    while (sp > 0) {
+        const BvhNode& n = tlas_[stack[--sp]];
+        if (!nodeBounds(n).overlaps(box)) continue;
+        if (n.count == 0) { stack[sp++] = n.first; stack[sp++] = n.first + 1; continue; }
+        for (uint32_t k = 0; k < n.count; ++k) {
+            uint32_t ii = tlasIndex_[n.first + k];
+            if (instances_[ii].bounds.overlaps(box)) out.push_back(ii);
+        }
+    }
+}
+
+Aabb Bvh::bounds() const {
+    return tlas_.empty() || instances_.empty() ? Aabb() : nodeBounds(tlas_[0]);
+}
+
+size_t Bvh::triangleCount() const {
+    size_t n = 0;
+    for (const auto& b : blas_) n += b.triIndex.size();
+    return n;
+}
+
+size_t Bvh::memoryBytes() const {
+    size_t bytes = tlas_.size() * sizeof(BvhNode) + tlasIndex_.size() * sizeof(uint32_t) + instances_.size() * sizeof(Instance);
+    for (const auto& b : blas_) bytes += b.nodes.size() * sizeof(BvhNode) + b.tris.size() * sizeof(glm::vec3) + b.triIndex.size() * sizeof(uint32_t);
+    return bytes;
+}
+
+} // namespace eng::scene
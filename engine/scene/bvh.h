@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+namespace eng::scene {
+    struct Mesh;
+
+    struct Aabb {
+        glm::vec3 lo{3.4e38f}, hi{-3.4e38f};
+        void grow(const glm::vec3& p) { lo = glm::min(lo, p); hi = glm::max(hi, p); }
+        void grow(const Aabb& b) { lo = glm::min(lo, b.lo); hi = glm::max(hi, b.hi); }
+        bool overlaps(const Aabb& b) const {
+            return lo.x <= b.hi.x && hi.x >= b.lo.x && lo.y <= b.hi.y && hi.y >= b.lo.y && lo.z <= b.hi.z && hi.z >= b.lo.z;
+        }
+        float area() const { glm::vec3 e = glm::max(hi - lo, glm::vec3(0.0f)); return 2.0f * (e.x * e.y + e.y * e.z + e.z * e.x); }
+    };
+
+    // Flattened node, 32 bytes so two share a cache line. Children of an interior node are stored
+    // next to each other (left at `first`, right at first + 1) and after their parent.
+    struct BvhNode {
+        float lo[3]; uint32_t first; // interior: left child; leaf: first primitive
+        float hi[3]; uint32_t count; // 0 = interior
+    };
+    static_assert(sizeof(BvhNode) == 32, "BvhNode is loaded as two 16-byte vectors");
+
+    struct BvhHit {
+        float t = 0.0f;                 // hit = origin + t * dir
+        uint32_t instance = UINT32_MAX; // index into Bvh::instances()
+        uint32_t mesh = UINT32_MAX;     // index into the meshes given to build()
+        uint32_t triangle = 0;          // triangle of that mesh (index into its indices / 3)
+        float u = 0.0f, v = 0.0f;       // barycentrics of vertices 1 and 2
+    };
+
+    // Two-level BVH over scene meshes for picking, line-of-sight and region queries.
+    // Each unique mesh gets a bottom-level tree over its triangles in mesh space (built once, in
+    // parallel across meshes, with binned SAH); the top level is a tree over every instance's
+    // world-space box. Moving instances only need setTransform() + refit(), which recomputes the
+    // top-level boxes without touching triangles. Queries are const and thread-safe.
+    //
+    //   Bvh bvh; bvh.build(scene.meshes);
+    //   BvhHit hit; if (bvh.raycast(origin, dir, 1000.0f, hit)) ...
+    //   bool visible = !bvh.occluded(eye, target);
+    class Bvh {
+    public:
+        struct Instance {
+            glm::mat4 transform{1.0f}, inverse{1.0f};
+            uint32_t mesh = 0;
+            Aabb bounds; // world space
+        };
+
+        // Bottom-level trees are built in parallel on the job system (serially before jobs::init)
+        void build(const std::vector<Mesh>& meshes);
+        void clear();
+
+        const std::vector<Instance>& instances() const { return instances_; }
+        void setTransform(uint32_t instance, const glm::mat4& transform);
+        void refit(); // after setTransform(); keeps the top-level topology, so quality degrades with large motion
+
+        // Nearest hit within maxT; dir need not be normalized
+        bool raycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, BvhHit& hit) const;
+        // Any hit strictly between from and to
+        bool occluded(const glm::vec3& from, const glm::vec3& to) const;
+        // Instances whose world box overlaps the box (appended)
+        void query(const Aabb& box, std::vector<uint32_t>& instances) const;
+
+        Aabb bounds() const;
+        size_t triangleCount() const;
+        size_t memoryBytes() const;
+    private:
+        struct Blas {
+            std::vector<BvhNode> nodes;
+            std::vector<glm::vec3> tris;     // three positions per triangle, in leaf order
+            std::vector<uint32_t> triIndex;  // leaf order -> mesh triangle
+        };
+        std::vector<Blas> blas_;
+        std::vector<Instance> instances_;
+        std::vector<BvhNode> tlas_;
+        std::vector<uint32_t> tlasIndex_;    // leaf order -> instance
+
+        void buildTlas();
+        template <bool AnyHit> bool trace(const glm::vec3& origin, const glm::vec3& dir, float maxT, BvhHit& hit) const;
+    };
+}
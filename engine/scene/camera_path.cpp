@@ -0,0 +1,71 @@
+#include "camera_path.h"
+#include "../core/log.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+namespace eng::scene {
+
+static constexpr char kMagic[4] = { 'C', 'A', 'M', 'P' };
+static constexpr uint32_t kVersion = 1;
+
+struct PathHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t sampleSize;
+    uint32_t count;
+};
+
+float CameraPath::duration() const {
+    // The first sample is the starting pose; each later one is reached its dt after the previous
+    float t = 0.0f;
+    for (size_t i = 1; i < samples_.size(); ++i) t += samples_[i].dt;
+    return t;
+}
+
+bool CameraPath::save(const std::string& path) const {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) { eng::log::error("Cannot write camera path '%s'", path); return false; }
+    PathHeader h{};
+    std::memcpy(h.magic, kMagic, sizeof(kMagic));
+    h.version = kVersion; h.sampleSize = sizeof(CameraSample); h.count = (uint32_t)samples_.size();
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1;
+    if (ok && !samples_.empty()) ok = std::fwrite(samples_.data(), sizeof(CameraSample), samples_.size(), f) == samples_.size();
+    ok = (std::fclose(f) == 0) && ok;
+    if (!ok) { eng::log::error("Failed to write camera path '%s'", path); return false; }
+    eng::log::info("Saved camera path '%s': %zu frames, %.1f s", path, samples_.size(), duration());
+    return true;
+}
+
+bool CameraPath::load(const std::string& path) {
+    samples_.clear(); cursor_ = 0; cursorTime_ = 0.0f;
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) { eng::log::error("Cannot open camera path '%s'", path); return false; }
+    PathHeader h{};
+    bool ok = std::fread(&h, sizeof(h), 1, f) == 1 && std::memcmp(h.magic, kMagic, sizeof(kMagic)) == 0 &&
+              h.version == kVersion && h.sampleSize == sizeof(CameraSample);
+    if (ok) {
+        samples_.resize(h.count);
+        ok = h.count == 0 || std::fread(samples_.data(), sizeof(CameraSample), h.count, f) == h.count;
+    }
+    std::fclose(f);
+    if (!ok) { samples_.clear(); eng::log::error("'%s' is not a version %u camera path", path, kVersion); return false; }
+    eng::log::info("Loaded camera path '%s': %zu frames, %.1f s", path, samples_.size(), duration());
+    return true;
+}
+
+void CameraPath::pose(float t, Camera& cam) const {
+    if (samples_.empty()) return;
+    if (t < cursorTime_) { cursor_ = 0; cursorTime_ = 0.0f; }
+    while (cursor_ + 1 < samples_.size() && cursorTime_ + samples_[cursor_ + 1].dt <= t) cursorTime_ += samples_[++cursor_].dt;
+    const CameraSample& a = samples_[cursor_];
+    if (cursor_ + 1 >= samples_.size() || t <= cursorTime_) { cam.position = a.position; cam.yaw = a.yaw; cam.pitch = a.pitch; return; }
+    const CameraSample& b = samples_[cursor_ + 1];
+    float k = b.dt > 0.0f ? (t - cursorTime_) / b.dt : 1.0f;
+    float dyaw = std::remainder(b.yaw - a.yaw, 6.28318531f);
+    cam.position = a.position + (b.position - a.position) * k;
+    cam.yaw = a.yaw + dyaw * k;
+    cam.pitch = a.pitch + (b.pitch - a.pitch) * k;
+}
+
+} // namespace eng::scene
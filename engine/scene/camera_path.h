@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "camera.h"
+
+namespace eng::scene {
+    // Movement keys held during a recorded frame
+    enum CameraKey : uint32_t {
+        KeyForward = 1u << 0, KeyBack = 1u << 1, KeyLeft = 1u << 2, KeyRight = 1u << 3, KeyUp = 1u << 4, KeyDown = 1u << 5,
+    };
+
+    // One recorded frame: the input that drove it, its wall-clock dt and the camera it produced
+    struct CameraSample {
+        float dt = 0.0f;
+        float mouseDx = 0.0f, mouseDy = 0.0f;
+        uint32_t keys = 0; // CameraKey bits
+        glm::vec3 position{0.0f};
+        float yaw = 0.0f, pitch = 0.0f;
+    };
+    static_assert(sizeof(CameraSample) == 36, "CameraSample is written to .campath files as-is");
+
+    // A flythrough recorded from live input, replayed at a fixed timestep so every run renders the
+    // same camera poses whatever the frame rate of the recording or the replaying machine.
+    // File: "CAMP" magic, version, sample size and count, then the packed samples (little endian).
+    class CameraPath {
+    public:
+        void clear() { samples_.clear(); }
+        void add(const CameraSample& s) { samples_.push_back(s); }
+        const std::vector<CameraSample>& samples() const { return samples_; }
+        bool empty() const { return samples_.empty(); }
+        float duration() const; // seconds from the first sample to the last
+
+        bool save(const std::string& path) const;
+        bool load(const std::string& path);
+
+        // Camera pose at time t (seconds after the first sample), interpolated between the recorded
+        // frames around it; clamped to the ends. Yaw takes the short way round.
+        void pose(float t, Camera& cam) const;
+    private:
+        std::vector<CameraSample> samples_;
+        mutable size_t cursor_ = 0;   // pose() is called with increasing t; resume the search here
+        mutable float cursorTime_ = 0.0f;
+    };
+}
@@ -1,12 +1,106 @@
 #include "gltf_loader.h"
+#include "../core/log.h"
+#include "../core/profiler.h"
+#include "../platform/async_io.h"
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
-#include <iostream>
+#include <cstring>
+#include <filesystem>
+#include <future>
 #include <stdexcept>
+#include <unordered_map>
 
 namespace eng::scene {
 
+// tinygltf decodes every image with stb_image while parsing, on the calling thread.
+// Keep the encoded bytes instead so decoding can happen later on worker threads.
+static bool keepEncodedImage(tinygltf::Image* image, const int, std::string*, std::string*,
+                             int, int, const unsigned char* bytes, int size, void*) {
+    image->image.assign(bytes, bytes + size);
+    image->width = image->height = image->component = 0;
+    return true;
+}
+
+static int textureImage(const tinygltf::Model& model, int textureIndex) {
+    if (textureIndex < 0 || textureIndex >= (int)model.textures.size()) return -1;
+    return model.textures[textureIndex].source;
+}
+
+// External files (buffers, images) are all requested from io in one batch as soon as the JSON is
+// in, so they load in parallel and overlap the parse. tinygltf still asks for them one at a time
+// through its file callback, which takes them from here; anything not prefetched is read directly.
+namespace {
+    struct Prefetch {
+        std::unordered_map<std::string, std::future<io::FileData>> files; // by the path tinygltf will ask for
+    };
+
+    std::string percentDecode(const std::string& s) {
+        std::string out;
+        for (size_t i = 0; i < s.size(); ++i) {
+            auto hex = [](char c) { return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1; };
+            if (s[i] == '%' && i + 2 < s.size() && hex(s[i + 1]) >= 0 && hex(s[i + 2]) >= 0) { out += (char)(hex(s[i + 1]) * 16 + hex(s[i + 2])); i += 2; }
+            else out += s[i];
+        }
+        return out;
+    }
+
+    // Every "uri" string value that names a file (data: URIs are embedded). A plain scan rather
+    // than a JSON parse: a miss only means that file is read when tinygltf gets to it.
+    std::vector<std::string> externalUris(const std::vector<uint8_t>& json) {
+        std::vector<std::string> uris;
+        const std::string text(json.begin(), json.end());
+        for (size_t at = text.find("\"uri\""); at != std::string::npos; at = text.find("\"uri\"", at + 5)) {
+            size_t q = text.find_first_not_of(" \t\r\n:", at + 5);
+            if (q == std::string::npos || text[q] != '"') continue;
+            std::string uri;
+            bool escaped = false;
+            for (size_t i = q + 1; i < text.size() && (escaped || text[i] != '"'); ++i) {
+                if (!escaped && text[i] == '\\') { escaped = true; continue; }
+                uri += text[i]; escaped = false;
+            }
+            if (!uri.empty() && uri.compare(0, 5, "data:") != 0) uris.push_back(percentDecode(uri));
+        }
+        return uris;
+    }
+
+    // tinygltf joins the glTF's directory and a URI this way before asking for the file
+    std::string joinPath(const std::string& gltfPath, const std::string& uri) {
+        size_t slash = gltfPath.find_last_of("/\\");
+        return slash == std::string::npos ? uri : gltfPath.substr(0, slash) + "/" + uri;
+    }
+
+    bool readWholeFile(std::vector<unsigned char>* out, std::string* err, const std::string& path, void* user) {
+        auto& prefetch = *static_cast<Prefetch*>(user);
+        auto it = prefetch.files.find(path);
+        io::FileData d;
+        if (it != prefetch.files.end()) { d = it->second.get(); prefetch.files.erase(it); }
+        else d = io::readNow(path);
+        if (!d.ok()) { if (err) *err += "File read error: " + path + ": " + std::strerror(d.error) + "\n"; return false; }
+        *out = std::move(d.bytes);
+        return true;
+    }
+
+    // Prefetched paths are kept verbatim so they match the keys; anything else gets tinygltf's
+    // usual ~ and environment variable expansion
+    std::string expandPath(const std::string& path, void* user) {
+        const auto& prefetch = *static_cast<const Prefetch*>(user);
+        return prefetch.files.count(path) ? path : tinygltf::ExpandFilePath(path, nullptr);
+    }
+
+    bool fileSize(size_t* out, std::string* err, const std::string& path, void*) {
+        std::error_code ec;
+        auto bytes = std::filesystem::file_size(path, ec);
+        if (ec) { if (err) *err += "File size error: " + path + ": " + ec.message() + "\n"; return false; }
+        *out = (size_t)bytes;
+        return true;
+    }
+
+    // tinygltf 2.8+ checks file sizes through a callback too; older versions have no such member
+    template <class Fs> auto setFileSizeCallback(Fs& fs, int) -> decltype(fs.GetFileSizeInBytes = &fileSize, void()) { fs.GetFileSizeInBytes = &fileSize; }
+    template <class Fs> void setFileSizeCallback(Fs&, long) {}
+}
+
 glm::mat4 GltfLoader::getNodeTransform(const tinygltf::Node& node) {
     glm::mat4 transform(1.0f);
 
@@ -141,7 +235,8 @@ void GltfLoader::processMesh(const tinygltf::Model& model,
         if (primitive.mode != TINYGLTF_MODE_TRIANGLES) continue; // Only triangles for now
 
         Mesh newMesh;
-        newMesh.transform = transform;
+        newMesh.instances.push_back(transform);
+        newMesh.material = primitive.material;
 
         extractMeshData(model, primitive, newMesh.vertices, newMesh.indices);
 
@@ -151,35 +246,121 @@ void GltfLoader::processMesh(const tinygltf::Model& model,
     }
 }
 
+void GltfLoader::extractMaterials(tinygltf::Model& model, Scene& out) {
+    out.materials.reserve(model.materials.size());
+    for (const auto& m : model.materials) {
+        const auto& pbr = m.pbrMetallicRoughness;
+        Material mat;
+        if (pbr.baseColorFactor.size() == 4) {
+            mat.baseColorFactor = glm::vec4(
+                static_cast<float>(pbr.baseColorFactor[0]),
+                static_cast<float>(pbr.baseColorFactor[1]),
+                static_cast<float>(pbr.baseColorFactor[2]),
+                static_cast<float>(pbr.baseColorFactor[3])
+            );
+        }
+        mat.metallicFactor = static_cast<float>(pbr.metallicFactor);
+        mat.roughnessFactor = static_cast<float>(pbr.roughnessFactor);
+        mat.baseColorImage = textureImage(model, pbr.baseColorTexture.index);
+        mat.normalImage = textureImage(model, m.normalTexture.index);
+        out.materials.push_back(mat);
+    }
+
+    out.images.reserve(model.images.size());
+    for (auto& img : model.images) {
+        ImageSource src;
+        src.name = img.name.empty() ? img.uri : img.name;
+        src.encoded = std::move(img.image);
+        out.images.push_back(std::move(src));
+    }
+}
+
+size_t Scene::instanceCount() const {
+    size_t n = 0;
+    for (const auto& m : meshes) n += m.instances.size();
+    return n;
+}
+
+size_t Scene::geometryBytes() const {
+    size_t bytes = 0;
+    for (const auto& m : meshes) bytes += m.vertices.size() * sizeof(MeshVertex) + m.indices.size() * sizeof(uint32_t);
+    return bytes;
+}
+
+size_t Scene::expandedGeometryBytes() const {
+    size_t bytes = 0;
+    for (const auto& m : meshes) bytes += (m.vertices.size() * sizeof(MeshVertex) + m.indices.size() * sizeof(uint32_t)) * m.instances.size();
+    return bytes;
+}
+
 std::vector<Mesh> GltfLoader::loadScene(const std::string& gltfPath) {
+    return load(gltfPath).meshes;
+}
+
+Scene GltfLoader::load(const std::string& gltfPath) {
+    ENG_PROFILE_FUNCTION();
     tinygltf::TinyGLTF loader;
     tinygltf::Model model;
     std::string err, warn;
-
-    bool ret = loader.LoadASCIIFromFile(&model, &err, &warn, gltfPath);
+    loader.SetImageLoader(keepEncodedImage, nullptr);
+
+    Prefetch prefetch;
+    {
+        ENG_PROFILE_SCOPE("gltf prefetch");
+        io::FileData json = io::readNow(gltfPath);
+        if (json.ok()) {
+            std::vector<std::string> paths;
+            for (const std::string& uri : externalUris(json.bytes)) paths.push_back(joinPath(gltfPath, uri));
+            auto futures = io::readBatch(paths);
+            for (size_t i = 0; i < paths.size(); ++i) prefetch.files.emplace(paths[i], std::move(futures[i]));
+            std::promise<io::FileData> ready;
+            ready.set_value(std::move(json));
+            prefetch.files[gltfPath] = ready.get_future();
+        }
+    }
+    tinygltf::FsCallbacks fs{};
+    fs.FileExists = &tinygltf::FileExists;
+    fs.ExpandFilePath = &expandPath;
+    fs.ReadWholeFile = &readWholeFile;
+    fs.WriteWholeFile = &tinygltf::WriteWholeFile;
+    setFileSizeCallback(fs, 0);
+    fs.user_data = &prefetch;
+    loader.SetFsCallbacks(fs);
+
+    bool ret;
+    {
+        ENG_PROFILE_SCOPE("gltf parse");
+        ret = loader.LoadASCIIFromFile(&model, &err, &warn, gltfPath);
+    }
 
     if (!warn.empty()) {
-        std::cout << "GLTF Warning: " << warn << std::endl;
+        eng::log::warn("GLTF: %s", warn);
     }
 
     if (!err.empty()) {
-        std::cerr << "GLTF Error: " << err << std::endl;
+        eng::log::error("GLTF: %s", err);
         return {};
     }
 
     if (!ret) {
-        std::cerr << "Failed to load GLTF file: " << gltfPath << std::endl;
+        eng::log::error("Failed to load GLTF file: %s", gltfPath);
         return {};
     }
 
-    std::vector<Mesh> meshes;
+    Scene result;
+    std::vector<Mesh>& meshes = result.meshes;
 
+    ENG_PROFILE_SCOPE("gltf extract meshes");
+    // Each glTF mesh is extracted on first use; later nodes referencing it only add an instance
+    std::unordered_map<int, std::pair<size_t, size_t>> meshRanges; // glTF mesh -> [first, count) in meshes
     // Process default scene
     if (model.defaultScene >= 0) {
         const tinygltf::Scene& scene = model.scenes[model.defaultScene];
 
+        // One traversal stack for all roots; it never holds more than every node once
+        std::vector<std::pair<int, glm::mat4>> nodeStack;
+        nodeStack.reserve(model.nodes.size());
         for (int nodeIndex : scene.nodes) {
-            std::vector<std::pair<int, glm::mat4>> nodeStack;
             nodeStack.emplace_back(nodeIndex, glm::mat4(1.0f));
 
             while (!nodeStack.empty()) {
@@ -191,8 +372,14 @@ std::vector<Mesh> GltfLoader::loadScene(const std::string& gltfPath) {
 
                 // Process mesh if present
                 if (node.mesh >= 0) {
-                    const tinygltf::Mesh& mesh = model.meshes[node.mesh];
-                    processMesh(model, mesh, nodeTransform, meshes);
+                    auto it = meshRanges.find(node.mesh);
+                    if (it == meshRanges.end()) {
+                        size_t first = meshes.size();
+                        processMesh(model, model.meshes[node.mesh], nodeTransform, meshes);
+                        meshRanges.emplace(node.mesh, std::make_pair(first, meshes.size() - first));
+                    } else {
+                        for (size_t i = 0; i < it->second.second; ++i) meshes[it->second.first + i].instances.push_back(nodeTransform);
+                    }
                 }
 
                 // Add children to stack
@@ -203,8 +390,15 @@ std::vector<Mesh> GltfLoader::loadScene(const std::string& gltfPath) {
         }
     }
 
-    std::cout << "Loaded " << meshes.size() << " meshes from GLTF scene" << std::endl;
-    return meshes;
+    extractMaterials(model, result);
+
+    eng::log::info("Loaded %zu meshes (%zu instances), %zu materials, %zu images from GLTF scene",
+                   meshes.size(), result.instanceCount(), result.materials.size(), result.images.size());
+    size_t unique = result.geometryBytes(), expanded = result.expandedGeometryBytes();
+    if (expanded > unique)
+        eng::log::info("Instancing keeps %.2f MiB of mesh data instead of %.2f MiB (%.2f MiB saved)",
+                       unique / 1048576.0, expanded / 1048576.0, (expanded - unique) / 1048576.0);
+    return result;
 }
 
 } // namespace eng::scene
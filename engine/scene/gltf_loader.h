@@ -11,18 +11,48 @@ struct MeshVertex {
     glm::vec2 texCoord;
 };
 
+// One glTF mesh primitive, stored once however many nodes reference it
 struct Mesh {
     std::vector<MeshVertex> vertices;
     std::vector<uint32_t> indices;
-    glm::mat4 transform;
+    std::vector<glm::mat4> instances; // world transform of every node that draws this primitive
+    int material = -1; // index into Scene::materials, -1 = default material
+};
+
+// Metallic-roughness material; texture slots index Scene::images (-1 = none)
+struct Material {
+    glm::vec4 baseColorFactor{1.0f};
+    float metallicFactor = 1.0f;
+    float roughnessFactor = 1.0f;
+    int baseColorImage = -1;
+    int normalImage = -1;
+};
+
+// Image file contents (PNG/JPEG/...) kept encoded; decoding is left to the texture streamer
+struct ImageSource {
+    std::string name;
+    std::vector<uint8_t> encoded;
+};
+
+struct Scene {
+    std::vector<Mesh> meshes;
+    std::vector<Material> materials;
+    std::vector<ImageSource> images;
+
+    size_t instanceCount() const;
+    // Vertex + index bytes held once per unique mesh, and what copying them per instance would take
+    size_t geometryBytes() const;
+    size_t expandedGeometryBytes() const;
 };
 
 class GltfLoader {
 public:
-    static std::vector<Mesh> loadScene(const std::string& gltfPath);
+    static Scene load(const std::string& gltfPath);
+    static std::vector<Mesh> loadScene(const std::string& gltfPath); // meshes only
 
 private:
     static glm::mat4 getNodeTransform(const tinygltf::Node& node);
+    static void extractMaterials(tinygltf::Model& model, Scene& out);
     static void processMesh(const tinygltf::Model& model,
                            const tinygltf::Mesh& mesh,
                            const glm::mat4& transform,
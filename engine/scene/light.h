@@ -7,5 +7,24 @@ namespace eng::scene {
         glm::vec3 color{ 1.0f, 0.98f, 0.9f };
         float intensity = 3.0f;
     };
+
+    // Local lights, shaded through the renderer's clustered light grid. Light falls off with the
+    // inverse square distance and reaches zero at range.
+    struct PointLight {
+        glm::vec3 position{ 0.0f };
+        glm::vec3 color{ 1.0f };
+        float intensity = 10.0f;
+        float range = 10.0f;
+    };
+
+    struct SpotLight {
+        glm::vec3 position{ 0.0f };
+        glm::vec3 direction{ 0.0f, -1.0f, 0.0f };
+        glm::vec3 color{ 1.0f };
+        float intensity = 20.0f;
+        float range = 15.0f;
+        float innerAngle = 0.35f; // radians from the axis; full intensity inside
+        float outerAngle = 0.6f;  // no light beyond
+    };
 }
 
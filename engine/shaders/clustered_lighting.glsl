@@ -0,0 +1,48 @@
+// Clustered point/spot lighting, shared by the mesh and terrain fragment shaders.
+// Set 2 holds this frame's light list and the per-cluster light indices written by
+// light_cluster.comp; see renderer/light_clusters.h for the grid layout.
+
+#define MAX_LIGHTS_PER_CLUSTER 128
+
+struct Light {
+    vec4 positionRange;   // world position, range
+    vec4 colorIntensity;
+    vec4 directionCosOuter;
+    vec4 cosInnerType;    // x = cos inner angle, y = type (0 point, 1 spot)
+};
+
+layout(std140, set = 2, binding = 0) uniform ClusterParams {
+    mat4 view;
+    mat4 invProj;
+    uvec4 grid;    // x, y, z, light count
+    vec4 screen;   // width, height, near, far
+    vec4 slice;    // scale, bias
+} clusters;
+layout(std430, set = 2, binding = 1) readonly buffer Lights { Light lights[]; };
+layout(std430, set = 2, binding = 2) readonly buffer ClusterCounts { uint clusterCounts[]; };
+layout(std430, set = 2, binding = 3) readonly buffer ClusterLights { uint clusterLights[]; };
+
+// Radiance from every local light in this fragment's cluster, for a diffuse surface
+vec3 clusteredLighting(vec3 worldPos, vec3 normal) {
+    float viewDepth = -(clusters.view * vec4(worldPos, 1.0)).z;
+    uvec2 tile = min(uvec2(gl_FragCoord.xy / clusters.screen.xy * vec2(clusters.grid.xy)), clusters.grid.xy - 1u);
+    int z = int(floor(log(max(viewDepth, 1e-6)) * clusters.slice.x + clusters.slice.y));
+    uint cluster = (uint(clamp(z, 0, int(clusters.grid.z) - 1)) * clusters.grid.y + tile.y) * clusters.grid.x + tile.x;
+
+    vec3 result = vec3(0.0);
+    uint count = clusterCounts[cluster];
+    for (uint i = 0; i < count; ++i) {
+        Light l = lights[clusterLights[cluster * MAX_LIGHTS_PER_CLUSTER + i]];
+        vec3 toLight = l.positionRange.xyz - worldPos;
+        float dist2 = max(dot(toLight, toLight), 1e-4);
+        vec3 L = toLight * inversesqrt(dist2);
+        // Inverse square falloff, windowed to reach zero at the light's range
+        float ratio = dist2 / (l.positionRange.w * l.positionRange.w);
+        float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+        float atten = window * window / dist2;
+        if (l.cosInnerType.y > 0.5)
+            atten *= smoothstep(l.directionCosOuter.w, l.cosInnerType.x, dot(-L, l.directionCosOuter.xyz));
+        result += l.colorIntensity.rgb * l.colorIntensity.a * atten * max(dot(normal, L), 0.0);
+    }
+    return result;
+}
@@ -0,0 +1,17 @@
+// Vertex pulling from the renderer's geometry arena (renderer/geometry_arena.h), set 3.
+// The arena is read as raw words; each range is aligned to its element stride, so
+// gl_VertexIndex / gl_InstanceIndex (which include firstVertex / vertexOffset / firstInstance)
+// index elements directly.
+
+layout(std430, set = 3, binding = 0) readonly buffer GeometryArena { float arenaWords[]; };
+
+vec2 arenaVec2(uint w) { return vec2(arenaWords[w], arenaWords[w + 1]); }
+vec3 arenaVec3(uint w) { return vec3(arenaWords[w], arenaWords[w + 1], arenaWords[w + 2]); }
+vec4 arenaVec4(uint w) { return vec4(arenaWords[w], arenaWords[w + 1], arenaWords[w + 2], arenaWords[w + 3]); }
+
+// scene::MeshVertex: position, normal, texCoord (8 words)
+#define MESH_VERTEX_WORDS 8u
+// Mesh instance: column-major model matrix, material index (20 words)
+#define MESH_INSTANCE_WORDS 20u
+// terrain::Vertex: position, normal, height (7 words)
+#define TERRAIN_VERTEX_WORDS 7u
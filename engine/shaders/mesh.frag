@@ -1,16 +1,23 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
 layout(location = 0) in vec3 inNormal;
 layout(location = 1) in vec2 inTexCoord;
 layout(location = 2) in vec3 inLightDir;
+layout(location = 4) in vec3 inWorldPos;
 
 layout(push_constant) uniform PushConstants {
     mat4 vp;
-    vec4 pc0;
+    vec4 pc0; // material base color factor
     vec4 lightDir;
     vec4 lightColor;
 } pc;
 
+// Streamed base color texture (white until the material's image is resident)
+layout(set = 0, binding = 0) uniform sampler2D baseColorTex;
+
+#include "clustered_lighting.glsl"
+
 layout(location = 0) out vec4 outColor;
 
 void main() {
@@ -18,12 +25,9 @@ void main() {
     vec3 lightDir = normalize(inLightDir);
 
     float diffuse = max(dot(normal, -lightDir), 0.1);
-    vec3 color = pc.lightColor.rgb * pc.lightColor.a * diffuse;
-
-    // Simple checkerboard pattern for visualization
-    vec2 uv = inTexCoord * 8.0;
-    float checker = mod(floor(uv.x) + floor(uv.y), 2.0);
-    color *= mix(vec3(0.8), vec3(1.2), checker);
+    vec3 albedo = texture(baseColorTex, inTexCoord).rgb * pc.pc0.rgb;
+    vec3 color = albedo * pc.lightColor.rgb * pc.lightColor.a * diffuse;
+    color += albedo * clusteredLighting(inWorldPos, normal);
 
     outColor = vec4(color, 1.0);
 }
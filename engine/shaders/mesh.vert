@@ -1,12 +1,12 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 
-layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
-layout(location = 2) in vec2 inTexCoord;
+// Vertices and instances (world transform + bindless material index) are pulled from the geometry arena
+#include "geometry_arena.glsl"
 
 layout(push_constant) uniform PushConstants {
     mat4 vp;
-    vec4 pc0; // unused for meshes
+    vec4 pc0; // material base color factor (fragment stage)
     vec4 lightDir;
     vec4 lightColor;
 } pc;
@@ -14,10 +14,21 @@ layout(push_constant) uniform PushConstants {
 layout(location = 0) out vec3 outNormal;
 layout(location = 1) out vec2 outTexCoord;
 layout(location = 2) out vec3 outLightDir;
+layout(location = 3) flat out uint outMaterial; // bindless path only
+layout(location = 4) out vec3 outWorldPos;
+
+// The depth pre-pass runs this shader in a second pipeline; both must produce identical depths
+invariant gl_Position;
 
 void main() {
-    gl_Position = pc.vp * vec4(inPosition, 1.0);
-    outNormal = inNormal;
-    outTexCoord = inTexCoord;
+    uint v = uint(gl_VertexIndex) * MESH_VERTEX_WORDS;
+    uint i = uint(gl_InstanceIndex) * MESH_INSTANCE_WORDS;
+    mat4 model = mat4(arenaVec4(i), arenaVec4(i + 4u), arenaVec4(i + 8u), arenaVec4(i + 12u));
+    vec4 worldPos = model * vec4(arenaVec3(v), 1.0);
+    gl_Position = pc.vp * worldPos;
+    outNormal = mat3(model) * arenaVec3(v + 3u); // renormalized per fragment; assumes uniform scale
+    outTexCoord = arenaVec2(v + 6u);
     outLightDir = pc.lightDir.xyz;
+    outMaterial = floatBitsToUint(arenaWords[i + 16u]);
+    outWorldPos = worldPos.xyz;
 }
@@ -0,0 +1,45 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+#extension GL_GOOGLE_include_directive : require
+
+// Bindless variant of mesh.frag: material and texture are looked up from the per-draw material
+// index (a per-instance attribute), so the mesh pass binds its descriptors once.
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec3 inLightDir;
+layout(location = 3) flat in uint inMaterial;
+layout(location = 4) in vec3 inWorldPos;
+
+layout(push_constant) uniform PushConstants {
+    mat4 vp;
+    vec4 pc0; // unused here, materials come from the buffer below
+    vec4 lightDir;
+    vec4 lightColor;
+} pc;
+
+struct Material {
+    vec4 baseColorFactor;
+    uint baseColorTexture;
+    uint pad0, pad1, pad2;
+};
+
+layout(set = 0, binding = 0) uniform sampler2D textures[];
+layout(std430, set = 1, binding = 0) readonly buffer Materials { Material materials[]; };
+
+#include "clustered_lighting.glsl"
+
+layout(location = 0) out vec4 outColor;
+
+void main() {
+    Material mat = materials[inMaterial];
+    vec3 normal = normalize(inNormal);
+    vec3 lightDir = normalize(inLightDir);
+
+    float diffuse = max(dot(normal, -lightDir), 0.1);
+    vec3 albedo = texture(textures[nonuniformEXT(mat.baseColorTexture)], inTexCoord).rgb * mat.baseColorFactor.rgb;
+    vec3 color = albedo * pc.lightColor.rgb * pc.lightColor.a * diffuse;
+    color += albedo * clusteredLighting(inWorldPos, normal);
+
+    outColor = vec4(color, 1.0);
+}
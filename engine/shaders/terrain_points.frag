@@ -1,6 +1,8 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 layout(location=0) in float vHeight;
 layout(location=1) in vec3 vNormal;
+layout(location=2) in vec3 vWorldPos;
 layout(location=0) out vec4 outColor;
 
 layout(push_constant) uniform Push {
@@ -10,6 +12,8 @@ layout(push_constant) uniform Push {
     vec4 lightColor; // xyz color, w intensity
 } pushC;
 
+#include "clustered_lighting.glsl"
+
 void main(){
     // circular sprite
     vec2 pc = gl_PointCoord * 2.0 - 1.0;
@@ -25,5 +29,6 @@ void main(){
     float ndl = max(dot(N, L), 0.0);
     vec3 ambient = 0.25 * col;
     vec3 diffuse = ndl * col * pushC.lightColor.xyz * pushC.lightColor.w;
-    outColor = vec4(ambient + diffuse, 1.0);
+    vec3 local = col * clusteredLighting(vWorldPos, N);
+    outColor = vec4(ambient + diffuse + local, 1.0);
 }
@@ -1,7 +1,6 @@
 #version 450
-layout(location=0) in vec3 inPos;
-layout(location=1) in vec3 inNormal;
-layout(location=2) in float inHeight;
+#extension GL_GOOGLE_include_directive : require
+#include "geometry_arena.glsl"
 
 layout(push_constant) uniform Push {
     mat4 vp;           // 64 bytes
@@ -12,11 +11,15 @@ layout(push_constant) uniform Push {
 
 layout(location=0) out float vHeight;
 layout(location=1) out vec3 vNormal;
+layout(location=2) out vec3 vWorldPos;
 
 void main(){
-    vHeight = inHeight;
-    vNormal = normalize(inNormal);
-    gl_Position = pushC.vp * vec4(inPos, 1.0);
+    uint v = uint(gl_VertexIndex) * TERRAIN_VERTEX_WORDS;
+    vec3 pos = arenaVec3(v);
+    vHeight = arenaWords[v + 6u];
+    vNormal = normalize(arenaVec3(v + 3u));
+    vWorldPos = pos;
+    gl_Position = pushC.vp * vec4(pos, 1.0);
     float dist = length(gl_Position.xyz / gl_Position.w);
     gl_PointSize = clamp(pushC.pc0.x / max(dist, 0.001), 1.0, 8.0);
 }
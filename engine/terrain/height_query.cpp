@@ -0,0 +1,240 @@
+#include "height_query.h"
+#include "../core/profiler.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ENG_TERRAIN_SSE2 1
+#endif
+
+using namespace eng::terrain;
+
+bool HeightQuery::build(const Settings& s, const std::vector<Vertex>& vertices) {
+    ENG_PROFILE_FUNCTION();
+    clear();
+    const int N = s.chunkPoints, R = s.radiusChunks, chunks = 2 * R + 1;
+    if (N < 2 || R < 0 || s.spacing <= 0.0f || vertices.size() != (size_t)chunks * chunks * N * N) return false;
+    settings_ = s;
+    spacing_ = s.spacing; invSpacing_ = 1.0f / s.spacing;
+    originX_ = originZ_ = -R * (N - 1) * s.spacing;
+    samples_ = (uint32_t)(chunks * (N - 1) + 1);
+    heights_.resize((size_t)samples_ * samples_);
+    // Same loop order as generate(); shared edge samples are written twice with the same value
+    size_t v = 0;
+    for (int cy = 0; cy < chunks; ++cy)
+        for (int cx = 0; cx < chunks; ++cx)
+            for (int j = 0; j < N; ++j)
+                for (int i = 0; i < N; ++i)
+                    heights_[(size_t)(cy * (N - 1) + j) * samples_ + cx * (N - 1) + i] = vertices[v++].height;
+
+    // Min/max pyramid over cells; a parent covers up to 2x2 children (odd sizes round up)
+    uint32_t cells = samples_ - 1;
+    std::vector<Range> level((size_t)cells * cells);
+    for (uint32_t z = 0; z < cells; ++z)
+        for (uint32_t x = 0; x < cells; ++x) {
+            const float* r0 = &heights_[(size_t)z * samples_ + x];
+            const float* r1 = r0 + samples_;
+            level[(size_t)z * cells + x] = { std::min({ r0[0], r0[1], r1[0], r1[1] }), std::max({ r0[0], r0[1], r1[0], r1[1] }) };
+        }
+    mips_.push_back(std::move(level));
+    for (uint32_t n = cells; n > 1;) {
+        uint32_t m = (n + 1) / 2;
+        const std::vector<Range>& src = mips_.back();
+        std::vector<Range> dst((size_t)m * m, { FLT_MAX, -FLT_MAX });
+        for (uint32_t z = 0; z < n; ++z)
+            for (uint32_t x = 0; x < n; ++x) {
+                Range& d = dst[(size_t)(z / 2) * m + x / 2];
+                const Range& r = src[(size_t)z * n + x];
+                d.lo = std::min(d.lo, r.lo); d.hi = std::max(d.hi, r.hi);
+            }
+        mips_.push_back(std::move(dst));
+        n = m;
+    }
+    return true;
+}
+
+void HeightQuery::clear() {
+    heights_.clear(); mips_.clear(); samples_ = 0;
+}
+
+bool HeightQuery::contains(float x, float z) const {
+    if (heights_.empty()) return false;
+    float fx = (x - originX_) * invSpacing_, fz = (z - originZ_) * invSpacing_, last = (float)(samples_ - 1);
+    return fx >= 0.0f && fz >= 0.0f && fx <= last && fz <= last;
+}
+
+float HeightQuery::gridHeight(float fx, float fz) const {
+    float last = (float)(samples_ - 2);
+    float cxf = std::min(std::floor(fx), last), czf = std::min(std::floor(fz), last);
+    float u = fx - cxf, v = fz - czf;
+    const float* r0 = &heights_[(size_t)czf * samples_ + (size_t)cxf];
+    const float* r1 = r0 + samples_;
+    float a = r0[0] + (r0[1] - r0[0]) * u, b = r1[0] + (r1[1] - r1[0]) * u;
+    return a + (b - a) * v;
+}
+
+float HeightQuery::height(float x, float z) const {
+    if (!contains(x, z)) return eng::terrain::height(x, z, settings_);
+    return gridHeight((x - originX_) * invSpacing_, (z - originZ_) * invSpacing_);
+}
+
+glm::vec3 HeightQuery::analyticNormal(float x, float z) const {
+    // Forward differences, as generate() computes its vertex normals
+    float e = settings_.spacing;
+    float y = eng::terrain::height(x, z, settings_);
+    float dx = eng::terrain::height(x + e, z, settings_) - y, dz = eng::terrain::height(x, z + e, settings_) - y;
+    return glm::normalize(glm::vec3(-dx, e, -dz));
+}
+
+void HeightQuery::sample(float x, float z, float& h, glm::vec3& n) const {
+    if (!contains(x, z)) { h = eng::terrain::height(x, z, settings_); n = analyticNormal(x, z); return; }
+    float fx = (x - originX_) * invSpacing_, fz = (z - originZ_) * invSpacing_;
+    float last = (float)(samples_ - 2);
+    float cxf = std::min(std::floor(fx), last), czf = std::min(std::floor(fz), last);
+    float u = fx - cxf, v = fz - czf;
+    const float* r0 = &heights_[(size_t)czf * samples_ + (size_t)cxf];
+    const float* r1 = r0 + samples_;
+    float a = r0[0] + (r0[1] - r0[0]) * u, b = r1[0] + (r1[1] - r1[0]) * u;
+    h = a + (b - a) * v;
+    // Gradient of the bilinear patch, in height per world unit
+    float dhdx = ((r0[1] - r0[0]) + ((r1[1] - r1[0]) - (r0[1] - r0[0])) * v) * invSpacing_;
+    float dhdz = (b - a) * invSpacing_;
+    n = glm::normalize(glm::vec3(-dhdx, 1.0f, -dhdz));
+}
+
+glm::vec3 HeightQuery::normal(float x, float z) const {
+    float h; glm::vec3 n;
+    sample(x, z, h, n);
+    return n;
+}
+
+void HeightQuery::heights(const float* xs, const float* zs, float* out, size_t count) const {
+    ENG_PROFILE_FUNCTION();
+    size_t i = 0;
+#ifdef ENG_TERRAIN_SSE2
+    if (!heights_.empty()) {
+        // Cell index and weights for four points at once; the corner loads are scalar (SSE2 has no
+        // gather). A group with any point outside the grid takes the scalar path.
+        const __m128 ox = _mm_set1_ps(originX_), oz = _mm_set1_ps(originZ_), inv = _mm_set1_ps(invSpacing_);
+        const __m128 zero = _mm_setzero_ps(), lastSample = _mm_set1_ps((float)(samples_ - 1)), lastCell = _mm_set1_ps((float)(samples_ - 2));
+        for (; i + 4 <= count; i += 4) {
+            __m128 fx = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(xs + i), ox), inv);
+            __m128 fz = _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(zs + i), oz), inv);
+            __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(fx, zero), _mm_cmple_ps(fx, lastSample)),
+                                       _mm_and_ps(_mm_cmpge_ps(fz, zero), _mm_cmple_ps(fz, lastSample)));
+            if (_mm_movemask_ps(inside) != 0xF) {
+                for (size_t k = i; k < i + 4; ++k) out[k] = height(xs[k], zs[k]);
+                continue;
+            }
+            __m128i cx = _mm_cvttps_epi32(_mm_min_ps(fx, lastCell)), cz = _mm_cvttps_epi32(_mm_min_ps(fz, lastCell));
+            __m128 u = _mm_sub_ps(fx, _mm_cvtepi32_ps(cx)), v = _mm_sub_ps(fz, _mm_cvtepi32_ps(cz));
+            alignas(16) int32_t ix[4], iz[4];
+            _mm_store_si128((__m128i*)ix, cx); _mm_store_si128((__m128i*)iz, cz);
+            alignas(16) float h00[4], h10[4], h01[4], h11[4];
+            for (int k = 0; k < 4; ++k) {
+                const float* r0 = &heights_[(size_t)iz[k] * samples_ + (size_t)ix[k]];
+                h00[k] = r0[0]; h10[k] = r0[1]; h01[k] = r0[samples_]; h11[k] = r0[samples_ + 1];
+            }
+            __m128 a00 = _mm_load_ps(h00), a10 = _mm_load_ps(h10), a01 = _mm_load_ps(h01), a11 = _mm_load_ps(h11);
+            __m128 a = _mm_add_ps(a00, _mm_mul_ps(_mm_sub_ps(a10, a00), u));
+            __m128 b = _mm_add_ps(a01, _mm_mul_ps(_mm_sub_ps(a11, a01), u));
+            _mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), v)));
+        }
+    }
+#endif
+    for (; i < count; ++i) out[i] = height(xs[i], zs[i]);
+}
+
+// Smallest t in [t0, t1] where the ray meets the bilinear patch of cell (cx, cz). Along the ray the
+// patch height minus the ray height is a quadratic in t (the u*v term), solved in closed form.
+bool HeightQuery::intersectCell(uint32_t cx, uint32_t cz, const glm::vec3& o, const glm::vec3& d, float t0, float t1, float& t) const {
+    const float* r0 = &heights_[(size_t)cz * samples_ + cx];
+    const float* r1 = r0 + samples_;
+    float h00 = r0[0], h10 = r0[1], h01 = r1[0], h11 = r1[1];
+    float a = h10 - h00, b = h01 - h00, k = h00 - h10 - h01 + h11;
+    float u0 = (o.x - originX_) * invSpacing_ - cx, du = d.x * invSpacing_;
+    float v0 = (o.z - originZ_) * invSpacing_ - cz, dv = d.z * invSpacing_;
+    float A = k * du * dv;
+    float B = a * du + b * dv + k * (u0 * dv + v0 * du) - d.y;
+    float C = h00 + a * u0 + b * v0 + k * u0 * v0 - o.y;
+    auto f = [&](float s) { return (A * s + B) * s + C; };
+    if (f(t0) >= 0.0f) { t = t0; return true; } // already at or below the surface on entry
+    float roots[2]; int n = 0;
+    if (std::abs(A) < 1e-12f) {
+        if (B != 0.0f) roots[n++] = -C / B;
+    } else {
+        float disc = B * B - 4.0f * A * C;
+        if (disc < 0.0f) return false;
+        // Numerically stable pair
+        float q = -0.5f * (B + std::copysign(std::sqrt(disc), B));
+        roots[n++] = q / A;
+        if (q != 0.0f) roots[n++] = C / q;
+        if (n == 2 && roots[1] < roots[0]) std::swap(roots[0], roots[1]);
+    }
+    for (int i = 0; i < n; ++i)
+        if (roots[i] >= t0 && roots[i] <= t1) { t = roots[i]; return true; }
+    return false;
+}
+
+bool HeightQuery::raycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, RayHit& hit) const {
+    ENG_PROFILE_FUNCTION();
+    if (heights_.empty() || maxT <= 0.0f) return false;
+    const uint32_t cells = samples_ - 1;
+    glm::vec3 inv(dir.x != 0.0f ? 1.0f / dir.x : FLT_MAX, dir.y != 0.0f ? 1.0f / dir.y : FLT_MAX, dir.z != 0.0f ? 1.0f / dir.z : FLT_MAX);
+    // Parametric overlap of the ray with a node's box; its x/z extent in cells, y from the node's range
+    auto slab = [&](uint32_t x0, uint32_t z0, uint32_t x1, uint32_t z1, const Range& r, float& tEnter, float& tExit) {
+        glm::vec3 lo(originX_ + x0 * spacing_, r.lo, originZ_ + z0 * spacing_), hi(originX_ + x1 * spacing_, r.hi, originZ_ + z1 * spacing_);
+        glm::vec3 ta = (lo - origin) * inv, tb = (hi - origin) * inv;
+        glm::vec3 tmin = glm::min(ta, tb), tmax = glm::max(ta, tb);
+        // An axis the ray is parallel to either always overlaps or never does
+        for (int a = 0; a < 3; ++a)
+            if (dir[a] == 0.0f) { bool in = origin[a] >= lo[a] && origin[a] <= hi[a]; tmin[a] = in ? -FLT_MAX : FLT_MAX; tmax[a] = in ? FLT_MAX : -FLT_MAX; }
+        tEnter = std::max({ tmin.x, tmin.y, tmin.z, 0.0f });
+        tExit = std::min({ tmax.x, tmax.y, tmax.z, maxT });
+        return tEnter <= tExit;
+    };
+
+    struct Node { uint32_t level, x, z; float tEnter, tExit; };
+    // Depth-first, at most three siblings wait per level, so a fixed stack suffices
+    Node stack[3 * 32 + 1]; int sp = 0;
+    float best = FLT_MAX;
+    uint32_t top = (uint32_t)mips_.size() - 1;
+    float te, tx;
+    if (slab(0, 0, cells, cells, mips_[top][0], te, tx)) stack[sp++] = { top, 0, 0, te, tx };
+    while (sp > 0) {
+        Node nd = stack[--sp];
+        if (nd.tEnter >= best) continue;
+        if (nd.level == 0) {
+            float t;
+            if (intersectCell(nd.x, nd.z, origin, dir, nd.tEnter, std::min(nd.tExit, best), t) && t < best) best = t;
+            continue;
+        }
+        // Children cover cells [x << (level - 1), ...) at the level below; push far ones first so
+        // the nearest is popped next
+        uint32_t cl = nd.level - 1, n = (uint32_t)std::lround(std::sqrt((double)mips_[cl].size()));
+        Node kids[4]; int count = 0;
+        for (uint32_t dz = 0; dz < 2; ++dz)
+            for (uint32_t dx = 0; dx < 2; ++dx) {
+                uint32_t x = nd.x * 2 + dx, z = nd.z * 2 + dz;
+                if (x >= n || z >= n) continue;
+                uint32_t x0 = x << cl, z0 = z << cl;
+                uint32_t x1 = std::min((x + 1) << cl, cells), z1 = std::min((z + 1) << cl, cells);
+                if (slab(x0, z0, x1, z1, mips_[cl][(size_t)z * n + x], te, tx) && te < best) kids[count++] = { cl, x, z, te, tx };
+            }
+        for (int i = 1; i < count; ++i) // at most four: insertion sort, farthest first
+            for (int j = i; j > 0 && kids[j - 1].tEnter < kids[j].tEnter; --j) std::swap(kids[j - 1], kids[j]);
+        for (int i = 0; i < count; ++i) stack[sp++] = kids[i];
+    }
+    if (best == FLT_MAX) return false;
+    hit.t = best;
+    hit.position = origin + dir * best;
+    float h; sample(hit.position.x, hit.position.z, h, hit.normal);
+    return true;
+}
+
+size_t HeightQuery::memoryBytes() const {
+    size_t bytes = heights_.size() * sizeof(float);
+    for (const auto& m : mips_) bytes += m.size() * sizeof(Range);
+    return bytes;
+}
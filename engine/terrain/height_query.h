@@ -0,0 +1,58 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "terrain.h"
+
+namespace eng::terrain {
+    struct RayHit {
+        float t = 0.0f;        // hit = origin + t * dir
+        glm::vec3 position{0.0f};
+        glm::vec3 normal{0.0f, 1.0f, 0.0f};
+    };
+
+    // CPU height/normal queries against generated terrain, for camera ground-following, object
+    // placement and physics. The generated chunks share their edge rows, so their height samples
+    // are stitched into one (2R+1)(N-1)+1 square grid; a query is a bilinear lookup in it. Points
+    // outside the loaded chunks fall back to the analytic height (terrain::height) with the same
+    // settings. Immutable after build(), so any number of threads may query concurrently.
+    //
+    //   HeightQuery hq; hq.build(settings, terrain::generate(settings));
+    //   float y = hq.height(x, z);
+    //   hq.heights(xs, zs, ys, n);             batch, SIMD where available
+    //   RayHit hit; if (hq.raycast(origin, dir, 500.0f, hit)) ...
+    class HeightQuery {
+    public:
+        // vertices must come from generate(s) with the same settings (their layout is relied on)
+        bool build(const Settings& s, const std::vector<Vertex>& vertices);
+        void clear();
+        bool loaded() const { return !heights_.empty(); }
+        bool contains(float x, float z) const; // inside the loaded grid
+
+        float height(float x, float z) const;
+        glm::vec3 normal(float x, float z) const;                  // unit, y up
+        void sample(float x, float z, float& h, glm::vec3& n) const;
+        void heights(const float* xs, const float* zs, float* out, size_t count) const;
+
+        // First intersection of the ray with the loaded heightfield (the bilinear surface height()
+        // describes) within maxT. dir need not be normalized; t is in units of |dir|. A ray that
+        // starts below the surface hits at t = 0. Traversal descends a min/max quadtree, so only
+        // cells whose height range the ray actually passes through are tested.
+        bool raycast(const glm::vec3& origin, const glm::vec3& dir, float maxT, RayHit& hit) const;
+
+        size_t memoryBytes() const;
+    private:
+        struct Range { float lo, hi; };
+
+        Settings settings_;
+        float originX_ = 0.0f, originZ_ = 0.0f, spacing_ = 1.0f, invSpacing_ = 1.0f;
+        uint32_t samples_ = 0;                 // per side
+        std::vector<float> heights_;           // samples_ x samples_, row-major by z
+        std::vector<std::vector<Range>> mips_; // [0] one per cell, each level halves until 1x1
+
+        float gridHeight(float fx, float fz) const; // fx, fz in samples, inside the grid
+        glm::vec3 analyticNormal(float x, float z) const;
+        bool intersectCell(uint32_t cx, uint32_t cz, const glm::vec3& o, const glm::vec3& d, float t0, float t1, float& t) const;
+    };
+}
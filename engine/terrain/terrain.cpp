@@ -1,4 +1,6 @@
 #include "terrain.h"
+#include "../core/jobs.h"
+#include "../core/profiler.h"
 #include <cmath>
 
 using namespace eng::terrain;
@@ -45,16 +47,24 @@ static inline float height_fn(float x, float z, const Settings& s){
     return h * s.heightScale;
 }
 
+float eng::terrain::height(float x, float z, const Settings& s) { return height_fn(x, z, s); }
+
 std::vector<Vertex> eng::terrain::generate(const Settings& s) {
-    std::vector<Vertex> verts;
+    ENG_PROFILE_FUNCTION();
     int N = s.chunkPoints;
     int R = s.radiusChunks;
-    verts.reserve((size_t)(2*R+1)*(2*R+1)*N*N);
+    int side = 2*R+1;
+    std::vector<Vertex> verts((size_t)side*side*N*N);
     const float e = s.spacing; // derivative step
-    for (int cy=-R; cy<=R; ++cy) {
-        for (int cx=-R; cx<=R; ++cx) {
+    // One chunk per index; each writes its own N*N slice, so the order matches the serial loop
+    eng::jobs::parallelFor(0, (size_t)side*side, [&](size_t begin, size_t end) {
+        ENG_PROFILE_SCOPE("terrain chunks");
+        for (size_t c = begin; c < end; ++c) {
+            int cx = (int)(c % side) - R;
+            int cy = (int)(c / side) - R;
             float baseX = cx * (N-1) * s.spacing;
             float baseY = cy * (N-1) * s.spacing;
+            Vertex* out = verts.data() + c * N * N;
             for (int j=0;j<N;++j) {
                 for (int i=0;i<N;++i) {
                     float x = baseX + i * s.spacing;
@@ -66,10 +76,10 @@ std::vector<Vertex> eng::terrain::generate(const Settings& s) {
                     glm::vec3 tx = glm::normalize(glm::vec3(e, hx - y, 0.0f));
                     glm::vec3 tz = glm::normalize(glm::vec3(0.0f, hz - y, e));
                     glm::vec3 n = glm::normalize(glm::cross(tz, tx));
-                    verts.push_back({{x, y, z}, n, y});
+                    *out++ = {{x, y, z}, n, y};
                 }
             }
         }
-    }
+    }, 1);
     return verts;
 }
@@ -18,5 +18,9 @@ namespace eng::terrain {
     float noise2D(float x, float y);
     float fbm(float x, float y, int octaves);
 
+    // Analytic terrain height at world (x, z): what generate() samples, at full octave cost.
+    // For many queries against generated terrain use HeightQuery (height_query.h).
+    float height(float x, float z, const Settings& s);
+
     std::vector<Vertex> generate(const Settings& s);
 }